@@ -35,6 +35,9 @@ CONFIG(with_updater) {
 
 CONFIG(with_tests) {
     SUBDIRS += ../tests/MEGASyncUnitTests
+    unix:!macx {
+        SUBDIRS += ../tests/MEGAShellExtBenchmark
+    }
 }
 
 CONFIG(with_tools) {
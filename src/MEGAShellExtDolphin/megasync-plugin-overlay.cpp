@@ -38,6 +38,9 @@ const char OP_STRING      = 'T'; //Get Translated String
 const char OP_VIEW        = 'V'; //View on MEGA
 const char OP_PREVIOUS    = 'R'; //View previous versions
 
+// max number of shown items remembered for the refresh of a sync root
+const int MAX_SHOWN_ITEMS = 200000;
+
 class MegasyncDolphinOverlayPlugin : public KOverlayIconPlugin
 {
     Q_PLUGIN_METADATA(IID "com.megasync.ovarlayiconplugin" FILE "megasync-plugin-overlay.json")
@@ -45,6 +48,8 @@ class MegasyncDolphinOverlayPlugin : public KOverlayIconPlugin
 
     typedef QHash<QByteArray, QByteArray> StatusMap;
     StatusMap m_status;
+    // local path -> canonical path of the items Dolphin asked overlays for
+    QHash<QString, QString> m_shownItems;
     QLocalSocket sockNotifyServer;
     QString sockPathNofityServer;
 
@@ -107,6 +112,9 @@ private slots:
             case 'D': // sync folder deleted
                 action="sync folder deleted";
                 break;
+            case 'R': // states of everything below a path changed
+                action="subtree changed";
+                break;
             default:
                 qCritical("MEGASYNCOVERLAYPLUGIN: unexpected read from notifyServer. type=%s", type);
                 break;
@@ -117,6 +125,12 @@ private slots:
 
             qDebug("MEGASYNCOVERLAYPLUGIN: Server notified <%s>: %s",action.toUtf8().constData(), url.toUtf8().constData());
 
+            if (*type == 'R')
+            {
+                refreshSubtree(url);
+                continue;
+            }
+
             emit overlaysChanged(QUrl::fromLocalFile(url), getOverlays(QUrl::fromLocalFile(url)));
         }
     }
@@ -172,7 +186,10 @@ public:
 
         QStringList r;
 
-        int state = getState(url.toLocalFile());
+        QString path = url.toLocalFile();
+        QString canonicalPath = QFileInfo(path).canonicalFilePath();
+        rememberItem(path, canonicalPath);
+        int state = getState(canonicalPath);
 
         switch (state)
         {
@@ -200,13 +217,48 @@ public:
 
 private:
 
-    int getState(QString path)
+    int getState(QString canonicalPath)
     {
         QString res;
-        res = sendRequest(OP_PATH_STATE, QFileInfo(path).canonicalFilePath());
+        res = sendRequest(OP_PATH_STATE, canonicalPath);
         return res.toInt();
     }
 
+    void rememberItem(const QString& path, const QString& canonicalPath)
+    {
+        // keep the memory bounded, the table is refilled as folders are shown
+        if (m_shownItems.size() >= MAX_SHOWN_ITEMS && !m_shownItems.contains(path))
+        {
+            m_shownItems.clear();
+        }
+        m_shownItems.insert(path, canonicalPath);
+    }
+
+    // updates the overlays of the shown items below a path. The server sends canonical paths
+    void refreshSubtree(const QString& root)
+    {
+        QString prefix = root.endsWith(QLatin1Char('/')) ? root : root + QLatin1Char('/');
+        QStringList paths;
+        bool rootShown = false;
+        for (QHash<QString, QString>::const_iterator it = m_shownItems.constBegin(); it != m_shownItems.constEnd(); ++it)
+        {
+            if (it.value() == root || it.value().startsWith(prefix))
+            {
+                paths.append(it.key());
+                rootShown = rootShown || it.value() == root;
+            }
+        }
+        if (!rootShown)
+        {
+            paths.append(root);
+        }
+
+        foreach (const QString& path, paths)
+        {
+            emit overlaysChanged(QUrl::fromLocalFile(path), getOverlays(QUrl::fromLocalFile(path)));
+        }
+    }
+
     // send request and receive response from Extension server
     // Return newly-allocated response string
     QString sendRequest(char type, QString command)
@@ -2,6 +2,7 @@
 #define MEGASHELLEXT_H
 
 #include <glib-object.h>
+#include "mega_ext_sync_trie.h"
 
 G_BEGIN_DECLS
 
@@ -22,11 +23,16 @@ struct _MEGAExt {
     gboolean syncs_received; // TRUE if the list with sync folders is received
 
     GHashTable *h_syncs; // table of paths of shared folders
+    MEGASyncTrie *sync_trie; // matcher of the paths in h_syncs, rebuilt when they change
+    GHashTable *h_states; // cache of path states, kept current by the notify server
+    GHashTable *h_shown; // paths of the items shown in sync folders, refreshed with their sync root
     gchar *string_upload; // cached string
     gchar *string_getlink; // cached string
     gchar *string_viewonmega; // cached string
     gchar *string_viewprevious; // cached string
 
+    GList *pending_updates; // file info requests waiting for the next batch
+    guint pending_source; // idle source that resolves pending_updates
 };
 
 struct _MEGAExtClass {
@@ -57,6 +63,7 @@ void  mega_ext_register_type(GTypeModule *module);
 G_END_DECLS
 
 void mega_ext_on_item_changed(MEGAExt *mega_ext, const gchar *path);
+void mega_ext_on_subtree_changed(MEGAExt *mega_ext, const gchar *path);
 void mega_ext_on_sync_add(MEGAExt *mega_ext, const gchar *path);
 void mega_ext_on_sync_del(MEGAExt *mega_ext, const gchar *path);
 void expanselocalpath(const char *path, char *absolutepath);
@@ -6,6 +6,7 @@
 #include <string.h>
 
 const gchar OP_PATH_STATE  = 'P'; //Path state
+const gchar OP_PATH_STATES = 'B'; //Batch of path states
 const gchar OP_INIT        = 'I'; //Init operation
 const gchar OP_END         = 'E'; //End operation
 const gchar OP_UPLOAD      = 'F'; //File-Folder upload
@@ -16,6 +17,11 @@ const gchar OP_STRING      = 'T'; //Get Translated String
 const gchar OP_VIEW        = 'V'; //View on MEGA
 const gchar OP_PREVIOUS    = 'R'; //View previous versions
 
+// max number of paths sent in a single batch request
+#define MAX_PATHS_PER_BATCH 256
+// max number of path states kept in the local cache
+#define MAX_CACHED_STATES 200000
+
 static void mega_ext_client_disconnect(MEGAExt *mega_ext);
 
 // try to connect to the server
@@ -160,13 +166,88 @@ gchar *mega_ext_client_get_string(MEGAExt *mega_ext, int stringID, int numFiles,
     return out;
 }
 
+// states are only cached while the notify server is connected,
+// because it is what keeps them up to date
+static gboolean mega_ext_client_can_cache(MEGAExt *mega_ext)
+{
+    return mega_ext->notify_chan != NULL && mega_ext->syncs_received;
+}
+
+static gboolean mega_ext_client_lookup_state(MEGAExt *mega_ext, const gchar *canonical, FileState *state)
+{
+    gpointer value;
+
+    if (!mega_ext_client_can_cache(mega_ext))
+        return FALSE;
+
+    if (!g_hash_table_lookup_extended(mega_ext->h_states, canonical, NULL, &value))
+        return FALSE;
+
+    *state = GPOINTER_TO_INT(value);
+    return TRUE;
+}
+
+static void mega_ext_client_store_state(MEGAExt *mega_ext, const gchar *canonical, FileState state)
+{
+    if (state == FILE_ERROR || !mega_ext_client_can_cache(mega_ext))
+        return;
+
+    // keep the memory bounded, the table is refilled on demand
+    if (g_hash_table_size(mega_ext->h_states) >= MAX_CACHED_STATES)
+        g_hash_table_remove_all(mega_ext->h_states);
+
+    g_hash_table_insert(mega_ext->h_states, g_strdup(canonical), GINT_TO_POINTER(state));
+}
+
+void mega_ext_client_invalidate_state(MEGAExt *mega_ext, const gchar *path)
+{
+    char canonical[PATH_MAX];
+
+    expanselocalpath((gchar *)path, canonical);
+    g_hash_table_remove(mega_ext->h_states, canonical);
+    if (strcmp(canonical, path))
+        g_hash_table_remove(mega_ext->h_states, path);
+}
+
+// removes the cached states of a path and of everything below it
+void mega_ext_client_invalidate_subtree(MEGAExt *mega_ext, const gchar *path)
+{
+    char canonical[PATH_MAX];
+    GHashTableIter iter;
+    gpointer key;
+    size_t len;
+
+    expanselocalpath((gchar *)path, canonical);
+    len = strlen(canonical);
+
+    g_hash_table_iter_init(&iter, mega_ext->h_states);
+    while (g_hash_table_iter_next(&iter, &key, NULL))
+    {
+        const gchar *cached = key;
+        if (!strncmp(cached, canonical, len)
+                && (cached[len] == '\0' || cached[len] == '/' || (len && canonical[len - 1] == '/')))
+        {
+            g_hash_table_iter_remove(&iter);
+        }
+    }
+}
+
+void mega_ext_client_clear_states(MEGAExt *mega_ext)
+{
+    g_hash_table_remove_all(mega_ext->h_states);
+}
+
 FileState mega_ext_client_get_path_state(MEGAExt *mega_ext, const gchar *path, int forceGetState)
 {
     gchar *out;
     FileState st;
 
     char canonical[PATH_MAX];
-    expanselocalpath(path,canonical);
+    expanselocalpath((gchar *)path,canonical);
+
+    // forced requests ignore the overlay settings, so they are not cached
+    if (!forceGetState && mega_ext_client_lookup_state(mega_ext, canonical, &st))
+        return st;
 
     char finalpath[PATH_MAX+2];
     sprintf(finalpath,"%s%c%c", canonical, (char)0x1C, forceGetState?'1':'0');
@@ -179,9 +260,89 @@ FileState mega_ext_client_get_path_state(MEGAExt *mega_ext, const gchar *path, i
     st = out[0]-'0';
     g_free(out);
 
+    if (!forceGetState)
+        mega_ext_client_store_state(mega_ext, canonical, st);
+
     return st;
 }
 
+// query the state of several paths with one round trip per MAX_PATHS_PER_BATCH paths
+// paths with a cached state are answered locally
+// request:  B:<force>0x1C<path>0x1D<path>...\n
+// response: one state digit per path
+// return FALSE if any of the requests failed
+gboolean mega_ext_client_get_path_states(MEGAExt *mega_ext, const gchar **paths, guint num_paths, int forceGetState, FileState *states)
+{
+    guint i, count, num_misses, first;
+    gchar **canonicals;
+    guint *misses;
+    gchar *out;
+    GString *in;
+    gint64 start_time;
+    gboolean result = TRUE;
+
+    start_time = g_get_monotonic_time();
+
+    canonicals = g_new0(gchar *, num_paths);
+    misses = g_new0(guint, num_paths);
+    num_misses = 0;
+    for (i = 0; i < num_paths; i++) {
+        char canonical[PATH_MAX];
+        expanselocalpath((gchar *)paths[i], canonical);
+        canonicals[i] = g_strdup(canonical);
+
+        if (forceGetState || !mega_ext_client_lookup_state(mega_ext, canonicals[i], &states[i]))
+            misses[num_misses++] = i;
+    }
+
+    for (first = 0; first < num_misses; first += MAX_PATHS_PER_BATCH) {
+        count = MIN(num_misses - first, MAX_PATHS_PER_BATCH);
+
+        in = g_string_sized_new(count * 64);
+        g_string_append_c(in, forceGetState ? '1' : '0');
+        g_string_append_c(in, (char)0x1C);
+        for (i = 0; i < count; i++) {
+            if (i)
+                g_string_append_c(in, (char)0x1D);
+            g_string_append(in, canonicals[misses[first + i]]);
+        }
+        g_string_append_c(in, '\n');
+
+        out = mega_ext_client_send_request(mega_ext, OP_PATH_STATES, in->str);
+        g_string_free(in, TRUE);
+
+        if (!out) {
+            result = FALSE;
+            break;
+        }
+
+        if (strlen(out) != count) {
+            g_warning("Unexpected batch response size: %u (expected %u)", (guint)strlen(out), count);
+            g_free(out);
+            result = FALSE;
+            break;
+        }
+
+        for (i = 0; i < count; i++) {
+            guint index = misses[first + i];
+            states[index] = out[i] - '0';
+            if (!forceGetState)
+                mega_ext_client_store_state(mega_ext, canonicals[index], states[index]);
+        }
+        g_free(out);
+    }
+
+    g_debug("Batch of %u path states (%u not cached) resolved in %" G_GINT64_FORMAT " us",
+            num_paths, num_misses, g_get_monotonic_time() - start_time);
+
+    for (i = 0; i < num_paths; i++)
+        g_free(canonicals[i]);
+    g_free(canonicals);
+    g_free(misses);
+
+    return result;
+}
+
 gboolean mega_ext_client_paste_link(MEGAExt *mega_ext, const gchar *path)
 {
     gchar *out;
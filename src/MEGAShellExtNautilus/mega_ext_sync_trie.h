@@ -0,0 +1,14 @@
+#ifndef MEGA_EXT_SYNC_TRIE_H
+#define MEGA_EXT_SYNC_TRIE_H
+
+#include <glib.h>
+
+// path-component trie of sync roots
+typedef struct _MEGASyncTrie MEGASyncTrie;
+
+MEGASyncTrie *mega_sync_trie_new(void);
+void mega_sync_trie_free(MEGASyncTrie *trie);
+void mega_sync_trie_insert(MEGASyncTrie *trie, const gchar *path);
+gboolean mega_sync_trie_match(MEGASyncTrie *trie, const gchar *path);
+
+#endif
@@ -7,6 +7,9 @@
 #include "mega_notify_client.h"
 #include <string.h>
 
+// max number of shown items remembered for the refresh of a sync root
+#define MAX_SHOWN_ITEMS 200000
+
 static GObjectClass *parent_class;
 
 static void mega_ext_class_init(MEGAExtClass *class)
@@ -21,11 +24,16 @@ static void mega_ext_instance_init(MEGAExt *mega_ext)
     mega_ext->chan = NULL;
     mega_ext->num_retries = 2;
     mega_ext->h_syncs = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+    mega_ext->sync_trie = mega_sync_trie_new();
+    mega_ext->h_states = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+    mega_ext->h_shown = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
     mega_ext->string_getlink = NULL;
     mega_ext->string_viewonmega = NULL;
     mega_ext->string_viewprevious = NULL;
     mega_ext->string_upload = NULL;
     mega_ext->syncs_received = FALSE;
+    mega_ext->pending_updates = NULL;
+    mega_ext->pending_source = 0;
 
     // ignore SIGPIPE as we most likely will write to a closed socket in mega_notify_client_read()
     signal(SIGPIPE, SIG_IGN);
@@ -49,23 +57,207 @@ static const gchar *file_state_to_str(FileState state)
     }
 }
 
-// received path from notify server with the path to item which state was changed
-void mega_ext_on_item_changed(MEGAExt *mega_ext, const gchar *path)
+// file info update waiting to be resolved in the next batch.
+// Updates without a closure come from the notify server
+typedef struct {
+    NemoFileInfo *file;
+    GClosure *update_complete;
+    gchar *path;
+    gboolean cancelled;
+} MEGAExtPendingUpdate;
+
+static void mega_ext_pending_update_free(MEGAExtPendingUpdate *update)
+{
+    g_object_unref(update->file);
+    if (update->update_complete)
+        g_closure_unref(update->update_complete);
+    g_free(update->path);
+    g_free(update);
+}
+
+static void mega_ext_set_state_emblem(NemoFileInfo *file, FileState state)
+{
+    // reset
+    nemo_file_info_invalidate_extension_info(file);
+
+    switch (state)
+    {
+        case FILE_SYNCED:
+            nemo_file_info_add_emblem(file, "mega-nemosynced");
+            break;
+        case FILE_PENDING:
+            nemo_file_info_add_emblem(file, "mega-nemopending");
+            break;
+        case FILE_SYNCING:
+            nemo_file_info_add_emblem(file, "mega-nemosyncing");
+            break;
+        default:
+            break;
+    }
+}
+
+static gboolean mega_ext_flush_pending_updates(gpointer user_data);
+
+// states of all the files requested in the same main loop iteration are resolved together
+static MEGAExtPendingUpdate *mega_ext_queue_update(MEGAExt *mega_ext, NemoFileInfo *file,
+                                                   GClosure *update_complete, gchar *path)
+{
+    MEGAExtPendingUpdate *update;
+
+    update = g_new0(MEGAExtPendingUpdate, 1);
+    update->file = g_object_ref(file);
+    update->update_complete = update_complete ? g_closure_ref(update_complete) : NULL;
+    update->path = path;
+    update->cancelled = FALSE;
+
+    mega_ext->pending_updates = g_list_prepend(mega_ext->pending_updates, update);
+    if (!mega_ext->pending_source)
+    {
+        mega_ext->pending_source = g_idle_add(mega_ext_flush_pending_updates, mega_ext);
+    }
+    return update;
+}
+
+// resolve all the file info requests received since the last run with batched requests
+static gboolean mega_ext_flush_pending_updates(gpointer user_data)
+{
+    MEGAExt *mega_ext = MEGA_EXT(user_data);
+    GList *pending, *l;
+    const gchar **paths;
+    FileState *states;
+    guint num_paths, i;
+
+    pending = g_list_reverse(mega_ext->pending_updates);
+    mega_ext->pending_updates = NULL;
+    mega_ext->pending_source = 0;
+
+    num_paths = g_list_length(pending);
+    paths = g_new0(const gchar *, num_paths);
+    states = g_new0(FileState, num_paths);
+    for (l = pending, i = 0; l != NULL; l = l->next, i++)
+    {
+        paths[i] = ((MEGAExtPendingUpdate *)l->data)->path;
+    }
+
+    if (!mega_ext_client_get_path_states(mega_ext, paths, num_paths, 0, states))
+    {
+        for (i = 0; i < num_paths; i++)
+        {
+            states[i] = FILE_ERROR;
+        }
+    }
+
+    for (l = pending, i = 0; l != NULL; l = l->next, i++)
+    {
+        MEGAExtPendingUpdate *update = l->data;
+        if (!update->cancelled)
+        {
+            g_debug("mega_ext_update_file_info. File: %s  State: %s", update->path, file_state_to_str(states[i]));
+            mega_ext_set_state_emblem(update->file, states[i]);
+            if (update->update_complete)
+                nemo_info_provider_update_complete_invoke(update->update_complete, (NemoInfoProvider*)mega_ext,
+                                                          (NemoOperationHandle*)update, NEMO_OPERATION_COMPLETE);
+        }
+        mega_ext_pending_update_free(update);
+    }
+
+    g_list_free(pending);
+    g_free(paths);
+    g_free(states);
+
+    return FALSE;
+}
+
+// queues the state of an item for the next batch, if the file manager has it loaded
+static gboolean mega_ext_refresh_item(MEGAExt *mega_ext, const gchar *path)
 {
     GFile *f;
+    NemoFileInfo *file;
+
     f = g_file_new_for_path(path);
-    if (!f) {
-        g_debug("No file found for %s!", path);
+    if (!f)
+        return FALSE;
+
+    file = nemo_file_info_lookup(f);
+    g_object_unref(f);
+    if (!file)
+        return FALSE;
+
+    // the new state is requested with the next batch, without blocking the main loop here
+    mega_ext_queue_update(mega_ext, file, NULL, g_strdup(path));
+    g_object_unref(file);
+    return TRUE;
+}
+
+// return TRUE if path is root or is located inside it
+static gboolean mega_ext_path_below(const gchar *path, const gchar *root)
+{
+    size_t len = strlen(root);
+
+    return !strncmp(path, root, len)
+            && (path[len] == '\0' || path[len] == '/' || (len && root[len - 1] == '/'));
+}
+
+// items shown by the file manager, whatever their cached state
+static void mega_ext_remember_item(MEGAExt *mega_ext, const gchar *path)
+{
+    // keep the memory bounded, the table is refilled as folders are shown
+    if (g_hash_table_size(mega_ext->h_shown) >= MAX_SHOWN_ITEMS
+            && !g_hash_table_contains(mega_ext->h_shown, path))
+        g_hash_table_remove_all(mega_ext->h_shown);
+
+    g_hash_table_add(mega_ext->h_shown, g_strdup(path));
+}
+
+// received path from notify server with the path to item which state was changed
+void mega_ext_on_item_changed(MEGAExt *mega_ext, const gchar *path)
+{
+    // changes notified for a sync root (e.g. the overlay icons setting was toggled)
+    // may affect everything below it
+    if (g_hash_table_contains(mega_ext->h_syncs, path))
+    {
+        mega_ext_on_subtree_changed(mega_ext, path);
         return;
     }
 
-    NemoFileInfo *file = nemo_file_info_lookup(f);
-    if (!file) {
+    mega_ext_client_invalidate_state(mega_ext, path);
+    g_debug("Item changed: %s", path);
+    if (!mega_ext_refresh_item(mega_ext, path))
         g_debug("No NemoFileInfo found for %s!", path);
-        return;
+}
+
+// received path from notify server below which the states of all the items may have changed
+// (e.g. the changes queued for this client were dropped)
+void mega_ext_on_subtree_changed(MEGAExt *mega_ext, const gchar *path)
+{
+    GHashTableIter iter;
+    gpointer key;
+    char canonical[PATH_MAX];
+
+    g_debug("Subtree changed: %s", path);
+    mega_ext_client_invalidate_subtree(mega_ext, path);
+
+    if (!g_hash_table_contains(mega_ext->h_shown, path))
+        mega_ext_refresh_item(mega_ext, path);
+
+    g_hash_table_iter_init(&iter, mega_ext->h_shown);
+    while (g_hash_table_iter_next(&iter, &key, NULL))
+    {
+        const gchar *shown = key;
+
+        // the server sends canonical paths, shown items may be reached through a symlink
+        if (!mega_ext_path_below(shown, path))
+        {
+            canonical[0] = '\0';
+            expanselocalpath(shown, canonical);
+            if (!canonical[0] || !mega_ext_path_below(canonical, path))
+                continue;
+        }
+
+        // items no longer loaded by the file manager are forgotten
+        if (!mega_ext_refresh_item(mega_ext, shown))
+            g_hash_table_iter_remove(&iter);
     }
-    g_debug("Item changed: %s", path);
-    nemo_info_provider_update_file_info((NemoInfoProvider*)mega_ext, file, (void*)1, (void*)1);
 }
 
 // user clicked on "Upload to MEGA" menu item
@@ -104,6 +296,19 @@ static void mega_ext_on_upload_selected(NemoMenuItem *item, gpointer user_data)
         mega_ext_client_end_request(mega_ext);
 }
 
+static void mega_ext_rebuild_sync_trie(MEGAExt *mega_ext)
+{
+    GHashTableIter iter;
+    gpointer sync;
+
+    mega_sync_trie_free(mega_ext->sync_trie);
+    mega_ext->sync_trie = mega_sync_trie_new();
+
+    g_hash_table_iter_init(&iter, mega_ext->h_syncs);
+    while (g_hash_table_iter_next(&iter, &sync, NULL))
+        mega_sync_trie_insert(mega_ext->sync_trie, sync);
+}
+
 void mega_ext_on_sync_add(MEGAExt *mega_ext, const gchar *path)
 {
     // ignore empty sync
@@ -111,12 +316,16 @@ void mega_ext_on_sync_add(MEGAExt *mega_ext, const gchar *path)
         return;
     g_debug("New sync path: %s", path);
     g_hash_table_insert(mega_ext->h_syncs, g_strdup(path), GINT_TO_POINTER(1));
+    mega_ext_rebuild_sync_trie(mega_ext);
+    mega_ext_client_clear_states(mega_ext);
 }
 
 void mega_ext_on_sync_del(MEGAExt *mega_ext, const gchar *path)
 {
     g_debug("Deleted sync path: %s", path);
     g_hash_table_remove(mega_ext->h_syncs, path);
+    mega_ext_rebuild_sync_trie(mega_ext);
+    mega_ext_client_clear_states(mega_ext);
 }
 
 
@@ -140,33 +349,15 @@ void expanselocalpath(char *path, char *absolutepath)
 // return TRUE if path located in one of the sync folders
 static gboolean mega_ext_path_in_sync(MEGAExt *mega_ext, const gchar *path)
 {
-    GList *l, *p;
-    gboolean found = FALSE;
-
-    l = g_hash_table_get_keys(mega_ext->h_syncs);
-    for (p = g_list_first(l); p; p = g_list_next(p)) {
-        const gchar *sync = p->data;
-        // sync must be a prefix of path
-        if (strlen(sync) <= strlen(path)) {
-            if (!strncmp(sync, path, strlen(sync))) {
-                found = TRUE;
-                break;
-            }
-        }
+    char canonical[PATH_MAX];
 
-        char canonical[PATH_MAX];
-        expanselocalpath(path,canonical);
-        if (strlen(sync) <= strlen(canonical)) {
-            if (!strncmp(sync, canonical, strlen(sync))) {
-                found = TRUE;
-                break;
-            }
-        }
-    }
+    if (mega_sync_trie_match(mega_ext->sync_trie, path))
+        return TRUE;
 
-    g_list_free(l);
-
-    return found;
+    // the path may still reach a sync folder through a symlink
+    canonical[0] = '\0';
+    expanselocalpath((char *)path, canonical);
+    return canonical[0] && strcmp(canonical, path) && mega_sync_trie_match(mega_ext->sync_trie, canonical);
 }
 
 // user clicked on "Get MEGA link" menu item
@@ -290,18 +481,30 @@ static GList *mega_ext_get_file_items(NemoMenuProvider *provider, G_GNUC_UNUSED
     GList *l, *l_out = NULL;
     int syncedFiles, syncedFolders, unsyncedFiles, unsyncedFolders;
     gchar *out = NULL;
+    FileState *states, *query_states;
+    const gchar **query_paths;
+    guint *query_index;
+    guint num_files, num_queries, i;
 
     g_debug("mega_ext_get_file_items: %u", g_list_length(files));
 
     syncedFiles = syncedFolders = unsyncedFiles = unsyncedFolders = 0;
 
-    // get list of selected objects
-    for (l = files; l != NULL; l = l->next)
+    num_files = g_list_length(files);
+    states = g_new0(FileState, num_files);
+    query_paths = g_new0(const gchar *, num_files);
+    query_states = g_new0(FileState, num_files);
+    query_index = g_new0(guint, num_files);
+    num_queries = 0;
+
+    // collect the paths of the selected objects to query their states in a single batch
+    for (l = files, i = 0; l != NULL; l = l->next, i++)
     {
         NemoFileInfo *file = NEMO_FILE_INFO(l->data);
         gchar *path;
         GFile *fp;
-        FileState state;
+
+        states[i] = FILE_ERROR;
 
         fp = nemo_file_info_get_location(file);
         if (!fp)
@@ -319,19 +522,37 @@ static GList *mega_ext_get_file_items(NemoMenuProvider *provider, G_GNUC_UNUSED
         // but make sure we received the list of synced folders first
         if (mega_ext->syncs_received && !mega_ext_path_in_sync(mega_ext, path))
         {
-            state = FILE_NOTFOUND;
+            states[i] = FILE_NOTFOUND;
+            g_free(path);
+            continue;
         }
-        else
+
+        query_paths[num_queries] = path;
+        query_index[num_queries] = i;
+        num_queries++;
+    }
+
+    if (num_queries && mega_ext_client_get_path_states(mega_ext, query_paths, num_queries, 1, query_states))
+    {
+        for (i = 0; i < num_queries; i++)
         {
-            state = mega_ext_client_get_path_state(mega_ext, path, 1);
-            if (state == FILE_NOTFOUND)
-            {
-                char canonical[PATH_MAX];
-                expanselocalpath(path,canonical);
-                state = mega_ext_client_get_path_state(mega_ext, canonical, 1);
-            }
+            states[query_index[i]] = query_states[i];
         }
-        g_free(path);
+    }
+
+    for (i = 0; i < num_queries; i++)
+    {
+        g_free((gchar *)query_paths[i]);
+    }
+    g_free(query_paths);
+    g_free(query_states);
+    g_free(query_index);
+
+    // get list of selected objects
+    for (l = files, i = 0; l != NULL; l = l->next, i++)
+    {
+        NemoFileInfo *file = NEMO_FILE_INFO(l->data);
+        FileState state = states[i];
 
         if (state == FILE_ERROR)
         {
@@ -366,6 +587,7 @@ static GList *mega_ext_get_file_items(NemoMenuProvider *provider, G_GNUC_UNUSED
             }
         }
     }
+    g_free(states);
 
 
     NemoMenuItem *root_menu_item = nemo_menu_item_new("NemoObj::root_menu_item",
@@ -454,9 +676,10 @@ static GList *mega_ext_get_file_items(NemoMenuProvider *provider, G_GNUC_UNUSED
 }
 
 static NemoOperationResult mega_ext_update_file_info(NemoInfoProvider *provider,
-    NemoFileInfo *file, G_GNUC_UNUSED GClosure *update_complete, G_GNUC_UNUSED NemoOperationHandle **handle)
+    NemoFileInfo *file, GClosure *update_complete, NemoOperationHandle **handle)
 {
     MEGAExt *mega_ext = MEGA_EXT(provider);
+    MEGAExtPendingUpdate *update;
     gchar *path;
     GFile *fp;
     FileState state;
@@ -481,42 +704,26 @@ static NemoOperationResult mega_ext_update_file_info(NemoInfoProvider *provider,
         return NEMO_OPERATION_COMPLETE;
     }
     g_debug("mega_ext_update_file_info %s", path);
+    mega_ext_remember_item(mega_ext, path);
 
-    state = mega_ext_client_get_path_state(mega_ext, path, 0);
-    if (state == FILE_NOTFOUND)
-    {
-        char canonical[PATH_MAX];
-        expanselocalpath(path,canonical);
-        state = mega_ext_client_get_path_state(mega_ext, canonical, 0);
-    }
-
-    g_debug("mega_ext_update_file_info. File: %s  State: %s", path, file_state_to_str(state));
-    g_free(path);
-
-    // reset
-    nemo_file_info_invalidate_extension_info(file);
-
-    if (state == FILE_ERROR || state == FILE_NOTFOUND)
+    if (!update_complete)
     {
+        state = mega_ext_client_get_path_state(mega_ext, path, 0);
+        g_debug("mega_ext_update_file_info. File: %s  State: %s", path, file_state_to_str(state));
+        g_free(path);
+        mega_ext_set_state_emblem(file, state);
         return NEMO_OPERATION_COMPLETE;
     }
 
-    switch (state)
-    {
-        case FILE_SYNCED:
-            nemo_file_info_add_emblem(file, "mega-nemosynced");
-            break;
-        case FILE_PENDING:
-            nemo_file_info_add_emblem(file, "mega-nemopending");
-            break;
-        case FILE_SYNCING:
-            nemo_file_info_add_emblem(file, "mega-nemosyncing");
-            break;
-        default:
-            break;
-    }
+    update = mega_ext_queue_update(mega_ext, file, update_complete, path);
+    *handle = (NemoOperationHandle*)update;
+    return NEMO_OPERATION_IN_PROGRESS;
+}
 
-    return NEMO_OPERATION_COMPLETE;
+static void mega_ext_cancel_update(G_GNUC_UNUSED NemoInfoProvider *provider, NemoOperationHandle *handle)
+{
+    MEGAExtPendingUpdate *update = (MEGAExtPendingUpdate *)handle;
+    update->cancelled = TRUE;
 }
 
 static void mega_ext_menu_provider_iface_init(NemoMenuProviderIface *iface)
@@ -527,6 +734,7 @@ static void mega_ext_menu_provider_iface_init(NemoMenuProviderIface *iface)
 static void mega_ext_info_provider_iface_init(NemoInfoProviderIface *iface)
 {
     iface->update_file_info = mega_ext_update_file_info;
+    iface->cancel_update = mega_ext_cancel_update;
 }
 
 static GType mega_ext_type = 0;
@@ -6,11 +6,13 @@ TEMPLATE = lib
 SOURCES += mega_ext_module.c \
     mega_ext_client.c \
     mega_notify_client.c \
+    mega_ext_sync_trie.c \
     MEGAShellExt.c
 
 HEADERS += MEGAShellExt.h \
     mega_ext_client.h \
-    mega_notify_client.h
+    mega_notify_client.h \
+    mega_ext_sync_trie.h
 
 CONFIG += link_pkgconfig
 PKGCONFIG += libnemo-extension
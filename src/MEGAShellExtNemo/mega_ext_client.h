@@ -5,6 +5,10 @@
 
 gchar *mega_ext_client_get_string(MEGAExt *mega_ext, int stringID, int numFiles, int numFolders);
 FileState mega_ext_client_get_path_state(MEGAExt *mega_ext, const gchar *path, int forceGetState);
+gboolean mega_ext_client_get_path_states(MEGAExt *mega_ext, const gchar **paths, guint num_paths, int forceGetState, FileState *states);
+void mega_ext_client_invalidate_state(MEGAExt *mega_ext, const gchar *path);
+void mega_ext_client_invalidate_subtree(MEGAExt *mega_ext, const gchar *path);
+void mega_ext_client_clear_states(MEGAExt *mega_ext);
 gboolean mega_ext_client_paste_link(MEGAExt *mega_ext, const gchar *path);
 gboolean mega_ext_client_upload(MEGAExt *mega_ext, const gchar *path);
 gboolean mega_ext_client_end_request(MEGAExt *mega_ext);
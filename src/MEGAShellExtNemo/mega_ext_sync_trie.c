@@ -0,0 +1,113 @@
+#include "mega_ext_sync_trie.h"
+#include <limits.h>
+#include <string.h>
+
+typedef struct _MEGASyncTrieNode MEGASyncTrieNode;
+
+struct _MEGASyncTrieNode {
+    GHashTable *children; // path component -> MEGASyncTrieNode
+    gboolean is_sync_root;
+};
+
+struct _MEGASyncTrie {
+    MEGASyncTrieNode *root;
+};
+
+static void mega_sync_trie_node_free(gpointer data)
+{
+    MEGASyncTrieNode *node = data;
+
+    g_hash_table_destroy(node->children);
+    g_free(node);
+}
+
+static MEGASyncTrieNode *mega_sync_trie_node_new(void)
+{
+    MEGASyncTrieNode *node = g_new0(MEGASyncTrieNode, 1);
+
+    node->children = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, mega_sync_trie_node_free);
+    node->is_sync_root = FALSE;
+    return node;
+}
+
+MEGASyncTrie *mega_sync_trie_new(void)
+{
+    MEGASyncTrie *trie = g_new0(MEGASyncTrie, 1);
+
+    trie->root = mega_sync_trie_node_new();
+    return trie;
+}
+
+void mega_sync_trie_free(MEGASyncTrie *trie)
+{
+    if (!trie)
+        return;
+
+    mega_sync_trie_node_free(trie->root);
+    g_free(trie);
+}
+
+void mega_sync_trie_insert(MEGASyncTrie *trie, const gchar *path)
+{
+    MEGASyncTrieNode *node = trie->root;
+    gchar **components;
+    gint i;
+
+    components = g_strsplit(path, "/", -1);
+    for (i = 0; components[i]; i++) {
+        MEGASyncTrieNode *child;
+
+        // skip the empty components of leading, trailing or repeated separators
+        if (!components[i][0])
+            continue;
+
+        child = g_hash_table_lookup(node->children, components[i]);
+        if (!child) {
+            child = mega_sync_trie_node_new();
+            g_hash_table_insert(node->children, g_strdup(components[i]), child);
+        }
+        node = child;
+    }
+    g_strfreev(components);
+
+    node->is_sync_root = TRUE;
+}
+
+// return TRUE if path is a sync root or is located inside one
+// walks the path in place, without allocations
+gboolean mega_sync_trie_match(MEGASyncTrie *trie, const gchar *path)
+{
+    MEGASyncTrieNode *node = trie->root;
+    gchar buf[PATH_MAX];
+    gchar *component, *next;
+
+    if (node->is_sync_root)
+        return TRUE;
+
+    if (g_strlcpy(buf, path, sizeof(buf)) >= sizeof(buf))
+        return FALSE;
+
+    component = buf;
+    while (*component) {
+        while (*component == '/')
+            component++;
+        if (!*component)
+            break;
+
+        next = strchr(component, '/');
+        if (next)
+            *next = '\0';
+
+        node = g_hash_table_lookup(node->children, component);
+        if (!node)
+            return FALSE;
+        if (node->is_sync_root)
+            return TRUE;
+        if (!next)
+            break;
+
+        component = next + 1;
+    }
+
+    return FALSE;
+}
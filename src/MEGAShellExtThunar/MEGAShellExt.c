@@ -276,18 +276,30 @@ static GList* mega_ext_get_file_actions(ThunarxMenuProvider *provider, G_GNUC_UN
     GList *l, *l_out = NULL;
     int syncedFiles, syncedFolders, unsyncedFiles, unsyncedFolders;
     gchar *out = NULL;
+    FileState *states, *query_states;
+    const gchar **query_paths;
+    guint *query_index;
+    guint num_files, num_queries, i;
 
     g_debug("mega_ext_get_file_items: %u", g_list_length(files));
 
     syncedFiles = syncedFolders = unsyncedFiles = unsyncedFolders = 0;
 
-    // get list of selected objects
-    for (l = files; l != NULL; l = l->next)
+    num_files = g_list_length(files);
+    states = g_new0(FileState, num_files);
+    query_paths = g_new0(const gchar *, num_files);
+    query_states = g_new0(FileState, num_files);
+    query_index = g_new0(guint, num_files);
+    num_queries = 0;
+
+    // collect the paths of the selected objects to query their states in a single batch
+    for (l = files, i = 0; l != NULL; l = l->next, i++)
     {
         ThunarxFileInfo *file = THUNARX_FILE_INFO(l->data);
         gchar *path;
         GFile *fp;
-        FileState state;
+
+        states[i] = FILE_ERROR;
 
         fp = thunarx_file_info_get_location(file);
         if (!fp)
@@ -305,19 +317,37 @@ static GList* mega_ext_get_file_actions(ThunarxMenuProvider *provider, G_GNUC_UN
         // but make sure we received the list of synced folders first
         if (mega_ext->syncs_received && !mega_ext_path_in_sync(mega_ext, path))
         {
-            state = FILE_NOTFOUND;
+            states[i] = FILE_NOTFOUND;
+            g_free(path);
+            continue;
         }
-        else
+
+        query_paths[num_queries] = path;
+        query_index[num_queries] = i;
+        num_queries++;
+    }
+
+    if (num_queries && mega_ext_client_get_path_states(mega_ext, query_paths, num_queries, 1, query_states))
+    {
+        for (i = 0; i < num_queries; i++)
         {
-            state = mega_ext_client_get_path_state(mega_ext, path, 1);
-            if (state == FILE_NOTFOUND)
-            {
-                char canonical[PATH_MAX];
-                expanselocalpath(path,canonical);
-                state = mega_ext_client_get_path_state(mega_ext, canonical, 1);
-            }
+            states[query_index[i]] = query_states[i];
         }
-        g_free(path);
+    }
+
+    for (i = 0; i < num_queries; i++)
+    {
+        g_free((gchar *)query_paths[i]);
+    }
+    g_free(query_paths);
+    g_free(query_states);
+    g_free(query_index);
+
+    // get list of selected objects
+    for (l = files, i = 0; l != NULL; l = l->next, i++)
+    {
+        ThunarxFileInfo *file = THUNARX_FILE_INFO(l->data);
+        FileState state = states[i];
 
         if (state == FILE_ERROR)
         {
@@ -352,6 +382,7 @@ static GList* mega_ext_get_file_actions(ThunarxMenuProvider *provider, G_GNUC_UN
             }
         }
     }
+    g_free(states);
     // if there any unsynced files / folders selected
     if (unsyncedFiles || unsyncedFolders)
     {
@@ -5,6 +5,7 @@
 #include <string.h>
 
 const gchar OP_PATH_STATE  = 'P'; //Path state
+const gchar OP_PATH_STATES = 'B'; //Batch of path states
 const gchar OP_INIT        = 'I'; //Init operation
 const gchar OP_END         = 'E'; //End operation
 const gchar OP_UPLOAD      = 'F'; //File-Folder upload
@@ -15,6 +16,9 @@ const gchar OP_STRING      = 'T'; //Get Translated String
 const gchar OP_VIEW        = 'V'; //View on MEGA
 const gchar OP_PREVIOUS    = 'R'; //View previous versions
 
+// max number of paths sent in a single batch request
+#define MAX_PATHS_PER_BATCH 256
+
 static void mega_ext_client_disconnect(MEGAExt *mega_ext);
 
 // try to connect to the server
@@ -179,6 +183,55 @@ FileState mega_ext_client_get_path_state(MEGAExt *mega_ext, const gchar *path, i
     return st;
 }
 
+// query the state of several paths with one round trip per MAX_PATHS_PER_BATCH paths
+// request:  B:<force>0x1C<path>0x1D<path>...\n
+// response: one state digit per path
+// return FALSE if any of the requests failed
+gboolean mega_ext_client_get_path_states(MEGAExt *mega_ext, const gchar **paths, guint num_paths, int forceGetState, FileState *states)
+{
+    guint first, i, count;
+    gchar *out;
+    GString *in;
+    gint64 start_time;
+
+    start_time = g_get_monotonic_time();
+    for (first = 0; first < num_paths; first += MAX_PATHS_PER_BATCH) {
+        count = MIN(num_paths - first, MAX_PATHS_PER_BATCH);
+
+        in = g_string_sized_new(count * 64);
+        g_string_append_c(in, forceGetState ? '1' : '0');
+        g_string_append_c(in, (char)0x1C);
+        for (i = 0; i < count; i++) {
+            char canonical[PATH_MAX];
+            expanselocalpath((gchar *)paths[first + i], canonical);
+            if (i)
+                g_string_append_c(in, (char)0x1D);
+            g_string_append(in, canonical);
+        }
+        g_string_append_c(in, '\n');
+
+        out = mega_ext_client_send_request(mega_ext, OP_PATH_STATES, in->str);
+        g_string_free(in, TRUE);
+
+        if (!out)
+            return FALSE;
+
+        if (strlen(out) != count) {
+            g_warning("Unexpected batch response size: %u (expected %u)", (guint)strlen(out), count);
+            g_free(out);
+            return FALSE;
+        }
+
+        for (i = 0; i < count; i++)
+            states[first + i] = out[i] - '0';
+        g_free(out);
+    }
+
+    g_debug("Batch of %u path states resolved in %" G_GINT64_FORMAT " us", num_paths, g_get_monotonic_time() - start_time);
+
+    return TRUE;
+}
+
 gboolean mega_ext_client_paste_link(MEGAExt *mega_ext, const gchar *path)
 {
     gchar *out;
@@ -220,7 +220,7 @@ MegaApplication::MegaApplication(int &argc, char **argv) :
     syncsMenu = NULL;
     menuSignalMapper = NULL;
     megaApi = NULL;
-    megaApiFolders = NULL;
+    maxPayloadLogSize = 0;
     delegateListener = NULL;
     httpServer = NULL;
     httpsServer = NULL;
@@ -326,6 +326,7 @@ MegaApplication::MegaApplication(int &argc, char **argv) :
     lastTsBusinessWarning = 0;
     lastTsErrorMessageShown = 0;
     maxMemoryUsage = 0;
+    memoryGrowthReported = false;
     nUnviewedTransfers = 0;
     completedTabActive = false;
     nodescurrent = false;
@@ -473,8 +474,6 @@ void MegaApplication::initialize()
     megaApi = new MegaApi(Preferences::CLIENT_KEY, basePath.toUtf8().constData(), Preferences::USER_AGENT, MacXPlatform::fd);
 #endif
 
-    megaApiFolders = new MegaApi(Preferences::CLIENT_KEY, basePath.toUtf8().constData(), Preferences::USER_AGENT);
-
     //Set payload max size to be logged: a 10th of system's memory
     long long availMemory = Utilities::getSystemsAvailableMemory();
     auto newPayLoadLogSize = availMemory / 10 ;
@@ -484,7 +483,7 @@ void MegaApplication::initialize()
     }
     megaApi->log(MegaApi::LOG_LEVEL_INFO, QString::fromUtf8("Establishing max payload log size: %1").arg(newPayLoadLogSize).toUtf8().constData());
     megaApi->setMaxPayloadLogSize(newPayLoadLogSize);
-    megaApiFolders->setMaxPayloadLogSize(newPayLoadLogSize);
+    maxPayloadLogSize = newPayLoadLogSize;
 
 
     controller = Controller::instance();
@@ -499,7 +498,7 @@ void MegaApplication::initialize()
         QString apiURL = settings.value(QString::fromUtf8("apiurl"), QString::fromUtf8("https://staging.api.mega.co.nz/")).toString();
         QString disablepkp = settings.value(QString::fromUtf8("disablepkp"), QString::fromUtf8("0")).toString();
         megaApi->changeApiUrl(apiURL.toUtf8(), disablepkp == QString::fromUtf8("1"));
-        megaApiFolders->changeApiUrl(apiURL.toUtf8());
+        stagingApiUrl = apiURL;
         QMegaMessageBox::warning(nullptr, QString::fromUtf8("MEGAsync"), QString::fromUtf8("API URL changed to ")+ apiURL);
 
         QString baseURL = settings.value(QString::fromUtf8("baseurl"), Preferences::BASE_URL).toString();
@@ -514,13 +513,13 @@ void MegaApplication::initialize()
         Preferences::overridePreferences(settings);
         Preferences::SDK_ID.append(QString::fromUtf8(" - STAGING"));
     }
+    finishedTransfers.setCapacity(Preferences::MAX_COMPLETED_ITEMS);
     trayIcon->show();
 
     megaApi->log(MegaApi::LOG_LEVEL_INFO, QString::fromUtf8("MEGAsync is starting. Version string: %1   Version code: %2.%3   User-Agent: %4").arg(Preferences::VERSION_STRING)
              .arg(Preferences::VERSION_CODE).arg(Preferences::BUILD_ID).arg(QString::fromUtf8(megaApi->getUserAgent())).toUtf8().constData());
 
     megaApi->setLanguage(currentLanguageCode.toUtf8().constData());
-    megaApiFolders->setLanguage(currentLanguageCode.toUtf8().constData());
     megaApi->setDownloadMethod(preferences->transferDownloadMethod());
     megaApi->setUploadMethod(preferences->transferUploadMethod());
     setMaxConnections(MegaTransfer::TYPE_UPLOAD,   preferences->parallelUploadConnections());
@@ -535,8 +534,11 @@ void MegaApplication::initialize()
     delegateListener = new MEGASyncDelegateListener(megaApi, this, this);
     megaApi->addListener(delegateListener);
     uploader = new MegaUploader(megaApi);
+    connect(uploader, SIGNAL(localCopyProgress(unsigned long long, int, int)), this, SLOT(onLocalCopyProgress(unsigned long long, int, int)), Qt::QueuedConnection);
+    connect(uploader, SIGNAL(localCopyFinished(unsigned long long, bool, bool)), this, SLOT(onLocalCopyFinished(unsigned long long, bool, bool)), Qt::QueuedConnection);
     downloader = new MegaDownloader(megaApi);
     connect(downloader, SIGNAL(finishedTransfers(unsigned long long)), this, SLOT(showNotificationFinishedTransfers(unsigned long long)), Qt::QueuedConnection);
+    connect(downloader, SIGNAL(downloadQueueProgress(unsigned long long, int, int)), this, SLOT(onDownloadQueueProgress(unsigned long long, int, int)), Qt::QueuedConnection);
 
 
     connectivityTimer = new QTimer(this);
@@ -1556,7 +1558,7 @@ void MegaApplication::processUploadQueue(MegaHandle nodeHandle)
 
     unsigned long long transferId = preferences->transferIdentifier();
     TransferMetaData* data = new TransferMetaData(MegaTransfer::TYPE_UPLOAD, uploadQueue.size(), uploadQueue.size());
-    transferAppData.insert(transferId, data);
+    addTransferAppData(transferId, data);
     preferences->setOverStorageDismissExecution(0);
 
     //Process the upload queue using the MegaUploader object
@@ -1617,11 +1619,10 @@ void MegaApplication::processDownloadQueue(QString path)
     TransferMetaData *transferData =  new TransferMetaData(MegaTransfer::TYPE_DOWNLOAD,
                                                            downloadQueue.size(),
                                                            downloadQueue.size());
-    transferAppData.insert(transferId, transferData);
+    addTransferAppData(transferId, transferData);
     if (!downloader->processDownloadQueue(&downloadQueue, path, transferId))
     {
-        transferAppData.remove(transferId);
-        delete transferData;
+        removeTransferAppData(transferId);
     }
 }
 
@@ -1983,6 +1984,7 @@ void MegaApplication::checkMemoryUsage()
     long long totalNodes = numNodes + numLocalNodes;
     long long totalTransfers =  megaApi->getNumPendingUploads() + megaApi->getNumPendingDownloads();
     long long procesUsage = 0;
+    MemorySampler::Usage usage;
 
     if (!totalNodes)
     {
@@ -1996,6 +1998,8 @@ void MegaApplication::checkMemoryUsage()
         return;
     }
     procesUsage = pmc.PrivateUsage;
+    usage.residentBytes = pmc.WorkingSetSize;
+    usage.anonymousBytes = pmc.PrivateUsage;
 #else
     #ifdef __APPLE__
         struct task_basic_info t_info;
@@ -2006,11 +2010,18 @@ void MegaApplication::checkMemoryUsage()
                                       &t_info_count))
         {
             procesUsage = t_info.resident_size;
+            usage.residentBytes = t_info.resident_size;
         }
         else
         {
             return;
         }
+    #else
+        if (!MemorySampler::readProcessUsage(usage))
+        {
+            return;
+        }
+        procesUsage = usage.trackedBytes();
     #endif
 #endif
 
@@ -2021,6 +2032,23 @@ void MegaApplication::checkMemoryUsage()
                  .arg((float)procesUsage / totalNodes)
                  .arg(totalTransfers).toUtf8().constData());
 
+    memorySampler.addSample(QDateTime::currentMSecsSinceEpoch(), usage, totalNodes);
+    bool growing = memorySampler.isGrowing();
+    MegaApi::log(MegaApi::LOG_LEVEL_DEBUG,
+                 QString::fromUtf8("Memory trend: RSS %1 MB / PSS %2 MB / anonymous %3 MB / %4% B/N growth over %5 samples")
+                 .arg(usage.residentBytes / (1024 * 1024))
+                 .arg(usage.proportionalBytes / (1024 * 1024))
+                 .arg(usage.anonymousBytes / (1024 * 1024))
+                 .arg(memorySampler.getGrowth() * 100, 0, 'f', 1)
+                 .arg(memorySampler.getSamples().size()).toUtf8().constData());
+    if (growing && !memoryGrowthReported)
+    {
+        MegaApi::log(MegaApi::LOG_LEVEL_WARNING,
+                     QString::fromUtf8("Sustained memory growth per node. Latest samples:\n%1")
+                     .arg(memorySampler.describe(MemorySampler::MIN_TREND_SAMPLES)).toUtf8().constData());
+    }
+    memoryGrowthReported = growing;
+
     if (procesUsage > maxMemoryUsage)
     {
         maxMemoryUsage = procesUsage;
@@ -2222,7 +2250,7 @@ void MegaApplication::periodicTasks()
             }
 
             checkMemoryUsage();
-            mThreadPool->push([=]()
+            mThreadPool->submit([=]()
             {//thread pool function
                 megaApi->update();
 
@@ -2232,7 +2260,7 @@ void MegaApplication::periodicTasks()
                     transferQuota->checkQuotaAndAlerts();
                 });//end of queued function
 
-            });// end of thread pool function
+            }, ThreadPool::Priority::HOUSEKEEPING);// end of thread pool function
         }
 
         onGlobalSyncStateChanged(megaApi);
@@ -2334,10 +2362,11 @@ void MegaApplication::cleanAll()
     delete megaApi;
     megaApi = NULL;
 
-    delete megaApiFolders;
-    megaApiFolders = NULL;
+    qDeleteAll(megaApiFolders);
+    megaApiFolders.clear();
 
     preferences->setLastExit(QDateTime::currentMSecsSinceEpoch());
+    preferences->flush();
     trayIcon->deleteLater();
     trayIcon = NULL;
 
@@ -2908,6 +2937,16 @@ TransferMetaData* MegaApplication::getTransferAppData(unsigned long long appData
     return value;
 }
 
+void MegaApplication::addTransferAppData(unsigned long long appDataID, TransferMetaData *data)
+{
+    transferAppData.insert(appDataID, data);
+}
+
+void MegaApplication::removeTransferAppData(unsigned long long appDataID)
+{
+    delete transferAppData.take(appDataID);
+}
+
 void MegaApplication::renewLocalSSLcert()
 {
     if (!updatingSSLcert)
@@ -3241,7 +3280,10 @@ void MegaApplication::unlink(bool keepLogs)
     mQueringWhyAmIBlocked = false;
     whyamiblockedPeriodicPetition = false;
     megaApi->logout(true, nullptr);
-    megaApiFolders->setAccountAuth(nullptr);
+    for (MegaApi *api : megaApiFolders)
+    {
+        api->setAccountAuth(nullptr);
+    }
     Platform::notifyAllSyncFoldersRemoved();
 
     for (unsigned i = 3; i--; )
@@ -3520,6 +3562,30 @@ void MegaApplication::stopUpdateTask()
     }
 }
 
+QList<MegaApi *> MegaApplication::getMegaApiFolders()
+{
+    if (megaApiFolders.isEmpty() && megaApi)
+    {
+        QString basePath = QDir::toNativeSeparators(dataPath + QString::fromUtf8("/"));
+        for (int i = 0; i < LinkProcessor::FOLDER_API_POOL_SIZE; i++)
+        {
+            MegaApi *api = new MegaApi(Preferences::CLIENT_KEY, basePath.toUtf8().constData(), Preferences::USER_AGENT);
+            api->setMaxPayloadLogSize(maxPayloadLogSize);
+            if (!stagingApiUrl.isEmpty())
+            {
+                api->changeApiUrl(stagingApiUrl.toUtf8());
+            }
+            api->setLanguage(currentLanguageCode.toUtf8().constData());
+            if (appliedProxySettings)
+            {
+                api->setProxySettings(appliedProxySettings.get());
+            }
+            megaApiFolders.append(api);
+        }
+    }
+    return megaApiFolders;
+}
+
 void MegaApplication::applyProxySettings()
 {
     if (appfinished)
@@ -3582,11 +3648,17 @@ void MegaApplication::applyProxySettings()
     }
 
     megaApi->setProxySettings(proxySettings);
-    megaApiFolders->setProxySettings(proxySettings);
-    delete proxySettings;
+    for (MegaApi *api : megaApiFolders)
+    {
+        api->setProxySettings(proxySettings);
+    }
+    appliedProxySettings.reset(proxySettings);
     QNetworkProxy::setApplicationProxy(proxy);
     megaApi->retryPendingConnections(true, true);
-    megaApiFolders->retryPendingConnections(true, true);
+    for (MegaApi *api : megaApiFolders)
+    {
+        api->retryPendingConnections(true, true);
+    }
 }
 
 void MegaApplication::showUpdatedMessage(int lastVersion)
@@ -3816,6 +3888,46 @@ int MegaApplication::getPrevVersion()
     return prevVersion;
 }
 
+void MegaApplication::onLocalCopyProgress(unsigned long long appDataID, int filesCopied, int filesQueued)
+{
+    TransferMetaData *data = getTransferAppData(appDataID);
+    if (data)
+    {
+        data->localFilesCopied = filesCopied;
+        data->localFilesQueued = filesQueued;
+    }
+}
+
+void MegaApplication::onDownloadQueueProgress(unsigned long long appDataID, int processed, int total)
+{
+    Q_UNUSED(total)
+    TransferMetaData *data = getTransferAppData(appDataID);
+    if (data)
+    {
+        data->queuedDownloads = processed;
+    }
+}
+
+void MegaApplication::onLocalCopyFinished(unsigned long long appDataID, bool isFolder, bool success)
+{
+    TransferMetaData *data = getTransferAppData(appDataID);
+    if (!data)
+    {
+        return;
+    }
+
+    if (!success)
+    {
+        data->transfersFailed++;
+    }
+    else
+    {
+        isFolder ? data->transfersFolderOK++ : data->transfersFileOK++;
+    }
+    data->pendingTransfers--;
+    showNotificationFinishedTransfers(appDataID);
+}
+
 void MegaApplication::showNotificationFinishedTransfers(unsigned long long appDataId)
 {
     QHash<unsigned long long, TransferMetaData*>::iterator it
@@ -4382,24 +4494,37 @@ void MegaApplication::toggleLogging()
                      .arg(Preferences::VERSION_CODE).arg(Preferences::BUILD_ID).arg(QString::fromUtf8(megaApi->getUserAgent())).toUtf8().constData());
         }
     }
+
+    if (settingsDialog)
+    {
+        settingsDialog->setDebugInfoVisible(logger->isDebug());
+    }
+}
+
+bool MegaApplication::isDebugModeEnabled()
+{
+    return logger && logger->isDebug();
+}
+
+QString MegaApplication::getDebugInfo()
+{
+    FinishedTransferHistory::Stats transferStats = finishedTransfers.getStats();
+    return QString::fromUtf8("Memory (%1% B/N growth over %2 samples%3):\n%4\n\n"
+                             "Finished transfers: %5 of %6, %7 kB in records, %8 failed kept as SDK copies")
+            .arg(memorySampler.getGrowth() * 100, 0, 'f', 1)
+            .arg(memorySampler.getSamples().size())
+            .arg(QString::fromUtf8(memorySampler.isGrowing() ? ", sustained" : ""))
+            .arg(memorySampler.describe(10))
+            .arg(transferStats.records)
+            .arg(finishedTransfers.getCapacity())
+            .arg(transferStats.recordBytes / 1024)
+            .arg(transferStats.transferCopies);
 }
 
 void MegaApplication::removeFinishedTransfer(int transferTag)
 {
-    QMap<int, MegaTransfer*>::iterator it = finishedTransfers.find(transferTag);
-    if (it != finishedTransfers.end())
+    if (finishedTransfers.remove(transferTag))
     {
-        for (QList<MegaTransfer*>::iterator it2 = finishedTransferOrder.begin(); it2 != finishedTransferOrder.end(); it2++)
-        {
-            if ((*it2)->getTag() == transferTag)
-            {
-                finishedTransferOrder.erase(it2);
-                break;
-            }
-        }
-        delete it.value();
-        finishedTransfers.erase(it);
-
         emit clearFinishedTransfer(transferTag);
 
         if (!finishedTransfers.size() && infoDialog)
@@ -4421,8 +4546,6 @@ bool MegaApplication::finishedTransfersWhileBlocked(int transferTag)
 
 void MegaApplication::removeAllFinishedTransfers()
 {
-    qDeleteAll(finishedTransfers);
-    finishedTransferOrder.clear();
     finishedTransfers.clear();
 
     emit clearAllFinishedTransfers();
@@ -4452,7 +4575,7 @@ void MegaApplication::showVerifyAccountInfo()
 
 QList<MegaTransfer*> MegaApplication::getFinishedTransfers()
 {
-    return finishedTransferOrder;
+    return finishedTransfers.getTransfers();
 }
 
 int MegaApplication::getNumUnviewedTransfers()
@@ -4462,11 +4585,7 @@ int MegaApplication::getNumUnviewedTransfers()
 
 MegaTransfer* MegaApplication::getFinishedTransferByTag(int tag)
 {
-    if (!finishedTransfers.contains(tag))
-    {
-        return NULL;
-    }
-    return finishedTransfers.value(tag);
+    return finishedTransfers.getTransfer(tag);
 }
 
 void MegaApplication::pauseTransfers()
@@ -4541,7 +4660,10 @@ void MegaApplication::importLinks()
     pasteMegaLinksDialog = NULL;
 
     //Send links to the link processor
-    LinkProcessor *linkProcessor = new LinkProcessor(linkList, megaApi, megaApiFolders);
+    LinkProcessor *linkProcessor = new LinkProcessor(linkList, megaApi, [this]()
+    {
+        return getMegaApiFolders();
+    });
 
     //Open the import dialog
     importDialog = new ImportMegaLinksDialog(megaApi, preferences, linkProcessor);
@@ -7785,8 +7907,7 @@ void MegaApplication::onTransferFinish(MegaApi* , MegaTransfer *transfer, MegaEr
 
     if (transfer->getState() == MegaTransfer::STATE_COMPLETED || transfer->getState() == MegaTransfer::STATE_FAILED)
     {
-        MegaTransfer *t = transfer->copy();
-        if (finishedTransfers.count(transfer->getTag()))
+        if (finishedTransfers.contains(transfer->getTag()))
         {
             assert(false);
             megaApi->sendEvent(AppStatsEvents::EVENT_DUP_FINISHED_TRSF,
@@ -7794,8 +7915,12 @@ void MegaApplication::onTransferFinish(MegaApi* , MegaTransfer *transfer, MegaEr
             removeFinishedTransfer(transfer->getTag());
         }
 
-        finishedTransfers.insert(transfer->getTag(), t);
-        finishedTransferOrder.push_back(t);
+        // The oldest transfer is dropped when the history is full
+        int evictedTag = finishedTransfers.add(transfer);
+        if (evictedTag != -1)
+        {
+            emit clearFinishedTransfer(evictedTag);
+        }
 
         if (!transferManager)
         {
@@ -7838,11 +7963,6 @@ void MegaApplication::onTransferFinish(MegaApi* , MegaTransfer *transfer, MegaEr
         infoDialog->onTransferFinish(megaApi, transfer, e);
     }
 
-    if (finishedTransferOrder.size() > (int)Preferences::MAX_COMPLETED_ITEMS)
-    {
-        removeFinishedTransfer(finishedTransferOrder.first()->getTag());
-    }
-
     if (e->getErrorCode() == MegaError::API_EBUSINESSPASTDUE
             && (!lastTsBusinessWarning || (QDateTime::currentMSecsSinceEpoch() - lastTsBusinessWarning) > 3000))//Notify only once within last five seconds
     {
@@ -33,6 +33,8 @@
 #include "control/MegaDownloader.h"
 #include "control/UpdateTask.h"
 #include "control/MegaSyncLogger.h"
+#include "control/MemorySampler.h"
+#include "control/FinishedTransferHistory.h"
 #include "control/ThreadPool.h"
 #include "control/MegaController.h"
 #include "control/Utilities.h"
@@ -61,7 +63,8 @@ public:
                     : transferDirection(direction), totalTransfers(total), pendingTransfers(pending),
                       localPath(path), totalFiles(0), totalFolders(0),
                       transfersFileOK(0), transfersFolderOK(0),
-                      transfersFailed(0), transfersCancelled(0){}
+                      transfersFailed(0), transfersCancelled(0),
+                      localFilesCopied(0), localFilesQueued(0), queuedDownloads(0){}
 
     int totalTransfers;
     int pendingTransfers;
@@ -71,6 +74,11 @@ public:
     int transfersFolderOK;
     int transfersFailed;
     int transfersCancelled;
+    // Files copied so far when uploading into a synced location
+    int localFilesCopied;
+    int localFilesQueued;
+    // Nodes of a download queue already handed to the SDK
+    int queuedDownloads;
     int transferDirection;
     QString localPath;
 };
@@ -156,6 +164,8 @@ public:
     void migrateSyncConfToSdk(QString email = QString());
 
     mega::MegaApi *getMegaApi() { return megaApi; }
+    // Folder link instances, created with the current settings the first time they are needed
+    QList<mega::MegaApi *> getMegaApiFolders();
     std::unique_ptr<mega::MegaApiLock> megaApiLock;
 
     void cleanLocalCaches(bool all = false);
@@ -183,6 +193,10 @@ public:
     // Create menus for the "..." menu in InfoDialog view.
     void createInfoDialogMenus();
     void toggleLogging();
+    bool isDebugModeEnabled();
+    // Shown in the settings dialog while debug mode is enabled
+    QString getDebugInfo();
+    // Oldest first. The caller takes ownership of the returned transfers
     QList<mega::MegaTransfer* > getFinishedTransfers();
     int getNumUnviewedTransfers();
     void removeFinishedTransfer(int transferTag);
@@ -192,8 +206,12 @@ public:
     void removeFinishedBlockedTransfer(int transferTag);
     bool finishedTransfersWhileBlocked(int transferTag);
 
+    // The caller takes ownership of the returned transfer
     mega::MegaTransfer* getFinishedTransferByTag(int tag);
     TransferMetaData* getTransferAppData(unsigned long long appDataID);
+    // Takes ownership of data
+    void addTransferAppData(unsigned long long appDataID, TransferMetaData *data);
+    void removeTransferAppData(unsigned long long appDataID);
     bool notificationsAreFiltered();
     bool hasNotifications();
     bool hasNotificationsOfType(int type);
@@ -328,6 +346,9 @@ public slots:
     void notifyItemChange(QString path, int newState);
     int getPrevVersion();
     void onDismissStorageOverquota(bool overStorage);
+    void onLocalCopyProgress(unsigned long long appDataID, int filesCopied, int filesQueued);
+    void onLocalCopyFinished(unsigned long long appDataID, bool isFolder, bool success);
+    void onDownloadQueueProgress(unsigned long long appDataID, int processed, int total);
     void showNotificationFinishedTransfers(unsigned long long appDataId);
     void renewLocalSSLcert();
     void onHttpServerConnectionError();
@@ -433,7 +454,12 @@ protected:
     Model *model;
     Controller *controller;
     mega::MegaApi *megaApi;
-    mega::MegaApi *megaApiFolders;
+    // Folder link instances, used in parallel to resolve pasted folder links
+    QList<mega::MegaApi *> megaApiFolders;
+    // Settings of megaApi that the folder link instances get when created
+    long long maxPayloadLogSize;
+    QString stagingApiUrl;
+    std::unique_ptr<mega::MegaProxy> appliedProxySettings;
     QFilterAlertsModel *notificationsProxyModel;
     QAlertsModel *notificationsModel;
     MegaAlertDelegate *notificationsDelegate;
@@ -476,6 +502,8 @@ protected:
     bool getUserDataRequestReady;
     long long receivedStorageSum;
     long long maxMemoryUsage;
+    MemorySampler memorySampler;
+    bool memoryGrowthReported;
     int exportOps;
     int syncState;
     std::shared_ptr<mega::MegaPricing> mPricing;
@@ -513,8 +541,7 @@ protected:
     QMap<QString, QString> pendingLinks;
     std::unique_ptr<MegaSyncLogger> logger;
     QPointer<TransferManager> transferManager;
-    QMap<int, mega::MegaTransfer*> finishedTransfers;
-    QList<mega::MegaTransfer*> finishedTransferOrder;
+    FinishedTransferHistory finishedTransfers;
     QSet<int> finishedBlockedTransfers;
 
     QHash<unsigned long long, TransferMetaData*> transferAppData;
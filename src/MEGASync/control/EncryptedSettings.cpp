@@ -1,14 +1,47 @@
 #include "EncryptedSettings.h"
 #include "platform/Platform.h"
+#include "Utilities.h"
+#include "ThreadPool.h"
+
+#include <QEvent>
+#include <QTimer>
+
+const int EncryptedSettings::FLUSH_DELAY_MS = 2000;
+
+namespace
+{
+// QSettings syncs itself from the thread that owns it after a change.
+// This one is only synced by flush(), from the thread that writes it.
+class FlushSettings : public QSettings
+{
+public:
+    FlushSettings(const QString &file) : QSettings(file, QSettings::IniFormat) {}
+
+protected:
+    bool event(QEvent *event) override
+    {
+        if (event->type() == QEvent::UpdateRequest)
+        {
+            return true;
+        }
+        return QSettings::event(event);
+    }
+};
+}
 
 EncryptedSettings::EncryptedSettings(QString file) :
     QSettings(file, QSettings::IniFormat)
 {
+    mFlushSettings.reset(new FlushSettings(file));
+    mFlushGuard = std::make_shared<FlushGuard>();
+    mFlushGuard->settings = this;
+
 #ifdef _WIN32
     // On Win, LocalStorageKey can change after an OS update, so don't fetch it every time from the OS.
     // Use the cached one if available, and only get it from the OS if not.
+    // The key is read and written directly, it doesn't go through the in-memory values.
     QString keyTag = QString::fromUtf8("LocalStorageKey");
-    encryptionKey = QByteArray::fromHex(value(keyTag).toByteArray());
+    encryptionKey = QByteArray::fromHex(decrypt(keyTag, QSettings::value(hash(keyTag)).toString()).toUtf8());
     if (!encryptionKey.isEmpty())
         return;
 #endif
@@ -24,19 +57,58 @@ EncryptedSettings::EncryptedSettings(QString file) :
     // Cache LocalStorageKey
     auto bkp = encryptionKey;
     encryptionKey.clear(); // switch to no key internally when caching the OS one
-    setValue(keyTag, bkp.toHex());
+    QSettings::setValue(hash(keyTag), encrypt(keyTag, QString::fromUtf8(bkp.toHex())));
     encryptionKey = bkp; // switch back to the real encryptionKey
 #endif
 }
 
+EncryptedSettings::~EncryptedSettings()
+{
+    {
+        QMutexLocker guardLocker(&mFlushGuard->mutex);
+        mFlushGuard->settings = nullptr;
+    }
+    flush();
+}
+
 void EncryptedSettings::setValue(const QString &key, const QVariant &value)
 {
-    QSettings::setValue(hash(key), encrypt(key, value.toString()));
+    QString currentGroup = QSettings::group();
+    QString stringValue = value.toString();
+    {
+        QWriteLocker locker(&mValuesLock);
+        mValues[currentGroup][key] = QVariant(stringValue);
+        mPendingValues[currentGroup][key] = stringValue;
+    }
+    scheduleFlush();
 }
 
 QVariant EncryptedSettings::value(const QString &key, const QVariant &defaultValue)
 {
-    return QVariant(decrypt(key, QSettings::value(hash(key), encrypt(key, defaultValue.toString())).toString()));
+    QString currentGroup = QSettings::group();
+    {
+        QReadLocker locker(&mValuesLock);
+        auto groupIt = mValues.constFind(currentGroup);
+        if (groupIt != mValues.constEnd())
+        {
+            auto it = groupIt->constFind(key);
+            if (it != groupIt->constEnd())
+            {
+                return it->isValid() ? *it : QVariant(defaultValue.toString());
+            }
+        }
+    }
+
+    // First read of this key: decrypt it once and keep it
+    QWriteLocker locker(&mValuesLock);
+    QHash<QString, QVariant> &groupValues = mValues[currentGroup];
+    auto it = groupValues.constFind(key);
+    if (it == groupValues.constEnd())
+    {
+        QVariant stored = QSettings::value(hash(key));
+        it = groupValues.insert(key, stored.isValid() ? QVariant(decrypt(key, stored.toString())) : QVariant());
+    }
+    return it->isValid() ? *it : QVariant(defaultValue.toString());
 }
 
 void EncryptedSettings::beginGroup(const QString &prefix)
@@ -46,7 +118,9 @@ void EncryptedSettings::beginGroup(const QString &prefix)
 
 void EncryptedSettings::beginGroup(int numGroup)
 {
-     QSettings::beginGroup(QSettings::childGroups().at(numGroup));
+    QMutexLocker flushLocker(&mFlushMutex);
+    writePendingValues();
+    QSettings::beginGroup(QSettings::childGroups().at(numGroup));
 }
 
 void EncryptedSettings::endGroup()
@@ -56,11 +130,15 @@ void EncryptedSettings::endGroup()
 
 int EncryptedSettings::numChildGroups()
 {
+    QMutexLocker flushLocker(&mFlushMutex);
+    writePendingValues();
     return QSettings::childGroups().size();
 }
 
 bool EncryptedSettings::containsGroup(QString groupName)
 {
+    QMutexLocker flushLocker(&mFlushMutex);
+    writePendingValues();
     return QSettings::childGroups().contains(hash(groupName));
 }
 
@@ -71,6 +149,8 @@ bool EncryptedSettings::isGroupEmpty()
 
 void EncryptedSettings::remove(const QString &key)
 {
+    QMutexLocker flushLocker(&mFlushMutex);
+    forget(key);
     if (!key.length())
     {
         QSettings::remove(QString::fromAscii(""));
@@ -79,11 +159,21 @@ void EncryptedSettings::remove(const QString &key)
     {
         QSettings::remove(hash(key));
     }
+    mSyncPending = true;
+    scheduleFlush();
 }
 
 void EncryptedSettings::clear()
 {
+    QMutexLocker flushLocker(&mFlushMutex);
+    {
+        QWriteLocker locker(&mValuesLock);
+        mValues.clear();
+        mPendingValues.clear();
+    }
     QSettings::clear();
+    mSyncPending = true;
+    scheduleFlush();
 }
 
 void EncryptedSettings::sync()
@@ -94,11 +184,103 @@ void EncryptedSettings::sync()
     }
     else
     {
-        QSettings::sync();
         mSyncDeferred = false;
+        mSyncPending = true;
+        scheduleFlush();
+    }
+}
+
+void EncryptedSettings::flush()
+{
+    QMutexLocker flushLocker(&mFlushMutex);
+    mFlushScheduled = false;
+    writePendingValues();
+    if (!mSyncPending.exchange(false))
+    {
+        return;
+    }
+
+    // Instances of the same file share their data, this also writes the changes made through this one
+    mFlushSettings->sync();
+
+    QFile::remove(this->fileName().append(QString::fromUtf8(".bak")));
+    QFile::copy(this->fileName(), this->fileName().append(QString::fromUtf8(".bak")));
+}
 
-        QFile::remove(this->fileName().append(QString::fromUtf8(".bak")));
-        QFile::copy(this->fileName(), this->fileName().append(QString::fromUtf8(".bak")));
+void EncryptedSettings::scheduleFlush()
+{
+    if (mFlushScheduled.exchange(true))
+    {
+        return;
+    }
+
+    // Changes made meanwhile are written by the same flush
+    std::shared_ptr<FlushGuard> guard = mFlushGuard;
+    Utilities::queueFunctionInAppThread([guard]()
+    {
+        QTimer::singleShot(FLUSH_DELAY_MS, [guard]()
+        {
+            ThreadPoolSingleton::getInstance()->submit([guard]()
+            {
+                QMutexLocker guardLocker(&guard->mutex);
+                if (guard->settings)
+                {
+                    guard->settings->flush();
+                }
+            }, ThreadPool::Priority::HOUSEKEEPING);
+        });
+    });
+}
+
+void EncryptedSettings::writePendingValues()
+{
+    QHash<QString, QHash<QString, QString>> pendingValues;
+    {
+        QWriteLocker locker(&mValuesLock);
+        pendingValues.swap(mPendingValues);
+    }
+
+    for (auto groupIt = pendingValues.cbegin(); groupIt != pendingValues.cend(); ++groupIt)
+    {
+        const QString &valuesGroup = groupIt.key();
+        QString prefix = valuesGroup.isEmpty() ? QString() : valuesGroup + QString::fromUtf8("/");
+        for (auto it = groupIt->cbegin(); it != groupIt->cend(); ++it)
+        {
+            mFlushSettings->setValue(prefix + hash(it.key(), valuesGroup), encrypt(it.key(), it.value(), valuesGroup));
+        }
+    }
+
+    if (!pendingValues.isEmpty())
+    {
+        mSyncPending = true;
+    }
+}
+
+void EncryptedSettings::forget(const QString &key)
+{
+    QString currentGroup = QSettings::group();
+    QString removedGroup = currentGroup;
+    QWriteLocker locker(&mValuesLock);
+    if (key.length())
+    {
+        mValues[currentGroup].remove(key);
+        mPendingValues[currentGroup].remove(key);
+        removedGroup = (currentGroup.isEmpty() ? QString() : currentGroup + QString::fromUtf8("/")) + hash(key);
+    }
+
+    // Everything below the removed group goes away too
+    auto isRemoved = [&removedGroup](const QString &valuesGroup)
+    {
+        return removedGroup.isEmpty() || valuesGroup == removedGroup
+                || valuesGroup.startsWith(removedGroup + QString::fromUtf8("/"));
+    };
+    for (auto it = mValues.begin(); it != mValues.end();)
+    {
+        it = isRemoved(it.key()) ? mValues.erase(it) : it + 1;
+    }
+    for (auto it = mPendingValues.begin(); it != mPendingValues.end();)
+    {
+        it = isRemoved(it.key()) ? mPendingValues.erase(it) : it + 1;
     }
 }
 
@@ -143,15 +325,20 @@ QByteArray EncryptedSettings::XOR(const QByteArray& key, const QByteArray& data)
 }
 
 QString EncryptedSettings::encrypt(const QString key, const QString value) const
+{
+    return encrypt(key, value, group());
+}
+
+QString EncryptedSettings::encrypt(const QString key, const QString value, const QString &group) const
 {
     if (value.isEmpty())
     {
         return value;
     }
 
-    QByteArray k = hash(key).toAscii();
+    QByteArray k = hash(key, group).toAscii();
     QByteArray xValue = XOR(k, value.toUtf8());
-    QByteArray xKey = XOR(k, group().toAscii());
+    QByteArray xKey = XOR(k, group.toAscii());
     QByteArray xEncrypted = XOR(k, Platform::encrypt(xValue, xKey));
     return QString::fromAscii(xEncrypted.toBase64());
 }
@@ -172,7 +359,12 @@ QString EncryptedSettings::decrypt(const QString key, const QString value) const
 
 QString EncryptedSettings::hash(const QString key) const
 {
-    QByteArray xPath = XOR(encryptionKey, (key+group()).toUtf8());
+    return hash(key, group());
+}
+
+QString EncryptedSettings::hash(const QString key, const QString &group) const
+{
+    QByteArray xPath = XOR(encryptionKey, (key+group).toUtf8());
     QByteArray keyHash = QCryptographicHash::hash(xPath, QCryptographicHash::Sha1);
     QByteArray xKeyHash = XOR(key.toUtf8(), keyHash);
     return QString::fromAscii(xKeyHash.toHex());
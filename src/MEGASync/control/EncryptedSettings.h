@@ -5,13 +5,24 @@
 #include <QVariant>
 #include <QStringList>
 #include <QCryptographicHash>
+#include <QHash>
+#include <QMutex>
+#include <QReadWriteLock>
 
+#include <atomic>
+#include <memory>
+
+// Values are decrypted once and kept in memory. Changes are encrypted and written
+// in batches by a background flush, a while after they are made or when flush() is called.
+// Callers serialize changes of the current group (Preferences does), value() can be called
+// from several threads at once.
 class EncryptedSettings : protected QSettings
 {
     Q_OBJECT
 
 public:
     explicit EncryptedSettings(QString file);
+    ~EncryptedSettings();
 
     void setValue(const QString & key, const QVariant & value);
     QVariant value(const QString & key, const QVariant & defaultValue = QVariant());
@@ -24,18 +35,50 @@ public:
     void remove(const QString & key);
     void clear();
     void sync();
+    // Writes the pending changes to disk before returning
+    void flush();
 
     void deferSyncs(bool b);  // this must receive balanced calls with true and false, as it maintains a count (to support threads).
     bool needsDeferredSync();
 
+    static const int FLUSH_DELAY_MS;
+
 protected:
     QByteArray XOR(const QByteArray &key, const QByteArray& data) const;
     QString encrypt(const QString key, const QString value) const;
+    QString encrypt(const QString key, const QString value, const QString &group) const;
     QString decrypt(const QString key, const QString value) const;
     QString hash(const QString key) const;
+    QString hash(const QString key, const QString &group) const;
+    void scheduleFlush();
+    // Makes the pending changes visible to QSettings, without writing them to disk
+    void writePendingValues();
+    void forget(const QString &key);
     QByteArray encryptionKey;
     int mDeferSyncEnableCount = 0;
     bool mSyncDeferred = false;
+
+    // Decrypted values by group and key. An invalid value means that the key isn't stored
+    QHash<QString, QHash<QString, QVariant>> mValues;
+    // Values not written yet, by group and key
+    QHash<QString, QHash<QString, QString>> mPendingValues;
+    QReadWriteLock mValuesLock;
+
+    // Writes from the flush thread, always at the root group. QSettings instances of the
+    // same file share their data
+    std::unique_ptr<QSettings> mFlushSettings;
+    QMutex mFlushMutex;
+    std::atomic<bool> mFlushScheduled{false};
+    std::atomic<bool> mSyncPending{false};
+
+    // Shared with the scheduled flushes. The destructor clears settings, waiting for a running flush,
+    // so flushes that start later do nothing
+    struct FlushGuard
+    {
+        QMutex mutex;
+        EncryptedSettings *settings;
+    };
+    std::shared_ptr<FlushGuard> mFlushGuard;
 };
 
 #endif // ENCRYPTEDSETTINGS_H
@@ -1,8 +1,15 @@
 #include "ExportProcessor.h"
+#include "ThreadPool.h"
+#include "Utilities.h"
+
+#include <QPointer>
 
 using namespace mega;
 using namespace std;
 
+// Fingerprinting reads whole files: a few at a time keep the disk busy without thrashing it
+const int ExportProcessor::MAX_PARALLEL_FINGERPRINTS = 4;
+
 ExportProcessor::ExportProcessor(MegaApi *megaApi, QStringList fileList) : QObject()
 {
     this->megaApi = megaApi;
@@ -13,6 +20,7 @@ ExportProcessor::ExportProcessor(MegaApi *megaApi, QStringList fileList) : QObje
     remainingNodes = fileList.size();
     importSuccess = 0;
     importFailed = 0;
+    runningFingerprints = 0;
 
     delegateListener = new QTMegaRequestListener(megaApi, this);
 }
@@ -27,6 +35,7 @@ ExportProcessor::ExportProcessor(MegaApi *megaApi, QList<MegaHandle> handleList)
     remainingNodes = handleList.size();
     importSuccess = 0;
     importFailed = 0;
+    runningFingerprints = 0;
 
     delegateListener = new QTMegaRequestListener(megaApi, this);
 }
@@ -39,68 +48,162 @@ ExportProcessor::~ExportProcessor()
 void ExportProcessor::requestLinks()
 {
     int size = (mode == MODE_PATHS) ? fileList.size() : handleList.size();
+    publicLinks.clear();
+    for (int i = 0; i < size; i++)
+    {
+        publicLinks.append(QString());
+    }
+
     if (!size)
     {
         emit onRequestLinksFinished();
         return;
     }
 
+    if (mode == MODE_HANDLES)
+    {
+        for (int i = 0; i < size; i++)
+        {
+            exportNode(i, megaApi->getNodeByHandle(handleList[i]));
+        }
+        return;
+    }
+
+    // Synced files are resolved in one pass, the rest need a fingerprint
     for (int i = 0; i < size; i++)
     {
-        MegaNode *node = NULL;
-        if (mode == MODE_PATHS)
+#ifdef WIN32
+        if (!fileList[i].startsWith(QString::fromAscii("\\\\")))
         {
-    #ifdef WIN32
-            if (!fileList[i].startsWith(QString::fromAscii("\\\\")))
-            {
-                fileList[i].insert(0, QString::fromAscii("\\\\?\\"));
-            }
+            fileList[i].insert(0, QString::fromAscii("\\\\?\\"));
+        }
 
-            string tmpPath((const char*)fileList[i].utf16(), fileList[i].size()*sizeof(wchar_t));
-    #else
-            string tmpPath((const char*)fileList[i].toUtf8().constData());
-    #endif
+        string tmpPath((const char*)fileList[i].utf16(), fileList[i].size()*sizeof(wchar_t));
+#else
+        string tmpPath((const char*)fileList[i].toUtf8().constData());
+#endif
 
-            node = megaApi->getSyncedNode(&tmpPath);
-            if (!node)
-            {
-                const char *fpLocal = megaApi->getFingerprint(tmpPath.c_str());
-                node = megaApi->getNodeByFingerprint(fpLocal);
-                delete [] fpLocal;
-            }
+        MegaNode *node = megaApi->getSyncedNode(&tmpPath);
+        if (node)
+        {
+            exportNode(i, node);
         }
         else
         {
-            node = megaApi->getNodeByHandle(handleList[i]);
+            pendingFingerprints.append(qMakePair(i, tmpPath));
         }
-        megaApi->exportNode(node, delegateListener);
-        delete node;
     }
+
+    fingerprintNextFiles();
 }
 
-QStringList ExportProcessor::getValidLinks()
+void ExportProcessor::fingerprintNextFiles()
 {
-    return validPublicLinks;
+    while (runningFingerprints < MAX_PARALLEL_FINGERPRINTS && !pendingFingerprints.isEmpty())
+    {
+        QPair<int, string> file = pendingFingerprints.takeFirst();
+        int index = file.first;
+        string path = file.second;
+        runningFingerprints++;
+
+        QPointer<ExportProcessor> processor(this);
+        MegaApi *api = megaApi;
+        ThreadPoolSingleton::getInstance()->submit([processor, api, index, path]()
+        {//thread pool function
+            const char *fpLocal = api->getFingerprint(path.c_str());
+            MegaNode *node = api->getNodeByFingerprint(fpLocal);
+            delete [] fpLocal;
+
+            Utilities::queueFunctionInAppThread([processor, index, node]()
+            {//queued function
+                if (processor)
+                {
+                    processor->onFingerprintNodeFound(index, node);
+                }
+                else
+                {
+                    delete node;
+                }
+            });//end of queued function
+
+        }, ThreadPool::Priority::INTERACTIVE, this);// end of thread pool function
+    }
 }
 
-void ExportProcessor::onRequestFinish(MegaApi *, MegaRequest *request, MegaError *e)
+void ExportProcessor::onFingerprintNodeFound(int index, MegaNode *node)
+{
+    runningFingerprints--;
+    exportNode(index, node);
+    fingerprintNextFiles();
+}
+
+void ExportProcessor::exportNode(int index, MegaNode *node)
+{
+    if (!node)
+    {
+        // Files without a node fail the export, as with the files that were never uploaded before
+        setLink(index, QString());
+        return;
+    }
+
+    exportsInFlight[node->getHandle()].append(index);
+    megaApi->exportNode(node, delegateListener);
+    delete node;
+}
+
+void ExportProcessor::setLink(int index, const QString &link)
 {
     currentIndex++;
     remainingNodes--;
-    if (e->getErrorCode() != MegaError::API_OK)
+    publicLinks[index] = link;
+    if (link.isEmpty())
     {
-        publicLinks.append(QString());
         importFailed++;
     }
     else
     {
-        publicLinks.append(QString::fromAscii(request->getLink()));
-        validPublicLinks.append(QString::fromAscii(request->getLink()));
         importSuccess++;
     }
 
     if (!remainingNodes)
     {
+        validPublicLinks.clear();
+        for (int i = 0; i < publicLinks.size(); i++)
+        {
+            if (!publicLinks[i].isEmpty())
+            {
+                validPublicLinks.append(publicLinks[i]);
+            }
+        }
         emit onRequestLinksFinished();
     }
 }
+
+QStringList ExportProcessor::getValidLinks()
+{
+    return validPublicLinks;
+}
+
+void ExportProcessor::onRequestFinish(MegaApi *, MegaRequest *request, MegaError *e)
+{
+    auto it = exportsInFlight.find(request->getNodeHandle());
+    if (it == exportsInFlight.end())
+    {
+        return;
+    }
+
+    int index = it.value().takeFirst();
+    if (it.value().isEmpty())
+    {
+        exportsInFlight.erase(it);
+    }
+
+    if (e->getErrorCode() != MegaError::API_OK)
+    {
+        setLink(index, QString());
+    }
+    else
+    {
+        setLink(index, QString::fromAscii(request->getLink()));
+    }
+}
@@ -2,9 +2,13 @@
 #define EXPORTPROCESSOR_H
 
 #include <QStringList>
+#include <QHash>
+#include <QPair>
 #include <megaapi.h>
 #include <QTMegaRequestListener.h>
 
+#include <string>
+
 class ExportProcessor :  public QObject, public mega::MegaRequestListener
 {
     Q_OBJECT
@@ -13,9 +17,14 @@ public:
     explicit ExportProcessor(mega::MegaApi *megaApi, QList<mega::MegaHandle> handleList);
     virtual ~ExportProcessor();
 
+    // In MODE_PATHS, synced files are exported right away and the rest are fingerprinted in the
+    // thread pool, at most MAX_PARALLEL_FINGERPRINTS at a time, and exported as each one is found.
+    // Links are kept in the order of the selection, whatever the order the exports finish in
     void requestLinks();
     QStringList getValidLinks();
 
+    static const int MAX_PARALLEL_FINGERPRINTS;
+
 signals:
     void onRequestLinksFinished();
 
@@ -28,6 +37,11 @@ protected:
         MODE_HANDLES
     };
 
+    void exportNode(int index, mega::MegaNode *node);
+    void setLink(int index, const QString &link);
+    void fingerprintNextFiles();
+    void onFingerprintNodeFound(int index, mega::MegaNode *node);
+
     mega::MegaApi *megaApi;
     QStringList fileList;
     QList<mega::MegaHandle> handleList;
@@ -38,6 +52,11 @@ protected:
     int importSuccess;
     int importFailed;
     int mode;
+    // Indexes of the files being exported, by node handle
+    QHash<mega::MegaHandle, QList<int>> exportsInFlight;
+    // Indexes and local paths (in the SDK format) of the files without a synced node
+    QList<QPair<int, std::string>> pendingFingerprints;
+    int runningFingerprints;
     mega::QTMegaRequestListener *delegateListener;
 };
 
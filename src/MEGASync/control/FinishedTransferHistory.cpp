@@ -0,0 +1,235 @@
+#include "FinishedTransferHistory.h"
+
+#include <algorithm>
+
+using namespace mega;
+
+// Read-only view of a completed transfer. Errors are left to the MegaTransfer defaults (API_OK)
+class FinishedTransferHistory::RecordTransfer : public MegaTransfer
+{
+public:
+    explicit RecordTransfer(const Record &record) : mRecord(record) {}
+
+    MegaTransfer *copy() override { return new RecordTransfer(mRecord); }
+    int getType() const override { return mRecord.type; }
+    long long getTransferredBytes() const override { return mRecord.transferredBytes; }
+    long long getTotalBytes() const override { return mRecord.totalBytes; }
+    const char *getPath() const override { return mRecord.path.isNull() ? nullptr : mRecord.path.constData(); }
+    MegaHandle getNodeHandle() const override { return mRecord.nodeHandle; }
+    MegaHandle getParentHandle() const override { return mRecord.parentHandle; }
+    const char *getFileName() const override { return mRecord.fileName.isNull() ? nullptr : mRecord.fileName.constData(); }
+    int getTag() const override { return mRecord.tag; }
+    long long getSpeed() const override { return mRecord.speed; }
+    long long getMeanSpeed() const override { return mRecord.meanSpeed; }
+    int64_t getUpdateTime() const override { return mRecord.updateTime; }
+    MegaNode *getPublicMegaNode() const override { return mRecord.publicNode ? mRecord.publicNode->copy() : nullptr; }
+    bool isSyncTransfer() const override { return mRecord.syncTransfer; }
+    bool isFinished() const override { return true; }
+    int getState() const override { return STATE_COMPLETED; }
+    unsigned long long getPriority() const override { return mRecord.priority; }
+
+private:
+    Record mRecord;
+};
+
+bool FinishedTransferHistory::Entry::isUsed() const
+{
+    return record.tag != -1;
+}
+
+void FinishedTransferHistory::setCapacity(unsigned int capacity)
+{
+    clear();
+    mSlots = std::vector<Entry>(std::max(1u, capacity));
+}
+
+unsigned int FinishedTransferHistory::getCapacity() const
+{
+    return static_cast<unsigned int>(mSlots.size());
+}
+
+int FinishedTransferHistory::add(MegaTransfer *transfer)
+{
+    if (mSlots.empty())
+    {
+        setCapacity(1);
+    }
+
+    const int tag = transfer->getTag();
+    remove(tag);
+
+    const unsigned int capacity = getCapacity();
+    if (mUsedSlots == capacity && mSlotByTag.size() < static_cast<int>(capacity))
+    {
+        // The free slots are in the middle of the ring, after removals
+        compact();
+    }
+
+    int evictedTag = -1;
+    if (mUsedSlots == capacity)
+    {
+        evictedTag = mSlots[mHead].record.tag;
+        release(mHead);
+        mHead = (mHead + 1) % capacity;
+        mUsedSlots--;
+    }
+
+    const unsigned int slot = (mHead + mUsedSlots) % capacity;
+    Entry &entry = mSlots[slot];
+    if (transfer->getState() == MegaTransfer::STATE_COMPLETED)
+    {
+        Record &record = entry.record;
+        record.type = transfer->getType();
+        record.syncTransfer = transfer->isSyncTransfer();
+        record.totalBytes = transfer->getTotalBytes();
+        record.transferredBytes = transfer->getTransferredBytes();
+        record.speed = transfer->getSpeed();
+        record.meanSpeed = transfer->getMeanSpeed();
+        record.updateTime = transfer->getUpdateTime();
+        record.priority = transfer->getPriority();
+        record.nodeHandle = transfer->getNodeHandle();
+        record.parentHandle = transfer->getParentHandle();
+        record.path = QByteArray(transfer->getPath());
+        record.fileName = QByteArray(transfer->getFileName());
+        record.publicNode.reset(transfer->getPublicMegaNode());
+    }
+    else
+    {
+        entry.failedTransfer.reset(transfer->copy());
+    }
+    entry.record.tag = tag;
+
+    mSlotByTag.insert(tag, slot);
+    mUsedSlots++;
+    return evictedTag;
+}
+
+bool FinishedTransferHistory::remove(int tag)
+{
+    auto it = mSlotByTag.constFind(tag);
+    if (it == mSlotByTag.constEnd())
+    {
+        return false;
+    }
+
+    release(it.value());
+
+    // Removed entries at both ends of the ring are reused right away
+    const unsigned int capacity = getCapacity();
+    while (mUsedSlots && !mSlots[mHead].isUsed())
+    {
+        mHead = (mHead + 1) % capacity;
+        mUsedSlots--;
+    }
+    while (mUsedSlots && !mSlots[(mHead + mUsedSlots - 1) % capacity].isUsed())
+    {
+        mUsedSlots--;
+    }
+    return true;
+}
+
+void FinishedTransferHistory::clear()
+{
+    for (Entry &entry : mSlots)
+    {
+        entry = Entry();
+    }
+    mSlotByTag.clear();
+    mHead = 0;
+    mUsedSlots = 0;
+}
+
+bool FinishedTransferHistory::contains(int tag) const
+{
+    return mSlotByTag.contains(tag);
+}
+
+int FinishedTransferHistory::size() const
+{
+    return mSlotByTag.size();
+}
+
+MegaTransfer *FinishedTransferHistory::getTransfer(int tag) const
+{
+    auto it = mSlotByTag.constFind(tag);
+    if (it == mSlotByTag.constEnd())
+    {
+        return nullptr;
+    }
+    return createTransfer(mSlots[it.value()]);
+}
+
+QList<MegaTransfer *> FinishedTransferHistory::getTransfers() const
+{
+    QList<MegaTransfer *> transfers;
+    transfers.reserve(mSlotByTag.size());
+    for (unsigned int i = 0; i < mUsedSlots; i++)
+    {
+        const Entry &entry = mSlots[(mHead + i) % getCapacity()];
+        if (entry.isUsed())
+        {
+            transfers.append(createTransfer(entry));
+        }
+    }
+    return transfers;
+}
+
+FinishedTransferHistory::Stats FinishedTransferHistory::getStats() const
+{
+    Stats stats;
+    stats.records = mSlotByTag.size();
+    stats.recordBytes = static_cast<long long>(mSlots.size() * sizeof(Entry));
+    for (const Entry &entry : mSlots)
+    {
+        if (entry.failedTransfer)
+        {
+            stats.transferCopies++;
+        }
+        stats.recordBytes += entry.record.path.capacity() + entry.record.fileName.capacity();
+    }
+    return stats;
+}
+
+MegaTransfer *FinishedTransferHistory::createTransfer(const Entry &entry) const
+{
+    if (entry.failedTransfer)
+    {
+        return entry.failedTransfer->copy();
+    }
+    return new RecordTransfer(entry.record);
+}
+
+void FinishedTransferHistory::release(unsigned int slot)
+{
+    Entry &entry = mSlots[slot];
+    if (entry.isUsed())
+    {
+        mSlotByTag.remove(entry.record.tag);
+        entry = Entry();
+    }
+}
+
+void FinishedTransferHistory::compact()
+{
+    // Moves the entries in use to the start of the ring, keeping their order
+    const unsigned int capacity = getCapacity();
+    unsigned int used = 0;
+    for (unsigned int i = 0; i < mUsedSlots; i++)
+    {
+        const unsigned int from = (mHead + i) % capacity;
+        if (!mSlots[from].isUsed())
+        {
+            continue;
+        }
+
+        const unsigned int to = (mHead + used) % capacity;
+        if (from != to)
+        {
+            mSlots[to] = std::move(mSlots[from]);
+            mSlots[from] = Entry();
+            mSlotByTag[mSlots[to].record.tag] = to;
+        }
+        used++;
+    }
+    mUsedSlots = used;
+}
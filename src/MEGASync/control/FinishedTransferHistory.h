@@ -0,0 +1,86 @@
+#pragma once
+
+#include "megaapi.h"
+
+#include <QByteArray>
+#include <QHash>
+#include <QList>
+
+#include <memory>
+#include <vector>
+
+/// Responsability: keeps the latest finished transfers, oldest first, up to a fixed capacity.
+/// Completed transfers are stored as plain records and handed out as lightweight MegaTransfer
+/// objects. Failed ones keep the SDK copy, which is needed to retry them.
+/// Entries live in a ring indexed by tag: adding, evicting and removing a transfer are O(1).
+class FinishedTransferHistory
+{
+public:
+    struct Stats
+    {
+        int records = 0;
+        // Failed transfers, stored as SDK copies
+        int transferCopies = 0;
+        // Ring slots and strings, without the SDK copies
+        long long recordBytes = 0;
+    };
+
+    // Drops the current entries
+    void setCapacity(unsigned int capacity);
+    unsigned int getCapacity() const;
+
+    // Stores a copy of a finished transfer. Returns the tag of the transfer evicted to make room for
+    // it, or -1. A transfer with the same tag is replaced
+    int add(mega::MegaTransfer *transfer);
+    bool remove(int tag);
+    void clear();
+
+    bool contains(int tag) const;
+    int size() const;
+    // The caller takes ownership of the returned transfers
+    mega::MegaTransfer *getTransfer(int tag) const;
+    QList<mega::MegaTransfer *> getTransfers() const;
+
+    Stats getStats() const;
+
+private:
+    // Only the fields read by the transfer views
+    struct Record
+    {
+        int tag = -1;
+        int type = 0;
+        bool syncTransfer = false;
+        long long totalBytes = 0;
+        long long transferredBytes = 0;
+        long long speed = 0;
+        long long meanSpeed = 0;
+        int64_t updateTime = 0;
+        unsigned long long priority = 0;
+        mega::MegaHandle nodeHandle = mega::INVALID_HANDLE;
+        mega::MegaHandle parentHandle = mega::INVALID_HANDLE;
+        QByteArray path;
+        QByteArray fileName;
+        // Only set for downloads of public links
+        std::shared_ptr<mega::MegaNode> publicNode;
+    };
+
+    struct Entry
+    {
+        Record record;
+        std::unique_ptr<mega::MegaTransfer> failedTransfer;
+
+        bool isUsed() const;
+    };
+
+    class RecordTransfer;
+
+    mega::MegaTransfer *createTransfer(const Entry &entry) const;
+    void release(unsigned int slot);
+    void compact();
+
+    std::vector<Entry> mSlots;
+    // Oldest slot, and slots in use from there including the removed ones
+    unsigned int mHead = 0;
+    unsigned int mUsedSlots = 0;
+    QHash<int, unsigned int> mSlotByTag;
+};
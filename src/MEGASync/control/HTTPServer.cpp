@@ -10,12 +10,32 @@
 using namespace mega;
 
 const unsigned int HTTPServer::MAX_REQUEST_TIME_SECS = 1800;
+const long long HTTPServer::EVENT_STREAM_HEARTBEAT_MS = 15000;
+const qint64 HTTPServer::MAX_EVENT_STREAM_BACKLOG = 256 * 1024;
+
+// Revision of the last change to webTransferStateRequests
+static quint64 transferRevision = 0;
 
 bool ts_comparator(RequestData* i, RequestData *j)
 {
     return i->tsStart < j->tsStart;
 }
 
+// Transfer state fields shared by the "t" command and the push channel
+static QString transferStateFields(RequestTransferData *tData)
+{
+    if (tData->state == MegaTransfer::STATE_NONE)
+    {
+        return QString::fromUtf8("\"s\":%1").arg(tData->state);
+    }
+
+    return QString::fromUtf8("\"s\":%1,\"p\":%2,\"t\":%3,\"v\":%4")
+            .arg(tData->state)
+            .arg(tData->progress)
+            .arg(tData->size)
+            .arg(tData->speed);
+}
+
 RequestData::RequestData()
 {
     files = -1;
@@ -34,6 +54,133 @@ RequestTransferData::RequestTransferData()
     tsStart = QDateTime::currentMSecsSinceEpoch() / 1000;
     tsEnd = -1;
     tPath = QString();
+    revision = ++transferRevision;
+}
+
+bool WebCommand::parse(const QByteArray& json)
+{
+    JsonTokenizer tokenizer(json);
+    if (tokenizer.next().type != JsonTokenizer::TokenType::OBJECT_BEGIN)
+    {
+        return false;
+    }
+
+    JsonTokenizer::Token key;
+    bool error = false;
+    while (tokenizer.nextKey(key, error))
+    {
+        JsonTokenizer::Token value = tokenizer.next();
+        if (key.equals("f") && value.type == JsonTokenizer::TokenType::ARRAY_BEGIN)
+        {
+            hasFiles = true;
+            if (!parseFiles(tokenizer))
+            {
+                return false;
+            }
+        }
+        else if (value.type == JsonTokenizer::TokenType::OBJECT_BEGIN || value.type == JsonTokenizer::TokenType::ARRAY_BEGIN)
+        {
+            if (!tokenizer.skipValue(value))
+            {
+                return false;
+            }
+        }
+        else if (value.type == JsonTokenizer::TokenType::STRING
+                 || value.type == JsonTokenizer::TokenType::NUMBER
+                 || value.type == JsonTokenizer::TokenType::LITERAL)
+        {
+            // the first occurrence wins, as with the previous text search
+            QByteArray name = QByteArray::fromRawData(key.data, key.size);
+            if (!mFields.contains(name))
+            {
+                mFields.insert(name, value);
+            }
+        }
+        else
+        {
+            return false;
+        }
+    }
+    return !error;
+}
+
+bool WebCommand::parseFiles(JsonTokenizer& tokenizer)
+{
+    while (true)
+    {
+        JsonTokenizer::Token token = tokenizer.next();
+        if (token.type == JsonTokenizer::TokenType::ARRAY_END)
+        {
+            return true;
+        }
+        if (token.type != JsonTokenizer::TokenType::OBJECT_BEGIN)
+        {
+            return false;
+        }
+
+        WebDownloadNode node;
+        JsonTokenizer::Token key;
+        bool error = false;
+        while (tokenizer.nextKey(key, error))
+        {
+            JsonTokenizer::Token value = tokenizer.next();
+            if (!value.isValid() || value.type == JsonTokenizer::TokenType::END)
+            {
+                return false;
+            }
+
+            bool isString = value.type == JsonTokenizer::TokenType::STRING;
+            if (key.equals("t"))
+            {
+                node.type = value.toLongLong();
+            }
+            else if (key.equals("h") && isString)
+            {
+                node.handle = value;
+            }
+            else if (key.equals("n") && isString)
+            {
+                node.name = value;
+            }
+            else if (key.equals("p") && isString)
+            {
+                node.parent = value;
+            }
+            else if (key.equals("k") && isString)
+            {
+                node.key = value;
+            }
+            else if (key.equals("s"))
+            {
+                node.size = value.toLongLong();
+            }
+            else if (key.equals("ts"))
+            {
+                node.mtime = value.toLongLong();
+            }
+            else if (!tokenizer.skipValue(value))
+            {
+                return false;
+            }
+        }
+
+        if (error)
+        {
+            return false;
+        }
+        files.append(node);
+    }
+}
+
+QString WebCommand::string(const char* name) const
+{
+    JsonTokenizer::Token value = mFields.value(QByteArray::fromRawData(name, int(strlen(name))));
+    return value.type == JsonTokenizer::TokenType::STRING ? value.toString() : QString();
+}
+
+long long WebCommand::number(const char* name) const
+{
+    return mFields.value(QByteArray::fromRawData(name, int(strlen(name)))).toLongLong();
 }
 
 bool HTTPServer::isFirstWebDownloadDone = false;
@@ -45,6 +192,7 @@ HTTPServer::HTTPServer(MegaApi *megaApi, quint16 port, bool sslEnabled)
 {
     this->megaApi = megaApi;
     this->sslEnabled = sslEnabled;
+    connect(&pushTimer, SIGNAL(timeout()), this, SLOT(pushTransferUpdates()));
     listen(QHostAddress::LocalHost, port);
 }
 
@@ -187,6 +335,16 @@ void HTTPServer::onUploadSelectionDiscarded()
     }
 }
 
+void HTTPServer::trackTransfer(MegaHandle handle)
+{
+    QMap<MegaHandle, RequestTransferData*>::iterator it = webTransferStateRequests.find(handle);
+    if (it != webTransferStateRequests.end())
+    {
+        delete it.value();
+    }
+    webTransferStateRequests.insert(handle, new RequestTransferData());
+}
+
 void HTTPServer::onTransferDataUpdate(MegaHandle handle, int state, long long progress, long long size, long long speed, QString localPath)
 {
     QMap<MegaHandle, RequestTransferData*>::iterator it = webTransferStateRequests.find(handle);
@@ -196,6 +354,7 @@ void HTTPServer::onTransferDataUpdate(MegaHandle handle, int state, long long pr
     }
 
     RequestTransferData* tData = it.value();
+    tData->revision = ++transferRevision;
     tData->state = state;
     tData->progress = progress;
     tData->size = size;
@@ -231,16 +390,53 @@ void HTTPServer::readClient()
         return;
     }
 
-    request->data.append(QString::fromUtf8(socket->readAll().data()));
-    if (request->data.contains(QString::fromUtf8("\r\n\r\n")))
+    if (request->keepAliveTimer)
+    {
+        request->keepAliveTimer->stop();
+    }
+    request->data.append(socket->readAll());
+
+    // On persistent connections the buffer can already hold the next request
+    QPointer<QAbstractSocket> safeSocket = socket;
+    QPointer<HTTPServer> safeServer = this;
+    while (processClientData(socket, request))
+    {
+        if (!safeServer || !safeSocket)
+        {
+            return;
+        }
+
+        request = requests.value(socket, NULL);
+        if (!request)
+        {
+            return;
+        }
+    }
+}
+
+// Processes the request once it is complete. Returns true if the connection is kept
+// alive and data of the next request is already buffered
+bool HTTPServer::processClientData(QAbstractSocket *socket, HTTPRequest *request)
+{
+    // Only the new bytes are searched for the end of the headers, and headers are parsed once
+    if (request->headerSize < 0)
     {
-        QStringList tokens = request->data.split(QString::fromUtf8("\r\n\r\n"));
-        QStringList headers = tokens[0].split(QString::fromUtf8("\r\n"));
-        if (!headers.size() || !headers[0].startsWith(QString::fromAscii("POST")))
+        int headerEnd = request->data.indexOf("\r\n\r\n", request->scanned);
+        if (headerEnd < 0)
+        {
+            request->scanned = qMax(0, request->data.size() - 3);
+            return false;
+        }
+        request->headerSize = headerEnd + 4;
+
+        QStringList headers = QString::fromUtf8(request->data.constData(), headerEnd).split(QString::fromUtf8("\r\n"));
+        bool isEventStream = headers.size() && headers[0].startsWith(QString::fromAscii("GET "))
+                && headers[0].section(QChar::fromAscii(' '), 1, 1) == QString::fromAscii("/events");
+        if (!headers.size() || (!headers[0].startsWith(QString::fromAscii("POST")) && !isEventStream))
         {
             MegaApi::log(MegaApi::LOG_LEVEL_WARNING, "Method not allowed for webclient request");
             rejectRequest(socket, QString::fromUtf8("405 Method Not Allowed"));
-            return;
+            return false;
         }
 
         if (Preferences::HTTPS_ORIGIN_CHECK_ENABLED && !Preferences::HTTPS_ALLOWED_ORIGINS.isEmpty())
@@ -270,66 +466,184 @@ void HTTPServer::readClient()
             {
                 MegaApi::log(MegaApi::LOG_LEVEL_DEBUG, "Missing or invalid Origin header");
                 rejectRequest(socket);
-                return;
+                return false;
             }
         }
 
+        if (isEventStream)
+        {
+            startEventStream(socket, request->origin);
+            return false;
+        }
+
+        // HTTP/1.1 connections are persistent unless the client closes them
+        if (headers[0].endsWith(QString::fromAscii("HTTP/1.1")))
+        {
+            request->keepAlive = headers.filter(QRegExp(QString::fromUtf8("^Connection:\\s*close"), Qt::CaseInsensitive)).isEmpty();
+        }
+        else
+        {
+            request->keepAlive = !headers.filter(QRegExp(QString::fromUtf8("^Connection:\\s*keep-alive"), Qt::CaseInsensitive)).isEmpty();
+        }
+
         QString contentLengthId = QString::fromUtf8("Content-length: ");
         QStringList contentLengthHeader = headers.filter(QRegExp(contentLengthId, Qt::CaseInsensitive));
         if (!contentLengthHeader.size())
         {
             MegaApi::log(MegaApi::LOG_LEVEL_WARNING, "Missing Content-length header");
             rejectRequest(socket);
-            return;
+            return false;
         }
 
         bool ok;
         request->contentLength = contentLengthHeader[0].mid(contentLengthId.size(), contentLengthHeader[0].size() - contentLengthId.size()).toInt(&ok);
-        if (!ok || request->contentLength < tokens[1].size())
+        if (!ok)
         {
-            if (!ok)
-            {
-                MegaApi::log(MegaApi::LOG_LEVEL_WARNING, QString::fromUtf8("Unable to parse Content-length header: %1")
-                             .arg(contentLengthHeader[0]).toUtf8().constData());
-            }
-            else
-            {
-                MegaApi::log(MegaApi::LOG_LEVEL_WARNING, QString::fromUtf8("Invalid Content-length header. Header: %1 - Data: %2")
-                             .arg(request->contentLength).arg(tokens[1].size()).toUtf8().constData());
-            }
+            MegaApi::log(MegaApi::LOG_LEVEL_WARNING, QString::fromUtf8("Unable to parse Content-length header: %1")
+                         .arg(contentLengthHeader[0]).toUtf8().constData());
             rejectRequest(socket);
-            return;
+            return false;
         }
+    }
 
-        if (request->contentLength > tokens[1].size())
-        {
-            return;
-        }
+    int bodySize = request->data.size() - request->headerSize;
+    if (request->contentLength < bodySize && !request->keepAlive)
+    {
+        MegaApi::log(MegaApi::LOG_LEVEL_WARNING, QString::fromUtf8("Invalid Content-length header. Header: %1 - Data: %2")
+                     .arg(request->contentLength).arg(bodySize).toUtf8().constData());
+        rejectRequest(socket);
+        return false;
+    }
 
-        request->data = tokens[1];
+    if (request->contentLength > bodySize)
+    {
+        return false;
+    }
 
+    // The request is taken out before processing it, so data arriving meanwhile starts the next one
+    QByteArray nextData = request->data.mid(request->headerSize + request->contentLength);
+    request->data = request->data.mid(request->headerSize, request->contentLength);
+    requests.remove(socket);
+    if (request->keepAlive)
+    {
+        HTTPRequest *nextRequest = new HTTPRequest();
+        nextRequest->data = nextData;
+        nextRequest->keepAliveTimer = request->keepAliveTimer;
+        requests.insert(socket, nextRequest);
+    }
 
-        QPointer<QAbstractSocket> safeSocket = socket;
-        QPointer<HTTPServer> safeServer = this;
-        processRequest(socket, *request);
-        if (!safeServer || !safeSocket)
+    QPointer<QAbstractSocket> safeSocket = socket;
+    QPointer<HTTPServer> safeServer = this;
+    bool keepAlive = request->keepAlive;
+    processRequest(socket, *request);
+    delete request;
+    return safeServer && safeSocket && keepAlive && !nextData.isEmpty();
+}
+
+void HTTPServer::startEventStream(QAbstractSocket *socket, const QString& origin)
+{
+    MegaApi::log(MegaApi::LOG_LEVEL_DEBUG, "Webclient subscribed to transfer updates");
+
+    // Nothing else is read from this connection
+    delete requests.take(socket);
+    disconnect(socket, SIGNAL(readyRead()), this, SLOT(readClient()));
+
+    socket->write(QString::fromUtf8("HTTP/1.1 200 OK\r\n"
+                                    "Access-Control-Allow-Origin: %1\r\n"
+                                    "Content-Type: text/event-stream\r\n"
+                                    "Cache-Control: no-cache\r\n"
+                                    "Connection: keep-alive\r\n"
+                                    "\r\n"
+                                    "retry: 3000\n\n").arg(origin).toUtf8());
+
+    // The first update has the state of every tracked transfer
+    EventClient& client = eventClients[socket];
+    sendTransferUpdates(socket, client, QDateTime::currentMSecsSinceEpoch());
+    if (!pushTimer.isActive())
+    {
+        pushTimer.start(Preferences::WEBCLIENT_PUSH_INTERVAL_MS);
+    }
+}
+
+// Updates are coalesced: each tick sends the latest state of the transfers changed since the previous one
+void HTTPServer::pushTransferUpdates()
+{
+    long long now = QDateTime::currentMSecsSinceEpoch();
+    for (QMap<QAbstractSocket*, EventClient>::iterator it = eventClients.begin(); it != eventClients.end(); ++it)
+    {
+        sendTransferUpdates(it.key(), it.value(), now);
+    }
+}
+
+void HTTPServer::sendTransferUpdates(QAbstractSocket *socket, EventClient& client, long long now)
+{
+    // A client that doesn't keep up gets the latest state when it does
+    if (socket->state() != QAbstractSocket::ConnectedState || socket->bytesToWrite() > MAX_EVENT_STREAM_BACKLOG)
+    {
+        return;
+    }
+
+    QByteArray events;
+    if (client.revision != transferRevision)
+    {
+        for (QMap<MegaHandle, RequestTransferData*>::const_iterator it = webTransferStateRequests.constBegin();
+             it != webTransferStateRequests.constEnd(); ++it)
         {
-            return;
+            if (it.value()->revision > client.revision)
+            {
+                char *handle = MegaApi::handleToBase64(it.key());
+                events.append(QString::fromUtf8("event: t\ndata: {\"h\":\"%1\",%2}\n\n")
+                              .arg(QString::fromUtf8(handle)).arg(transferStateFields(it.value())).toUtf8());
+                delete [] handle;
+            }
         }
+        client.revision = transferRevision;
+    }
 
-        HTTPRequest *req = requests.value(socket, NULL);
-        if (request == req)
+    if (events.isEmpty())
+    {
+        if (now - client.lastWrite < EVENT_STREAM_HEARTBEAT_MS)
         {
-            requests.remove(socket);
-            delete request;
+            return;
         }
+        events = ": keep-alive\n\n";
     }
+
+    socket->write(events);
+    client.lastWrite = now;
 }
+
+void HTTPServer::restartKeepAliveTimer(QAbstractSocket *socket)
+{
+    HTTPRequest *request = requests.value(socket);
+    if (!request)
+    {
+        return;
+    }
+
+    if (!request->keepAliveTimer)
+    {
+        QTimer *timer = new QTimer(socket);
+        timer->setSingleShot(true);
+        connect(timer, &QTimer::timeout, socket, [socket]()
+        {
+            socket->disconnectFromHost();
+        });
+        request->keepAliveTimer = timer;
+    }
+    request->keepAliveTimer->start(Preferences::WEBCLIENT_KEEPALIVE_TIMEOUT_MS);
+}
+
 void HTTPServer::discardClient()
 {
     QAbstractSocket* socket = (QSslSocket*)sender();
     socket->deleteLater();
 
+    if (eventClients.remove(socket) && eventClients.isEmpty())
+    {
+        pushTimer.stop();
+    }
+
     HTTPRequest *request = requests.value(socket);
     if (request)
     {
@@ -357,22 +671,21 @@ void HTTPServer::rejectRequest(QAbstractSocket *socket, QString response)
 void HTTPServer::processRequest(QAbstractSocket *socket, HTTPRequest request)
 {
     QString response;
-    QString openLinkRequestStart(QString::fromUtf8("{\"a\":\"l\","));
-    QString externalDownloadRequestStart   = QString::fromUtf8("{\"a\":\"d\",");
-    QString externalFileUploadRequestStart = QString::fromUtf8("{\"a\":\"ufi\",");
-    QString externalFolderUploadRequestStart = QString::fromUtf8("{\"a\":\"ufo\",");
-    QString externalFolderSyncRequestStart = QString::fromUtf8("{\"a\":\"s\",");
-    QString externalFolderSyncCheckStart   = QString::fromUtf8("{\"a\":\"sp\",");
-    QString externalOpenTransferManagerStart   = QString::fromUtf8("{\"a\":\"tm\",");
-    QString externalUploadSelectionStatusStart = QString::fromUtf8("{\"a\":\"uss\",");
-    QString externalTransferQueryProgressStart = QString::fromUtf8("{\"a\":\"t\",");
-    QString externalShowInFolder = QString::fromUtf8("{\"a\":\"sf\",");
 
     QPointer<QAbstractSocket> safeSocket = socket;
     QPointer<HTTPServer> safeServer = this;
 
-    MegaApi::log(MegaApi::LOG_LEVEL_DEBUG, QString::fromUtf8("Webclient request received: %1").arg(request.data).toUtf8().constData());
-    if (request.data == QString::fromUtf8("{\"a\":\"v\"}"))
+    MegaApi::log(MegaApi::LOG_LEVEL_DEBUG, QString::fromUtf8("Webclient request received: %1").arg(QString::fromUtf8(request.data)).toUtf8().constData());
+
+    // The command is parsed once, handlers only look up its fields
+    WebCommand command;
+    QString action;
+    if (command.parse(request.data))
+    {
+        action = command.string("a");
+    }
+
+    if (action == QString::fromUtf8("v"))
     {
         MegaApi::log(MegaApi::LOG_LEVEL_DEBUG, "GetVersion command received from the webclient");
         char *myHandle = megaApi->getMyUserHandle();
@@ -388,12 +701,12 @@ void HTTPServer::processRequest(QAbstractSocket *socket, HTTPRequest request)
             delete [] myHandle;
         }
     }
-    else if (request.data.startsWith(openLinkRequestStart))
+    else if (action == QString::fromUtf8("l"))
     {
         MegaApi::log(MegaApi::LOG_LEVEL_DEBUG, "OpenLink command received from the webclient");
-        QString handle = Utilities::extractJSONString(request.data, QString::fromUtf8("h"));
-        QString key = Utilities::extractJSONString(request.data, QString::fromUtf8("k"));
-        QString auth = Utilities::extractJSONString(request.data, QString::fromUtf8("esid"));
+        QString handle = command.string("h");
+        QString key = command.string("k");
+        QString auth = command.string("esid");
 
         if (key.size() > 43)
         {
@@ -409,12 +722,7 @@ void HTTPServer::processRequest(QAbstractSocket *socket, HTTPRequest request)
             Preferences *preferences = Preferences::instance();
             QString defaultPath = preferences->downloadFolder();
             MegaHandle megaHandle = megaApi->base64ToHandle(handle.toUtf8().constData());
-            QMap<MegaHandle, RequestTransferData*>::iterator it = webTransferStateRequests.find(megaHandle);
-            if (it != webTransferStateRequests.end())
-            {
-                delete it.value();
-            }
-            webTransferStateRequests.insert(megaHandle, new RequestTransferData());
+            trackTransfer(megaHandle);
 
             if (preferences->hasDefaultDownloadFolder() && QFile(defaultPath).exists())
             {
@@ -433,19 +741,18 @@ void HTTPServer::processRequest(QAbstractSocket *socket, HTTPRequest request)
             response = QString::number(MegaError::API_EKEY);
         }
     }
-    else if (request.data.startsWith(externalDownloadRequestStart))
+    else if (action == QString::fromUtf8("d"))
     {
         MegaApi::log(MegaApi::LOG_LEVEL_DEBUG, "ExternalDownload command received from the webclient");
-        int start = request.data.indexOf(QString::fromUtf8("\"f\":[")) + 5;
-        if (start > 0)
+        if (command.hasFiles)
         {
-            QString privateAuth = Utilities::extractJSONString(request.data.mid(0, start), QString::fromUtf8("esid"));
-            QString publicAuth  = Utilities::extractJSONString(request.data.mid(0, start), QString::fromUtf8("en"));
-            QString chatAuth    = Utilities::extractJSONString(request.data.mid(0, start), QString::fromUtf8("cauth"));
+            QString privateAuth = command.string("esid");
+            QString publicAuth  = command.string("en");
+            QString chatAuth    = command.string("cauth");
 
             if (privateAuth.isEmpty() && publicAuth.isEmpty())
             {
-                QString auth  = Utilities::extractJSONString(request.data.mid(0, start), QString::fromUtf8("auth"));
+                QString auth  = command.string("auth");
                 if (auth.length() == 8)
                 {
                     publicAuth = auth;
@@ -459,26 +766,14 @@ void HTTPServer::processRequest(QAbstractSocket *socket, HTTPRequest request)
             if (privateAuth.size() || publicAuth.size())
             {
                 QQueue<WrappedNode *> downloadQueue;
+                QByteArray privateAuthUtf8 = privateAuth.toUtf8();
+                QByteArray publicAuthUtf8 = publicAuth.toUtf8();
+                QByteArray chatAuthUtf8 = chatAuth.toUtf8();
 
-                int end;
-                bool firstnode = true;
-
-                while (request.data[start] == QChar::fromAscii('{'))
+                for (int i = 0; i < command.files.size(); i++)
                 {
-                    end = request.data.indexOf(QChar::fromAscii('}'), start);
-                    if (end < 0)
-                    {
-                        MegaApi::log(MegaApi::LOG_LEVEL_ERROR, "Error parsing webclient request");
-                        qDeleteAll(downloadQueue);
-                        downloadQueue.clear();
-                        break;
-                    }
-
-                    end++;
-                    QString file = request.data.mid(start, end - start);
-                    start = end + 1;
-
-                    int type = Utilities::extractJSONNumber(file, QString::fromUtf8("t"));
+                    const WebDownloadNode& file = command.files.at(i);
+                    int type = int(file.type);
                     if (type < 0)
                     {
                         MegaApi::log(MegaApi::LOG_LEVEL_ERROR, "Node without type in webclient request");
@@ -487,8 +782,7 @@ void HTTPServer::processRequest(QAbstractSocket *socket, HTTPRequest request)
                         break;
                     }
 
-                    QString handle = Utilities::extractJSONString(file, QString::fromUtf8("h"));
-                    if (handle.isEmpty())
+                    if (!file.handle.size)
                     {
                         MegaApi::log(MegaApi::LOG_LEVEL_ERROR, "Node without handle in webclient request");
                         qDeleteAll(downloadQueue);
@@ -496,10 +790,10 @@ void HTTPServer::processRequest(QAbstractSocket *socket, HTTPRequest request)
                         break;
                     }
 
-                    QString name = Utilities::extractJSONString(file, QString::fromUtf8("n"));
-                    name.replace(QString::fromUtf8("-"), QString::fromUtf8("+"));
-                    name.replace(QString::fromUtf8("_"), QString::fromUtf8("/"));
-                    name = QString::fromUtf8(QByteArray::fromBase64(name.toUtf8().constData()).constData());
+                    QByteArray name(file.name.data, file.name.size);
+                    name.replace('-', '+');
+                    name.replace('_', '/');
+                    name = QByteArray(QByteArray::fromBase64(name).constData());
                     if (name.isEmpty())
                     {
                         MegaApi::log(MegaApi::LOG_LEVEL_ERROR, "Node without name in webclient request");
@@ -508,50 +802,32 @@ void HTTPServer::processRequest(QAbstractSocket *socket, HTTPRequest request)
                         break;
                     }
 
-                    MegaHandle h = megaApi->base64ToHandle(handle.toUtf8().constData());
+                    MegaHandle h = megaApi->base64ToHandle(QByteArray(file.handle.data, file.handle.size).constData());
                     MegaHandle p = INVALID_HANDLE;
 
-                    if (!firstnode)
-                    {
-                        QString parentHandle = Utilities::extractJSONString(file, QString::fromUtf8("p"));
-                        p = megaApi->base64ToHandle(parentHandle.toUtf8().constData());
-                        QApplication::processEvents();
-                        if (!safeServer || !safeSocket)
-                        {
-                            return;
-                        }
-                    }
-                    else
+                    if (i)
                     {
-                        firstnode = false;
+                        p = megaApi->base64ToHandle(QByteArray(file.parent.data, file.parent.size).constData());
                     }
 
                     if (type != MegaNode::TYPE_FILE)
                     {
-                        MegaNode *node = megaApi->createForeignFolderNode(h, name.toUtf8().constData(), p,
-                                                                         privateAuth.toUtf8().constData(),
-                                                                         publicAuth.toUtf8().constData());
+                        MegaNode *node = megaApi->createForeignFolderNode(h, name.constData(), p,
+                                                                         privateAuthUtf8.constData(),
+                                                                         publicAuthUtf8.constData());
                         downloadQueue.append(new WrappedNode(WrappedNode::TransferOrigin::FROM_WEBSERVER, node));
                     }
                     else
                     {
-                        QString key = Utilities::extractJSONString(file, QString::fromUtf8("k"));
-                        if (key.size() == 43)
+                        if (file.key.size == 43)
                         {
-                            long long size = Utilities::extractJSONNumber(file, QString::fromUtf8("s"));
-                            long long mtime = Utilities::extractJSONNumber(file, QString::fromUtf8("ts"));
-
-                            MegaNode *node = megaApi->createForeignFileNode(h, key.toUtf8().constData(),
-                                                             name.toUtf8().constData(), size, mtime,
-                                                             p, privateAuth.toUtf8().constData(),
-                                                             publicAuth.toUtf8().constData(), chatAuth.isEmpty() ? NULL : chatAuth.toUtf8().constData());
+                            QByteArray key(file.key.data, file.key.size);
+                            MegaNode *node = megaApi->createForeignFileNode(h, key.constData(),
+                                                             name.constData(), file.size, file.mtime,
+                                                             p, privateAuthUtf8.constData(),
+                                                             publicAuthUtf8.constData(), chatAuth.isEmpty() ? NULL : chatAuthUtf8.constData());
                             downloadQueue.append(new WrappedNode(WrappedNode::TransferOrigin::FROM_WEBSERVER, node));
-                            QMap<MegaHandle, RequestTransferData*>::iterator it = webTransferStateRequests.find(h);
-                            if (it != webTransferStateRequests.end())
-                            {
-                                delete it.value();
-                            }
-                            webTransferStateRequests.insert(h, new RequestTransferData());
+                            trackTransfer(h);
                         }
                         else
                         {
@@ -569,10 +845,10 @@ void HTTPServer::processRequest(QAbstractSocket *socket, HTTPRequest request)
             }
         }
     }
-    else if (request.data.startsWith(externalFileUploadRequestStart))
+    else if (action == QString::fromUtf8("ufi"))
     {
         MegaApi::log(MegaApi::LOG_LEVEL_DEBUG, "UploadFile command received from the webclient");
-        QString targetHandle = Utilities::extractJSONString(request.data, QString::fromUtf8("h"));
+        QString targetHandle = command.string("h");
         MegaHandle handle = ::mega::INVALID_HANDLE;
         if (targetHandle.size())
         {
@@ -587,7 +863,7 @@ void HTTPServer::processRequest(QAbstractSocket *socket, HTTPRequest request)
         else
         {
             delete targetNode;
-            QString bid = Utilities::extractJSONString(request.data, QString::fromUtf8("bid"));
+            QString bid = command.string("bid");
             if (!bid.isEmpty())
             {
                 webDataRequests.insert(bid, new RequestData());
@@ -600,10 +876,10 @@ void HTTPServer::processRequest(QAbstractSocket *socket, HTTPRequest request)
             }
         }
     }
-    else if (request.data.startsWith(externalFolderUploadRequestStart))
+    else if (action == QString::fromUtf8("ufo"))
     {
         MegaApi::log(MegaApi::LOG_LEVEL_DEBUG, "UploadFolder command received from the webclient");
-        QString targetHandle = Utilities::extractJSONString(request.data, QString::fromUtf8("h"));
+        QString targetHandle = command.string("h");
         MegaHandle handle = ::mega::INVALID_HANDLE;
         if (targetHandle.size())
         {
@@ -618,7 +894,7 @@ void HTTPServer::processRequest(QAbstractSocket *socket, HTTPRequest request)
         else
         {
             delete targetNode;
-            QString bid = Utilities::extractJSONString(request.data, QString::fromUtf8("bid"));
+            QString bid = command.string("bid");
             if (!bid.isEmpty())
             {
                 webDataRequests.insert(bid, new RequestData());
@@ -631,10 +907,10 @@ void HTTPServer::processRequest(QAbstractSocket *socket, HTTPRequest request)
             }
         }
     }
-    else if (request.data.startsWith(externalUploadSelectionStatusStart))
+    else if (action == QString::fromUtf8("uss"))
     {
         MegaApi::log(MegaApi::LOG_LEVEL_DEBUG, "Upload selection status command received from the webclient");
-        QString bid = Utilities::extractJSONString(request.data, QString::fromUtf8("bid"));
+        QString bid = command.string("bid");
         if (!bid.isEmpty())
         {
             QList<RequestData*> values = webDataRequests.values(bid);
@@ -671,10 +947,10 @@ void HTTPServer::processRequest(QAbstractSocket *socket, HTTPRequest request)
             response = QString::number(MegaError::API_EARGS);
         }
     }
-    else if (request.data.startsWith(externalFolderSyncRequestStart))
+    else if (action == QString::fromUtf8("s"))
     {
         MegaApi::log(MegaApi::LOG_LEVEL_DEBUG, "Sync command received from the webclient");
-        QString targetHandle = Utilities::extractJSONString(request.data, QString::fromUtf8("h"));
+        QString targetHandle = command.string("h");
         MegaHandle handle = ::mega::INVALID_HANDLE;
         if (targetHandle.size())
         {
@@ -693,10 +969,10 @@ void HTTPServer::processRequest(QAbstractSocket *socket, HTTPRequest request)
             response = QString::number(MegaError::API_OK);
         }
     }
-    else if (request.data.startsWith(externalFolderSyncCheckStart))
+    else if (action == QString::fromUtf8("sp"))
     {
         MegaApi::log(MegaApi::LOG_LEVEL_DEBUG, "Check sync folder command received from the webclient");
-        QString targetHandle = Utilities::extractJSONString(request.data, QString::fromUtf8("h"));
+        QString targetHandle = command.string("h");
         MegaHandle handle = ::mega::INVALID_HANDLE;
         if (targetHandle.size())
         {
@@ -727,10 +1003,10 @@ void HTTPServer::processRequest(QAbstractSocket *socket, HTTPRequest request)
             response = QString::number(MegaError::API_EARGS);
         }
     }
-    else if (request.data.startsWith(externalOpenTransferManagerStart))
+    else if (action == QString::fromUtf8("tm"))
     {
         MegaApi::log(MegaApi::LOG_LEVEL_DEBUG, "Open Transfer Manager command received from the webclient");
-        int tab = Utilities::extractJSONNumber(request.data, QString::fromUtf8("t"));
+        int tab = command.number("t");
         if (tab < 0 || tab > 3) //Not valid number tab (all, downloads, uploads, completed)
         {
             response = QString::number(MegaError::API_EARGS);
@@ -741,10 +1017,10 @@ void HTTPServer::processRequest(QAbstractSocket *socket, HTTPRequest request)
             response = QString::number(MegaError::API_OK);
         }
     }
-    else if (request.data.startsWith(externalShowInFolder))
+    else if (action == QString::fromUtf8("sf"))
     {
         MegaApi::log(MegaApi::LOG_LEVEL_DEBUG, "Show in folder command received from the webclient");
-        QString targetHandle = Utilities::extractJSONString(request.data, QString::fromUtf8("h"));
+        QString targetHandle = command.string("h");
         MegaHandle handle = ::mega::INVALID_HANDLE;
         if (targetHandle.size())
         {
@@ -784,9 +1060,9 @@ void HTTPServer::processRequest(QAbstractSocket *socket, HTTPRequest request)
             }
         }
     }
-    else if (request.data.startsWith(externalTransferQueryProgressStart))
+    else if (action == QString::fromUtf8("t"))
     {
-        QString targetHandle = Utilities::extractJSONString(request.data, QString::fromUtf8("h"));
+        QString targetHandle = command.string("h");
         MegaHandle handle = ::mega::INVALID_HANDLE;
         if (targetHandle.size())
         {
@@ -806,25 +1082,14 @@ void HTTPServer::processRequest(QAbstractSocket *socket, HTTPRequest request)
             else
             {
                 RequestTransferData* tData = webTransferStateRequests.value(handle);
-                if (tData->state == MegaTransfer::STATE_NONE)
-                {
-                    response = QString::fromUtf8("{\"s\":%1}").arg(tData->state);
-                }
-                else
-                {
-                    response = QString::fromUtf8("{\"s\":%1,\"p\":%2,\"t\":%3,\"v\":%4}")
-                            .arg(tData->state)
-                            .arg(tData->progress)
-                            .arg(tData->size)
-                            .arg(tData->speed);
-                }
+                response = QString::fromUtf8("{%1}").arg(transferStateFields(tData));
             }
         }
     }
 
     if (!response.size())
     {
-        MegaApi::log(MegaApi::LOG_LEVEL_ERROR, QString::fromUtf8("Invalid webclient request: %1").arg(request.data).toUtf8().constData());
+        MegaApi::log(MegaApi::LOG_LEVEL_ERROR, QString::fromUtf8("Invalid webclient request: %1").arg(QString::fromUtf8(request.data)).toUtf8().constData());
         response = QString::number(MegaError::API_EARGS);
     }
     else
@@ -832,18 +1097,28 @@ void HTTPServer::processRequest(QAbstractSocket *socket, HTTPRequest request)
         MegaApi::log(MegaApi::LOG_LEVEL_DEBUG, QString::fromUtf8("Response to HTTP request: %1").arg(response).toUtf8().constData());
     }
 
-    QString fullResponse = QString::fromUtf8("HTTP/1.0 200 Ok\r\n"
-                                             "Access-Control-Allow-Origin: %1\r\n"
+    QByteArray body = response.toUtf8();
+    QString connection = request.keepAlive ? QString::fromUtf8("HTTP/1.1 200 Ok\r\n"
+                                                               "Connection: keep-alive\r\n")
+                                           : QString::fromUtf8("HTTP/1.0 200 Ok\r\n");
+    QString fullResponse = QString::fromUtf8("%1"
+                                             "Access-Control-Allow-Origin: %2\r\n"
                                              "Content-Type: text/html; charset=\"utf-8\"\r\n"
-                                             "Content-Length: %2\r\n"
-                                             "\r\n"
-                                             "%3").arg(request.origin).arg(response.size()).arg(response);
+                                             "Content-Length: %3\r\n"
+                                             "\r\n").arg(connection).arg(request.origin).arg(body.size());
     if (safeServer && safeSocket)
     {
-        safeSocket->write(fullResponse.toUtf8());
+        safeSocket->write(fullResponse.toUtf8() + body);
         safeSocket->flush();
-        safeSocket->disconnectFromHost();
-        safeSocket->deleteLater();
+        if (request.keepAlive)
+        {
+            restartKeepAliveTimer(safeSocket);
+        }
+        else
+        {
+            safeSocket->disconnectFromHost();
+            safeSocket->deleteLater();
+        }
     }
 }
 
@@ -8,10 +8,15 @@
 #include <QStringList>
 #include <QDateTime>
 #include <QQueue>
+#include <QTimer>
+#include <QPointer>
+#include <QHash>
+#include <QVector>
 
 #include <megaapi.h>
 
 #include "Utilities.h"
+#include "JsonTokenizer.h"
 
 class RequestData
 {
@@ -42,15 +47,53 @@ public:
     long long tsStart;
     long long tsEnd;
     QString tPath;
+    // Increases on every change, for the push channel
+    quint64 revision;
 };
 
 class HTTPRequest
 {
 public:
-    HTTPRequest() : contentLength(0), origin(QString::fromUtf8("*")) {}
-    QString data;
+    HTTPRequest() : contentLength(0), headerSize(-1), scanned(0), keepAlive(false), origin(QString::fromUtf8("*")) {}
+    QByteArray data;
     int contentLength;
+    int headerSize;
+    int scanned;
+    bool keepAlive;
     QString origin;
+    // Closes an idle persistent connection. Owned by the socket and handed over to the next request
+    QPointer<QTimer> keepAliveTimer;
+};
+
+// Node of the "f" array of a download command. Tokens point into the request data
+struct WebDownloadNode
+{
+    long long type = 0;
+    JsonTokenizer::Token handle;
+    JsonTokenizer::Token name;
+    JsonTokenizer::Token parent;
+    JsonTokenizer::Token key;
+    long long size = 0;
+    long long mtime = 0;
+};
+
+// Webclient command, parsed in a single pass over the request data
+class WebCommand
+{
+public:
+    bool parse(const QByteArray& json);
+
+    // Missing fields are empty strings or 0, like Utilities::extractJSONString/extractJSONNumber
+    QString string(const char* name) const;
+    long long number(const char* name) const;
+
+    bool hasFiles = false;
+    QVector<WebDownloadNode> files;
+
+private:
+    bool parseFiles(JsonTokenizer& tokenizer);
+
+    QHash<QByteArray, JsonTokenizer::Token> mFields;
 };
 
 class HTTPServer: public QTcpServer
@@ -59,6 +102,8 @@ class HTTPServer: public QTcpServer
 
     public:
         static const unsigned int MAX_REQUEST_TIME_SECS;
+        static const long long EVENT_STREAM_HEARTBEAT_MS;
+        static const qint64 MAX_EVENT_STREAM_BACKLOG;
 
         HTTPServer(mega::MegaApi *megaApi, quint16 port, bool sslEnabled);
         ~HTTPServer();
@@ -73,6 +118,8 @@ class HTTPServer: public QTcpServer
         static void checkAndPurgeRequests();
         static void onUploadSelectionAccepted(int files, int folders);
         static void onUploadSelectionDiscarded();
+        // Starts (or restarts) reporting the state of a transfer to the webclient
+        static void trackTransfer(mega::MegaHandle handle);
         static void onTransferDataUpdate(mega::MegaHandle handle, int state, long long progress, long long size, long long speed, QString localPath);
 
     signals:
@@ -95,11 +142,28 @@ class HTTPServer: public QTcpServer
         void sslErrors(const QList<QSslError> & errors);
         void peerVerifyError(const QSslError & error);
 
+    private slots:
+        void pushTransferUpdates();
+
     private:
+        // Client subscribed to transfer updates with GET /events (Server-Sent Events)
+        struct EventClient
+        {
+            quint64 revision = 0;
+            long long lastWrite = 0;
+        };
+
+        bool processClientData(QAbstractSocket *socket, HTTPRequest *request);
+        void startEventStream(QAbstractSocket *socket, const QString& origin);
+        void sendTransferUpdates(QAbstractSocket *socket, EventClient& client, long long now);
+        void restartKeepAliveTimer(QAbstractSocket *socket);
+
         bool disabled;
         bool sslEnabled;
         mega::MegaApi *megaApi;
         QMap<QAbstractSocket*, HTTPRequest*> requests;
+        QMap<QAbstractSocket*, EventClient> eventClients;
+        QTimer pushTimer;
         static bool isFirstWebDownloadDone;
         static QMultiMap<QString, RequestData*> webDataRequests;
         static QMap<mega::MegaHandle, RequestTransferData*> webTransferStateRequests;
@@ -0,0 +1,233 @@
+#include "JsonTokenizer.h"
+
+#include <climits>
+#include <cstring>
+
+bool JsonTokenizer::Token::equals(const char* literal) const
+{
+    return size == int(strlen(literal)) && !memcmp(data, literal, size_t(size));
+}
+
+QString JsonTokenizer::Token::toString() const
+{
+    if (type != TokenType::STRING || !hasEscapes)
+    {
+        return QString::fromUtf8(data, size);
+    }
+
+    QString result;
+    result.reserve(size);
+    const char* end = data + size;
+    const char* run = data;
+    for (const char* c = data; c < end; c++)
+    {
+        if (*c != '\\')
+        {
+            continue;
+        }
+
+        result.append(QString::fromUtf8(run, int(c - run)));
+        if (++c == end)
+        {
+            return result;
+        }
+
+        switch (*c)
+        {
+            case 'b': result.append(QChar::fromLatin1('\b')); break;
+            case 'f': result.append(QChar::fromLatin1('\f')); break;
+            case 'n': result.append(QChar::fromLatin1('\n')); break;
+            case 'r': result.append(QChar::fromLatin1('\r')); break;
+            case 't': result.append(QChar::fromLatin1('\t')); break;
+            case 'u':
+            {
+                bool ok = end - c > 4;
+                ushort unicode = ok ? QByteArray::fromRawData(c + 1, 4).toUShort(&ok, 16) : 0;
+                if (ok)
+                {
+                    // surrogate pairs come as two escapes and end up as two UTF-16 units
+                    result.append(QChar(unicode));
+                    c += 4;
+                }
+                break;
+            }
+            default: result.append(QChar::fromLatin1(*c)); break;
+        }
+        run = c + 1;
+    }
+    result.append(QString::fromUtf8(run, int(end - run)));
+    return result;
+}
+
+// Integer part only, like Utilities::extractJSONNumber
+long long JsonTokenizer::Token::toLongLong() const
+{
+    if (type != TokenType::NUMBER)
+    {
+        return 0;
+    }
+
+    const char* c = data;
+    const char* end = data + size;
+    bool negative = c < end && *c == '-';
+    if (negative)
+    {
+        c++;
+    }
+
+    long long value = 0;
+    while (c < end && *c >= '0' && *c <= '9' && value <= (LLONG_MAX - 9) / 10)
+    {
+        value = value * 10 + (*c - '0');
+        c++;
+    }
+    return negative ? -value : value;
+}
+
+JsonTokenizer::JsonTokenizer(const QByteArray& json, int offset)
+    : mBegin(json.constData()),
+      mCurrent(json.constData() + qBound(0, offset, json.size())),
+      mEnd(json.constData() + json.size())
+{
+}
+
+int JsonTokenizer::position() const
+{
+    return int(mCurrent - mBegin);
+}
+
+JsonTokenizer::Token JsonTokenizer::fail()
+{
+    mCurrent = mEnd;
+    return Token();
+}
+
+JsonTokenizer::Token JsonTokenizer::next()
+{
+    while (mCurrent < mEnd && (*mCurrent == ' ' || *mCurrent == '\t' || *mCurrent == '\r'
+                               || *mCurrent == '\n' || *mCurrent == ',' || *mCurrent == ':'))
+    {
+        mCurrent++;
+    }
+
+    Token token;
+    token.data = mCurrent;
+    if (mCurrent == mEnd)
+    {
+        token.type = TokenType::END;
+        return token;
+    }
+
+    switch (*mCurrent)
+    {
+        case '{': token.type = TokenType::OBJECT_BEGIN; break;
+        case '}': token.type = TokenType::OBJECT_END; break;
+        case '[': token.type = TokenType::ARRAY_BEGIN; break;
+        case ']': token.type = TokenType::ARRAY_END; break;
+        case '"':
+        {
+            const char* c = ++mCurrent;
+            while (c < mEnd && *c != '"')
+            {
+                if (*c == '\\')
+                {
+                    token.hasEscapes = true;
+                    if (++c == mEnd)
+                    {
+                        break;
+                    }
+                }
+                c++;
+            }
+
+            if (c >= mEnd)
+            {
+                return fail();
+            }
+
+            token.type = TokenType::STRING;
+            token.data = mCurrent;
+            token.size = int(c - mCurrent);
+            mCurrent = c + 1;
+            return token;
+        }
+        default:
+        {
+            const char* c = mCurrent;
+            if (*c == '-' || (*c >= '0' && *c <= '9'))
+            {
+                while (c < mEnd && (*c == '-' || *c == '+' || *c == '.' || *c == 'e' || *c == 'E' || (*c >= '0' && *c <= '9')))
+                {
+                    c++;
+                }
+                token.type = TokenType::NUMBER;
+            }
+            else
+            {
+                while (c < mEnd && *c >= 'a' && *c <= 'z')
+                {
+                    c++;
+                }
+                token.type = TokenType::LITERAL;
+            }
+
+            token.size = int(c - mCurrent);
+            mCurrent = c;
+            if (token.type == TokenType::LITERAL && !token.equals("true") && !token.equals("false") && !token.equals("null"))
+            {
+                return fail();
+            }
+            return token;
+        }
+    }
+
+    token.size = 1;
+    mCurrent++;
+    return token;
+}
+
+bool JsonTokenizer::skipValue(const Token& first)
+{
+    switch (first.type)
+    {
+        case TokenType::STRING:
+        case TokenType::NUMBER:
+        case TokenType::LITERAL:
+            return true;
+        case TokenType::OBJECT_BEGIN:
+        case TokenType::ARRAY_BEGIN:
+            break;
+        default:
+            return false;
+    }
+
+    int depth = 1;
+    while (depth)
+    {
+        Token token = next();
+        switch (token.type)
+        {
+            case TokenType::OBJECT_BEGIN:
+            case TokenType::ARRAY_BEGIN:
+                depth++;
+                break;
+            case TokenType::OBJECT_END:
+            case TokenType::ARRAY_END:
+                depth--;
+                break;
+            case TokenType::INVALID:
+            case TokenType::END:
+                return false;
+            default:
+                break;
+        }
+    }
+    return true;
+}
+
+bool JsonTokenizer::nextKey(Token& key, bool& error)
+{
+    key = next();
+    error = key.type != TokenType::STRING && key.type != TokenType::OBJECT_END;
+    return key.type == TokenType::STRING;
+}
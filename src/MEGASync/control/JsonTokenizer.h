@@ -0,0 +1,56 @@
+#pragma once
+
+#include <QByteArray>
+#include <QString>
+
+/// Pull tokenizer over a JSON document held in a QByteArray. Tokens point into the
+/// buffer, nothing is copied until a value is converted. Separators (':' and ',')
+/// are consumed while looking for the next token.
+class JsonTokenizer
+{
+public:
+    enum class TokenType
+    {
+        INVALID,
+        END,
+        OBJECT_BEGIN,
+        OBJECT_END,
+        ARRAY_BEGIN,
+        ARRAY_END,
+        STRING,
+        NUMBER,
+        LITERAL // true, false or null
+    };
+
+    struct Token
+    {
+        TokenType type = TokenType::INVALID;
+        // Raw contents, without the quotes for strings
+        const char* data = nullptr;
+        int size = 0;
+        bool hasEscapes = false;
+
+        bool isValid() const { return type != TokenType::INVALID; }
+        bool equals(const char* literal) const;
+        QString toString() const;
+        long long toLongLong() const;
+    };
+
+    explicit JsonTokenizer(const QByteArray& json, int offset = 0);
+
+    Token next();
+    int position() const;
+
+    // Skips the value that starts with the given token, including nested containers
+    bool skipValue(const Token& first);
+
+    // Reads "key": of the current object. Returns false at the end of the object or on error
+    bool nextKey(Token& key, bool& error);
+
+private:
+    Token fail();
+
+    const char* mBegin;
+    const char* mCurrent;
+    const char* mEnd;
+};
@@ -8,19 +8,27 @@
 
 using namespace mega;
 
-LinkProcessor::LinkProcessor(QStringList linkList, MegaApi *megaApi, MegaApi *megaApiFolders)
+// Public node requests are cheap for the API, the window hides the round trip latency
+const int LinkProcessor::MAX_FILE_LINK_REQUESTS = 8;
+// Each instance logs into a folder and fetches all its nodes
+const int LinkProcessor::FOLDER_API_POOL_SIZE = 3;
+
+LinkProcessor::LinkProcessor(QStringList linkList, MegaApi *megaApi,
+                             std::function<QList<MegaApi *>()> folderApiProvider)
 {
     this->megaApi = megaApi;
-    this->megaApiFolders = megaApiFolders;
+    this->folderApiProvider = folderApiProvider;
     this->linkList = linkList;
     for (int i = 0; i < linkList.size(); i++)
     {
         linkSelected.append(false);
         linkNode.append(NULL);
         linkError.append(MegaError::API_ENOENT);
+        linkInfoAvailable.append(false);
     }
 
     importParentFolder = mega::INVALID_HANDLE;
+    fileRequestsInFlight = 0;
     currentIndex = 0;
     remainingNodes = 0;
     importSuccess = 0;
@@ -63,30 +71,32 @@ int LinkProcessor::size() const
     return linkList.size();
 }
 
+bool LinkProcessor::isLinkInfoAvailable(int id) const
+{
+    return linkInfoAvailable[id];
+}
+
 void LinkProcessor::onRequestFinish(MegaApi *api, MegaRequest *request, MegaError *e)
 {
     if (request->getType() == MegaRequest::TYPE_GET_PUBLIC_NODE)
     {
-        if (e->getErrorCode() != MegaError::API_OK)
+        QString link = QString::fromUtf8(request->getLink());
+        auto it = fileLinksInFlight.find(link);
+        if (it == fileLinksInFlight.end())
         {
-            linkNode[currentIndex] = NULL;
-        }
-        else
-        {
-            linkNode[currentIndex] = request->getPublicMegaNode();
+            MegaApi::log(MegaApi::LOG_LEVEL_ERROR, "Public node received for an unknown link");
+            return;
         }
 
-        linkError[currentIndex] = e->getErrorCode();
-        currentIndex++;
-        emit onLinkInfoAvailable(currentIndex-1);
-        if (currentIndex == linkList.size())
+        int id = it->takeFirst();
+        if (it->isEmpty())
         {
-            emit onLinkInfoRequestFinish();
-        }
-        else
-        {
-            requestLinkInfo();
+            fileLinksInFlight.erase(it);
         }
+        fileRequestsInFlight--;
+
+        setLinkInfo(id, (e->getErrorCode() == MegaError::API_OK) ? request->getPublicMegaNode() : NULL, e->getErrorCode());
+        requestNextLinks();
     }
     else if (request->getType() == MegaRequest::TYPE_CREATE_FOLDER)
     {
@@ -113,32 +123,39 @@ void LinkProcessor::onRequestFinish(MegaApi *api, MegaRequest *request, MegaErro
     }
     else if (request->getType() == MegaRequest::TYPE_LOGIN)
     {
+        auto it = folderLinksInFlight.find(api);
+        if (it == folderLinksInFlight.end())
+        {
+            return;
+        }
+
         if (e->getErrorCode() == MegaError::API_OK)
         {
-            megaApiFolders->fetchNodes(this);
+            api->fetchNodes(delegateListener);
         }
         else
         {
-            linkNode[currentIndex] = NULL;
-            linkError[currentIndex] = e->getErrorCode();
-            currentIndex++;
-            emit onLinkInfoAvailable(currentIndex - 1);
-            if (currentIndex == linkList.size())
-            {
-                emit onLinkInfoRequestFinish();
-            }
-            else
-            {
-                requestLinkInfo();
-            }
+            QString link = it.value();
+            folderLinksInFlight.erase(it);
+            setFolderLinkInfo(link, NULL, e->getErrorCode());
+            requestNextLinks();
         }
     }
     else if (request->getType() == MegaRequest::TYPE_FETCH_NODES)
     {
+        auto it = folderLinksInFlight.find(api);
+        if (it == folderLinksInFlight.end())
+        {
+            return;
+        }
+
+        QString currentStr = it.value();
+        folderLinksInFlight.erase(it);
+
+        MegaNode *node = NULL;
         if (e->getErrorCode() == MegaError::API_OK)
         {
             MegaNode *rootNode = NULL;
-            QString currentStr = linkList[currentIndex];
             QString splitSeparator;
 
             if (currentStr.count(QChar::fromAscii('!')) == 3)
@@ -162,59 +179,114 @@ void LinkProcessor::onRequestFinish(MegaApi *api, MegaRequest *request, MegaErro
 
             if (splitSeparator.isEmpty())
             {
-                rootNode = megaApiFolders->getRootNode();
+                rootNode = api->getRootNode();
             }
             else
             {
                 QStringList linkparts = currentStr.split(splitSeparator, QString::KeepEmptyParts);
                 MegaHandle handle = MegaApi::base64ToHandle(linkparts.last().toUtf8().constData());
-                rootNode = megaApiFolders->getNodeByHandle(handle);
+                rootNode = api->getNodeByHandle(handle);
             }
 
             Preferences::instance()->setLastPublicHandle(request->getNodeHandle(), MegaApi::AFFILIATE_TYPE_FILE_FOLDER);
-            linkNode[currentIndex] = megaApiFolders->authorizeNode(rootNode);
+            node = api->authorizeNode(rootNode);
             delete rootNode;
         }
-        else
-        {
-            linkNode[currentIndex] = NULL;
-        }
 
-        linkError[currentIndex] = e->getErrorCode();
-        currentIndex++;
-        emit onLinkInfoAvailable(currentIndex-1);
-        if (currentIndex == linkList.size())
+        setFolderLinkInfo(currentStr, node, e->getErrorCode());
+        requestNextLinks();
+    }
+}
+
+void LinkProcessor::requestLinkInfo()
+{
+    if (currentIndex || fileRequestsInFlight || !folderLinksInFlight.isEmpty())
+    {
+        return;
+    }
+
+    for (int i = 0; i < linkList.size(); i++)
+    {
+        const QString &link = linkList[i];
+        if (link.startsWith(Preferences::BASE_URL + QString::fromUtf8("/#F!"))
+                || link.startsWith(Preferences::BASE_URL + QString::fromUtf8("/folder/")))
         {
-            emit onLinkInfoRequestFinish();
+            QList<int> &ids = folderLinkIds[link];
+            if (ids.isEmpty())
+            {
+                pendingFolderLinks.append(link);
+            }
+            ids.append(i);
         }
         else
         {
-            requestLinkInfo();
+            pendingFileLinks.append(i);
+        }
+    }
+
+    if (!pendingFolderLinks.isEmpty())
+    {
+        // The folder link instances are only created when a folder link is pasted
+        megaApiFolders = folderApiProvider();
+        std::unique_ptr<char []> authToken(megaApi->getAccountAuth());
+        if (authToken)
+        {
+            for (MegaApi *api : megaApiFolders)
+            {
+                api->setAccountAuth(authToken.get());
+            }
         }
     }
+
+    requestNextLinks();
 }
 
-void LinkProcessor::requestLinkInfo()
+void LinkProcessor::requestNextLinks()
 {
-    if (currentIndex < 0 || currentIndex >= linkList.size())
+    while (fileRequestsInFlight < MAX_FILE_LINK_REQUESTS && !pendingFileLinks.isEmpty())
     {
-        return;
+        int id = pendingFileLinks.takeFirst();
+        fileLinksInFlight[linkList[id]].append(id);
+        fileRequestsInFlight++;
+        megaApi->getPublicNode(linkList[id].toUtf8().constData(), delegateListener);
     }
 
-    QString link = linkList[currentIndex];
-    if (link.startsWith(Preferences::BASE_URL + QString::fromUtf8("/#F!"))
-            || link.startsWith(Preferences::BASE_URL + QString::fromUtf8("/folder/")))
+    for (MegaApi *api : megaApiFolders)
     {
-        std::unique_ptr<char []> authToken(megaApi->getAccountAuth());
-        if (authToken)
+        if (pendingFolderLinks.isEmpty())
         {
-            megaApiFolders->setAccountAuth(authToken.get());
+            break;
+        }
+
+        if (!folderLinksInFlight.contains(api))
+        {
+            QString link = pendingFolderLinks.takeFirst();
+            folderLinksInFlight.insert(api, link);
+            api->loginToFolder(link.toUtf8().constData(), delegateListener);
         }
-        megaApiFolders->loginToFolder(link.toUtf8().constData(), delegateListener);
     }
-    else
+}
+
+void LinkProcessor::setLinkInfo(int id, MegaNode *node, int error)
+{
+    linkNode[id] = node;
+    linkError[id] = error;
+    linkInfoAvailable[id] = true;
+    currentIndex++;
+    emit onLinkInfoAvailable(id);
+    if (currentIndex == linkList.size())
+    {
+        emit onLinkInfoRequestFinish();
+    }
+}
+
+void LinkProcessor::setFolderLinkInfo(const QString &link, MegaNode *node, int error)
+{
+    // Every index of a link pasted more than once gets its own copy of the node
+    QList<int> ids = folderLinkIds.take(link);
+    for (int i = 0; i < ids.size(); i++)
     {
-        megaApi->getPublicNode(link.toUtf8().constData(), delegateListener);
+        setLinkInfo(ids[i], (node && i) ? node->copy() : node, error);
     }
 }
 
@@ -3,15 +3,20 @@
 
 #include <QObject>
 #include <QStringList>
+#include <QHash>
 #include "megaapi.h"
 #include "QTMegaRequestListener.h"
 
+#include <functional>
+
 class LinkProcessor: public QObject, public mega::MegaRequestListener
 {
     Q_OBJECT
 
 public:
-    LinkProcessor(QStringList linkList, mega::MegaApi *megaApi, mega::MegaApi *megaApiFolders);
+    // folderApiProvider returns the folder API instances, it is only called if a folder link is pasted
+    LinkProcessor(QStringList linkList, mega::MegaApi *megaApi,
+                  std::function<QList<mega::MegaApi *>()> folderApiProvider);
     virtual ~LinkProcessor();
 
     QString getLink(int id);
@@ -19,7 +24,11 @@ public:
     int getError(int id);
     mega::MegaNode *getNode(int id);
     int size() const;
+    bool isLinkInfoAvailable(int id) const;
 
+    // File links are resolved with up to MAX_FILE_LINK_REQUESTS requests in flight, and folder links
+    // with one login per folder API instance and distinct link. onLinkInfoAvailable is emitted as each one finishes,
+    // in any order, with the index of the link
     void requestLinkInfo();
     void importLinks(QString nodePath);
     void importLinks(mega::MegaNode *node);
@@ -30,17 +39,37 @@ public:
 
     int numSuccessfullImports();
     int numFailedImports();
+    // Number of links resolved so far
     int getCurrentIndex();
 
     bool atLeastOneLinkValidAndSelected() const;
 
+    static const int MAX_FILE_LINK_REQUESTS;
+    static const int FOLDER_API_POOL_SIZE;
+
 protected:
+    void requestNextLinks();
+    void setLinkInfo(int id, mega::MegaNode *node, int error);
+    void setFolderLinkInfo(const QString &link, mega::MegaNode *node, int error);
+
     mega::MegaApi *megaApi;
-    mega::MegaApi *megaApiFolders;
+    std::function<QList<mega::MegaApi *>()> folderApiProvider;
+    // Taken from the provider when the first folder link is resolved
+    QList<mega::MegaApi *> megaApiFolders;
     QStringList linkList;
     QList<bool> linkSelected;
     QList<mega::MegaNode *> linkNode;
     QList<int> linkError;
+    QList<bool> linkInfoAvailable;
+    QList<int> pendingFileLinks;
+    // Distinct folder links not resolved yet, and the indexes of each one
+    QStringList pendingFolderLinks;
+    QHash<QString, QList<int>> folderLinkIds;
+    // Indexes of the file links in flight by link. The same link can be pasted more than once
+    QHash<QString, QList<int>> fileLinksInFlight;
+    int fileRequestsInFlight;
+    // Folder link resolved by each folder API instance
+    QHash<mega::MegaApi *, QString> folderLinksInFlight;
     int currentIndex;
     int remainingNodes;
     int importSuccess;
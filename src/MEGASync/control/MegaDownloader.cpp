@@ -6,19 +6,45 @@
 
 using namespace mega;
 
-MegaDownloader::MegaDownloader(MegaApi *megaApi) : QObject()
+namespace
+{
+// Nodes handed to the SDK by each job queued in the thread pool
+const int DOWNLOAD_CHUNK_SIZE = 512;
+
+QString withSeparator(QString path)
+{
+    path = QDir::toNativeSeparators(path);
+    if (!path.endsWith(QDir::separator()))
+    {
+        path += QDir::separator();
+    }
+    return path;
+}
+}
+
+MegaDownloader::MegaDownloader(MegaApi *megaApi) : QObject(),
+    mJobGuard(std::make_shared<JobGuard>())
 {
     this->megaApi = megaApi;
+    mJobGuard->downloader = this;
 }
 
 MegaDownloader::~MegaDownloader()
 {
+    // Waits for the chunk in progress, if any. Pending chunks are discarded
+    QMutexLocker locker(&mJobGuard->mutex);
+    mJobGuard->downloader = nullptr;
+}
 
+MegaDownloader::DownloadBatch::~DownloadBatch()
+{
+    qDeleteAll(nodes);
 }
 
 void MegaDownloader::download(WrappedNode *parent, QString path, QString appData)
 {
-    return download(parent, QFileInfo(path), appData);
+    DownloadBatch batch;
+    download(parent, withSeparator(QFileInfo(path).absoluteFilePath()), appData, &batch);
 }
 
 bool MegaDownloader::processDownloadQueue(QQueue<WrappedNode *> *downloadQueue, QString path, unsigned long long appDataId)
@@ -36,87 +62,172 @@ bool MegaDownloader::processDownloadQueue(QQueue<WrappedNode *> *downloadQueue,
     // Get transfer's metadata
     TransferMetaData *data = ((MegaApplication*)qApp)->getTransferAppData(appDataId);
 
-    // Process all nodes in the download queue
-    while (!downloadQueue->isEmpty())
+    // The nodes are processed in the thread pool, without pumping the event loop for each of them
+    auto batch = std::make_shared<DownloadBatch>();
+    batch->nodes.swap(*downloadQueue);
+    batch->total = batch->nodes.size();
+    batch->pathWithSep = withSeparator(QFileInfo(path).absoluteFilePath());
+    batch->appDataId = appDataId;
+    batch->hasMetaData = data != nullptr;
+    batch->singleTransfer = data && data->totalTransfers == 1;
+    queueBatch(batch);
+    return true;
+}
+
+void MegaDownloader::queueBatch(std::shared_ptr<DownloadBatch> batch)
+{
+    // One chunk per job, so that other users of the pool aren't blocked by a big download
+    std::shared_ptr<JobGuard> guard = mJobGuard;
+    ThreadPoolSingleton::getInstance()->push([guard, batch]()
     {
-        static QString currentPath;
+        QMutexLocker locker(&guard->mutex);
+        if (guard->downloader)
+        {
+            guard->downloader->processBatch(batch);
+        }
+    });
+}
 
-        QString appData = QString::number(appDataId);
-        WrappedNode *wNode = downloadQueue->dequeue();
+void MegaDownloader::processBatch(std::shared_ptr<DownloadBatch> batch)
+{
+    for (int i = 0; i < DOWNLOAD_CHUNK_SIZE && !batch->nodes.isEmpty(); i++)
+    {
+        QString appData = QString::number(batch->appDataId);
+        WrappedNode *wNode = batch->nodes.dequeue();
         MegaNode *node = wNode->getMegaNode();
 
-        // Get path from pathMap or build it if necessary
-        if (node->isForeign() && pathMap.contains(node->getParentHandle()))
+        // Get path from pathMap or use the destination path for "root" nodes
+        QString currentPath;
+        auto it = node->isForeign() ? batch->pathMap.constFind(node->getParentHandle()) : batch->pathMap.constEnd();
+        if (it != batch->pathMap.constEnd())
         {
-            currentPath = pathMap[node->getParentHandle()];
+            currentPath = it.value();
         }
         else
         {
-            if (data)
+            if (batch->hasMetaData)
             {
-                // Update transfer metadata according to node type.
-                if (node->isFolder())
-                {
-                    data->totalFolders++;
-                }
-                else
-                {
-                    data->totalFiles++;
-                }
+                reportRootNode(batch.get(), node);
 
                 // Report that there is still a "root folder" to download/create
                 appData.append(QString::fromUtf8("*"));
-
-                // Set the metadata local path to destination path
-                if (data->localPath.isEmpty())
-                {
-                    data->localPath = QDir::toNativeSeparators(path);
-
-                    // If there is only 1 transfer, set localPath to full path
-                    if (data->totalTransfers == 1)
-                    {
-                        char *escapedName = megaApi->escapeFsIncompatible(node->getName(),
-                                                                          path.toStdString().c_str());
-                        QString nodeName = QString::fromUtf8(escapedName);
-                        delete [] escapedName;
-                        if (!data->localPath.endsWith(QDir::separator()))
-                        {
-                            data->localPath += QDir::separator();
-                        }
-                        data->localPath += nodeName;
-                    }
-                }
             }
-
-            currentPath = path;
+            currentPath = batch->pathWithSep;
         }
 
         // We now have all the necessary info to effectively download.
-        download(wNode, currentPath, appData);
+        download(wNode, currentPath, appData, batch.get());
 
         // Delete the node object once the transfer has been passed over to the SDK.
         delete wNode;
+        batch->processed++;
+    }
+
+    emit downloadQueueProgress(batch->appDataId, batch->processed, batch->total);
+
+    if (!batch->nodes.isEmpty())
+    {
+        queueBatch(batch);
     }
-    pathMap.clear();
-    return true;
 }
 
-void MegaDownloader::download(WrappedNode *parent, QFileInfo info, QString appData)
+QString MegaDownloader::escapedName(DownloadBatch *batch, const char *name, const QString& pathWithSep)
 {
-    QPointer<MegaDownloader> safePointer = this;
-
-    QApplication::processEvents();
-    if (!safePointer)
+    QString key = QString::fromUtf8(name);
+    auto it = batch->escapedNames.constFind(key);
+    if (it != batch->escapedNames.constEnd())
     {
-        return;
+        return it.value();
     }
 
-    QString currentPathWithSep = QDir::toNativeSeparators(info.absoluteFilePath());
-    if (!currentPathWithSep.endsWith(QDir::separator()))
+    // Get a c-string with the escaped name. This string will have to be deleted because
+    // megaApi->escapeFsIncompatible allocates it.
+    char *escapedName = megaApi->escapeFsIncompatible(name, pathWithSep.toUtf8().constData());
+    QString nodeName = QString::fromUtf8(escapedName);
+    delete [] escapedName;
+
+    batch->escapedNames.insert(key, nodeName);
+    return nodeName;
+}
+
+// Transfer metadata belongs to the app thread, so updates are queued there
+void MegaDownloader::reportRootNode(DownloadBatch *batch, MegaNode *node)
+{
+    // If there is only 1 transfer, set localPath to full path
+    QString localPath = batch->pathWithSep;
+    if (batch->singleTransfer)
     {
-        currentPathWithSep += QDir::separator();
+        localPath += escapedName(batch, node->getName(), batch->pathWithSep);
     }
+    else if (localPath.size() > 1)
+    {
+        localPath.chop(1);
+    }
+
+    unsigned long long appDataId = batch->appDataId;
+    bool isFolder = node->isFolder();
+    Utilities::queueFunctionInAppThread([appDataId, isFolder, localPath]()
+    {
+        TransferMetaData *data = ((MegaApplication*)qApp)->getTransferAppData(appDataId);
+        if (!data)
+        {
+            return;
+        }
+
+        // Update transfer metadata according to node type.
+        if (isFolder)
+        {
+            data->totalFolders++;
+        }
+        else
+        {
+            data->totalFiles++;
+        }
+
+        // Set the metadata local path to destination path
+        if (data->localPath.isEmpty())
+        {
+            data->localPath = localPath;
+        }
+    });
+}
+
+void MegaDownloader::reportFolderCreated(const QString& appData)
+{
+    QPointer<MegaDownloader> safePointer = this;
+    Utilities::queueFunctionInAppThread([safePointer, appData]()
+    {
+        // Once the folder has been checked for existence/created with success:
+        // - check if this was A "root folder" for the transfer (if yes, update
+        //     transfer metadata)
+        // - check if this was the last pending transfer. If yes, emit notification.
+        QByteArray appDataArray = appData.toUtf8();
+        char *endptr;
+        unsigned long long notificationId = strtoull(appDataArray.constData(), &endptr, 10);
+        TransferMetaData *data = ((MegaApplication*)qApp)->getTransferAppData(notificationId);
+        if (!data)
+        {
+            return;
+        }
+
+        // Thus, if there is a '*', this was a "root folder", and we successfully transfered it.
+        if (*endptr == '*')
+        {
+            data->transfersFolderOK++;
+        }
 
+        // Update pending transfers in metadata, and notify if this was the last.
+        data->pendingTransfers--;
+        if (data->pendingTransfers == 0 && safePointer)
+        {
+            //Transfers finished, show notification
+            emit safePointer->finishedTransfers(notificationId);
+        }
+    });
+}
+
+void MegaDownloader::download(WrappedNode *parent, const QString& pathWithSep, const QString& appData, DownloadBatch *batch)
+{
     // Extract MEGA node from wrapped node for more readable code
     // Both parent and node should be not null at this point.
     mega::MegaNode *node {parent->getMegaNode()};
@@ -130,7 +241,7 @@ void MegaDownloader::download(WrappedNode *parent, QFileInfo info, QString appDa
             {
                 // Downloads initiated through http server get top priority
                 megaApi->startDownloadWithTopPriority(node,
-                                                      currentPathWithSep.toUtf8().constData(),
+                                                      pathWithSep.toUtf8().constData(),
                                                       appData.toUtf8().constData());
                 break;
             }
@@ -140,7 +251,7 @@ void MegaDownloader::download(WrappedNode *parent, QFileInfo info, QString appDa
             {
                 // For other downloads, use normal priority call
                 megaApi->startDownloadWithData(node,
-                                               currentPathWithSep.toUtf8().constData(),
+                                               pathWithSep.toUtf8().constData(),
                                                appData.toUtf8().constData());
             }
         }
@@ -149,15 +260,8 @@ void MegaDownloader::download(WrappedNode *parent, QFileInfo info, QString appDa
     // Downloading amounts to creating the dir if it doesn't exist.
     else
     {
-        // Get a c-string with the escaped name. This string will have to be deleted because
-        // megaApi->escapeFsIncompatible allocates it.
-        char *escapedName = megaApi->escapeFsIncompatible(node->getName(),
-                                                          currentPathWithSep.toStdString().c_str());
-        QString nodeName = QString::fromUtf8(escapedName);
-        delete [] escapedName;
-
         // Build destination path and create it if it does not exist. If the creation fails, exit.
-        QString destPath = currentPathWithSep + nodeName;
+        QString destPath = pathWithSep + escapedName(batch, node->getName(), pathWithSep);
         QDir dir(destPath);
         if (!dir.exists())
         {
@@ -171,32 +275,9 @@ void MegaDownloader::download(WrappedNode *parent, QFileInfo info, QString appDa
             }
         }
 
-        // Once the folder has been checked for existence/created with success:
-        // - check if this was A "root folder" for the transfer (if yes, update
-        //     transfer metadata)
-        // - check if this was the last pending transfer. If yes, emit notification.
-        QByteArray appDataArray = appData.toUtf8();
-        char *endptr;
-        unsigned long long notificationId = strtoull(appDataArray.constData(), &endptr, 10);
-        TransferMetaData *data = ((MegaApplication*)qApp)->getTransferAppData(notificationId);
-        if (data)
-        {
-            // Thus, if there is a '*', this was a "root folder", and we successfully transfered it.
-            if (*endptr == '*')
-            {
-                data->transfersFolderOK++;
-            }
-
-            // Update pending transfers in metadata, and notify if this was the last.
-            data->pendingTransfers--;
-            if (data->pendingTransfers == 0)
-            {
-                //Transfers finished, show notification
-                emit finishedTransfers(notificationId);
-            }
-        }
+        reportFolderCreated(appData);
 
         // Add path to pathMap
-        pathMap[node->getHandle()] = destPath;
+        batch->pathMap.insert(node->getHandle(), destPath + QDir::separator());
     }
 }
@@ -6,10 +6,13 @@
 #include <QFileInfo>
 #include <QDir>
 #include <QQueue>
-#include <QMap>
+#include <QHash>
+#include <QMutex>
 #include "megaapi.h"
 #include "control/Utilities.h"
 
+#include <memory>
+
 class MegaDownloader : public QObject
 {
     Q_OBJECT
@@ -23,13 +26,46 @@ public:
     void download(WrappedNode *parent, QString path, QString appData);
 
 protected:
-    void download(WrappedNode *parent, QFileInfo info, QString appData);
+    // Nodes of one processDownloadQueue call. They are handed to the SDK in chunks from the thread pool
+    struct DownloadBatch
+    {
+        QQueue<WrappedNode *> nodes;
+        QString pathWithSep;
+        unsigned long long appDataId = 0;
+        bool hasMetaData = false;
+        bool singleTransfer = false;
+        int total = 0;
+        int processed = 0;
+        // Local paths of the foreign folders created so far, with trailing separator
+        QHash<mega::MegaHandle, QString> pathMap;
+        // All folders of a batch share the destination filesystem, so escaped names can be reused
+        QHash<QString, QString> escapedNames;
+
+        ~DownloadBatch();
+    };
+
+    void queueBatch(std::shared_ptr<DownloadBatch> batch);
+    void processBatch(std::shared_ptr<DownloadBatch> batch);
+    void download(WrappedNode *parent, const QString& pathWithSep, const QString& appData, DownloadBatch *batch);
+    QString escapedName(DownloadBatch *batch, const char *name, const QString& pathWithSep);
+    void reportRootNode(DownloadBatch *batch, mega::MegaNode *node);
+    void reportFolderCreated(const QString& appData);
 
     mega::MegaApi *megaApi;
-    QMap<mega::MegaHandle, QString> pathMap;
+
+    // Shared with the queued chunks. The destructor clears downloader, waiting for a running chunk,
+    // so the chunks that start later are discarded
+    struct JobGuard
+    {
+        QMutex mutex;
+        MegaDownloader *downloader;
+    };
+    std::shared_ptr<JobGuard> mJobGuard;
 
 signals:
     void finishedTransfers(unsigned long long appDataId);
+    // Emitted from the worker after each chunk of nodes is handed to the SDK
+    void downloadQueueProgress(unsigned long long appDataId, int processed, int total);
 };
 
 #endif // MEGADOWNLOADER_H
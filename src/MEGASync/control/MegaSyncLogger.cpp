@@ -14,9 +14,15 @@
 #include <QFile>
 
 
+#include <algorithm>
+#include <atomic>
 #include <chrono>
+#include <cstdint>
+#include <cstring>
 #include <thread>
 #include <condition_variable>
+#include <deque>
+#include <vector>
 
 #include <zlib.h>
 
@@ -25,6 +31,10 @@
 
 #ifdef WIN32
 #include <windows.h>
+#include <Psapi.h>
+#else
+#include <sys/resource.h>
+#include <time.h>
 #endif
 
 #include <unistd.h>
@@ -41,6 +51,13 @@
 #define MAX_ROTATE_LOGS 50   // So we expect to keep 42MB or so in compressed logs
 #define MAX_ROTATE_LOGS_TODELETE 50   // If ever reducing the number of logs, we should remove the older ones anyway. This number should be the historical maximum of that value
 
+#define LOG_RING_SIZE (256 * 1024)  // per logging thread, allocated on its first line
+#define LOG_OUTPUT_BUFFER_SIZE (64 * 1024)  // lines are written out in chunks of about this size
+
+#define LOG_COMPRESS_BLOCK_SIZE (1024 * 1024)  // read size when compressing a rotated log
+#define LOG_GZ_BUFFER_SIZE (256 * 1024)        // zlib input/output buffer, the default 8KB means many more deflate calls
+#define NO_LOG_SEQUENCE UINT64_MAX
+
 
 #ifdef _WIN32
     #define CERRQSTRING(filename) std::wcerr << filename.toStdWString()
@@ -49,17 +66,67 @@
 #endif
 
 
-void gzipCompressOnRotate(const QString filename, const QString destinationFilename)
+long long currentThreadCpuTimeMs()
+{
+#ifdef WIN32
+    FILETIME creationTime, exitTime, kernelTime, userTime;
+    if (!GetThreadTimes(GetCurrentThread(), &creationTime, &exitTime, &kernelTime, &userTime))
+    {
+        return 0;
+    }
+    ULARGE_INTEGER kernel, user;
+    kernel.LowPart = kernelTime.dwLowDateTime;
+    kernel.HighPart = kernelTime.dwHighDateTime;
+    user.LowPart = userTime.dwLowDateTime;
+    user.HighPart = userTime.dwHighDateTime;
+    return (long long)((kernel.QuadPart + user.QuadPart) / 10000);
+#else
+    struct timespec ts;
+    if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts))
+    {
+        return 0;
+    }
+    return (long long)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+#endif
+}
+
+long long processPeakRssKB()
+{
+#ifdef WIN32
+    PROCESS_MEMORY_COUNTERS pmc;
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc)))
+    {
+        return 0;
+    }
+    return (long long)(pmc.PeakWorkingSetSize / 1024);
+#else
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage))
+    {
+        return 0;
+    }
+#ifdef __APPLE__
+    return (long long)usage.ru_maxrss / 1024; // bytes on macOS
+#else
+    return (long long)usage.ru_maxrss;
+#endif
+#endif
+}
+
+// Compresses the rotated log in big blocks. The result is the same gzip stream the old line by line
+// gzputs version produced (the file is still read in text mode, so line endings are unchanged)
+bool gzipCompressOnRotate(const QString filename, const QString destinationFilename, long long& inputSize, long long& outputSize)
 {
+    inputSize = outputSize = 0;
 #ifdef WIN32
-    std::ifstream file(filename.toStdWString().data(), std::ofstream::out);
+    std::ifstream file(filename.toStdWString().data(), std::ifstream::in);
 #else
-    std::ifstream file(filename.toUtf8().data(), std::ofstream::out);
+    std::ifstream file(filename.toUtf8().data(), std::ifstream::in);
 #endif
     if (!file.is_open())
     {
         std::cerr << "Unable to open log file for reading: "; CERRQSTRING(filename) << std::endl;
-        return;
+        return false;
     }
 
     auto gzdeleter = [](gzFile_s* f) { if (f) gzclose(f); };
@@ -72,34 +139,45 @@ void gzipCompressOnRotate(const QString filename, const QString destinationFilen
     if (!gzfile)
     {
         std::cerr << "Unable to open gzfile for writing: "; CERRQSTRING(filename) << std::endl;
-        return;
+        return false;
     }
+    gzbuffer(gzfile.get(), LOG_GZ_BUFFER_SIZE); // must be set before the first write
 
-    std::string line;
-    while (std::getline(file, line))
+    std::unique_ptr<char[]> block(new char[LOG_COMPRESS_BLOCK_SIZE]);
+    while (file)
     {
-        line.push_back('\n');
-        if (gzputs(gzfile.get(), line.c_str()) == -1)
+        file.read(block.get(), LOG_COMPRESS_BLOCK_SIZE);
+        auto n = file.gcount();
+        if (n > 0 && gzwrite(gzfile.get(), block.get(), unsigned(n)) != int(n))
         {
             std::cerr << "Unable to compress log file: "; CERRQSTRING(filename) << std::endl;
-            return;
+            return false;
         }
+        inputSize += n;
     }
 
-    gzfile.reset();
+    if (gzclose(gzfile.release()) != Z_OK)
+    {
+        std::cerr << "Unable to finish compressed log file: "; CERRQSTRING(filename) << std::endl;
+        return false;
+    }
     file.close();
     QFile::remove(filename);
+    outputSize = QFileInfo(destinationFilename).size();
+    return true;
 }
 
 using DirectLogFunction = std::function <void (std::ostream *)>;
 
+// Lines that don't fit into the thread's ring (too long, ring full, or no ring could be allocated)
+// go through this mutex protected list, one line per entry
 struct LogLinkedList
 {
     LogLinkedList* next = nullptr;
+    uint64_t sequence = 0;
     unsigned allocated = 0;
     unsigned used = 0;
-    int lastmessage = -1;
-    int lastmessageRepeats = 0;
+    unsigned messageOffset = 0;
     bool oomGap = false;
     DirectLogFunction *mDirectLoggingFunction = nullptr; // we cannot use a non pointer due to the malloc allocation of new entries
     std::promise<void>* mCompletionPromise = nullptr; // we cannot use a unique_ptr due to the malloc allocation of new entries
@@ -111,10 +189,10 @@ struct LogLinkedList
         if (entry) 
         {
             entry->next = nullptr;
+            entry->sequence = 0;
             entry->allocated = unsigned(size - sizeof(LogLinkedList));
             entry->used = 0;
-            entry->lastmessage = -1;
-            entry->lastmessageRepeats = 0;
+            entry->messageOffset = 0;
             entry->oomGap = false;
             entry->mDirectLoggingFunction = nullptr;
             entry->mCompletionPromise = nullptr;
@@ -123,11 +201,6 @@ struct LogLinkedList
         return entry;
     }
 
-    bool messageFits(size_t size)
-    {
-        return used + size + 2 < allocated;
-    }
-
     bool needsDirectOutput()
     {
         return mDirectLoggingFunction != nullptr;
@@ -137,8 +210,9 @@ struct LogLinkedList
     {
         n = n ? n : unsigned(strlen(s));
         assert(used + n + 1 < allocated);
-        strcpy(message + used, s);
+        memcpy(message + used, s, n);
         used += n;
+        message[used] = 0;
     }
 
     void notifyWaiter()
@@ -151,6 +225,97 @@ struct LogLinkedList
 
 };
 
+// Single producer (the thread that owns it) / single consumer (the logging thread) ring of
+// formatted lines. Only the producer moves head and only the consumer moves tail, so
+// logging a line doesn't take any lock.
+struct LogRing
+{
+    struct RecordHeader
+    {
+        uint64_t sequence;
+        uint32_t size;           // bytes of the line following this header
+        uint32_t messageOffset;  // start of the message within the line, for repeat detection
+    };
+
+    explicit LogRing(size_t size)
+        : capacity(size)
+        , buffer(new (std::nothrow) char[size])
+    {
+    }
+
+    size_t freeSpace() const
+    {
+        return capacity - size_t(head.load(std::memory_order_relaxed) - tail.load(std::memory_order_acquire));
+    }
+
+    void write(uint64_t& position, const char* data, size_t size)
+    {
+        size_t offset = size_t(position % capacity);
+        size_t first = std::min(size, capacity - offset);
+        memcpy(buffer.get() + offset, data, first);
+        memcpy(buffer.get(), data + first, size - first);
+        position += size;
+    }
+
+    void read(uint64_t position, char* data, size_t size) const
+    {
+        size_t offset = size_t(position % capacity);
+        size_t first = std::min(size, capacity - offset);
+        memcpy(data, buffer.get() + offset, first);
+        memcpy(data + first, buffer.get(), size - first);
+    }
+
+    // Consumer side. A published header is always followed by its whole line
+    bool peek(RecordHeader& header) const
+    {
+        uint64_t position = tail.load(std::memory_order_relaxed);
+        if (head.load(std::memory_order_acquire) - position < sizeof(RecordHeader))
+        {
+            return false;
+        }
+        read(position, reinterpret_cast<char*>(&header), sizeof(RecordHeader));
+        return true;
+    }
+
+    // appends the line to output
+    void pop(const RecordHeader& header, std::string& output)
+    {
+        uint64_t position = tail.load(std::memory_order_relaxed);
+        size_t start = output.size();
+        output.resize(start + header.size);
+        read(position + sizeof(RecordHeader), &output[start], header.size);
+        tail.store(position + sizeof(RecordHeader) + header.size, std::memory_order_release);
+    }
+
+    const size_t capacity;
+    std::unique_ptr<char[]> buffer;
+    std::atomic<uint64_t> head{0};
+    std::atomic<uint64_t> tail{0};
+    std::atomic<uint64_t> inFlight{NO_LOG_SEQUENCE}; // lower bound of the sequence number being written
+    std::atomic<bool> orphaned{false};
+};
+
+// Per-thread logging state: the thread's ring, its name and the broken down time of the last second seen
+struct ThreadLogState
+{
+    std::shared_ptr<LogRing> ring;
+    unsigned loggerId = 0;
+    std::string threadName;
+    time_t lastT = 0;
+    struct tm lastTm;
+
+    ~ThreadLogState()
+    {
+        if (ring)
+        {
+            ring->orphaned = true;
+        }
+    }
+};
+
+thread_local ThreadLogState tlsLogState;
+std::atomic<unsigned> loggerIdCounter{0};
+
 MegaSyncLogger *g_megaSyncLogger = nullptr;
 
 struct LoggingThread
@@ -161,9 +326,9 @@ struct LoggingThread
     std::mutex logRotationMutex;
     LogLinkedList logListFirst;
     LogLinkedList* logListLast = &logListFirst;
-    bool logExit = false;
-    bool flushLog = false;
-    bool closeLog = false;
+    std::atomic<bool> logExit{false};
+    std::atomic<bool> flushLog{false};
+    std::atomic<bool> closeLog{false};
     bool forceRotationForReporting = false;
     bool forceRenew = false; //to force removal of all logs and create an empty MEGAsync.log
     bool logToDesktop = false;
@@ -172,6 +337,21 @@ struct LoggingThread
     std::chrono::seconds logFlushPeriod = std::chrono::seconds(10);
     std::chrono::steady_clock::time_point nextFlushTime = std::chrono::steady_clock::now() + logFlushPeriod;
 
+    // Lines are numbered when logged so the logging thread can merge the per-thread rings in order
+    std::atomic<uint64_t> logSequence{0};
+    const unsigned loggerId = ++loggerIdCounter;
+    std::mutex ringsMutex;
+    std::vector<std::shared_ptr<LogRing>> rings;
+    std::atomic<unsigned> ringsVersion{0};
+    std::atomic<bool> ringsNeedDrain{false};
+
+    // Rotated logs are compressed on this thread, one at a time
+    std::unique_ptr<std::thread> compressThread;
+    std::mutex compressMutex;
+    std::condition_variable compressConditionVariable;
+    std::deque<std::function<void()>> compressJobs;
+    bool compressExit = false;
+
     void startLoggingThread(QString filename, QString desktopFilename)
     {
         if (!logThread)
@@ -184,7 +364,73 @@ struct LoggingThread
 
     void log(int loglevel, const char *message, const char **directMessages = nullptr, size_t *directMessagesSizes = nullptr, int numberMessages = 0);
 
+    // Finishes the compression in progress and any queued one
+    void stopCompressionThread()
+    {
+        {
+            std::lock_guard<std::mutex> g(compressMutex);
+            compressExit = true;
+        }
+        compressConditionVariable.notify_one();
+        if (compressThread)
+        {
+            compressThread->join();
+            compressThread.reset();
+        }
+    }
+
 private:
+    void queueCompression(std::function<void()> job)
+    {
+        std::lock_guard<std::mutex> g(compressMutex);
+        compressJobs.push_back(std::move(job));
+        if (!compressThread)
+        {
+            compressThread.reset(new std::thread([this]() {
+                for (;;)
+                {
+                    std::function<void()> next;
+                    {
+                        std::unique_lock<std::mutex> lock(compressMutex);
+                        compressConditionVariable.wait(lock, [this]() { return compressExit || !compressJobs.empty(); });
+                        if (compressJobs.empty())
+                        {
+                            return;
+                        }
+                        next = std::move(compressJobs.front());
+                        compressJobs.pop_front();
+                    }
+                    next();
+                }
+            }));
+        }
+        compressConditionVariable.notify_one();
+    }
+
+    LogRing* threadRing()
+    {
+        ThreadLogState& state = tlsLogState;
+        if (state.loggerId != loggerId)
+        {
+            if (state.ring)
+            {
+                state.ring->orphaned = true;
+                state.ring.reset();
+            }
+            state.loggerId = loggerId;
+
+            std::shared_ptr<LogRing> ring = std::make_shared<LogRing>(LOG_RING_SIZE);
+            if (ring->buffer)
+            {
+                std::lock_guard<std::mutex> g(ringsMutex);
+                rings.push_back(ring);
+                ++ringsVersion;
+                state.ring = ring;
+            }
+        }
+        return state.ring.get();
+    }
+
     QString numberedLogFilename(QString baseName, int logNumber)
     {
         QString newName = baseName;
@@ -206,8 +452,74 @@ private:
         std::ofstream logDesktopFile;
         bool logDesktopFileOpen = false;
 
-        while (!logExit)
+        struct DrainCursor
+        {
+            std::shared_ptr<LogRing> ring;
+            LogRing::RecordHeader header;
+            bool hasRecord;
+        };
+        std::vector<DrainCursor> cursors;
+        unsigned cursorsVersion = 0;
+        LogLinkedList* pendingFirst = nullptr;
+        LogLinkedList* pendingLast = nullptr;
+        bool heldBack = false;
+        std::string outputBuffer;
+        std::string lastMessage;
+        unsigned lastMessageRepeats = 0;
+        outputBuffer.reserve(LOG_OUTPUT_BUFFER_SIZE * 2);
+
+        auto writeOutput = [&]()
+        {
+            if (outputBuffer.empty())
+            {
+                return;
+            }
+            if (outputFile)
+            {
+                outputFile.write(outputBuffer.data(), std::streamsize(outputBuffer.size()));
+                outFileSize += outputBuffer.size();
+            }
+            if (logDesktopFile)
+            {
+                logDesktopFile.write(outputBuffer.data(), std::streamsize(outputBuffer.size()));
+            }
+            if (g_megaSyncLogger && g_megaSyncLogger->mLogToStdout)
+            {
+                std::cout.write(outputBuffer.data(), std::streamsize(outputBuffer.size()));
+            }
+            outputBuffer.clear();
+        };
+
+        // the line has just been appended to outputBuffer at lineStart
+        auto acceptLine = [&](size_t lineStart, size_t messageOffset)
         {
+            const char* message = outputBuffer.data() + lineStart + messageOffset;
+            size_t messageSize = outputBuffer.size() - lineStart - messageOffset;
+            if (lastMessage.size() == messageSize && !memcmp(lastMessage.data(), message, messageSize))
+            {
+                ++lastMessageRepeats;
+                outputBuffer.resize(lineStart);
+                return;
+            }
+            lastMessage.assign(message, messageSize);
+            if (lastMessageRepeats)
+            {
+                char repeatbuf[31]; // this one can occur very frequently with many in a row: cURL DEBUG: schannel: failed to decrypt data, need more data
+                int n = snprintf(repeatbuf, 30, "[repeated x%u]\n", lastMessageRepeats);
+                outputBuffer.insert(lineStart, repeatbuf, size_t(n));
+                lastMessageRepeats = 0;
+            }
+            if (outputBuffer.size() >= LOG_OUTPUT_BUFFER_SIZE)
+            {
+                writeOutput();
+            }
+        };
+
+        for (bool exiting = false; !exiting; )
+        {
+            // lines logged before the exit request are still written by this last iteration
+            exiting = logExit;
+
             if (forceRenew)
             {
                 std::lock_guard<std::mutex> g(logRotationMutex);
@@ -280,15 +592,25 @@ private:
                 bool report = forceRotationForReporting;
                 forceRotationForReporting = false;
 
-                std::thread t([=]() {
+                queueCompression([this, newNameZipping, newNameDone, report]() {
                     std::lock_guard<std::mutex> g(logRotationMutex); // prevent another rotation while we work on this file (in case of unfortunate timing with bug report etc)
-                    gzipCompressOnRotate(newNameZipping, newNameDone); 
+                    auto startTime = std::chrono::steady_clock::now();
+                    auto startCpuMs = currentThreadCpuTimeMs();
+                    long long inputSize = 0;
+                    long long outputSize = 0;
+                    if (gzipCompressOnRotate(newNameZipping, newNameDone, inputSize, outputSize))
+                    {
+                        auto elapsedMs = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - startTime).count();
+                        char statsbuf[200];
+                        snprintf(statsbuf, sizeof(statsbuf), "Log rotation: compressed %lld bytes into %lld bytes in %lld ms (%lld ms CPU). Peak RSS: %lld KB",
+                                 inputSize, outputSize, (long long)elapsedMs, currentThreadCpuTimeMs() - startCpuMs, processPeakRssKB());
+                        log(mega::MegaApi::LOG_LEVEL_INFO, statsbuf);
+                    }
                     if (report && g_megaSyncLogger)
                     {
                         emit g_megaSyncLogger->logReadyForReporting();
                     }
                 });
-                t.detach();
 
     #ifdef WIN32
                 outputFile.open(filename.toStdWString().data(), std::ofstream::out);
@@ -300,20 +622,57 @@ private:
 
             LogLinkedList* newMessages = nullptr;
             bool topLevelMemoryGap = false;
+            uint64_t sequenceLimit = 0;
             {
                 std::unique_lock<std::mutex> lock(logMutex);
-                logConditionVariable.wait_for(lock, std::chrono::milliseconds(500), [this, &newMessages, &topLevelMemoryGap]() { 
-                        if (forceRenew || logListFirst.next || logExit || forceRotationForReporting || logToDesktopChanged || flushLog || closeLog)
-                        {
-                            newMessages = logListFirst.next;
-                            logListFirst.next = nullptr;
-                            logListLast = &logListFirst;
-                            topLevelMemoryGap = logListFirst.oomGap;
-                            logListFirst.oomGap = false;
-                            return true;
-                        }
-                        else return false;
+                // lines held back behind a line still being written are picked up again shortly
+                logConditionVariable.wait_for(lock, std::chrono::milliseconds(heldBack ? 1 : 500), [this]() {
+                        return forceRenew || logListFirst.next || logExit || forceRotationForReporting || logToDesktopChanged || flushLog || closeLog || ringsNeedDrain;
                 });
+                newMessages = logListFirst.next;
+                logListFirst.next = nullptr;
+                logListLast = &logListFirst;
+                topLevelMemoryGap = logListFirst.oomGap;
+                logListFirst.oomGap = false;
+
+                // list entries are numbered under this mutex, so all the lower numbers are in hand
+                sequenceLimit = logSequence.load();
+            }
+            ringsNeedDrain = false;
+
+            if (newMessages)
+            {
+                if (pendingLast)
+                {
+                    pendingLast->next = newMessages;
+                }
+                else
+                {
+                    pendingFirst = newMessages;
+                }
+                for (pendingLast = newMessages; pendingLast->next; pendingLast = pendingLast->next);
+            }
+
+            if (ringsVersion != cursorsVersion)
+            {
+                std::lock_guard<std::mutex> g(ringsMutex);
+                cursors.clear();
+                for (auto& ring : rings)
+                {
+                    cursors.push_back(DrainCursor{ring, LogRing::RecordHeader(), false});
+                }
+                cursorsVersion = ringsVersion;
+            }
+
+            // A producer publishes its in-flight lower bound before taking a sequence number, so any
+            // line numbered below sequenceLimit is either in its ring already or covered by inFlight
+            for (auto& cursor : cursors)
+            {
+                sequenceLimit = std::min(sequenceLimit, cursor.ring->inFlight.load());
+            }
+            for (auto& cursor : cursors)
+            {
+                cursor.hasRecord = cursor.ring->peek(cursor.header);
             }
 
             if (logToDesktopChanged)
@@ -336,68 +695,106 @@ private:
 
             if (topLevelMemoryGap)
             {
-                if (outputFile)
-                {
-                    outputFile << "<log gap - out of logging memory at this point>\n";
-                }
-                if (logDesktopFile)
-                {
-                    logDesktopFile << "<log gap - out of logging memory at this point>\n";
-                }
+                outputBuffer.append("<log gap - out of logging memory at this point>\n");
             }
 
-            while (newMessages)
+            // merge the rings and the list in sequence order
+            for (;;)
             {
-                auto p = newMessages;
-                newMessages = newMessages->next;
-                if (outputFile)
+                DrainCursor* next = nullptr;
+                uint64_t nextSequence = sequenceLimit;
+                for (auto& cursor : cursors)
                 {
-                    if (p->needsDirectOutput())
+                    if (cursor.hasRecord && cursor.header.sequence < nextSequence)
                     {
-                        (*p->mDirectLoggingFunction)(&outputFile);
-                    }
-                    else
-                    {
-                        outputFile << p->message;
-                        outFileSize += p->used;
-                        if (p->oomGap)
-                        {
-                            outputFile << "<log gap - out of logging memory at this point>\n";
-                        }
+                        nextSequence = cursor.header.sequence;
+                        next = &cursor;
                     }
                 }
-                if (logDesktopFile)
+
+                if (pendingFirst && pendingFirst->sequence < nextSequence)
                 {
-                    if (p->needsDirectOutput())
+                    auto p = pendingFirst;
+                    pendingFirst = p->next;
+                    if (!pendingFirst)
                     {
-                        (*p->mDirectLoggingFunction)(&logDesktopFile);
+                        pendingLast = nullptr;
                     }
-                    else
-                    {
-                        logDesktopFile << p->message;
-                        if (p->oomGap)
-                        {
-                            logDesktopFile << "<log gap - out of logging memory at this point>\n";
-                        }
-                    }
-                    logDesktopFile.flush(); //always flush in `active` logging
-                }
 
-                if (g_megaSyncLogger && g_megaSyncLogger->mLogToStdout)
-                {
                     if (p->needsDirectOutput())
                     {
-                        (*p->mDirectLoggingFunction)(&std::cout);
+                        writeOutput();
+                        lastMessage.clear();
+                        if (outputFile)
+                        {
+                            (*p->mDirectLoggingFunction)(&outputFile);
+                        }
+                        if (logDesktopFile)
+                        {
+                            (*p->mDirectLoggingFunction)(&logDesktopFile);
+                        }
+                        if (g_megaSyncLogger && g_megaSyncLogger->mLogToStdout)
+                        {
+                            (*p->mDirectLoggingFunction)(&std::cout);
+                        }
                     }
                     else
                     {
-                        std::cout << p->message;
+                        size_t lineStart = outputBuffer.size();
+                        outputBuffer.append(p->message, p->used);
+                        acceptLine(lineStart, p->messageOffset);
                     }
-                    std::cout << std::flush; //always flush into stdout (DEBUG mode)
+                    p->notifyWaiter();
+                    free(p);
+                    continue;
+                }
+
+                if (!next)
+                {
+                    break;
                 }
-                p->notifyWaiter();
-                free(p);
+
+                size_t lineStart = outputBuffer.size();
+                next->ring->pop(next->header, outputBuffer);
+                acceptLine(lineStart, next->header.messageOffset);
+                next->hasRecord = next->ring->peek(next->header);
             }
+            writeOutput();
+
+            heldBack = pendingFirst != nullptr;
+            bool prune = false;
+            for (auto& cursor : cursors)
+            {
+                if (cursor.hasRecord)
+                {
+                    heldBack = true;
+                }
+                else if (cursor.ring->orphaned)
+                {
+                    prune = true;
+                }
+            }
+
+            if (prune)
+            {
+                // the owning threads are gone and their lines are written
+                std::lock_guard<std::mutex> g(ringsMutex);
+                rings.erase(std::remove_if(rings.begin(), rings.end(), [](const std::shared_ptr<LogRing>& ring) {
+                    LogRing::RecordHeader header;
+                    return ring->orphaned && !ring->peek(header);
+                }), rings.end());
+                ++ringsVersion;
+            }
+
+            if (logDesktopFile)
+            {
+                logDesktopFile.flush(); //always flush in `active` logging
+            }
+            if (g_megaSyncLogger && g_megaSyncLogger->mLogToStdout)
+            {
+                std::cout << std::flush; //always flush into stdout (DEBUG mode)
+            }
+
             if (flushLog || forceRotationForReporting || nextFlushTime <= std::chrono::steady_clock::now())
             {
                 flushLog = false;
@@ -463,6 +860,7 @@ MegaSyncLogger::~MegaSyncLogger()
     g_megaSyncLogger = nullptr;
     g_loggingThread->logThread->join();
     g_loggingThread->logThread.reset();
+    g_loggingThread->stopCompressionThread();
 }
 
 inline void twodigit(char*& s, int n)
@@ -497,39 +895,28 @@ char* filltime(char* s, struct tm*  gmt, int microsec)
     return s;
 }
 
-std::mutex threadNameMutex;
-std::map<std::thread::id, std::string> threadNames;
-struct tm lastTm;
-time_t lastT = 0;
-std::thread::id lastThreadId;
-const char* lastThreadName;
-
+// Thread name and broken down time are cached per thread, so formatting a line doesn't need any lock
 void cacheThreadNameAndTimeT(time_t t, struct tm& gmt, const char*& threadname)
 {
-    std::lock_guard<std::mutex> g(threadNameMutex);
-
-    if (t != lastT)
-    {
-        lastTm = *std::gmtime(&t);
-        lastT = t;
-    }
-    gmt = lastTm;
-
-    if (lastThreadId == std::this_thread::get_id())
+    ThreadLogState& state = tlsLogState;
+    if (t != state.lastT)
     {
-        threadname = lastThreadName;
-        return;
+#ifdef _WIN32
+        gmtime_s(&state.lastTm, &t);
+#else
+        gmtime_r(&t, &state.lastTm);
+#endif
+        state.lastT = t;
     }
+    gmt = state.lastTm;
 
-    auto& entry = threadNames[std::this_thread::get_id()];
-    if (entry.empty())
+    if (state.threadName.empty())
     {
         std::ostringstream s;
         s << std::this_thread::get_id() << " ";
-        entry = s.str();
+        state.threadName = s.str();
     }
-    threadname = lastThreadName = entry.c_str();
-    lastThreadId = std::this_thread::get_id();
+    threadname = state.threadName.c_str();
 }
 
 void MegaSyncLogger::log(const char*, int loglevel, const char*, const char *message
@@ -592,114 +979,134 @@ void LoggingThread::log(int loglevel, const char *message, const char **directMe
     case mega::MegaApi::LOG_LEVEL_DEBUG: loglevelstring = "DBG  "; break;
     case mega::MegaApi::LOG_LEVEL_MAX: loglevelstring = "DTL  "; break;
     }
-    
-    auto messageLen = strlen(message);
-    auto threadnameLen = strlen(threadname);
-    auto lineLen = LOG_TIME_CHARS + threadnameLen + LOG_LEVEL_CHARS + messageLen;
-    bool notify = false;
 
+    size_t messageLen = 0;
+    if (direct)
     {
-        std::unique_ptr<std::lock_guard<std::mutex>> g(new std::lock_guard<std::mutex>(logMutex));
-
-        bool isRepeat = !direct && logListLast != &logListFirst &&
-                        logListLast->lastmessage >= 0 && 
-                        !strncmp(message, logListLast->message + logListLast->lastmessage, messageLen);
+        for (int i = 0; i < numberMessages; i++)
+        {
+            messageLen += directMessagesSizes[i];
+        }
+    }
+    else
+    {
+        messageLen = strlen(message);
+    }
+    auto threadnameLen = strlen(threadname);
+    auto prefixLen = LOG_TIME_CHARS + threadnameLen + LOG_LEVEL_CHARS;
+    auto lineLen = prefixLen + messageLen + 1;
+    bool flush = loglevel <= flushOnLevel;
 
-        if (isRepeat)
+    LogRing* ring = threadRing();
+    auto recordSize = sizeof(LogRing::RecordHeader) + lineLen;
+    if (ring && recordSize <= ring->freeSpace())
+    {
+        LogRing::RecordHeader header;
+        header.size = uint32_t(lineLen);
+        header.messageOffset = uint32_t(prefixLen);
+
+        // publish a lower bound first, so the logging thread never writes a later line before this one
+        ring->inFlight = logSequence.load();
+        header.sequence = logSequence++;
+
+        uint64_t position = ring->head.load(std::memory_order_relaxed);
+        bool wasBelowHalf = position - ring->tail.load(std::memory_order_acquire) < ring->capacity / 2;
+        ring->write(position, reinterpret_cast<const char*>(&header), sizeof(header));
+        ring->write(position, timebuf, LOG_TIME_CHARS);
+        ring->write(position, threadname, threadnameLen);
+        ring->write(position, loglevelstring, LOG_LEVEL_CHARS);
+        if (direct)
         {
-            ++logListLast->lastmessageRepeats;
+            for (int i = 0; i < numberMessages; i++)
+            {
+                ring->write(position, directMessages[i], directMessagesSizes[i]);
+            }
         }
         else
         {
-            unsigned reportRepeats = logListLast != &logListFirst ? logListLast->lastmessageRepeats : 0;
-            if (reportRepeats)
+            ring->write(position, message, messageLen);
+        }
+        ring->write(position, "\n", 1);
+        ring->head.store(position, std::memory_order_release);
+        ring->inFlight = NO_LOG_SEQUENCE;
+
+        if (flush)
+        {
+            // Lines to be flushed right away still wake the logging thread. Taking the mutex
+            // makes sure it is waiting, or will see the flag, before it is notified
             {
-                lineLen += 30;
-                logListLast->lastmessageRepeats = 0;
+                std::lock_guard<std::mutex> g(logMutex);
+                flushLog = true;
             }
+            logConditionVariable.notify_one();
+        }
+        else if (wasBelowHalf && position - ring->tail.load(std::memory_order_acquire) >= ring->capacity / 2)
+        {
+            // This notify call was taking 1% when notifying on every log line, so let the other thead
+            // wake up by itself every 500ms without notify for the common case.
+            // But still wake it if our ring is getting full
+            ringsNeedDrain = true;
+            logConditionVariable.notify_one();
+        }
+        return;
+    }
 
-            if (direct)
+    // Oversized lines, or any line while our ring is full, take the slower path through the locked list
+    std::unique_lock<std::mutex> g(logMutex);
+    if (flush)
+    {
+        flushLog = true;
+    }
+    if (direct)
+    {
+        if (LogLinkedList* newentry = LogLinkedList::create(logListLast, 1 + sizeof(LogLinkedList))) //create a new "empty" element
+        {
+            logListLast = newentry;
+            newentry->sequence = logSequence++;
+            std::promise<void> promise;
+            newentry->mCompletionPromise = &promise;
+            auto future = promise.get_future();
+            DirectLogFunction func = [&timebuf, &threadname, &loglevelstring, &directMessages, &directMessagesSizes, numberMessages](std::ostream *oss)
             {
-                if (LogLinkedList* newentry = LogLinkedList::create(logListLast, 1 + sizeof(LogLinkedList))) //create a new "empty" element
-                {
-                    logListLast = newentry;
-                    std::promise<void> promise;
-                    logListLast->mCompletionPromise = &promise;
-                    auto future = logListLast->mCompletionPromise->get_future();
-                    DirectLogFunction func = [&timebuf, &threadname, &loglevelstring, &directMessages, &directMessagesSizes, numberMessages](std::ostream *oss)
-                    {
-                        *oss << timebuf << threadname << loglevelstring;
-
-                        for(int i = 0; i < numberMessages; i++)
-                        {
-                            oss->write(directMessages[i], directMessagesSizes[i]);
-                        }
-                        *oss << std::endl;
-                    };
-
-                    logListLast->mDirectLoggingFunction = &func;
-
-                    g.reset(); //to liberate the mutex and let the logging thread call the logging function
-
-                    logConditionVariable.notify_one();
+                *oss << timebuf << threadname << loglevelstring;
 
-                    //wait for until logging thread completes the outputting
-                    future.get();
-                    return;
-                }
-                else
+                for(int i = 0; i < numberMessages; i++)
                 {
-                    logListLast->oomGap = true;
+                    oss->write(directMessages[i], directMessagesSizes[i]);
                 }
+                *oss << std::endl;
+            };
 
-            }
-            else
-            {
-                if (logListLast == &logListFirst || logListLast->oomGap || !logListLast->messageFits(lineLen))
-                {
-                    if (LogLinkedList* newentry = LogLinkedList::create(logListLast, std::max<size_t>(lineLen, 8192) + sizeof(LogLinkedList) + 10))
-                    {
-                        logListLast = newentry;
-                    }
-                    else
-                    {
-                        logListLast->oomGap = true;
-                    }
-                }
-                if (!logListLast->oomGap)
-                {
-                    if (reportRepeats)
-                    {
-                        char repeatbuf[31]; // this one can occur very frequently with many in a row: cURL DEBUG: schannel: failed to decrypt data, need more data
-                        int n = snprintf(repeatbuf, 30, "[repeated x%u]\n", reportRepeats);
-                        logListLast->append(repeatbuf, n);
-                    }
-                    logListLast->append(timebuf, LOG_TIME_CHARS);
-                    logListLast->append(threadname, unsigned(threadnameLen));
-                    logListLast->append(loglevelstring, LOG_LEVEL_CHARS);
-                    logListLast->lastmessage = logListLast->used;
-                    logListLast->append(message, unsigned(messageLen));
-                    logListLast->append("\n", 1);
-                    notify = logListLast->used + 1024 > logListLast->allocated;
-                }
-            }
-        }
+            newentry->mDirectLoggingFunction = &func;
 
-        if (loglevel <= flushOnLevel)
-        {
-            flushLog = true;
+            g.unlock(); //to liberate the mutex and let the logging thread call the logging function
+
+            logConditionVariable.notify_one();
+
+            //wait for until logging thread completes the outputting
+            future.get();
+            return;
         }
     }
-    
-    if (notify)
+    else if (LogLinkedList* newentry = LogLinkedList::create(logListLast, lineLen + sizeof(LogLinkedList) + 10))
     {
-        // notify outside the mutex lock is better (and correct) for much less chance the other 
-        // thread wakes up just to find the mutex locked. (saw lower cpu on the other thread like this)
-        // Still, this notify call was taking 1% when notifying on every log line, so let the other thead
-        // wake up by itself every 500ms without notify for the common case.
-        // But still wake it if our memory block is getting full
+        logListLast = newentry;
+        newentry->sequence = logSequence++;
+        newentry->append(timebuf, LOG_TIME_CHARS);
+        newentry->append(threadname, unsigned(threadnameLen));
+        newentry->append(loglevelstring, LOG_LEVEL_CHARS);
+        newentry->messageOffset = newentry->used;
+        newentry->append(message, unsigned(messageLen));
+        newentry->append("\n", 1);
+
+        // notify outside the mutex lock is better (and correct) for much less chance the other
+        // thread wakes up just to find the mutex locked
+        g.unlock();
         logConditionVariable.notify_one();
+        return;
     }
+
+    logListFirst.oomGap = true;
 }
 
 void MegaSyncLogger::setDebug(const bool enable)
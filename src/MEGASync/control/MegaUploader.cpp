@@ -1,6 +1,7 @@
 #include "MegaUploader.h"
 #include <QThread>
 #include "control/Utilities.h"
+#include "control/ThreadPool.h"
 #include "MegaApplication.h"
 #include <QMessageBox>
 #include <QtCore>
@@ -16,9 +17,143 @@
 #include <utime.h>
 #endif
 
+#ifdef __linux__
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <linux/fs.h>
+#include <unistd.h>
+#endif
+
+#if defined(__APPLE__) && defined(__has_include)
+#if __has_include(<sys/clonefile.h>)
+#include <sys/clonefile.h>
+#define MEGA_HAS_CLONEFILE
+#endif
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <vector>
+
 using namespace mega;
 using namespace std;
 
+namespace
+{
+const int MAX_CONCURRENT_FOLDER_REQUESTS = 64;
+const int MAX_QUEUED_FILE_COPIES = 256;
+const qint64 LOCAL_COPY_PROGRESS_INTERVAL_MS = 500;
+
+// Bounds how many file copies are queued or running at a time
+class CopyThrottle
+{
+public:
+    explicit CopyThrottle(int maxInFlight) : mMaxInFlight(maxInFlight) {}
+
+    void acquire()
+    {
+        std::unique_lock<std::mutex> lock(mMutex);
+        mCondition.wait(lock, [this]() { return mInFlight < mMaxInFlight; });
+        mInFlight++;
+    }
+
+    void release()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mInFlight--;
+        }
+        mCondition.notify_all();
+    }
+
+    void waitIdle()
+    {
+        std::unique_lock<std::mutex> lock(mMutex);
+        mCondition.wait(lock, [this]() { return mInFlight == 0; });
+    }
+
+private:
+    std::mutex mMutex;
+    std::condition_variable mCondition;
+    int mInFlight = 0;
+    const int mMaxInFlight;
+};
+
+// Like QFile::copy (fails if the destination exists), but uses copy-on-write clones or
+// in-kernel copies where the platform offers them, falling back to QFile::copy
+bool copyFileFast(const QString& srcPath, const QString& dstPath)
+{
+#if defined(__linux__)
+    const QByteArray src = QFile::encodeName(srcPath);
+    const QByteArray dst = QFile::encodeName(dstPath);
+    int in = open(src.constData(), O_RDONLY | O_CLOEXEC);
+    if (in >= 0)
+    {
+        struct stat st;
+        int out = fstat(in, &st) ? -1 : open(dst.constData(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, st.st_mode & 0777);
+        if (out < 0)
+        {
+            bool exists = errno == EEXIST;
+            close(in);
+            if (exists)
+            {
+                return false;
+            }
+        }
+        else
+        {
+            bool done = false;
+#ifdef FICLONE
+            done = !ioctl(out, FICLONE, in);
+#endif
+#ifdef __NR_copy_file_range
+            if (!done)
+            {
+                done = true;
+                for (off_t remaining = st.st_size; remaining > 0; )
+                {
+                    ssize_t copied = syscall(__NR_copy_file_range, in, nullptr, out, nullptr, size_t(std::min<off_t>(remaining, 1 << 30)), 0);
+                    if (copied < 0)
+                    {
+                        done = false; // e.g. EXDEV on older kernels
+                        break;
+                    }
+                    if (!copied)
+                    {
+                        break; // the source shrank while copying
+                    }
+                    remaining -= copied;
+                }
+            }
+#endif
+            close(out);
+            close(in);
+            if (done)
+            {
+                return true;
+            }
+            QFile::remove(dstPath);
+        }
+    }
+#elif defined(MEGA_HAS_CLONEFILE)
+    if (!clonefile(QFile::encodeName(srcPath).constData(), QFile::encodeName(dstPath).constData(), 0))
+    {
+        return true;
+    }
+    if (errno == EEXIST)
+    {
+        return false;
+    }
+#endif
+    return QFile::copy(srcPath, dstPath);
+}
+}
+
 MegaUploader::MegaUploader(MegaApi *megaApi)
 {
     this->megaApi = megaApi;
@@ -43,31 +178,15 @@ bool MegaUploader::filesdiffer(QFileInfo &source, QFileInfo &destination)
         return true;
     }
 
-    QCryptographicHash hashsrc( QCryptographicHash::Sha1 );
-    QFile filesrc( source.absoluteFilePath() );
-    if ( filesrc.open( QIODevice::ReadOnly ) ) {
-        hashsrc.addData( filesrc.readAll() );
-    } else {
-        return true;
-    }
-
-    QCryptographicHash hashdst( QCryptographicHash::Sha1 );
-    QFile filedst( destination.absoluteFilePath() );
-    if ( filedst.open( QIODevice::ReadOnly ) ) {
-        hashdst.addData( filedst.readAll() );
-    } else {
-        return true;
-    }
-
-    if (hashdst.result() != hashsrc.result())
-    {
-        return true;
-    }
-    return false;
+    return Utilities::fileContentsDiffer(source.absoluteFilePath(), destination.absoluteFilePath());
 }
 
 /**
  * @brief MegaUploader::uploadRecursivelyIntoASyncedLocation
+ * Folders are processed one tree level at a time: the missing remote folders of a level are created
+ * with concurrent requests, then the local folders are created and their files handed to a bounded
+ * pool of copiers while the next level is prepared.
+ * Progress and the final result are reported with localCopyProgress and localCopyFinished
  * @param srcFileInfo local path to be copied uploaded
  * @param destPath corresponding local synced path where srcFileInfo would end
  * @param parent node parent that will hold the uploaded file/folder
@@ -76,7 +195,6 @@ bool MegaUploader::filesdiffer(QFileInfo &source, QFileInfo &destination)
  */
 bool MegaUploader::uploadRecursivelyIntoASyncedLocation(QFileInfo srcFileInfo, QString destPath, MegaNode *parent, unsigned long long appDataID)
 {
-    bool toret = true;
     if (!srcFileInfo.exists())
     {
         MegaApi::log(MegaApi::LOG_LEVEL_ERROR, QString::fromUtf8("Recursive upload failed: source file non existing: %1").arg(srcFileInfo.absoluteFilePath()).toUtf8().constData());
@@ -110,76 +228,217 @@ bool MegaUploader::uploadRecursivelyIntoASyncedLocation(QFileInfo srcFileInfo, Q
         return true;
     }
 
-    QFileInfo dstfileinfo(destPath);
+    if (srcFileInfo.isFile())
+    {
+        bool toret = copyFileIntoSyncedLocation(srcFileInfo, destPath);
+        emit localCopyFinished(appDataID, false, toret);
+        return toret;
+    }
 
-    if (srcFileInfo.isFile()) //if copying a file: replace (moving to debris if existing and different)
+    QFileInfo dstfileinfo(destPath);
+    if (dstfileinfo.exists() && !dstfileinfo.isDir()) //if local destiny is a file, move it to debris
     {
-        if (dstfileinfo.exists() && (dstfileinfo.isDir() || filesdiffer(srcFileInfo, dstfileinfo)))
-        {
-            megaApi->moveToLocalDebris(destPath.toUtf8().constData());
-        }
-        QFile src(srcPath);
-        src.copy(destPath); //This will fail if file exists, which should only happen if they don't differ
-#ifndef _WIN32
-       time_t t = srcFileInfo.lastModified().toTime_t();
-       struct utimbuf times = { t, t };
-       utime(destPath.toUtf8().constData(), &times);
-#endif
+        megaApi->moveToLocalDebris(destPath.toUtf8().constData());
     }
-    else if (srcFileInfo.isDir()) // for folders we need to recurse
+
+    bool toret = true;
+    std::atomic<bool> copiesOk(true);
+    std::atomic<int> filesCopied(0);
+    std::atomic<int> filesQueued(0);
+    QElapsedTimer progressTimer;
+    progressTimer.start();
+    std::atomic<qint64> lastProgressMs(0);
+    int foldersDone = 0;
+    CopyThrottle throttle(MAX_QUEUED_FILE_COPIES);
+    ThreadPool copiers(ThreadPool::defaultThreadCount());
+
+    QVector<FolderToCopy> level;
+    level.append(FolderToCopy{srcFileInfo, destPath, std::shared_ptr<MegaNode>(parent->copy())});
+    while (!level.isEmpty())
     {
-        if (dstfileinfo.exists() && !dstfileinfo.isDir()) //if local destiny is a file, move it to debris
-        {
-            megaApi->moveToLocalDebris(destPath.toUtf8().constData());
-        }
+        QVector<std::shared_ptr<MegaNode>> remoteFolders = getOrCreateRemoteFolders(level);
 
-        // get the corresponding remote parent or create if non existent
-        std::unique_ptr<MegaNode> newParent(megaApi->getNodeByPath(srcFileInfo.fileName().toUtf8().constData(), parent) );
-        if (!newParent || !newParent->isFolder()) //for files it will leave the file and create a folder, same as regular upload
+        QVector<FolderToCopy> nextLevel;
+        for (int i = 0; i < level.size(); i++)
         {
-            newParent.reset(); //for files, we don't want them, we'll create a new folder
-
-            unique_ptr<SynchronousRequestListener> srl(new SynchronousRequestListener());
-
-            megaApi->createFolder(srcFileInfo.fileName().toUtf8().constData(), parent, srl.get());
-            srl->wait();
-            if (srl->getError()->getErrorCode() == MegaError::API_OK)
+            const FolderToCopy& folder = level.at(i);
+            const std::shared_ptr<MegaNode>& newParent = remoteFolders.at(i);
+            if (!newParent)
             {
-                newParent.reset(megaApi->getNodeByHandle(srl->getRequest()->getNodeHandle()));
+                toret = false;
+                continue;
             }
-            else
+
+            //create local folder if non existent. Note this should happen after creating remote folder, otherwise sync algorithm may produce duplicates
+            QDir dstDir(folder.destPath);
+            dstDir.mkpath(QString::fromAscii(".")); //this will do nothing if already exists
+
+            QDirIterator di(QDir::toNativeSeparators(folder.source.absoluteFilePath()), QDir::AllEntries | QDir::Hidden | QDir::NoDotAndDotDot);
+            while (di.hasNext())
             {
-                MegaApi::log(MegaApi::LOG_LEVEL_ERROR, QString::fromUtf8("Failed to create folder recursive upload: %1").arg(srcFileInfo.fileName()).toUtf8().constData());
-                return false;
+                di.next();
+                QFileInfo entry = di.fileInfo();
+                if (entry.isSymLink() || di.filePath() == folder.destPath)
+                {
+                    continue;
+                }
+
+                QString entryPath = QDir::toNativeSeparators(entry.absoluteFilePath());
+                QString entryDestPath = QDir::toNativeSeparators(folder.destPath + QDir::separator() + di.fileName());
+                if (!entry.isFile() && !entry.isDir())
+                {
+                    MegaApi::log(MegaApi::LOG_LEVEL_DEBUG, QString::fromUtf8("Recursive upload skipping non file/folder: %1").arg(entryPath).toUtf8().constData());
+                    continue;
+                }
+
+                if (!megaApi->isSyncable(entryDestPath.toUtf8().constData(), entry.size()))
+                {
+                    MegaApi::log(MegaApi::LOG_LEVEL_DEBUG, QString::fromUtf8("Recursive upload uploading non syncable path: %1").arg(entryPath).toUtf8().constData());
+                    uploadNonSyncable(entryPath, newParent.get(), appDataID);
+                    continue;
+                }
+
+                if (entry.isDir())
+                {
+                    QFileInfo entryDestInfo(entryDestPath);
+                    if (entryDestInfo.exists() && !entryDestInfo.isDir())
+                    {
+                        megaApi->moveToLocalDebris(entryDestPath.toUtf8().constData());
+                    }
+                    nextLevel.append(FolderToCopy{entry, entryDestPath, newParent});
+                    continue;
+                }
+
+                throttle.acquire();
+                filesQueued++;
+                copiers.submit([this, entry, entryDestPath, appDataID, &copiesOk, &filesCopied, &filesQueued,
+                               &progressTimer, &lastProgressMs, &throttle]()
+                {
+                    if (!copyFileIntoSyncedLocation(entry, entryDestPath))
+                    {
+                        copiesOk = false;
+                    }
+                    const int copied = ++filesCopied;
+
+                    // Only the copier that claims the interval reports it
+                    qint64 lastMs = lastProgressMs.load();
+                    const qint64 nowMs = progressTimer.elapsed();
+                    if (nowMs - lastMs >= LOCAL_COPY_PROGRESS_INTERVAL_MS
+                            && lastProgressMs.compare_exchange_strong(lastMs, nowMs))
+                    {
+                        emit localCopyProgress(appDataID, copied, filesQueued.load());
+                    }
+                    throttle.release();
+                });
             }
         }
 
-        if (!newParent) //just in case getNodeByHandle for just created folder
+        foldersDone += level.size();
+        MegaApi::log(MegaApi::LOG_LEVEL_DEBUG, QString::fromUtf8("Recursive upload progress: %1 folders processed, %2 of %3 files copied")
+                     .arg(foldersDone).arg(filesCopied.load()).arg(filesQueued.load()).toUtf8().constData());
+        level.swap(nextLevel);
+    }
+
+    throttle.waitIdle();
+    emit localCopyProgress(appDataID, filesCopied.load(), filesQueued.load());
+    toret = toret && copiesOk;
+    emit localCopyFinished(appDataID, true, toret);
+    return toret;
+}
+
+bool MegaUploader::copyFileIntoSyncedLocation(QFileInfo srcFileInfo, const QString& destPath)
+{
+    QFileInfo dstfileinfo(destPath);
+    //if copying a file: replace (moving to debris if existing and different)
+    if (dstfileinfo.exists() && (dstfileinfo.isDir() || filesdiffer(srcFileInfo, dstfileinfo)))
+    {
+        megaApi->moveToLocalDebris(destPath.toUtf8().constData());
+    }
+
+    //This will fail if file exists, which should only happen if they don't differ
+    if (!copyFileFast(QDir::toNativeSeparators(srcFileInfo.absoluteFilePath()), destPath))
+    {
+        if (!QFileInfo::exists(destPath))
         {
-            MegaApi::log(MegaApi::LOG_LEVEL_ERROR, QString::fromUtf8("Failed to obtain newfolder at recursive upload: %1").arg(srcFileInfo.fileName()).toUtf8().constData());
+            MegaApi::log(MegaApi::LOG_LEVEL_ERROR, QString::fromUtf8("Recursive upload failed to copy %1 to %2")
+                         .arg(srcFileInfo.absoluteFilePath()).arg(destPath).toUtf8().constData());
             return false;
         }
+        return true;
+    }
+#ifndef _WIN32
+    time_t t = srcFileInfo.lastModified().toTime_t();
+    struct utimbuf times = { t, t };
+    utime(destPath.toUtf8().constData(), &times);
+#endif
+    return true;
+}
 
-        //create local folder if non existent. Note this should happen after creating remote folder, otherwise sync algorithm may produce duplicates
-        QDir dstDir(destPath);
-        dstDir.mkpath(QString::fromAscii(".")); //this will do nothing if already exists
+QVector<std::shared_ptr<MegaNode>> MegaUploader::getOrCreateRemoteFolders(const QVector<FolderToCopy>& folders)
+{
+    QVector<std::shared_ptr<MegaNode>> result(folders.size());
+    QVector<int> missing;
+    for (int i = 0; i < folders.size(); i++)
+    {
+        // get the corresponding remote folder if it already exists
+        std::shared_ptr<MegaNode> node(megaApi->getNodeByPath(folders.at(i).source.fileName().toUtf8().constData(), folders.at(i).parent.get()));
+        if (node && node->isFolder()) //for files it will leave the file and create a folder, same as regular upload
+        {
+            result[i] = node;
+        }
+        else
+        {
+            missing.append(i);
+        }
+    }
 
-        //loop all contents and call recursive algorithm
-        QDirIterator di(srcPath, QDir::AllEntries | QDir::Hidden | QDir::NoDotAndDotDot);
-        while (di.hasNext())
+    // Requests are not waited one by one: a batch is sent in a row so the SDK can pack them together
+    for (int first = 0; first < missing.size(); first += MAX_CONCURRENT_FOLDER_REQUESTS)
+    {
+        const int count = std::min(MAX_CONCURRENT_FOLDER_REQUESTS, missing.size() - first);
+        std::vector<std::unique_ptr<SynchronousRequestListener>> listeners;
+        for (int j = 0; j < count; j++)
         {
-            di.next();
-            if (!di.fileInfo().isSymLink() && (di.filePath() != destPath))
+            const FolderToCopy& folder = folders.at(missing.at(first + j));
+            listeners.emplace_back(new SynchronousRequestListener());
+            megaApi->createFolder(folder.source.fileName().toUtf8().constData(), folder.parent.get(), listeners.back().get());
+        }
+
+        for (int j = 0; j < count; j++)
+        {
+            const int index = missing.at(first + j);
+            const QString folderName = folders.at(index).source.fileName();
+            SynchronousRequestListener* srl = listeners.at(j).get();
+            srl->wait();
+            if (srl->getError()->getErrorCode() != MegaError::API_OK)
             {
-                if (newParent)
-                {
-                    bool r = uploadRecursivelyIntoASyncedLocation(di.fileInfo(), QDir::toNativeSeparators(destPath + QDir::separator() + di.fileName()), newParent.get(), appDataID);
-                    toret = r && toret;
-                }
+                MegaApi::log(MegaApi::LOG_LEVEL_ERROR, QString::fromUtf8("Failed to create folder recursive upload: %1").arg(folderName).toUtf8().constData());
+                continue;
+            }
+
+            result[index].reset(megaApi->getNodeByHandle(srl->getRequest()->getNodeHandle()));
+            if (!result.at(index)) //just in case getNodeByHandle for just created folder
+            {
+                MegaApi::log(MegaApi::LOG_LEVEL_ERROR, QString::fromUtf8("Failed to obtain newfolder at recursive upload: %1").arg(folderName).toUtf8().constData());
             }
         }
     }
-    return  toret;
+    return result;
+}
+
+void MegaUploader::uploadNonSyncable(const QString& srcPath, MegaNode *parent, unsigned long long appDataID)
+{
+    // the finished transfer will be accounted in the same metadata, so count it first
+    Utilities::queueFunctionInAppThread([appDataID]()
+    {
+        TransferMetaData *data = ((MegaApplication*)qApp)->getTransferAppData(appDataID);
+        if (data)
+        {
+            data->totalTransfers++;
+            data->pendingTransfers++;
+        }
+    });
+    megaApi->startUploadWithData(srcPath.toUtf8().constData(), parent, (QString::number(appDataID) + QString::fromUtf8("*")).toUtf8().constData());
 }
 
 void MegaUploader::upload(QFileInfo info, MegaNode *parent, unsigned long long appDataID)
@@ -221,7 +480,11 @@ void MegaUploader::upload(QFileInfo info, MegaNode *parent, unsigned long long a
     {
         if (!destPath.startsWith(QFileInfo(currentPath).canonicalFilePath()))//to avoid recurses //note: destPath should have been cannonicalized already
         {
-            QtConcurrent::run(this, &MegaUploader::uploadRecursivelyIntoASyncedLocation, QFileInfo(currentPath), destPath, parent->copy(), appDataID);
+            std::shared_ptr<MegaNode> parentCopy(parent->copy());
+            QtConcurrent::run([this, currentPath, destPath, parentCopy, appDataID]()
+            {
+                uploadRecursivelyIntoASyncedLocation(QFileInfo(currentPath), destPath, parentCopy.get(), appDataID);
+            });
         }
         else
         {
@@ -5,10 +5,13 @@
 #include <QFileInfo>
 #include <QDir>
 #include <QQueue>
+#include <QVector>
 #include "Preferences.h"
 #include "megaapi.h"
 #include "QTMegaRequestListener.h"
 
+#include <memory>
+
 class MegaUploader : public QObject
 {
     Q_OBJECT
@@ -21,9 +24,26 @@ public:
     bool uploadRecursivelyIntoASyncedLocation(QFileInfo srcPath, QString destPath, mega::MegaNode *parent, unsigned long long appDataID);
 
 protected:
+    // A local folder whose remote counterpart is to be found or created under parent
+    struct FolderToCopy
+    {
+        QFileInfo source;
+        QString destPath;
+        std::shared_ptr<mega::MegaNode> parent;
+    };
+
     void upload(QFileInfo info, mega::MegaNode *parent, unsigned long long appDataID);
+    void uploadNonSyncable(const QString& srcPath, mega::MegaNode *parent, unsigned long long appDataID);
+    bool copyFileIntoSyncedLocation(QFileInfo srcFileInfo, const QString& destPath);
+    QVector<std::shared_ptr<mega::MegaNode>> getOrCreateRemoteFolders(const QVector<FolderToCopy>& folders);
 
     mega::MegaApi *megaApi;
+
+signals:
+    // Emitted from the copying threads while a folder is copied into a synced location
+    void localCopyProgress(unsigned long long appDataID, int filesCopied, int filesQueued);
+    // The synced copy gets uploaded by the sync engine, so for the user the upload is done
+    void localCopyFinished(unsigned long long appDataID, bool isFolder, bool success);
 };
 
 #endif // MEGAUPLOADER_H
@@ -0,0 +1,228 @@
+#include "MemorySampler.h"
+
+#include <QDateTime>
+#include <QFile>
+#include <QStringList>
+
+#include <algorithm>
+
+#if defined(__linux__) || defined(__FreeBSD__)
+#include <unistd.h>
+#endif
+
+#ifdef __FreeBSD__
+#include <sys/types.h>
+#include <sys/sysctl.h>
+#include <sys/user.h>
+#endif
+
+constexpr unsigned int MemorySampler::MAX_SAMPLES;
+constexpr unsigned int MemorySampler::MIN_TREND_SAMPLES;
+constexpr double MemorySampler::GROWTH_THRESHOLD;
+
+namespace
+{
+QString megabytes(long long bytes)
+{
+    return QString::fromUtf8("%1 MB").arg(bytes / 1048576.0, 0, 'f', 1);
+}
+
+#ifdef __linux__
+// Values of smaps_rollup are in kB: "Rss:              123456 kB"
+bool readSmapsRollup(MemorySampler::Usage& usage)
+{
+    QFile file(QString::fromUtf8("/proc/self/smaps_rollup"));
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        return false;
+    }
+
+    bool hasRss = false;
+    QByteArray line;
+    while (!(line = file.readLine()).isEmpty())
+    {
+        long long* field = nullptr;
+        if (line.startsWith("Rss:"))
+        {
+            field = &usage.residentBytes;
+            hasRss = true;
+        }
+        else if (line.startsWith("Pss:"))
+        {
+            field = &usage.proportionalBytes;
+        }
+        else if (line.startsWith("Anonymous:"))
+        {
+            field = &usage.anonymousBytes;
+        }
+
+        if (field)
+        {
+            QList<QByteArray> parts = line.simplified().split(' ');
+            if (parts.size() >= 2)
+            {
+                *field = parts.at(1).toLongLong() * 1024;
+            }
+        }
+    }
+    return hasRss;
+}
+
+// Kernels older than 4.14 only have statm, in pages: "size resident shared text lib data dt"
+bool readStatm(MemorySampler::Usage& usage)
+{
+    QFile file(QString::fromUtf8("/proc/self/statm"));
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        return false;
+    }
+
+    QList<QByteArray> parts = file.readLine().simplified().split(' ');
+    if (parts.size() < 3)
+    {
+        return false;
+    }
+
+    long long pageSize = sysconf(_SC_PAGESIZE);
+    long long resident = parts.at(1).toLongLong();
+    long long shared = parts.at(2).toLongLong();
+    usage.residentBytes = resident * pageSize;
+    usage.proportionalBytes = usage.residentBytes;
+    usage.anonymousBytes = std::max(0LL, resident - shared) * pageSize;
+    return true;
+}
+#endif
+}
+
+long long MemorySampler::Usage::trackedBytes() const
+{
+    if (anonymousBytes)
+    {
+        return anonymousBytes;
+    }
+    return proportionalBytes ? proportionalBytes : residentBytes;
+}
+
+double MemorySampler::Sample::bytesPerNode() const
+{
+    return static_cast<double>(usage.trackedBytes()) / std::max(1LL, nodes);
+}
+
+bool MemorySampler::readProcessUsage(Usage& usage)
+{
+    usage = Usage();
+#if defined(__linux__)
+    return readSmapsRollup(usage) || readStatm(usage);
+#elif defined(__FreeBSD__)
+    int mib[4] = {CTL_KERN, KERN_PROC, KERN_PROC_PID, getpid()};
+    struct kinfo_proc info;
+    size_t length = sizeof(info);
+    if (sysctl(mib, 4, &info, &length, nullptr, 0) || length != sizeof(info))
+    {
+        return false;
+    }
+
+    // Only the resident set is available without walking the memory map
+    usage.residentBytes = static_cast<long long>(info.ki_rssize) * getpagesize();
+    usage.proportionalBytes = usage.residentBytes;
+    return true;
+#else
+    return false;
+#endif
+}
+
+void MemorySampler::addSample(long long timeMs, const Usage& usage, long long nodes)
+{
+    Sample sample;
+    sample.timeMs = timeMs;
+    sample.usage = usage;
+    sample.nodes = std::max(1LL, nodes);
+    mSamples.push_back(sample);
+    while (mSamples.size() > MAX_SAMPLES)
+    {
+        mSamples.pop_front();
+    }
+}
+
+const std::deque<MemorySampler::Sample>& MemorySampler::getSamples() const
+{
+    return mSamples;
+}
+
+double MemorySampler::getGrowth() const
+{
+    if (mSamples.size() < 2)
+    {
+        return 0.0;
+    }
+
+    // Least squares fit of the bytes per node over time, relative to the first sample
+    const double n = static_cast<double>(mSamples.size());
+    const long long firstTime = mSamples.front().timeMs;
+    double sumX = 0.0, sumY = 0.0, sumXY = 0.0, sumXX = 0.0;
+    for (const Sample& sample : mSamples)
+    {
+        double x = static_cast<double>(sample.timeMs - firstTime);
+        double y = sample.bytesPerNode();
+        sumX += x;
+        sumY += y;
+        sumXY += x * y;
+        sumXX += x * x;
+    }
+
+    double denominator = n * sumXX - sumX * sumX;
+    if (denominator <= 0.0)
+    {
+        return 0.0;
+    }
+
+    double slope = (n * sumXY - sumX * sumY) / denominator;
+    double intercept = (sumY - slope * sumX) / n;
+    if (intercept <= 0.0)
+    {
+        return 0.0;
+    }
+
+    double span = static_cast<double>(mSamples.back().timeMs - firstTime);
+    return slope * span / intercept;
+}
+
+bool MemorySampler::isGrowing() const
+{
+    if (mSamples.size() < MIN_TREND_SAMPLES || getGrowth() <= GROWTH_THRESHOLD)
+    {
+        return false;
+    }
+
+    // Sustained: the last quarter of the window stays above anything seen in the first quarter
+    const size_t quarter = mSamples.size() / 4;
+    double firstMax = 0.0;
+    for (size_t i = 0; i < quarter; i++)
+    {
+        firstMax = std::max(firstMax, mSamples[i].bytesPerNode());
+    }
+    for (size_t i = mSamples.size() - quarter; i < mSamples.size(); i++)
+    {
+        if (mSamples[i].bytesPerNode() <= firstMax)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+QString MemorySampler::describe(unsigned int maxSamples) const
+{
+    QStringList lines;
+    for (auto it = mSamples.rbegin(); it != mSamples.rend() && static_cast<unsigned int>(lines.size()) < maxSamples; ++it)
+    {
+        lines.append(QString::fromUtf8("%1  RSS %2  PSS %3  anonymous %4  %5 nodes  %6 B/N")
+                     .arg(QDateTime::fromMSecsSinceEpoch(it->timeMs).toString(QString::fromUtf8("hh:mm:ss")))
+                     .arg(megabytes(it->usage.residentBytes))
+                     .arg(megabytes(it->usage.proportionalBytes))
+                     .arg(megabytes(it->usage.anonymousBytes))
+                     .arg(it->nodes)
+                     .arg(it->bytesPerNode(), 0, 'f', 0));
+    }
+    return lines.join(QString::fromUtf8("\n"));
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <QString>
+
+#include <deque>
+
+/// Responsability: keeps a rolling series of the memory used by the process, normalized by the
+/// number of nodes, and tells when it grows steadily. Memory that follows the workload goes up and
+/// down, a leak keeps growing for the whole window even if the number of nodes stays the same.
+class MemorySampler
+{
+public:
+    struct Usage
+    {
+        long long residentBytes = 0;
+        // Shared pages divided among the processes that map them
+        long long proportionalBytes = 0;
+        // Heap and other private memory, where leaks show up
+        long long anonymousBytes = 0;
+
+        // The most specific value available
+        long long trackedBytes() const;
+    };
+
+    struct Sample
+    {
+        long long timeMs = 0;
+        Usage usage;
+        long long nodes = 1;
+
+        double bytesPerNode() const;
+    };
+
+    // One hour with a sample per minute
+    static constexpr unsigned int MAX_SAMPLES{60};
+    static constexpr unsigned int MIN_TREND_SAMPLES{20};
+    // Growth of the bytes per node over the window that counts as sustained
+    static constexpr double GROWTH_THRESHOLD{0.1};
+
+    // Reads the memory of this process on Linux (/proc/self/smaps_rollup, or /proc/self/statm on old
+    // kernels) and FreeBSD (kern.proc.pid). Returns false on other platforms or on error.
+    static bool readProcessUsage(Usage& usage);
+
+    void addSample(long long timeMs, const Usage& usage, long long nodes);
+    const std::deque<Sample>& getSamples() const;
+
+    // Fitted growth of the bytes per node from the first to the last sample, relative to the first one
+    double getGrowth() const;
+    bool isGrowing() const;
+
+    // Latest samples first, one per line
+    QString describe(unsigned int maxSamples) const;
+
+private:
+    std::deque<Sample> mSamples;
+};
@@ -32,6 +32,9 @@ const QString Preferences::TRANSLATION_PREFIX = QString::fromAscii("MEGASyncStri
 
 int Preferences::STATE_REFRESH_INTERVAL_MS        = 10000;
 int Preferences::FINISHED_TRANSFER_REFRESH_INTERVAL_MS        = 10000;
+int Preferences::WEBCLIENT_PUSH_INTERVAL_MS        = 500;
+int Preferences::WEBCLIENT_KEEPALIVE_TIMEOUT_MS    = 15000;
+int Preferences::SYNC_SETTINGS_WRITE_DELAY_MS      = 1000;
 
 long long Preferences::OQ_DIALOG_INTERVAL_MS = 604800000; // 7 days
 long long Preferences::OQ_NOTIFICATION_INTERVAL_MS = 129600000; // 36 hours
@@ -511,11 +514,20 @@ void Preferences::initialize(QString dataPath)
     }
 }
 
-Preferences::Preferences() : QObject(), mutex(QMutex::Recursive)
+Preferences::Preferences() : QObject(), mutex(QReadWriteLock::Recursive)
 {
     diffTimeWithSDK = 0;
     lastTransferNotification = 0;
+    pendingSyncSettingsReset = false;
+    syncSettingsWriteScheduled = false;
     clearTemporalBandwidth();
+
+    syncSettingsTimer.setSingleShot(true);
+    connect(&syncSettingsTimer, &QTimer::timeout, this, [this]()
+    {
+        QWriteLocker qm(&mutex);
+        writePendingSyncSettings();
+    });
 }
 
 QString Preferences::email()
@@ -526,7 +538,7 @@ QString Preferences::email()
 
 void Preferences::setEmail(QString email)
 {
-    mutex.lock();
+    mutex.lockForWrite();
     login(email);
     settings->setValue(emailKey, email);
     setCachedValue(emailKey, email);
@@ -559,7 +571,7 @@ void Preferences::setLastName(QString lastName)
 
 void Preferences::setSession(QString session)
 {
-    mutex.lock();
+    mutex.lockForWrite();
     storeSessionInGeneral(session);
     settings->sync();
     mutex.unlock();
@@ -573,7 +585,7 @@ void Preferences::setSessionInUserGroup(QString session)
 
 void Preferences::storeSessionInGeneral(QString session)
 {
-    mutex.lock();
+    mutex.lockForWrite();
 
     QString currentAccount;
     if (logged())
@@ -595,7 +607,7 @@ void Preferences::storeSessionInGeneral(QString session)
 
 QString Preferences::getSessionInGeneral()
 {
-    mutex.lock();
+    mutex.lockForWrite();
     QString currentAccount;
     if (logged())
     {
@@ -615,7 +627,7 @@ QString Preferences::getSessionInGeneral()
 
 QString Preferences::getSession()
 {
-    mutex.lock();
+    mutex.lockForWrite();
     QString value;
     if (logged())
     {
@@ -633,7 +645,7 @@ QString Preferences::getSession()
 
 unsigned long long Preferences::transferIdentifier()
 {
-    mutex.lock();
+    mutex.lockForWrite();
     assert(logged());
     long long value = getValue<long long>(transferIdentifierKey, defaultTransferIdentifier);
     value++;
@@ -680,8 +692,8 @@ void Preferences::setUsedStorage(long long value)
 
 long long Preferences::availableStorage()
 {
-    mutex.lock();
     assert(logged());
+    mutex.lockForRead();
     long long total = getValue<long long>(totalStorageKey);
     long long used = getValue<long long>(usedStorageKey);
     mutex.unlock();
@@ -958,8 +970,8 @@ void Preferences::setOverStorageDismissExecution(long long timestamp)
 
 std::chrono::system_clock::time_point Preferences::getTimePoint(const QString& key)
 {
-    QMutexLocker locker(&mutex);
     assert(logged());
+    QReadLocker locker(&mutex);
     const long long value{getValue<long long>(key, defaultTimeStamp)};
     std::chrono::milliseconds durationMillis(value);
     return std::chrono::system_clock::time_point{durationMillis};
@@ -967,7 +979,7 @@ std::chrono::system_clock::time_point Preferences::getTimePoint(const QString& k
 
 void Preferences::setTimePoint(const QString& key, const std::chrono::system_clock::time_point& timepoint)
 {
-    QMutexLocker locker(&mutex);
+    QWriteLocker locker(&mutex);
     assert(logged());
     auto timePointMillis = std::chrono::time_point_cast<std::chrono::milliseconds>(timepoint).time_since_epoch().count();
     settings->setValue(key, static_cast<long long>(timePointMillis));
@@ -1001,14 +1013,14 @@ T Preferences::getValue(const QString &key, const T &defaultValue)
 template<typename T>
 T Preferences::getValueConcurrent(const QString &key)
 {
-    QMutexLocker locker(&mutex);
+    QReadLocker locker(&mutex);
     return getValue<T>(key);
 }
 
 template<typename T>
 T Preferences::getValueConcurrent(const QString &key, const T &defaultValue)
 {
-    QMutexLocker locker(&mutex);
+    QReadLocker locker(&mutex);
     return getValue<T>(key, defaultValue);
 }
 
@@ -1020,14 +1032,14 @@ void Preferences::setAndCachedValue(const QString &key, const QVariant &value)
 
 void Preferences::setValueAndSyncConcurrent(const QString &key, const QVariant &value)
 {
-    QMutexLocker locker(&mutex);
+    QWriteLocker locker(&mutex);
     setAndCachedValue(key, value);
     settings->sync();
 }
 
 void Preferences::setValueConcurrent(const QString &key, const QVariant &value)
 {
-    QMutexLocker locker(&mutex);
+    QWriteLocker locker(&mutex);
     setAndCachedValue(key, value);
 }
 
@@ -1290,7 +1302,7 @@ void Preferences::setUseHttpsOnly(bool value)
 
 bool Preferences::SSLcertificateException()
 {
-    mutex.lock();
+    mutex.lockForWrite();
     QString currentAccount;
     if (logged())
     {
@@ -1308,7 +1320,7 @@ bool Preferences::SSLcertificateException()
 
 void Preferences::setSSLcertificateException(bool value)
 {
-    mutex.lock();
+    mutex.lockForWrite();
     QString currentAccount;
     if (logged())
     {
@@ -1397,7 +1409,7 @@ void Preferences::setHasDefaultImportFolder(bool value)
 
 bool Preferences::canUpdate(QString filePath)
 {
-    mutex.lock();
+    mutex.lockForWrite();
 
     bool value = true;
 
@@ -1419,7 +1431,7 @@ bool Preferences::canUpdate(QString filePath)
 
 int Preferences::accountStateInGeneral()
 {
-    mutex.lock();
+    mutex.lockForWrite();
     QString currentAccount;
     if (logged())
     {
@@ -1439,7 +1451,7 @@ int Preferences::accountStateInGeneral()
 
 void Preferences::setAccountStateInGeneral(int value)
 {
-    mutex.lock();
+    mutex.lockForWrite();
 
     QString currentAccount;
     if (logged())
@@ -1462,7 +1474,7 @@ void Preferences::setAccountStateInGeneral(int value)
 
 bool Preferences::needsFetchNodesInGeneral()
 {
-    mutex.lock();
+    mutex.lockForWrite();
     QString currentAccount;
     if (logged())
     {
@@ -1482,7 +1494,7 @@ bool Preferences::needsFetchNodesInGeneral()
 
 void Preferences::setNeedsFetchNodesInGeneral(bool value)
 {
-    mutex.lock();
+    mutex.lockForWrite();
 
     QString currentAccount;
     if (logged())
@@ -1648,7 +1660,7 @@ void Preferences::setLowerSizeLimitUnit(int value)
 
 int Preferences::folderPermissionsValue()
 {
-    mutex.lock();
+    mutex.lockForRead();
     int permissions = getValue<int>(folderPermissionsKey, defaultFolderPermissions);
     mutex.unlock();
     return permissions;
@@ -1661,7 +1673,7 @@ void Preferences::setFolderPermissionsValue(int permissions)
 
 int Preferences::filePermissionsValue()
 {
-    mutex.lock();
+    mutex.lockForRead();
     int permissions = getValue<int>(filePermissionsKey, defaultFilePermissions);
     mutex.unlock();
     return permissions;
@@ -1744,27 +1756,28 @@ void Preferences::setProxyPassword(const QString &value)
 
 QString Preferences::proxyHostAndPort()
 {
-    mutex.lock();
+    mutex.lockForRead();
     QString proxy;
-    QString hostname = proxyServer();
+    QString hostname = getValue<QString>(proxyServerKey, defaultProxyServer);
+    int port = getValue<int>(proxyPortKey, defaultProxyPort);
+    mutex.unlock();
 
     QHostAddress ipAddress(hostname);
     if (ipAddress.protocol() == QAbstractSocket::IPv6Protocol)
     {
-        proxy = QString::fromUtf8("[") + hostname + QString::fromAscii("]:") + QString::number(proxyPort());
+        proxy = QString::fromUtf8("[") + hostname + QString::fromAscii("]:") + QString::number(port);
     }
     else
     {
-        proxy = hostname + QString::fromAscii(":") + QString::number(proxyPort());
+        proxy = hostname + QString::fromAscii(":") + QString::number(port);
     }
 
-    mutex.unlock();
     return proxy;
 }
 
 long long Preferences::lastExecutionTime()
 {
-    mutex.lock();
+    mutex.lockForRead();
     long long value = getValue<long long>(lastExecutionTimeKey, 0);
     mutex.unlock();
     return value;
@@ -1911,7 +1924,7 @@ void Preferences::setLastUpdateVersion(int version)
 
 QString Preferences::downloadFolder()
 {
-    mutex.lock();
+    mutex.lockForWrite();
     QString value = QDir::toNativeSeparators(getValue<QString>(downloadFolderKey));
     mutex.unlock();
     return value;
@@ -1961,10 +1974,12 @@ void Preferences::setNeverCreateLink(bool value)
 
 void Preferences::removeAllFolders()
 {
-    QMutexLocker qm(&mutex);
+    QWriteLocker qm(&mutex);
     assert(logged());
 
     //remove all configured syncs
+    pendingSyncSettings.clear();
+    pendingSyncSettingsReset = false;
     settings->beginGroup(syncsGroupByTagKey);
     settings->remove(QString::fromAscii("")); //remove group and all its settings
     settings->endGroup();
@@ -1973,7 +1988,7 @@ void Preferences::removeAllFolders()
 
 QStringList Preferences::getExcludedSyncNames()
 {
-    mutex.lock();
+    mutex.lockForWrite();
     assert(logged());
     QStringList value = excludedSyncNames;
     mutex.unlock();
@@ -1982,7 +1997,7 @@ QStringList Preferences::getExcludedSyncNames()
 
 void Preferences::setExcludedSyncNames(QStringList names)
 {
-    mutex.lock();
+    mutex.lockForWrite();
     assert(logged());
     excludedSyncNames = names;
     if (!excludedSyncNames.size())
@@ -2002,7 +2017,7 @@ void Preferences::setExcludedSyncNames(QStringList names)
 
 QStringList Preferences::getExcludedSyncPaths()
 {
-    mutex.lock();
+    mutex.lockForWrite();
     assert(logged());
     QStringList value = excludedSyncPaths;
     mutex.unlock();
@@ -2011,7 +2026,7 @@ QStringList Preferences::getExcludedSyncPaths()
 
 void Preferences::setExcludedSyncPaths(QStringList paths)
 {
-    mutex.lock();
+    mutex.lockForWrite();
     assert(logged());
     excludedSyncPaths = paths;
     if (!excludedSyncPaths.size())
@@ -2032,7 +2047,7 @@ void Preferences::setExcludedSyncPaths(QStringList paths)
 
 bool Preferences::isOneTimeActionDone(int action)
 {
-    mutex.lock();
+    mutex.lockForWrite();
     QString currentAccount;
     if (logged())
     {
@@ -2052,7 +2067,7 @@ bool Preferences::isOneTimeActionDone(int action)
 
 void Preferences::setOneTimeActionDone(int action, bool done)
 {
-    mutex.lock();
+    mutex.lockForWrite();
     QString currentAccount;
     if (logged())
     {
@@ -2074,7 +2089,7 @@ void Preferences::setOneTimeActionDone(int action, bool done)
 
 QStringList Preferences::getPreviousCrashes()
 {
-    mutex.lock();
+    mutex.lockForWrite();
     QStringList previousCrashes;
     QString currentAccount;
     if (logged())
@@ -2094,7 +2109,7 @@ QStringList Preferences::getPreviousCrashes()
 
 void Preferences::setPreviousCrashes(QStringList crashes)
 {
-    mutex.lock();
+    mutex.lockForWrite();
     QString currentAccount;
     if (logged())
     {
@@ -2124,7 +2139,7 @@ void Preferences::setPreviousCrashes(QStringList crashes)
 
 long long Preferences::getLastReboot()
 {
-    mutex.lock();
+    mutex.lockForWrite();
     QString currentAccount;
     if (logged())
     {
@@ -2145,7 +2160,7 @@ long long Preferences::getLastReboot()
 
 void Preferences::setLastReboot(long long value)
 {
-    mutex.lock();
+    mutex.lockForWrite();
     QString currentAccount;
     if (logged())
     {
@@ -2167,7 +2182,7 @@ void Preferences::setLastReboot(long long value)
 
 long long Preferences::getLastExit()
 {
-    mutex.lock();
+    mutex.lockForWrite();
     QString currentAccount;
     if (logged())
     {
@@ -2188,7 +2203,7 @@ long long Preferences::getLastExit()
 
 void Preferences::setLastExit(long long value)
 {
-    mutex.lock();
+    mutex.lockForWrite();
     QString currentAccount;
     if (logged())
     {
@@ -2210,10 +2225,10 @@ void Preferences::setLastExit(long long value)
 
 QSet<MegaHandle> Preferences::getDisabledSyncTags()
 {
-    QMutexLocker qm(&mutex);
+    QWriteLocker qm(&mutex);
     assert(logged());
 
-    QStringList stringTagList = getValueConcurrent<QString>(disabledSyncsKey).split(QString::fromUtf8("0x1E"), QString::SkipEmptyParts);
+    QStringList stringTagList = getValue<QString>(disabledSyncsKey).split(QString::fromUtf8("0x1E"), QString::SkipEmptyParts);
     if (!stringTagList.isEmpty())
     {
         QList<mega::MegaHandle> tagList;
@@ -2230,7 +2245,7 @@ QSet<MegaHandle> Preferences::getDisabledSyncTags()
 
 void Preferences::setDisabledSyncTags(QSet<mega::MegaHandle> disabledSyncs)
 {
-    QMutexLocker qm(&mutex);
+    QWriteLocker qm(&mutex);
     assert(logged());
 
     QList<mega::MegaHandle> disabledTags = disabledSyncs.toList();
@@ -2256,7 +2271,7 @@ void Preferences::setNotifyDisabledSyncsOnLogin(bool notify)
 
 QString Preferences::getHttpsKey()
 {
-    mutex.lock();
+    mutex.lockForWrite();
     QString currentAccount;
     if (logged())
     {
@@ -2297,7 +2312,7 @@ void Preferences::setHttpsKey(QString key)
 
 QString Preferences::getHttpsCert()
 {
-    mutex.lock();
+    mutex.lockForWrite();
     QString currentAccount;
     if (logged())
     {
@@ -2338,7 +2353,7 @@ void Preferences::setHttpsCert(QString cert)
 
 QString Preferences::getHttpsCertIntermediate()
 {
-    mutex.lock();
+    mutex.lockForWrite();
     QString currentAccount;
     if (logged())
     {
@@ -2379,7 +2394,7 @@ void Preferences::setHttpsCertIntermediate(QString intermediate)
 
 long long Preferences::getHttpsCertExpiration()
 {
-    mutex.lock();
+    mutex.lockForWrite();
     QString currentAccount;
     if (logged())
     {
@@ -2420,7 +2435,7 @@ void Preferences::setHttpsCertExpiration(long long expiration)
 
 void Preferences::getLastHandleInfo(MegaHandle &lastHandle, int &type, long long &timestamp)
 {
-    mutex.lock();
+    mutex.lockForWrite();
     assert(logged());
     timestamp = getValue<long long>(lastPublicHandleTimestampKey, 0);
     lastHandle = getValue<unsigned long long>(lastPublicHandleKey, mega::INVALID_HANDLE);
@@ -2430,7 +2445,7 @@ void Preferences::getLastHandleInfo(MegaHandle &lastHandle, int &type, long long
 
 void Preferences::setLastPublicHandle(MegaHandle handle, int type)
 {
-    mutex.lock();
+    mutex.lockForWrite();
     assert(logged());
     settings->setValue(lastPublicHandleKey, (unsigned long long) handle);
     setCachedValue(lastPublicHandleKey, (unsigned long long) handle);
@@ -2444,7 +2459,7 @@ void Preferences::setLastPublicHandle(MegaHandle handle, int type)
 
 int Preferences::getNumUsers()
 {
-    mutex.lock();
+    mutex.lockForWrite();
     assert(!logged());
     int value = settings->numChildGroups();
     mutex.unlock();
@@ -2454,7 +2469,7 @@ int Preferences::getNumUsers()
 
 bool Preferences::enterUser(QString account)
 {
-    QMutexLocker locker(&mutex);
+    QWriteLocker locker(&mutex);
     assert(!logged());
     if (account.size() && settings->containsGroup(account))
     {
@@ -2467,7 +2482,7 @@ bool Preferences::enterUser(QString account)
 
 void Preferences::enterUser(int i)
 {
-    mutex.lock();
+    mutex.lockForWrite();
     assert(!logged());
     assert(i < settings->numChildGroups());
     if (i < settings->numChildGroups())
@@ -2481,8 +2496,9 @@ void Preferences::enterUser(int i)
 
 void Preferences::leaveUser()
 {
-    mutex.lock();
+    mutex.lockForWrite();
     assert(logged());
+    writePendingSyncSettings();
     settings->endGroup();
 
     mutex.unlock();
@@ -2490,8 +2506,9 @@ void Preferences::leaveUser()
 
 void Preferences::unlink()
 {
-    mutex.lock();
+    mutex.lockForWrite();
     assert(logged());
+    writePendingSyncSettings();
     settings->remove(sessionKey); // Remove session from specific account settings
     settings->endGroup();
     mutex.unlock();
@@ -2501,7 +2518,7 @@ void Preferences::unlink()
 
 void Preferences::resetGlobalSettings()
 {
-    mutex.lock();
+    mutex.lockForWrite();
     QString currentAccount;
     if (logged())
     {
@@ -2528,7 +2545,7 @@ void Preferences::resetGlobalSettings()
 
 bool Preferences::isCrashed()
 {
-    mutex.lock();
+    mutex.lockForWrite();
     bool value = getValue<bool>(isCrashedKey, false);
     mutex.unlock();
     return value;
@@ -2581,7 +2598,7 @@ void Preferences::setLastStatsRequest(long long value)
 
 bool Preferences::fileVersioningDisabled()
 {
-    mutex.lock();
+    mutex.lockForWrite();
     assert(logged());
     bool result = getValue(disableFileVersioningKey, false);
     mutex.unlock();
@@ -2595,7 +2612,7 @@ void Preferences::disableFileVersioning(bool value)
 
 bool Preferences::overlayIconsDisabled()
 {
-    mutex.lock();
+    mutex.lockForWrite();
     bool result = getValue(disableOverlayIconsKey, false);
     mutex.unlock();
     return result;
@@ -2608,7 +2625,7 @@ void Preferences::disableOverlayIcons(bool value)
 
 bool Preferences::leftPaneIconsDisabled()
 {
-    mutex.lock();
+    mutex.lockForWrite();
     bool result = getValue(disableLeftPaneIconsKey, false);
     mutex.unlock();
     return result;
@@ -2626,7 +2643,7 @@ bool Preferences::error()
 
 QString Preferences::getDataPath()
 {
-    mutex.lock();
+    mutex.lockForWrite();
     QString ret = dataPath;
     mutex.unlock();
     return ret;
@@ -2641,7 +2658,7 @@ void Preferences::clearTemporalBandwidth()
 
 void Preferences::clearAll()
 {
-    mutex.lock();
+    mutex.lockForWrite();
     if (logged())
     {
         unlink();
@@ -2654,21 +2671,29 @@ void Preferences::clearAll()
 
 void Preferences::sync()
 {
-    mutex.lock();
+    mutex.lockForWrite();
     settings->sync();
     mutex.unlock();
 }
 
+void Preferences::flush()
+{
+    mutex.lockForWrite();
+    writePendingSyncSettings();
+    settings->flush();
+    mutex.unlock();
+}
+
 void Preferences::deferSyncs(bool b)
 {
-    mutex.lock();
+    mutex.lockForWrite();
     settings->deferSyncs(b);
     mutex.unlock();
 }
 
 bool Preferences::needsDeferredSync()
 {
-    mutex.lock();
+    mutex.lockForWrite();
     bool b = settings->needsDeferredSync();
     mutex.unlock();
     return b;
@@ -2700,7 +2725,7 @@ void Preferences::setEmailAndGeneralSettings(const QString &email)
 
 void Preferences::login(QString account)
 {
-    mutex.lock();
+    mutex.lockForWrite();
     logout();
     settings->setValue(currentAccountKey, account);
     setCachedValue(currentAccountKey, account);
@@ -2723,7 +2748,7 @@ void Preferences::login(QString account)
 
 bool Preferences::logged()
 {
-    mutex.lock();
+    mutex.lockForWrite();
     bool value = !settings->isGroupEmpty();
     mutex.unlock();
     return value;
@@ -2731,7 +2756,7 @@ bool Preferences::logged()
 
 bool Preferences::hasEmail(QString email)
 {
-    mutex.lock();
+    mutex.lockForWrite();
     assert(!logged());
     bool value = settings->containsGroup(email);
     if (value)
@@ -2753,9 +2778,10 @@ bool Preferences::hasEmail(QString email)
 
 void Preferences::logout()
 {
-    mutex.lock();
+    mutex.lockForWrite();
     if (logged())
     {
+        writePendingSyncSettings();
         settings->endGroup();
     }
     clearTemporalBandwidth();
@@ -2770,7 +2796,7 @@ static bool caseInsensitiveLessThan(const QString &s1, const QString &s2)
 
 void Preferences::loadExcludedSyncNames()
 {
-    mutex.lock();
+    mutex.lockForWrite();
     excludedSyncNames = getValue<QString>(excludedSyncNamesKey).split(QString::fromAscii("\n", QString::SkipEmptyParts));
     if (excludedSyncNames.size()==1 && excludedSyncNames.at(0).isEmpty())
     {
@@ -2827,9 +2853,10 @@ QMap<mega::MegaHandle, std::shared_ptr<SyncSetting> > Preferences::getLoadedSync
 
 void Preferences::readFolders()
 {
-    mutex.lock();
+    mutex.lockForWrite();
     assert(logged());
 
+    writePendingSyncSettings();
     loadedSyncsMap.clear();
 
     settings->beginGroup(syncsGroupByTagKey);
@@ -2864,7 +2891,7 @@ SyncData::SyncData(QString name, QString localFolder, long long  megaHandle, QSt
 
 void Preferences::removeOldCachedSync(int position, QString email)
 {
-    QMutexLocker qm(&mutex);
+    QWriteLocker qm(&mutex);
     assert(logged() || !email.isEmpty());
 
     // if not logged, use email to get into that user group and remove just some specific sync group
@@ -2898,7 +2925,7 @@ void Preferences::removeOldCachedSync(int position, QString email)
 
 QList<SyncData> Preferences::readOldCachedSyncs(int *cachedBusinessState, int *cachedBlockedState, int *cachedStorageState, QString email)
 {
-    QMutexLocker qm(&mutex);
+    QWriteLocker qm(&mutex);
     oldSyncs.clear();
 
     // if not logged in & email provided, read old syncs from that user and load new-cache sync from prev session
@@ -2969,7 +2996,7 @@ QList<SyncData> Preferences::readOldCachedSyncs(int *cachedBusinessState, int *c
 
 void Preferences::saveOldCachedSyncs()
 {
-    QMutexLocker qm(&mutex);
+    QWriteLocker qm(&mutex);
     assert(logged());
 
     if (!logged())
@@ -3004,21 +3031,18 @@ void Preferences::saveOldCachedSyncs()
 
 void Preferences::removeAllSyncSettings()
 {
-    QMutexLocker qm(&mutex);
+    QWriteLocker qm(&mutex);
     assert(logged());
 
-    settings->beginGroup(syncsGroupByTagKey);
-
-    settings->remove(QString::fromAscii("")); //removes group and all its settings
-
-    settings->endGroup();
-    settings->sync();
+    pendingSyncSettings.clear();
+    pendingSyncSettingsReset = true;
+    scheduleSyncSettingsWrite();
 }
 
 
 void Preferences::removeSyncSetting(std::shared_ptr<SyncSetting> syncSettings)
 {
-    QMutexLocker qm(&mutex);
+    QWriteLocker qm(&mutex);
     assert(logged() && syncSettings);
     if (!syncSettings)
     {
@@ -3026,39 +3050,78 @@ void Preferences::removeSyncSetting(std::shared_ptr<SyncSetting> syncSettings)
         return;
     }
 
-    settings->beginGroup(syncsGroupByTagKey);
-
-    settings->beginGroup(QString::number(syncSettings->backupId()));
-
-    settings->remove(QString::fromAscii("")); //removes group and all its settings
-
-    settings->endGroup();
-
-    settings->endGroup();
-    settings->sync();
+    pendingSyncSettings[syncSettings->backupId()] = QString();
+    scheduleSyncSettingsWrite();
 }
 
 void Preferences::writeSyncSetting(std::shared_ptr<SyncSetting> syncSettings)
 {
     if (logged())
     {
-        QMutexLocker qm(&mutex);
-
-        settings->beginGroup(syncsGroupByTagKey);
+        QWriteLocker qm(&mutex);
+        // Only the latest state of each sync is written
+        pendingSyncSettings[syncSettings->backupId()] = syncSettings->toString();
+        scheduleSyncSettingsWrite();
+    }
+    else
+    {
+        MegaApi::log(MegaApi::LOG_LEVEL_WARNING, QString::fromAscii("Writting sync settings before logged in").toUtf8().constData());
+    }
+}
 
-        settings->beginGroup(QString::number(syncSettings->backupId()));
+void Preferences::scheduleSyncSettingsWrite()
+{
+    if (!syncSettingsWriteScheduled)
+    {
+        syncSettingsWriteScheduled = true;
+        // Queued when called from another thread
+        QMetaObject::invokeMethod(&syncSettingsTimer, "start", Q_ARG(int, SYNC_SETTINGS_WRITE_DELAY_MS));
+    }
+}
 
-        settings->setValue(configuredSyncsKey, syncSettings->toString());
+void Preferences::writePendingSyncSettings()
+{
+    syncSettingsWriteScheduled = false;
+    if (pendingSyncSettings.isEmpty() && !pendingSyncSettingsReset)
+    {
+        return;
+    }
 
-        settings->endGroup();
+    if (!logged())
+    {
+        MegaApi::log(MegaApi::LOG_LEVEL_ERROR, QString::fromUtf8("Discarding %1 sync settings changes written out of an account")
+                     .arg(pendingSyncSettings.size()).toUtf8().constData());
+        pendingSyncSettings.clear();
+        pendingSyncSettingsReset = false;
+        return;
+    }
 
-        settings->endGroup();
-        settings->sync();
+    settings->beginGroup(syncsGroupByTagKey);
+    if (pendingSyncSettingsReset)
+    {
+        settings->remove(QString::fromAscii("")); //removes group and all its settings
     }
-    else
+
+    for (auto it = pendingSyncSettings.constBegin(); it != pendingSyncSettings.constEnd(); ++it)
     {
-        MegaApi::log(MegaApi::LOG_LEVEL_WARNING, QString::fromAscii("Writting sync settings before logged in").toUtf8().constData());
+        settings->beginGroup(QString::number(it.key()));
+        if (it.value().isEmpty())
+        {
+            settings->remove(QString::fromAscii("")); //removes group and all its settings
+        }
+        else
+        {
+            settings->setValue(configuredSyncsKey, it.value());
+        }
+        settings->endGroup();
     }
+
+    settings->endGroup();
+    pendingSyncSettings.clear();
+    pendingSyncSettingsReset = false;
+
+    // One sync for the whole batch. The file is replaced atomically when it is written
+    settings->sync();
 }
 
 void Preferences::setBaseUrl(const QString &value)
@@ -3100,6 +3163,9 @@ void Preferences::overridePreferences(const QSettings &settings)
     overridePreference(settings, QString::fromUtf8("PAYWALL_NOTIFICATION_INTERVAL_MS"), Preferences::PAYWALL_NOTIFICATION_INTERVAL_MS);
     overridePreference(settings, QString::fromUtf8("USER_INACTIVITY_MS"), Preferences::USER_INACTIVITY_MS);
     overridePreference(settings, QString::fromUtf8("STATE_REFRESH_INTERVAL_MS"), Preferences::STATE_REFRESH_INTERVAL_MS);
+    overridePreference(settings, QString::fromUtf8("WEBCLIENT_PUSH_INTERVAL_MS"), Preferences::WEBCLIENT_PUSH_INTERVAL_MS);
+    overridePreference(settings, QString::fromUtf8("WEBCLIENT_KEEPALIVE_TIMEOUT_MS"), Preferences::WEBCLIENT_KEEPALIVE_TIMEOUT_MS);
+    overridePreference(settings, QString::fromUtf8("SYNC_SETTINGS_WRITE_DELAY_MS"), Preferences::SYNC_SETTINGS_WRITE_DELAY_MS);
 
     overridePreference(settings, QString::fromUtf8("TRANSFER_OVER_QUOTA_DIALOG_DISABLE_DURATION_MS"), Preferences::OVER_QUOTA_DIALOG_DISABLE_DURATION);
     overridePreference(settings, QString::fromUtf8("TRANSFER_OVER_QUOTA_OS_NOTIFICATION_DISABLE_DURATION_MS"), Preferences::OVER_QUOTA_OS_NOTIFICATION_DISABLE_DURATION);
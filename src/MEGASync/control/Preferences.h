@@ -5,8 +5,9 @@
 #include <QString>
 #include <QLocale>
 #include <QStringList>
-#include <QMutex>
+#include <QReadWriteLock>
 #include <QDataStream>
+#include <QTimer>
 
 #include "control/EncryptedSettings.h"
 #include "model/Model.h"
@@ -261,6 +262,8 @@ public:
     void setNeverCreateLink(bool value);
 
     // sync related
+    // Sync settings changes are journaled in memory and written in one batch SYNC_SETTINGS_WRITE_DELAY_MS
+    // after the first one, when leaving the account or on flush()
     void writeSyncSetting(std::shared_ptr<SyncSetting> syncSettings); //write sync into cache
     void removeAllSyncSettings(); //remove all sync from cache
     void removeSyncSetting(std::shared_ptr<SyncSetting> syncSettings); //remove one sync from cache
@@ -349,6 +352,8 @@ public:
     void clearTemporalBandwidth();
     void clearAll();
     void sync();
+    // Writes the pending changes to disk before returning
+    void flush();
 
     void deferSyncs(bool b);  // this must receive balanced calls with true and false, as it maintains a count (to support threads).
     bool needsDeferredSync();
@@ -426,6 +431,9 @@ public:
 
     static int STATE_REFRESH_INTERVAL_MS;
     static int FINISHED_TRANSFER_REFRESH_INTERVAL_MS;
+    static int WEBCLIENT_PUSH_INTERVAL_MS;
+    static int WEBCLIENT_KEEPALIVE_TIMEOUT_MS;
+    static int SYNC_SETTINGS_WRITE_DELAY_MS;
 
     static long long MIN_UPDATE_NOTIFICATION_INTERVAL_MS;
     static unsigned int UPDATE_INITIAL_DELAY_SECS;
@@ -478,7 +486,10 @@ public:
     static void overridePreferences(const QSettings &settings);
 
 protected:
-    QMutex mutex;
+    // Pure reads share it, anything that changes the current group or the values takes it for writing.
+    // Recursive, but a thread holding it for writing can't take it for reading: use getValue, not the
+    // *Concurrent getters, while it is held
+    QReadWriteLock mutex;
     void login(QString account);
     void logout();
 
@@ -516,6 +527,15 @@ protected:
     // These are only used for retrieving values or removing at uninstall
     QMap<mega::MegaHandle, std::shared_ptr<SyncSetting>> loadedSyncsMap;
 
+    // sync settings journal: serialized settings by backup id, empty for removed syncs
+    QMap<mega::MegaHandle, QString> pendingSyncSettings;
+    // all the stored sync settings are removed before writing the pending ones
+    bool pendingSyncSettingsReset;
+    bool syncSettingsWriteScheduled;
+    QTimer syncSettingsTimer;
+    void scheduleSyncSettingsWrite();
+    void writePendingSyncSettings();
+
     QStringList excludedSyncNames;
     QStringList excludedSyncPaths;
     bool errorFlag;
@@ -1,5 +1,6 @@
 #include "ThreadPool.h"
 
+#include <algorithm>
 #include <array>
 #include <chrono>
 #include <string>
@@ -10,9 +11,46 @@
 #include <pthread.h>
 #endif
 
+namespace
+{
+// Lets jobs submitted from a worker go to that worker's own deque
+thread_local const ThreadPool* tlsPool = nullptr;
+thread_local std::size_t tlsIndex = 0;
+
+constexpr std::size_t laneCount = static_cast<std::size_t>(ThreadPool::Priority::COUNT);
+}
+
+ThreadPool::TaskHandle::TaskHandle(std::shared_ptr<std::atomic<bool>> cancelled)
+    : mCancelled(std::move(cancelled))
+{
+}
+
+void ThreadPool::TaskHandle::cancel()
+{
+    if (mCancelled)
+    {
+        mCancelled->store(true);
+    }
+}
+
+bool ThreadPool::TaskHandle::isCancelled() const
+{
+    return mCancelled && mCancelled->load();
+}
+
+bool ThreadPool::TaskHandle::isValid() const
+{
+    return mCancelled != nullptr;
+}
+
 ThreadPool::ThreadPool(const std::size_t threadCount)
 {
     Q_ASSERT(threadCount > 0);
+    for (std::size_t i = 0; i < threadCount; ++i)
+    {
+        mQueues.emplace_back(new WorkerQueue);
+    }
+
     for (std::size_t i = 0; i < threadCount; ++i)
     {
         std::thread thread;
@@ -43,13 +81,75 @@ ThreadPool::~ThreadPool()
     shutdown();
 }
 
+std::size_t ThreadPool::defaultThreadCount()
+{
+    const std::size_t hardwareThreads = std::thread::hardware_concurrency();
+    return std::max<std::size_t>(2, std::min<std::size_t>(hardwareThreads, 4));
+}
+
 void ThreadPool::push(std::function<void()> functor)
 {
+    bool schedule = false;
     {
-        std::lock_guard<std::mutex> lock{mMutex};
-        mFunctors.push(std::move(functor));
+        std::lock_guard<std::mutex> lock{mSerialMutex};
+        mSerialFunctors.push(std::move(functor));
+        if (!mSerialRunning)
+        {
+            mSerialRunning = true;
+            schedule = true;
+        }
     }
-    mCv.notify_one();
+
+    if (schedule)
+    {
+        Task task;
+        task.functor = [this]()
+        {
+            drainSerialQueue();
+        };
+        enqueue(std::move(task));
+    }
+}
+
+ThreadPool::TaskHandle ThreadPool::submit(std::function<void()> functor, Priority priority, QPointer<QObject> owner)
+{
+    Task task;
+    task.functor = std::move(functor);
+    task.cancelled = std::make_shared<std::atomic<bool>>(false);
+    task.priority = priority;
+    if (owner)
+    {
+        // Emitted in the owner's thread from its destructor
+        std::shared_ptr<std::atomic<bool>> cancelled = task.cancelled;
+        task.ownerConnection = QObject::connect(owner.data(), &QObject::destroyed, [cancelled]()
+        {
+            cancelled->store(true);
+        });
+    }
+
+    TaskHandle handle{task.cancelled};
+    enqueue(std::move(task));
+    return handle;
+}
+
+ThreadPool::Stats ThreadPool::getStats() const
+{
+    Stats stats;
+    stats.threadCount = mThreads.size();
+    stats.stolen = mStolen.load();
+    for (std::size_t lane = 0; lane < laneCount; ++lane)
+    {
+        const LaneCounters& counters = mCounters[lane];
+        LaneStats& laneStats = stats.lanes[lane];
+        laneStats.submitted = counters.submitted.load();
+        laneStats.executed = counters.executed.load();
+        laneStats.cancelled = counters.cancelled.load();
+        const std::uint64_t done = laneStats.executed + laneStats.cancelled;
+        laneStats.queueDepth = laneStats.submitted > done ? laneStats.submitted - done : 0;
+        laneStats.meanLatencyUs = laneStats.executed ? counters.totalLatencyUs.load() / laneStats.executed : 0;
+        laneStats.maxLatencyUs = counters.maxLatencyUs.load();
+    }
+    return stats;
 }
 
 void ThreadPool::worker(const std::size_t index)
@@ -62,21 +162,133 @@ void ThreadPool::worker(const std::size_t index)
         Q_ASSERT(false);
     }
 #endif
+    tlsPool = this;
+    tlsIndex = index;
+
     for (;;)
     {
-        std::function<void()> functor;
+        Task task;
+        if (takeTask(index, task))
         {
-            std::unique_lock<std::mutex> lock{mMutex};
-            mCv.wait(lock, [this]
+            runTask(task);
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock{mMutex};
+        mCv.wait(lock, [this]
+        {
+            return mDone || mPending > 0;
+        });
+        if (mDone && mPending <= 0)
+        {
+            break;
+        }
+    }
+}
+
+void ThreadPool::enqueue(Task task)
+{
+    const std::size_t lane = static_cast<std::size_t>(task.priority);
+    const std::size_t target = (tlsPool == this) ? tlsIndex : mNextQueue++ % mQueues.size();
+
+    task.queuedTime = Clock::now();
+    ++mCounters[lane].submitted;
+    {
+        // mPending is updated together with the deques, so that a waiting worker
+        // never sees a count that doesn't match the queued tasks
+        std::lock_guard<std::mutex> lock{mQueues[target]->mutex};
+        mQueues[target]->lanes[lane].push_back(std::move(task));
+        std::lock_guard<std::mutex> pendingLock{mMutex};
+        ++mPending;
+    }
+    mCv.notify_one();
+}
+
+bool ThreadPool::takeTask(const std::size_t index, Task& task)
+{
+    const std::size_t queueCount = mQueues.size();
+    for (std::size_t lane = 0; lane < laneCount; ++lane)
+    {
+        {
+            WorkerQueue& own = *mQueues[index];
+            std::lock_guard<std::mutex> lock{own.mutex};
+            if (!own.lanes[lane].empty())
+            {
+                task = std::move(own.lanes[lane].front());
+                own.lanes[lane].pop_front();
+                std::lock_guard<std::mutex> pendingLock{mMutex};
+                --mPending;
+                return true;
+            }
+        }
+
+        for (std::size_t i = 1; i < queueCount; ++i)
+        {
+            WorkerQueue& victim = *mQueues[(index + i) % queueCount];
+            std::lock_guard<std::mutex> lock{victim.mutex};
+            if (!victim.lanes[lane].empty())
             {
-                return mDone || !mFunctors.empty();
-            });
-            if (mDone && mFunctors.empty())
+                task = std::move(victim.lanes[lane].back());
+                victim.lanes[lane].pop_back();
+                std::lock_guard<std::mutex> pendingLock{mMutex};
+                --mPending;
+                ++mStolen;
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+void ThreadPool::runTask(Task& task)
+{
+    LaneCounters& counters = mCounters[static_cast<std::size_t>(task.priority)];
+    const bool cancelled = task.cancelled && task.cancelled->load();
+    if (task.ownerConnection)
+    {
+        // Safe from any thread, also if the owner is already gone
+        QObject::disconnect(task.ownerConnection);
+    }
+    if (cancelled)
+    {
+        ++counters.cancelled;
+        return;
+    }
+
+    const std::uint64_t latencyUs = static_cast<std::uint64_t>(
+                std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - task.queuedTime).count());
+    counters.totalLatencyUs += latencyUs;
+    std::uint64_t maxLatencyUs = counters.maxLatencyUs.load();
+    while (latencyUs > maxLatencyUs && !counters.maxLatencyUs.compare_exchange_weak(maxLatencyUs, latencyUs))
+    {
+    }
+    ++counters.executed;
+
+    try
+    {
+        task.functor();
+    }
+    catch (const std::exception& e)
+    {
+        qCritical("ThreadPool: Error: %s", e.what());
+        Q_ASSERT(false);
+    }
+}
+
+void ThreadPool::drainSerialQueue()
+{
+    for (;;)
+    {
+        std::function<void()> functor;
+        {
+            std::lock_guard<std::mutex> lock{mSerialMutex};
+            if (mSerialFunctors.empty())
             {
-                break;
+                mSerialRunning = false;
+                return;
             }
-            functor = std::move(mFunctors.front());
-            mFunctors.pop();
+            functor = std::move(mSerialFunctors.front());
+            mSerialFunctors.pop();
         }
         try
         {
@@ -103,4 +315,3 @@ void ThreadPool::shutdown()
     }
     mThreads.clear();
 }
-
@@ -1,36 +1,141 @@
 #pragma once
 
+#include <array>
+#include <atomic>
+#include <chrono>
 #include <condition_variable>
 #include <cstddef>
+#include <cstdint>
+#include <deque>
 #include <functional>
+#include <memory>
 #include <mutex>
 #include <queue>
 #include <thread>
 #include <vector>
 
+#include <QObject>
+#include <QPointer>
 #include <QtGlobal>
 
+// Work-stealing pool: every worker owns one deque per priority lane and
+// idle workers steal from the back of the other workers' deques.
+//
+// push() keeps the historical semantics: functors are run one at a time
+// and in FIFO order, so callers that rely on ordering between jobs (like
+// logout cleanup after transfer population) keep working.
+// submit() schedules independent jobs that may run in parallel.
 class ThreadPool
 {
 public:
 
+    enum class Priority
+    {
+        INTERACTIVE = 0,
+        HOUSEKEEPING,
+        COUNT
+    };
+
+    class TaskHandle
+    {
+    public:
+        TaskHandle() = default;
+
+        // The task is skipped if it has not started yet
+        void cancel();
+        bool isCancelled() const;
+        bool isValid() const;
+
+    private:
+        friend class ThreadPool;
+        explicit TaskHandle(std::shared_ptr<std::atomic<bool>> cancelled);
+
+        std::shared_ptr<std::atomic<bool>> mCancelled;
+    };
+
+    struct LaneStats
+    {
+        std::uint64_t submitted = 0;
+        std::uint64_t executed = 0;
+        std::uint64_t cancelled = 0;
+        std::uint64_t queueDepth = 0;
+        std::uint64_t meanLatencyUs = 0;
+        std::uint64_t maxLatencyUs = 0;
+    };
+
+    struct Stats
+    {
+        std::size_t threadCount = 0;
+        std::uint64_t stolen = 0;
+        std::array<LaneStats, static_cast<std::size_t>(Priority::COUNT)> lanes;
+    };
+
     explicit ThreadPool(std::size_t threadCount);
     ~ThreadPool();
 
     Q_DISABLE_COPY(ThreadPool)
 
+    static std::size_t defaultThreadCount();
+
     void push(std::function<void()> functor);
 
+    // Jobs tied to an owner are dropped if the owner is destroyed before they start
+    TaskHandle submit(std::function<void()> functor,
+                      Priority priority = Priority::INTERACTIVE,
+                      QPointer<QObject> owner = QPointer<QObject>());
+
+    Stats getStats() const;
+
 private:
 
+    using Clock = std::chrono::steady_clock;
+
+    struct Task
+    {
+        std::function<void()> functor;
+        // Also set when the owner is destroyed, so workers never touch the owner itself
+        std::shared_ptr<std::atomic<bool>> cancelled;
+        QMetaObject::Connection ownerConnection;
+        Priority priority = Priority::INTERACTIVE;
+        Clock::time_point queuedTime;
+    };
+
+    struct WorkerQueue
+    {
+        std::mutex mutex;
+        std::array<std::deque<Task>, static_cast<std::size_t>(Priority::COUNT)> lanes;
+    };
+
+    struct LaneCounters
+    {
+        std::atomic<std::uint64_t> submitted{0};
+        std::atomic<std::uint64_t> executed{0};
+        std::atomic<std::uint64_t> cancelled{0};
+        std::atomic<std::uint64_t> totalLatencyUs{0};
+        std::atomic<std::uint64_t> maxLatencyUs{0};
+    };
+
     void worker(std::size_t index);
+    void enqueue(Task task);
+    bool takeTask(std::size_t index, Task& task);
+    void runTask(Task& task);
+    void drainSerialQueue();
 
     void shutdown();
 
     bool mDone = false;
     std::vector<std::thread> mThreads;
-    std::queue<std::function<void()>> mFunctors;
+    std::vector<std::unique_ptr<WorkerQueue>> mQueues;
+    // Tasks in the worker deques, guarded by mMutex
+    long long mPending = 0;
+    std::atomic<std::size_t> mNextQueue{0};
+    std::atomic<std::uint64_t> mStolen{0};
+    std::array<LaneCounters, static_cast<std::size_t>(Priority::COUNT)> mCounters;
     std::condition_variable mCv;
     std::mutex mMutex;
-};
 
+    // Ordered jobs queued with push()
+    std::queue<std::function<void()>> mSerialFunctors;
+    bool mSerialRunning = false;
+    std::mutex mSerialMutex;
+};
@@ -1,18 +1,57 @@
 #include "UpdateTask.h"
 #include "control/Utilities.h"
+#include "control/ThreadPool.h"
 #include "platform/Platform.h"
 #include <iostream>
 #include <QAuthenticator>
+#include <QCryptographicHash>
+#include <QDataStream>
 #include <QDesktopServices>
 
 using namespace mega;
 using namespace std;
 
+namespace
+{
+const int MAX_PARALLEL_UPDATE_DOWNLOADS = 4;
+const qint64 SIGNATURE_CHUNK_SIZE = 1024 * 1024;
+const QString PARTIAL_DOWNLOAD_SUFFIX = QString::fromUtf8(".part");
+
+// Delta patches are published by MEGAUpdateGenerator next to the full file as
+// <file url>.<sha256 of the installed file>.delta. Integers are little endian:
+//   "MEGADLT1", uint64 installed size, uint64 new size, then operations until 'E':
+//   'C' uint64 offset, uint32 length: copy a range of the installed file
+//   'D' uint32 length, <length bytes>: literal data
+const QByteArray DELTA_MAGIC("MEGADLT1");
+const QString DELTA_SUFFIX = QString::fromUtf8(".delta");
+
+// Hex SHA-256 of an installed file, or an empty string if it can't be read
+QString installedFileHash(const QString &path)
+{
+    QFile installed(path);
+    if (!installed.open(QIODevice::ReadOnly))
+    {
+        return QString();
+    }
+
+    QCryptographicHash sha256(QCryptographicHash::Sha256);
+    if (!sha256.addData(&installed))
+    {
+        return QString();
+    }
+    return QString::fromAscii(sha256.result().toHex());
+}
+}
+
 UpdateTask::UpdateTask(MegaApi *megaApi, QString appFolder, bool isPublic, QObject *parent) :
-    QObject(parent)
+    QObject(parent),
+    hashGuard(std::make_shared<HashGuard>())
 {
+    hashGuard->task = this;
     m_WebCtrl = NULL;
     signatureChecker = NULL;
+    updateInfoReply = NULL;
+    nextFile = 0;
     forceInstall = false;
     running = false;
     forceCheck = false;
@@ -25,6 +64,11 @@ UpdateTask::UpdateTask(MegaApi *megaApi, QString appFolder, bool isPublic, QObje
 
 UpdateTask::~UpdateTask()
 {
+    {
+        QMutexLocker locker(&hashGuard->mutex);
+        hashGuard->task = NULL;
+    }
+    abortFileDownloads();
     delete m_WebCtrl;
     delete signatureChecker;
     delete updateTimer;
@@ -71,7 +115,7 @@ void UpdateTask::startUpdateThread()
     connect(m_WebCtrl, SIGNAL(finished(QNetworkReply*)), this, SLOT(downloadFinished(QNetworkReply*)));
     connect(m_WebCtrl, SIGNAL(proxyAuthenticationRequired(const QNetworkProxy&, QAuthenticator*)), this, SLOT(onProxyAuthenticationRequired(const QNetworkProxy&, QAuthenticator*)));
 
-    string updatePublicKey = Preferences::UPDATE_PUBLIC_KEY;
+    updatePublicKey = Preferences::UPDATE_PUBLIC_KEY;
     if (getenv("MEGA_UPDATE_PUBLIC_KEY"))
     {
         updatePublicKey = getenv("MEGA_UPDATE_PUBLIC_KEY");
@@ -108,12 +152,15 @@ void UpdateTask::tryUpdate()
         MegaApi::log(MegaApi::LOG_LEVEL_WARNING, "Using environment variable MEGA_UPDATE_CHECK_URL to fetch update file");
     }
 
-    downloadFile(updateURL + randomSequence);
+    updateInfoReply = downloadFile(updateURL + randomSequence);
 }
 
 void UpdateTask::onTimeout()
 {
     timeoutTimer->stop();
+    // partial files are kept, the next attempt resumes them
+    abortFileDownloads();
+    updateInfoReply = NULL;
     delete m_WebCtrl;
     m_WebCtrl = new QNetworkAccessManager();
     connect(m_WebCtrl, SIGNAL(finished(QNetworkReply*)), this, SLOT(downloadFinished(QNetworkReply*)));
@@ -155,7 +202,7 @@ void UpdateTask::initialCleanup()
     downloadURLs.clear();
     localPaths.clear();
     fileSignatures.clear();
-    currentFile = -1;
+    nextFile = 0;
 }
 
 //Called after a successful update
@@ -192,7 +239,7 @@ void UpdateTask::postponeUpdate()
     forceCheck = false;
 }
 
-void UpdateTask::downloadFile(QString url)
+QNetworkReply *UpdateTask::downloadFile(QString url, qint64 resumeOffset)
 {
     MegaApi::log(MegaApi::LOG_LEVEL_DEBUG, QString::fromUtf8("Downloading updated file from %1").arg(url).toUtf8().constData());
 
@@ -200,9 +247,27 @@ void UpdateTask::downloadFile(QString url)
     request.setAttribute(QNetworkRequest::CacheLoadControlAttribute,
                          QVariant(int(QNetworkRequest::AlwaysNetwork)));
     request.setRawHeader("User-Agent", megaApi->getUserAgent());
+    if (resumeOffset > 0)
+    {
+        request.setRawHeader("Range", QString::fromUtf8("bytes=%1-").arg(resumeOffset).toUtf8());
+    }
 
-    m_WebCtrl->get(request);
+    QNetworkReply *reply = m_WebCtrl->get(request);
     timeoutTimer->start(Preferences::UPDATE_TIMEOUT_SECS*1000);
+    return reply;
+}
+
+// Keeps the inactivity timeout running while anything is being downloaded
+void UpdateTask::refreshTimeout()
+{
+    if (updateInfoReply || !fileDownloads.isEmpty())
+    {
+        timeoutTimer->start(Preferences::UPDATE_TIMEOUT_SECS*1000);
+    }
+    else
+    {
+        timeoutTimer->stop();
+    }
 }
 
 QString UpdateTask::readNextLine(QNetworkReply *reply)
@@ -327,71 +392,334 @@ bool UpdateTask::processUpdateFile(QNetworkReply *reply)
     return true;
 }
 
-bool UpdateTask::processFile(QNetworkReply *reply)
+// Starts downloads until MAX_PARALLEL_UPDATE_DOWNLOADS are running. Once everything is downloaded, applies the update
+void UpdateTask::startFileDownloads()
 {
-    QByteArray data = reply->readAll();
+    while (fileDownloads.size() + hashingDownloads.size() < MAX_PARALLEL_UPDATE_DOWNLOADS && nextFile < downloadURLs.size())
+    {
+        int index = nextFile++;
+        if (alreadyDownloaded(localPaths[index], fileSignatures[index]))
+        {
+            MegaApi::log(MegaApi::LOG_LEVEL_INFO, QString::fromAscii("File already downloaded: %1").arg(localPaths[index]).toUtf8().constData());
+            continue;
+        }
 
-    //Check signature
-    initSignature();
-    addToSignature(data);
-    if (!checkSignature(fileSignatures[currentFile]))
+        if (!startFileDownload(index))
+        {
+            abortFileDownloads();
+            postponeUpdate();
+            return;
+        }
+    }
+
+    if (fileDownloads.isEmpty() && hashingDownloads.isEmpty())
+    {
+        applyUpdate();
+    }
+}
+
+bool UpdateTask::startFileDownload(int index, bool allowDelta)
+{
+    QString localPath = updateFolder.absoluteFilePath(localPaths[index]);
+    QFileInfo(localPath).absoluteDir().mkpath(QString::fromAscii("."));
+
+    std::unique_ptr<FileDownload> download(new FileDownload());
+    download->index = index;
+    download->hash.reset(new MegaHashSignature(updatePublicKey.c_str()));
+    download->hash->init();
+    download->partFile.setFileName(localPath + PARTIAL_DOWNLOAD_SUFFIX);
+    if (!download->partFile.open(QIODevice::ReadWrite))
     {
-        MegaApi::log(MegaApi::LOG_LEVEL_ERROR, QString::fromUtf8("Invalid or corrupt file: %1")
-                     .arg(updateFolder.absoluteFilePath(localPaths[currentFile])).toUtf8().constData());
+        MegaApi::log(MegaApi::LOG_LEVEL_ERROR, QString::fromUtf8("Error opening local file from writting: %1").arg(download->partFile.fileName()).toUtf8().constData());
         return false;
     }
 
-    //Create the folder for the new file
-    QFile localFile(updateFolder.absoluteFilePath(localPaths[currentFile]));
-    QFileInfo info(localFile);
-    info.absoluteDir().mkpath(QString::fromAscii("."));
+    // A partial file left by a previous attempt is hashed again and the rest requested with a range
+    if (download->partFile.size() > 0)
+    {
+        if (addFileToSignature(download->partFile, download->hash.get()))
+        {
+            download->resumeOffset = download->partFile.size();
+            MegaApi::log(MegaApi::LOG_LEVEL_INFO, QString::fromUtf8("Resuming download of %1 at byte %2")
+                         .arg(localPaths[index]).arg(download->resumeOffset).toUtf8().constData());
+        }
+        else
+        {
+            download->hash->init();
+            download->partFile.resize(0);
+        }
+    }
 
-    //Delete the file if it exists.
-    localFile.remove();
+    // Try a delta against the installed file first, unless there is a full download to resume.
+    // The delta is named after the hash of the installed file, computed in the thread pool
+    QString installedPath = appFolder.absoluteFilePath(localPaths[index]);
+    if (allowDelta && !download->resumeOffset && QFile::exists(installedPath))
+    {
+        hashingDownloads.insert(index, download.release());
+        std::shared_ptr<HashGuard> guard = hashGuard;
+        ThreadPoolSingleton::getInstance()->submit([guard, index, installedPath]()
+        {
+            QString sha256 = installedFileHash(installedPath);
+            QMutexLocker locker(&guard->mutex);
+            if (guard->task)
+            {
+                QMetaObject::invokeMethod(guard->task, "onInstalledFileHashed", Qt::QueuedConnection,
+                                          Q_ARG(int, index), Q_ARG(QString, sha256));
+            }
+        }, ThreadPool::Priority::HOUSEKEEPING);
+        return true;
+    }
 
-    //Open the new file
-    if (!localFile.open(QIODevice::WriteOnly))
+    sendFileRequest(download.release(), downloadURLs[index]);
+    return true;
+}
+
+void UpdateTask::onInstalledFileHashed(int index, QString sha256)
+{
+    FileDownload *download = hashingDownloads.take(index);
+    if (!download)
     {
-        MegaApi::log(MegaApi::LOG_LEVEL_ERROR, QString::fromUtf8("Error opening local file from writting: %1").arg(info.absoluteFilePath()).toUtf8().constData());
-        return false;
+        return; // aborted
+    }
+
+    QString url = downloadURLs[index];
+    if (!sha256.isEmpty())
+    {
+        url += QString::fromAscii(".") + sha256 + DELTA_SUFFIX;
+        download->delta = true;
+    }
+    sendFileRequest(download, url);
+}
+
+void UpdateTask::sendFileRequest(FileDownload *download, const QString &url)
+{
+    MegaApi::log(MegaApi::LOG_LEVEL_INFO, QString::fromAscii("Downloading file: %1").arg(url).toUtf8().constData());
+    QNetworkReply *reply = downloadFile(url, download->resumeOffset);
+    connect(reply, SIGNAL(readyRead()), this, SLOT(onFileDownloadReadyRead()));
+    fileDownloads.insert(reply, download);
+}
+
+void UpdateTask::onFileDownloadReadyRead()
+{
+    QNetworkReply *reply = qobject_cast<QNetworkReply*>(sender());
+    FileDownload *download = fileDownloads.value(reply);
+    if (!download || download->aborted)
+    {
+        return;
+    }
+
+    timeoutTimer->start(Preferences::UPDATE_TIMEOUT_SECS*1000);
+    if (download->delta)
+    {
+        download->deltaData.append(reply->readAll());
+        return;
     }
 
-    //Write the new file
-    int remainingSize = data.size();
-    int position = 0;
-    while (remainingSize)
+    if (!processFileData(reply, download))
     {
-        int written = localFile.write(data.constData()+position, remainingSize);
-        if (written == -1)
+        reply->abort();
+    }
+}
+
+// Appends the received bytes to the partial file and the file signature
+bool UpdateTask::processFileData(QNetworkReply *reply, FileDownload *download)
+{
+    if (!download->started)
+    {
+        int statusCode = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+        if (statusCode != 200 && statusCode != 206)
         {
-            MegaApi::log(MegaApi::LOG_LEVEL_ERROR, QString::fromUtf8("Error writting file: %1").arg(info.absoluteFilePath()).toUtf8().constData());
-            localFile.close();
-            return false;
+            return true; // reported as an error once finished
         }
-        remainingSize -= written;
-        position += written;
+
+        QByteArray contentRange = reply->rawHeader("Content-Range");
+        bool resumed = statusCode == 206 && download->resumeOffset > 0
+                && contentRange.startsWith(QString::fromUtf8("bytes %1-").arg(download->resumeOffset).toUtf8());
+        if (!resumed)
+        {
+            if (statusCode == 206)
+            {
+                MegaApi::log(MegaApi::LOG_LEVEL_ERROR, QString::fromUtf8("Unexpected range received: %1")
+                             .arg(QString::fromUtf8(contentRange)).toUtf8().constData());
+                return false;
+            }
+
+            // the server sent the whole file
+            download->resumeOffset = 0;
+            download->hash->init();
+            download->partFile.resize(0);
+        }
+        download->partFile.seek(download->partFile.size());
+        download->started = true;
+    }
+
+    QByteArray data = reply->readAll();
+    if (data.isEmpty())
+    {
+        return true;
     }
 
+    download->hash->add(data.constData(), data.size());
+    if (download->partFile.write(data) != data.size())
+    {
+        MegaApi::log(MegaApi::LOG_LEVEL_ERROR, QString::fromUtf8("Error writting file: %1").arg(download->partFile.fileName()).toUtf8().constData());
+        return false;
+    }
+    return true;
+}
+
+bool UpdateTask::processFile(QNetworkReply *reply, FileDownload *download)
+{
+    int index = download->index;
+    QString localPath = updateFolder.absoluteFilePath(localPaths[index]);
+
+    //Check signature
+    int result = download->hash->checkSignature(fileSignatures[index].toAscii().constData());
+    if (!result)
+    {
+        MegaApi::log(MegaApi::LOG_LEVEL_ERROR, QString::fromUtf8("Invalid or corrupt file: %1").arg(localPath).toUtf8().constData());
+        download->partFile.close();
+        download->partFile.remove(); // don't resume from corrupt data
+        return false;
+    }
 
     //Save the new file
-    if (!localFile.flush())
+    if (!download->partFile.flush())
+    {
+        MegaApi::log(MegaApi::LOG_LEVEL_ERROR, QString::fromUtf8("Error flushing file: %1").arg(localPath).toUtf8().constData());
+        download->partFile.close();
+        return false;
+    }
+    download->partFile.close();
+
+    //Delete the file if it exists.
+    QFile::remove(localPath);
+    if (!download->partFile.rename(localPath))
     {
-        MegaApi::log(MegaApi::LOG_LEVEL_ERROR, QString::fromUtf8("Error flushing file: %1").arg(info.absoluteFilePath()).toUtf8().constData());
-        localFile.close();
+        MegaApi::log(MegaApi::LOG_LEVEL_ERROR, QString::fromUtf8("Error renaming downloaded file: %1").arg(localPath).toUtf8().constData());
         return false;
     }
-    localFile.close();
 
 #ifdef _WIN32
     if (isPublic)
     {
-        Platform::makePubliclyReadable((LPTSTR)QDir::toNativeSeparators(localFile.fileName()).utf16());
+        Platform::makePubliclyReadable((LPTSTR)QDir::toNativeSeparators(localPath).utf16());
     }
 #endif
 
+    Q_UNUSED(reply);
     return true;
 }
 
+// Rebuilds the new file into the partial file from the installed one and the received delta.
+// The result is checked against the signature of the full file by processFile
+bool UpdateTask::applyDelta(FileDownload *download)
+{
+    QFile installed(appFolder.absoluteFilePath(localPaths[download->index]));
+    if (!installed.open(QIODevice::ReadOnly))
+    {
+        return false;
+    }
+
+    QDataStream delta(download->deltaData);
+    delta.setByteOrder(QDataStream::LittleEndian);
+
+    QByteArray magic(DELTA_MAGIC.size(), Qt::Uninitialized);
+    quint64 installedSize = 0;
+    quint64 newSize = 0;
+    if (delta.readRawData(magic.data(), magic.size()) != magic.size() || magic != DELTA_MAGIC)
+    {
+        return false;
+    }
+    delta >> installedSize >> newSize;
+    if (delta.status() != QDataStream::Ok || installedSize != quint64(installed.size()))
+    {
+        return false;
+    }
+
+    download->hash->init();
+    if (!download->partFile.resize(0) || !download->partFile.seek(0))
+    {
+        return false;
+    }
+
+    QByteArray buffer;
+    quint64 written = 0;
+    while (true)
+    {
+        quint8 operation = 0;
+        delta >> operation;
+        if (delta.status() != QDataStream::Ok)
+        {
+            return false;
+        }
+
+        if (operation == 'E')
+        {
+            return written == newSize;
+        }
+
+        quint64 offset = 0;
+        quint32 length = 0;
+        if (operation == 'C')
+        {
+            delta >> offset >> length;
+            if (delta.status() != QDataStream::Ok || offset + length > installedSize || !installed.seek(offset))
+            {
+                return false;
+            }
+        }
+        else if (operation == 'D')
+        {
+            delta >> length;
+        }
+        else
+        {
+            return false;
+        }
+
+        while (length)
+        {
+            int chunk = static_cast<int>(qMin<qint64>(length, SIGNATURE_CHUNK_SIZE));
+            buffer.resize(chunk);
+            int read = operation == 'C' ? static_cast<int>(installed.read(buffer.data(), chunk))
+                                        : delta.readRawData(buffer.data(), chunk);
+            if (read != chunk || written + chunk > newSize)
+            {
+                return false;
+            }
+
+            download->hash->add(buffer.constData(), chunk);
+            if (download->partFile.write(buffer) != chunk)
+            {
+                return false;
+            }
+            written += chunk;
+            length -= chunk;
+        }
+    }
+}
+
+// Partial files are kept so that a later attempt can resume them
+void UpdateTask::abortFileDownloads()
+{
+    QMap<QNetworkReply*, FileDownload*> downloads;
+    downloads.swap(fileDownloads);
+    for (auto it = downloads.begin(); it != downloads.end(); ++it)
+    {
+        it.value()->aborted = true;
+        it.key()->disconnect(this);
+        it.key()->abort();
+        it.key()->deleteLater();
+        it.value()->partFile.close();
+        delete it.value();
+    }
+
+    // Their hashing jobs find nothing to resume when they finish
+    qDeleteAll(hashingDownloads);
+    hashingDownloads.clear();
+}
+
 bool UpdateTask::performUpdate()
 {
     MegaApi::log(MegaApi::LOG_LEVEL_INFO, "Applying update...");
@@ -490,72 +818,137 @@ bool UpdateTask::alreadyDownloaded(QString relativePath, QString fileSignature)
 
 bool UpdateTask::alreadyExists(QString absolutePath, QString fileSignature)
 {
-    MegaHashSignature tmpHash((const char *)Preferences::UPDATE_PUBLIC_KEY);
+    MegaHashSignature tmpHash(updatePublicKey.c_str());
     QFile file(absolutePath);
     if (!file.open(QIODevice::ReadOnly))
     {
         return false;
     }
 
-    QByteArray bytes = file.readAll();
-    tmpHash.add(bytes.constData(), bytes.size());
+    bool readOk = addFileToSignature(file, &tmpHash);
     file.close();
 
-    return tmpHash.checkSignature(fileSignature.toAscii().constData());
+    return readOk && tmpHash.checkSignature(fileSignature.toAscii().constData());
 }
 
-void UpdateTask::downloadFinished(QNetworkReply *reply)
+// Hashes an open file from the start in fixed size chunks
+bool UpdateTask::addFileToSignature(QFile &file, MegaHashSignature *hash)
 {
-    timeoutTimer->stop();
-    reply->deleteLater();
-
-    //Check if the request has been successful
-    QVariant statusCode = reply->attribute( QNetworkRequest::HttpStatusCodeAttribute );
-    if (!statusCode.isValid() || (statusCode.toInt() != 200) || (reply->error() != QNetworkReply::NoError))
+    if (!file.seek(0))
     {
-        MegaApi::log(MegaApi::LOG_LEVEL_ERROR, "Unable to download file");
-        postponeUpdate();
-        return;
+        return false;
     }
 
-    //Process the received data
-    if (currentFile <  0)
+    QByteArray chunk(static_cast<int>(SIGNATURE_CHUNK_SIZE), Qt::Uninitialized);
+    while (!file.atEnd())
     {
-        //Process the update file
-        if (!processUpdateFile(reply))
+        qint64 read = file.read(chunk.data(), SIGNATURE_CHUNK_SIZE);
+        if (read < 0)
         {
-            postponeUpdate();
-            return;
+            return false;
         }
-        emit installingUpdate(forceCheck);
+        hash->add(chunk.constData(), static_cast<unsigned>(read));
     }
-    else
+    return true;
+}
+
+void UpdateTask::downloadFinished(QNetworkReply *reply)
+{
+    reply->deleteLater();
+
+    if (reply != updateInfoReply)
     {
+        FileDownload *download = fileDownloads.take(reply);
+        if (!download)
+        {
+            return; // aborted
+        }
+        std::unique_ptr<FileDownload> finished(download);
+        refreshTimeout();
+
+        if (download->delta)
+        {
+            int index = download->index;
+            download->deltaData.append(reply->readAll());
+            QVariant statusCode = reply->attribute( QNetworkRequest::HttpStatusCodeAttribute );
+            if (statusCode.toInt() == 200 && reply->error() == QNetworkReply::NoError
+                    && applyDelta(download) && processFile(reply, download))
+            {
+                MegaApi::log(MegaApi::LOG_LEVEL_INFO, QString::fromUtf8("File patched: %1 (%2 bytes downloaded)")
+                             .arg(localPaths[index]).arg(download->deltaData.size()).toUtf8().constData());
+                startFileDownloads();
+                return;
+            }
+
+            //No usable delta. Download the full file instead
+            MegaApi::log(MegaApi::LOG_LEVEL_INFO, QString::fromUtf8("Delta not available for %1. Downloading the full file")
+                         .arg(localPaths[index]).toUtf8().constData());
+            finished->partFile.remove();
+            finished.reset();
+            if (!startFileDownload(index, false))
+            {
+                abortFileDownloads();
+                refreshTimeout();
+                postponeUpdate();
+            }
+            return;
+        }
+
+        //Check if the request has been successful
+        QVariant statusCode = reply->attribute( QNetworkRequest::HttpStatusCodeAttribute );
+        bool ok = statusCode.isValid() && (statusCode.toInt() == 200 || statusCode.toInt() == 206)
+                && reply->error() == QNetworkReply::NoError;
+        if (!ok)
+        {
+            MegaApi::log(MegaApi::LOG_LEVEL_ERROR, "Unable to download file");
+            if (statusCode.toInt() == 416) // the partial file is not a prefix of the current one
+            {
+                finished->partFile.remove();
+            }
+        }
+
         //Process the file
-        if (!processFile(reply))
+        if (!ok || !processFileData(reply, download) || !processFile(reply, download))
         {
             MegaApi::log(MegaApi::LOG_LEVEL_ERROR, QString::fromUtf8("Update failed processing file: %1")
-                         .arg(downloadURLs[currentFile]).toUtf8().constData());
+                         .arg(downloadURLs[download->index]).toUtf8().constData());
+            finished->partFile.close();
+            abortFileDownloads();
+            refreshTimeout();
             postponeUpdate();
             return;
         }
+
+        //File processed. Download the next files
+        startFileDownloads();
+        return;
     }
 
-    //File processed. Download the next file
-    currentFile++;
-    while (currentFile < downloadURLs.size())
+    updateInfoReply = NULL;
+    refreshTimeout();
+
+    //Check if the request has been successful
+    QVariant statusCode = reply->attribute( QNetworkRequest::HttpStatusCodeAttribute );
+    if (!statusCode.isValid() || (statusCode.toInt() != 200) || (reply->error() != QNetworkReply::NoError))
     {
-        if (!alreadyDownloaded(localPaths[currentFile], fileSignatures[currentFile]))
-        {
-            MegaApi::log(MegaApi::LOG_LEVEL_INFO, QString::fromAscii("Downloading file: %1").arg(downloadURLs[currentFile]).toUtf8().constData());
-            downloadFile(downloadURLs[currentFile]);
-            return;
-        }
+        MegaApi::log(MegaApi::LOG_LEVEL_ERROR, "Unable to download file");
+        postponeUpdate();
+        return;
+    }
 
-        MegaApi::log(MegaApi::LOG_LEVEL_INFO, QString::fromAscii("File already downloaded: %1").arg(localPaths[currentFile]).toUtf8().constData());
-        currentFile++;
+    //Process the update file
+    if (!processUpdateFile(reply))
+    {
+        postponeUpdate();
+        return;
     }
+    emit installingUpdate(forceCheck);
 
+    startFileDownloads();
+}
+
+void UpdateTask::applyUpdate()
+{
     //All files have been processed. Apply update
     if (preferences->updateAutomatically() || forceInstall)
     {
@@ -13,6 +13,11 @@
 #include <QDir>
 #include <QDirIterator>
 #include <QDateTime>
+#include <QFile>
+#include <QMap>
+#include <QMutex>
+
+#include <memory>
 
 #include "megaapi.h"
 #include "control/Preferences.h"
@@ -26,13 +31,34 @@ public:
     ~UpdateTask();
 
 protected:
+   // One update file being downloaded into <path>.part and hashed as bytes arrive
+   struct FileDownload
+   {
+       int index = -1;
+       QFile partFile;
+       std::unique_ptr<mega::MegaHashSignature> hash;
+       qint64 resumeOffset = 0;
+       bool started = false;
+       bool aborted = false;
+       bool delta = false;
+       QByteArray deltaData;
+   };
+
    void initialCleanup();
    void finalCleanup();
    void postponeUpdate();
-   void downloadFile(QString url);
+   QNetworkReply *downloadFile(QString url, qint64 resumeOffset = 0);
    QString readNextLine(QNetworkReply *reply);
    bool processUpdateFile(QNetworkReply *reply);
-   bool processFile(QNetworkReply *reply);
+   void startFileDownloads();
+   bool startFileDownload(int index, bool allowDelta = true);
+   void sendFileRequest(FileDownload *download, const QString &url);
+   bool applyDelta(FileDownload *download);
+   bool processFileData(QNetworkReply *reply, FileDownload *download);
+   bool processFile(QNetworkReply *reply, FileDownload *download);
+   void abortFileDownloads();
+   void refreshTimeout();
+   void applyUpdate();
    bool performUpdate();
    void rollbackUpdate(int fileNum);
    void addToSignature(QString value);
@@ -42,6 +68,7 @@ protected:
    bool alreadyInstalled(QString relativePath, QString fileSignature);
    bool alreadyDownloaded(QString relativePath, QString fileSignature);
    bool alreadyExists(QString absolutePath, QString fileSignature);
+   bool addFileToSignature(QFile &file, mega::MegaHashSignature *hash);
 
    Preferences *preferences;
    QStringList downloadURLs;
@@ -49,9 +76,14 @@ protected:
    QStringList fileSignatures;
    QNetworkAccessManager *m_WebCtrl;
    mega::MegaHashSignature *signatureChecker;
+   std::string updatePublicKey;
    char signature[512];
    int updateVersion;
-   int currentFile;
+   int nextFile;
+   QNetworkReply *updateInfoReply;
+   QMap<QNetworkReply*, FileDownload*> fileDownloads;
+   // Waiting for the hash of the installed file, to ask for a delta
+   QMap<int, FileDownload*> hashingDownloads;
    QDir updateFolder;
    QDir backupFolder;
    QDir appFolder;
@@ -64,6 +96,15 @@ protected:
    bool isPublic;
    mega::MegaApi *megaApi;
 
+   // Shared with the hashing jobs. The destructor clears task, waiting for a job that is reporting
+   // its result, so results of later jobs are dropped
+   struct HashGuard
+   {
+       QMutex mutex;
+       UpdateTask *task;
+   };
+   std::shared_ptr<HashGuard> hashGuard;
+
 signals:
    void updateCompleted();
    void updateAvailable(bool requested);
@@ -73,6 +114,8 @@ signals:
 
 private slots:
    void downloadFinished(QNetworkReply* reply);
+   void onFileDownloadReadyRead();
+   void onInstalledFileHashed(int index, QString sha256);
    void onProxyAuthenticationRequired(const QNetworkProxy&, QAuthenticator*);
 
 public slots:
@@ -8,6 +8,8 @@
 #include <QTextStream>
 #include <QDateTime>
 #include <iostream>
+#include <atomic>
+#include <thread>
 #include <QDesktopWidget>
 #include "MegaApplication.h"
 #include "control/gzjoin.h"
@@ -392,6 +394,79 @@ void Utilities::copyRecursively(QString srcPath, QString dstPath)
     }
 }
 
+namespace
+{
+const qint64 FILE_COMPARE_CHUNK_SIZE = 1 * MB;
+const qint64 FILE_COMPARE_PARALLEL_THRESHOLD = 1 * GB;
+const unsigned FILE_COMPARE_MAX_THREADS = 4;
+
+// Compares [offset, offset + length) of both files chunk by chunk.
+// Returns true as soon as a chunk differs, a read fails or another range already found a difference
+bool fileRangesDiffer(const QString& sourcePath, const QString& destinationPath,
+                      qint64 offset, qint64 length, std::atomic<bool>& differs)
+{
+    QFile source(sourcePath);
+    QFile destination(destinationPath);
+    if (!source.open(QIODevice::ReadOnly) || !destination.open(QIODevice::ReadOnly)
+            || !source.seek(offset) || !destination.seek(offset))
+    {
+        return true;
+    }
+
+    std::unique_ptr<char[]> sourceChunk(new char[FILE_COMPARE_CHUNK_SIZE]);
+    std::unique_ptr<char[]> destinationChunk(new char[FILE_COMPARE_CHUNK_SIZE]);
+    while (length > 0 && !differs)
+    {
+        const qint64 chunkSize = std::min(length, FILE_COMPARE_CHUNK_SIZE);
+        if (source.read(sourceChunk.get(), chunkSize) != chunkSize
+                || destination.read(destinationChunk.get(), chunkSize) != chunkSize
+                || memcmp(sourceChunk.get(), destinationChunk.get(), static_cast<size_t>(chunkSize)))
+        {
+            return true;
+        }
+        length -= chunkSize;
+    }
+    return differs;
+}
+}
+
+bool Utilities::fileContentsDiffer(const QString& sourcePath, const QString& destinationPath)
+{
+    const qint64 size = QFileInfo(sourcePath).size();
+    if (size != QFileInfo(destinationPath).size())
+    {
+        return true;
+    }
+
+    std::atomic<bool> differs(false);
+    const unsigned threadCount = std::min(FILE_COMPARE_MAX_THREADS, std::thread::hardware_concurrency());
+    if (size < FILE_COMPARE_PARALLEL_THRESHOLD || threadCount < 2)
+    {
+        return fileRangesDiffer(sourcePath, destinationPath, 0, size, differs);
+    }
+
+    // Very large files: split them in contiguous ranges compared at the same time,
+    // the first range to find a difference stops the others
+    const qint64 rangeSize = (size / threadCount + FILE_COMPARE_CHUNK_SIZE - 1) / FILE_COMPARE_CHUNK_SIZE * FILE_COMPARE_CHUNK_SIZE;
+    std::vector<std::thread> threads;
+    for (qint64 offset = 0; offset < size; offset += rangeSize)
+    {
+        const qint64 length = std::min(rangeSize, size - offset);
+        threads.emplace_back([&sourcePath, &destinationPath, offset, length, &differs]()
+        {
+            if (fileRangesDiffer(sourcePath, destinationPath, offset, length, differs))
+            {
+                differs = true;
+            }
+        });
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+    return differs;
+}
+
 bool Utilities::verifySyncedFolderLimits(QString path)
 {
 #ifdef WIN32
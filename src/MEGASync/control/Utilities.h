@@ -190,7 +190,7 @@ class ThreadPoolSingleton
         {
             if (instance == nullptr)
             {
-                instance.reset(new ThreadPool(1));
+                instance.reset(new ThreadPool(ThreadPool::defaultThreadCount()));
             }
 
             return instance.get();
@@ -318,6 +318,9 @@ public:
     static QString getAvatarPath(QString email);
     static bool removeRecursively(QString path);
     static void copyRecursively(QString srcPath, QString dstPath);
+    // Compares the contents of two files in fixed size chunks, stopping at the first difference.
+    // Also true if any of them can't be read
+    static bool fileContentsDiffer(const QString& sourcePath, const QString& destinationPath);
 
     static void queueFunctionInAppThread(std::function<void()> fun);
 
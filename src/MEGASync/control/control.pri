@@ -4,6 +4,7 @@ INCLUDEPATH += $$PWD
 QT       += network
 
 SOURCES += $$PWD/HTTPServer.cpp \
+    $$PWD/JsonTokenizer.cpp \
     $$PWD/Preferences.cpp \
     $$PWD/LinkProcessor.cpp \
     $$PWD/MegaUploader.cpp \
@@ -17,10 +18,13 @@ SOURCES += $$PWD/HTTPServer.cpp \
     $$PWD/MegaDownloader.cpp \
     $$PWD/MegaController.cpp \
     $$PWD/MegaSyncLogger.cpp \
+    $$PWD/MemorySampler.cpp \
+    $$PWD/FinishedTransferHistory.cpp \
     $$PWD/ConnectivityChecker.cpp \
     $$PWD/qrcodegen.c
 
 HEADERS  +=  $$PWD/HTTPServer.h \
+    $$PWD/JsonTokenizer.h \
     $$PWD/AppStatsEvents.h \
     $$PWD/Preferences.h \
     $$PWD/LinkProcessor.h \
@@ -35,6 +39,8 @@ HEADERS  +=  $$PWD/HTTPServer.h \
     $$PWD/MegaDownloader.h \
     $$PWD/MegaController.h \
     $$PWD/MegaSyncLogger.h \
+    $$PWD/MemorySampler.h \
+    $$PWD/FinishedTransferHistory.h \
     $$PWD/ConnectivityChecker.h \
     $$PWD/qrcodegen.h \
     $$PWD/gzjoin.h
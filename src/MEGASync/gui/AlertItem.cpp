@@ -13,7 +13,8 @@ using namespace mega;
 
 AlertItem::AlertItem(QWidget *parent) :
     QWidget(parent),
-    ui(new Ui::AlertItem)
+    ui(new Ui::AlertItem),
+    alertDataReady(false)
 {
     ui->setupUi(this);
     megaApi = ((MegaApplication *)qApp)->getMegaApi();
@@ -31,6 +32,7 @@ AlertItem::AlertItem(QWidget *parent) :
         setAlertContent(alertUser.get());
         setAlertTimeStamp(alertUser->getTimestamp(0));
         alertUser->getSeen() ? ui->lNew->hide() : ui->lNew->show();
+        alertDataReady = true;
 
         emit refreshAlertItem(alertUser->getId());
         });
@@ -43,6 +45,7 @@ AlertItem::~AlertItem()
 
 void AlertItem::setAlertData(MegaUserAlert *alert)
 {
+    alertDataReady = false;
     alertUser.reset(alert->copy());
     MegaHandle handle = alertUser->getNodeHandle();
     getAlertNodeWatcher.setFuture(QtConcurrent::run([=]()
@@ -51,6 +54,11 @@ void AlertItem::setAlertData(MegaUserAlert *alert)
     }));
 }
 
+bool AlertItem::isAlertDataReady() const
+{
+    return alertDataReady;
+}
+
 void AlertItem::setAlertType(int type)
 {
     ui->wNotificationIcon->hide();
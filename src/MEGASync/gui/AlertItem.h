@@ -25,6 +25,8 @@ public:
     void setAlertTimeStamp(int64_t ts);
 
     QString getHeadingString();
+    // False until the node of the alert has been loaded
+    bool isAlertDataReady() const;
 
     QSize minimumSizeHint() const;
     QSize sizeHint() const;
@@ -46,6 +48,7 @@ private:
     std::unique_ptr<mega::MegaNode> alertNode;
     std::unique_ptr<mega::MegaUserAlert> alertUser;
     QFutureWatcher<mega::MegaNode*> getAlertNodeWatcher;
+    bool alertDataReady;
 };
 
 #endif // ALERTITEM_H
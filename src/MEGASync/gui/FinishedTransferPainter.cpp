@@ -0,0 +1,157 @@
+#include "FinishedTransferPainter.h"
+#include "QTransfersModel.h"
+#include "Preferences.h"
+#include "control/Utilities.h"
+
+#include <QDateTime>
+#include <QFontMetrics>
+#include <QPainter>
+
+using namespace mega;
+
+const int FinishedTransferPainter::MAX_CACHED_ROWS = 512;
+
+namespace
+{
+// Horizontal positions of the completed state of TransferManagerItem. The icons and the name are
+// placed from the left edge of the row and the other columns from its right edge
+const int TYPE_ICON_X = 8;
+const int FILE_ICON_X = 26;
+const int NAME_X = 54;
+const int MAX_NAME_WIDTH = 375;
+const int NAME_SPACING = 33;
+const int STATUS_ICON_RIGHT = 322;
+const int SIZE_RIGHT = 302;
+const int ACTION_ICON_RIGHT = 222;
+const int TIME_RIGHT = 184;
+const int CLEAR_BUTTON_RIGHT_MARGIN = 20;
+const int SMALL_ICON_SIZE = 12;
+const QSize FILE_ICON_SIZE(20, 22);
+const QSize ACTION_ICON_SIZE(32, 32);
+const QColor TEXT_COLOR(0x33, 0x33, 0x33);
+}
+
+FinishedTransferPainter::FinishedTransferPainter()
+    : nameFont(QString::fromUtf8("Lato")),
+      sizeFont(QString::fromUtf8("Lato")),
+      timeFont(QString::fromUtf8("Lato"))
+{
+    nameFont.setPixelSize(16);
+    sizeFont.setPixelSize(13);
+    timeFont.setPixelSize(10);
+    rows.setMaxCost(MAX_CACHED_ROWS);
+}
+
+void FinishedTransferPainter::paint(QPainter *painter, const QRect &rect, TransferItemData *tData, bool hovered)
+{
+    int width = rect.width();
+    int nameWidth = qBound(0, width - STATUS_ICON_RIGHT - NAME_SPACING - NAME_X, MAX_NAME_WIDTH);
+    Row *row = getRow(tData, nameWidth);
+    int height = rect.height();
+    bool failed = tData->data.errorCode < 0;
+
+    QString typeIcon;
+    if (tData->data.type == MegaTransfer::TYPE_UPLOAD)
+    {
+        typeIcon = failed ? QString::fromUtf8(":/images/upload_fail_item_ico.png")
+                          : QString::fromUtf8(":/images/uploaded_item_ico.png");
+    }
+    else
+    {
+        typeIcon = failed ? QString::fromUtf8(":/images/download_fail_item_ico.png")
+                          : QString::fromUtf8(":/images/downloaded_item_ico.png");
+    }
+
+    painter->save();
+    painter->translate(rect.topLeft());
+
+    int smallIconY = (height - SMALL_ICON_SIZE) / 2;
+    painter->drawPixmap(TYPE_ICON_X, smallIconY, getPixmap(typeIcon, QSize(SMALL_ICON_SIZE, SMALL_ICON_SIZE)));
+    painter->drawPixmap(FILE_ICON_X, (height - FILE_ICON_SIZE.height()) / 2, row->fileIcon);
+    painter->drawPixmap(width - STATUS_ICON_RIGHT, smallIconY,
+                        getPixmap(failed ? QString::fromUtf8(":/images/import_error_ico.png")
+                                         : QString::fromUtf8(":/images/completed_item_ico.png"),
+                                  QSize(SMALL_ICON_SIZE, SMALL_ICON_SIZE)));
+    painter->drawPixmap(width - ACTION_ICON_RIGHT, (height - ACTION_ICON_SIZE.height()) / 2,
+                        getPixmap(tData->data.isSyncTransfer ? QString::fromUtf8(":/images/sync_item_ico.png")
+                                                             : QString::fromUtf8(":/images/cloud_item_ico.png"),
+                                  ACTION_ICON_SIZE));
+
+    painter->setPen(TEXT_COLOR);
+    painter->setFont(nameFont);
+    painter->drawStaticText(NAME_X, (height - QFontMetrics(nameFont).height()) / 2, row->name);
+    painter->setFont(sizeFont);
+    painter->drawStaticText(width - SIZE_RIGHT, (height - QFontMetrics(sizeFont).height()) / 2, row->size);
+    painter->setFont(timeFont);
+    painter->drawStaticText(width - TIME_RIGHT, (height - QFontMetrics(timeFont).height()) / 2, row->finishedTime);
+
+    if (hovered)
+    {
+        painter->drawPixmap(width - CLEAR_BUTTON_RIGHT_MARGIN - SMALL_ICON_SIZE, smallIconY,
+                            getPixmap(QString::fromUtf8(":/images/clear_item_ico.png"), QSize(SMALL_ICON_SIZE, SMALL_ICON_SIZE)));
+    }
+    painter->restore();
+}
+
+bool FinishedTransferPainter::isInsideClearButton(const QPoint &pos, const QRect &rect) const
+{
+    QRect button(rect.width() - CLEAR_BUTTON_RIGHT_MARGIN - SMALL_ICON_SIZE, (rect.height() - SMALL_ICON_SIZE) / 2,
+                 SMALL_ICON_SIZE, SMALL_ICON_SIZE);
+    return button.contains(pos);
+}
+
+bool FinishedTransferPainter::isFileNameElided(int tag) const
+{
+    Row *row = rows.object(tag);
+    return row && row->elided;
+}
+
+FinishedTransferPainter::Row *FinishedTransferPainter::getRow(TransferItemData *tData, int nameWidth)
+{
+    Row *row = rows.object(tData->data.tag);
+    if (!row || row->fileName != tData->data.filename || row->nameWidth != nameWidth)
+    {
+        row = new Row();
+        row->fileName = tData->data.filename;
+        row->nameWidth = nameWidth;
+
+        QString elidedName = QFontMetrics(nameFont).elidedText(row->fileName, Qt::ElideMiddle, nameWidth);
+        row->elided = elidedName != row->fileName;
+        row->name.setText(elidedName);
+        row->name.setTextFormat(Qt::PlainText);
+        row->name.prepare(QTransform(), nameFont);
+
+        row->size.setText(Utilities::getSizeString(tData->data.totalSize));
+        row->size.setTextFormat(Qt::PlainText);
+        row->size.prepare(QTransform(), sizeFont);
+
+        row->fileIcon = Utilities::getExtensionPixmapSmall(row->fileName).pixmap(FILE_ICON_SIZE);
+        row->finishedSecs = -1;
+        rows.insert(tData->data.tag, row);
+    }
+
+    // The relative time is the only text that changes
+    long long secs = (QDateTime::currentMSecsSinceEpoch() / 100
+                      - (Preferences::instance()->getMsDiffTimeWithSDK() + tData->data.updateTime)) / 10;
+    if (secs != row->finishedSecs)
+    {
+        row->finishedSecs = secs;
+        row->finishedTime.setText(Utilities::getFinishedTimeString(secs));
+        row->finishedTime.setTextFormat(Qt::PlainText);
+        row->finishedTime.prepare(QTransform(), timeFont);
+    }
+    return row;
+}
+
+QPixmap FinishedTransferPainter::getPixmap(const QString &resource, const QSize &size)
+{
+    QHash<QString, QPixmap>::const_iterator it = pixmaps.constFind(resource);
+    if (it != pixmaps.constEnd())
+    {
+        return it.value();
+    }
+
+    QPixmap pixmap = Utilities::getCachedPixmap(resource).pixmap(size);
+    pixmaps.insert(resource, pixmap);
+    return pixmap;
+}
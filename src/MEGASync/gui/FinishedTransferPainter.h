@@ -0,0 +1,52 @@
+#ifndef FINISHEDTRANSFERPAINTER_H
+#define FINISHEDTRANSFERPAINTER_H
+
+#include <QCache>
+#include <QFont>
+#include <QHash>
+#include <QPixmap>
+#include <QStaticText>
+
+class QPainter;
+class TransferItemData;
+
+// Paints the rows of the finished transfers list with QPainter only, with the
+// same layout as the completed state of TransferManagerItem. Texts are laid out
+// once per row and width, and icons are kept as pixmaps.
+class FinishedTransferPainter
+{
+public:
+    FinishedTransferPainter();
+
+    void paint(QPainter *painter, const QRect &rect, TransferItemData *tData, bool hovered);
+
+    // Positions are relative to the top left corner of the row
+    bool isInsideClearButton(const QPoint &pos, const QRect &rect) const;
+    bool isFileNameElided(int tag) const;
+
+    static const int MAX_CACHED_ROWS;
+
+private:
+    struct Row
+    {
+        QString fileName;
+        int nameWidth;
+        bool elided;
+        QStaticText name;
+        QStaticText size;
+        QPixmap fileIcon;
+        long long finishedSecs;
+        QStaticText finishedTime;
+    };
+
+    Row *getRow(TransferItemData *tData, int nameWidth);
+    QPixmap getPixmap(const QString &resource, const QSize &size);
+
+    QCache<int, Row> rows;
+    QHash<QString, QPixmap> pixmaps;
+    QFont nameFont;
+    QFont sizeFont;
+    QFont timeFont;
+};
+
+#endif // FINISHEDTRANSFERPAINTER_H
@@ -52,6 +52,16 @@ void MegaAlertDelegate::paint(QPainter *painter, const QStyleOptionViewItem &opt
             return;
         }
 
+        // Alerts are rendered once and then painted from the pixmap, the widget is only
+        // needed again when the alert changes
+        qreal ratio = painter->device()->devicePixelRatioF();
+        QPixmap *pixmap = model->alertPixmaps[alert->getId()];
+        if (pixmap && pixmap->size() == option.rect.size() * ratio)
+        {
+            painter->drawPixmap(option.rect.topLeft(), *pixmap);
+            return;
+        }
+
         AlertItem *ti = model->alertItems[alert->getId()];
         if (!ti)
         {
@@ -62,13 +72,22 @@ void MegaAlertDelegate::paint(QPainter *painter, const QStyleOptionViewItem &opt
             ti->setAlertData(alert); //Just set when created and when updated at QAlertsModel
         }
 
-        painter->save();
-        painter->translate(option.rect.topLeft());
-
         ti->resize(option.rect.width(), option.rect.height());
+        if (!ti->isAlertDataReady())
+        {
+            painter->save();
+            painter->translate(option.rect.topLeft());
+            ti->render(painter, QPoint(0, 0), QRegion(0, 0, option.rect.width(), option.rect.height()));
+            painter->restore();
+            return;
+        }
 
-        ti->render(painter, QPoint(0, 0), QRegion(0, 0, option.rect.width(), option.rect.height()));
-        painter->restore();
+        pixmap = new QPixmap(option.rect.size() * ratio);
+        pixmap->setDevicePixelRatio(ratio);
+        pixmap->fill(Qt::transparent);
+        ti->render(pixmap, QPoint(0, 0), QRegion(0, 0, option.rect.width(), option.rect.height()));
+        painter->drawPixmap(option.rect.topLeft(), *pixmap);
+        model->alertPixmaps.insert(alert->getId(), pixmap, qMax(1, pixmap->width() * pixmap->height() * 4 / 1024));
     }
     else
     {
@@ -10,6 +10,10 @@ MegaItem::MegaItem(MegaNode *node, MegaItem *parentItem, bool showFiles)
     this->children = NULL;
     this->parent = parentItem;
     this->showFiles = showFiles;
+    this->childrenState = CHILDREN_NOT_FETCHED;
+    this->row = 0;
+    this->numVisibleChildren = 0;
+    this->numFetchedChildren = 0;
 }
 
 mega::MegaNode *MegaItem::getNode()
@@ -17,25 +21,91 @@ mega::MegaNode *MegaItem::getNode()
     return node;
 }
 
+bool MegaItem::isPlaceholder()
+{
+    return node == NULL;
+}
+
+void MegaItem::setFetching()
+{
+    childrenState = CHILDREN_FETCHING;
+    MegaItem *placeholder = new MegaItem(NULL, this);
+    placeholder->row = childItems.size();
+    childItems.append(placeholder);
+}
+
 void MegaItem::setChildren(MegaNodeList *children)
 {
+    if (childrenState == CHILDREN_FETCHING)
+    {
+        qDeleteAll(childItems);
+        childItems.clear();
+    }
+
+    delete this->children;
     this->children = children;
-    for (int i = 0; i < children->size(); i++)
+    childrenState = CHILDREN_FETCHED;
+    numFetchedChildren = 0;
+    numVisibleChildren = children->size();
+    if (!showFiles)
     {
-        MegaNode *node = children->get(i);
-        if (!showFiles && node->getType() == MegaNode::TYPE_FILE)
+        // Folders come first
+        for (int i = 0; i < children->size(); i++)
         {
-            break;
+            if (children->get(i)->getType() == MegaNode::TYPE_FILE)
+            {
+                numVisibleChildren = i;
+                break;
+            }
         }
-        childItems.append(new MegaItem(children->get(i), this, showFiles));
     }
 }
 
+int MegaItem::fetchChildren(int count)
+{
+    int end = qMin(numVisibleChildren, numFetchedChildren + count);
+    int fetched = end - numFetchedChildren;
+    childItems.reserve(childItems.size() + fetched);
+    childrenByHandle.reserve(childrenByHandle.size() + fetched);
+    for (; numFetchedChildren < end; numFetchedChildren++)
+    {
+        MegaItem *item = new MegaItem(children->get(numFetchedChildren), this, showFiles);
+        item->row = childItems.size();
+        childItems.append(item);
+        childrenByHandle.insert(item->node->getHandle(), item);
+    }
+    return fetched;
+}
+
+int MegaItem::getPendingChildren()
+{
+    return numVisibleChildren - numFetchedChildren;
+}
+
+void MegaItem::releaseChildren()
+{
+    qDeleteAll(childItems);
+    childItems.clear();
+    childrenByHandle.clear();
+    qDeleteAll(insertedNodes);
+    insertedNodes.clear();
+    delete children;
+    children = NULL;
+    childrenState = CHILDREN_NOT_FETCHED;
+    numVisibleChildren = 0;
+    numFetchedChildren = 0;
+}
+
 bool MegaItem::areChildrenSet()
 {
     return children != NULL;
 }
 
+int MegaItem::getChildrenState()
+{
+    return childrenState;
+}
+
 MegaItem *MegaItem::getParent()
 {
     return parent;
@@ -46,6 +116,11 @@ MegaItem *MegaItem::getChild(int i)
     return childItems.at(i);
 }
 
+MegaItem *MegaItem::getChildByHandle(MegaHandle handle)
+{
+    return childrenByHandle.value(handle, NULL);
+}
+
 int MegaItem::getNumChildren()
 {
     return childItems.size();
@@ -53,36 +128,53 @@ int MegaItem::getNumChildren()
 
 int MegaItem::indexOf(MegaItem *item)
 {
-    return childItems.indexOf(item);
+    return (item && item->parent == this) ? item->row : -1;
+}
+
+int MegaItem::getRow()
+{
+    return row;
+}
+
+void MegaItem::setRow(int row)
+{
+    this->row = row;
 }
 
 int MegaItem::insertPosition(MegaNode *node)
 {
+    // Children are sorted by type (folders first) and then by name
     int type = node->getType();
+    QByteArray key = QByteArray(node->getName()).toLower();
 
-    int i;
-    for (i = 0; i < childItems.size(); i++)
+    int first = 0;
+    int last = childItems.size();
+    while (first < last)
     {
-        MegaNode *n = childItems.at(i)->getNode();
-        int nodeType = n->getType();
-        if (type < nodeType)
+        int middle = first + (last - first) / 2;
+        MegaItem *item = childItems.at(middle);
+        bool before = item->node && (item->node->getType() > type
+                                     || (item->node->getType() == type && item->getSortKey() < key));
+        if (before)
         {
-            continue;
+            first = middle + 1;
         }
-
-        if (qstricmp(node->getName(), n->getName()) <= 0)
+        else
         {
-            break;
+            last = middle;
         }
     }
 
-    return i;
+    return first;
 }
 
 void MegaItem::insertNode(MegaNode *node, int index)
 {
-    childItems.insert(index, new MegaItem(node, this, showFiles));
-    insertedNodes.append(node);
+    MegaItem *item = new MegaItem(node, this, showFiles);
+    childItems.insert(index, item);
+    childrenByHandle.insert(node->getHandle(), item);
+    insertedNodes.insert(node->getHandle(), node);
+    updateRows(index);
 }
 
 void MegaItem::removeNode(MegaNode *node)
@@ -92,25 +184,17 @@ void MegaItem::removeNode(MegaNode *node)
         return;
     }
 
-    for (int i = 0; i < childItems.size(); i++)
+    MegaHandle handle = node->getHandle();
+    MegaItem *item = childrenByHandle.take(handle);
+    if (item)
     {
-        if (childItems[i]->getNode()->getHandle() == node->getHandle())
-        {
-            delete childItems[i];
-            childItems.removeAt(i);
-            break;
-        }
+        int index = item->row;
+        childItems.removeAt(index);
+        delete item;
+        updateRows(index);
     }
 
-    for (int i = 0; i < insertedNodes.size(); i++)
-    {
-        if (insertedNodes[i]->getHandle() == node->getHandle())
-        {
-            delete insertedNodes[i];
-            insertedNodes.removeAt(i);
-            break;
-        }
-    }
+    delete insertedNodes.take(handle);
 }
 
 void MegaItem::displayFiles(bool enable)
@@ -118,6 +202,23 @@ void MegaItem::displayFiles(bool enable)
     this->showFiles = enable;
 }
 
+const QByteArray &MegaItem::getSortKey()
+{
+    if (sortKey.isNull() && node)
+    {
+        sortKey = QByteArray(node->getName()).toLower();
+    }
+    return sortKey;
+}
+
+void MegaItem::updateRows(int from)
+{
+    for (int i = from; i < childItems.size(); i++)
+    {
+        childItems.at(i)->row = i;
+    }
+}
+
 MegaItem::~MegaItem()
 {
     delete children;
@@ -2,21 +2,43 @@
 #define MEGAITEM_H
 
 #include <QList>
+#include <QHash>
+#include <QByteArray>
 #include <megaapi.h>
 
 class MegaItem
 {
 public:
+    enum ChildrenState
+    {
+        CHILDREN_NOT_FETCHED = 0,
+        CHILDREN_FETCHING,
+        CHILDREN_FETCHED
+    };
+
     MegaItem(mega::MegaNode *node, MegaItem *parentItem = 0, bool showFiles = false);
 
     mega::MegaNode *getNode();
+    bool isPlaceholder();
+
+    // Adds a placeholder child that is shown until setChildren is called
+    void setFetching();
+    // Takes ownership of the list. Items for the children are created by fetchChildren
     void setChildren(mega::MegaNodeList *children);
+    int fetchChildren(int count);
+    int getPendingChildren();
+    // Frees the children, that will be fetched again when needed
+    void releaseChildren();
 
     bool areChildrenSet();
+    int getChildrenState();
     MegaItem *getParent();
     MegaItem *getChild(int i);
+    MegaItem *getChildByHandle(mega::MegaHandle handle);
     int getNumChildren();
     int indexOf(MegaItem *item);
+    int getRow();
+    void setRow(int row);
 
     int insertPosition(mega::MegaNode *node);
     void insertNode(mega::MegaNode *node, int index);
@@ -27,11 +49,21 @@ public:
 
 protected:
     bool showFiles;
+    int childrenState;
+    int row;
+    int numVisibleChildren;
+    int numFetchedChildren;
     MegaItem *parent;
     mega::MegaNode *node;
     mega::MegaNodeList *children;
     QList<MegaItem *> childItems;
-    QList<mega::MegaNode *> insertedNodes;
+    QHash<mega::MegaHandle, MegaItem *> childrenByHandle;
+    QHash<mega::MegaHandle, mega::MegaNode *> insertedNodes;
+    // Lowercase name, computed when first needed to sort inserted nodes
+    QByteArray sortKey;
+
+    const QByteArray &getSortKey();
+    void updateRows(int from);
 };
 
 #endif // MEGAITEM_H
@@ -31,6 +31,16 @@ void MegaTransferDelegate::paint(QPainter *painter, const QStyleOptionViewItem &
 
         int tag = index.internalId();
         int modelType = model->getModelType();
+        if (modelType == QTransfersModel::TYPE_FINISHED)
+        {
+            TransferItemData *tData = model->data(index, Qt::UserRole).value<TransferItemData*>();
+            if (tData)
+            {
+                finishedPainter.paint(painter, option.rect, tData, option.state & QStyle::State_MouseOver);
+            }
+            return;
+        }
+
         TransferItem *ti = model->transferItems[tag];
         if (!ti)
         {
@@ -218,7 +228,15 @@ void MegaTransferDelegate::processCancel(int tag)
 
 bool MegaTransferDelegate::editorEvent(QEvent *event, QAbstractItemModel *, const QStyleOptionViewItem &option, const QModelIndex &index)
 {
-    if (QEvent::MouseButtonPress ==  event->type())
+    if (QEvent::MouseButtonPress ==  event->type() && model->getModelType() == QTransfersModel::TYPE_FINISHED)
+    {
+        if (finishedPainter.isInsideClearButton(((QMouseEvent *)event)->pos() - option.rect.topLeft(), option.rect))
+        {
+            processCancel(index.internalId());
+            return true; // click consumed
+        }
+    }
+    else if (QEvent::MouseButtonPress ==  event->type())
     {
         int tag = index.internalId();
         TransferItem *item = model->transferItems[tag];
@@ -307,7 +325,16 @@ bool MegaTransferDelegate::editorEvent(QEvent *event, QAbstractItemModel *, cons
 
 bool MegaTransferDelegate::helpEvent(QHelpEvent *event, QAbstractItemView *view, const QStyleOptionViewItem &option, const QModelIndex &index)
 {
-    if (event->type() == QEvent::ToolTip)
+    if (event->type() == QEvent::ToolTip && model->getModelType() == QTransfersModel::TYPE_FINISHED)
+    {
+        TransferItemData *tData = model->data(index, Qt::UserRole).value<TransferItemData*>();
+        if (tData && finishedPainter.isFileNameElided(tData->data.tag))
+        {
+            QToolTip::showText(event->globalPos(), tData->data.filename);
+            return true;
+        }
+    }
+    else if (event->type() == QEvent::ToolTip)
     {
         int tag = index.internalId();
         TransferItem *item = model->transferItems[tag];
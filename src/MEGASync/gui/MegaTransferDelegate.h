@@ -5,6 +5,7 @@
 #include "TransferItem.h"
 #include "TransferManagerItem.h"
 #include "CustomTransferItem.h"
+#include "FinishedTransferPainter.h"
 #include "QTransfersModel.h"
 
 class MegaTransferDelegate : public QStyledItemDelegate
@@ -20,6 +21,8 @@ public:
 
 protected:
     QTransfersModel *model;
+    // Finished transfers are painted without widgets
+    mutable FinishedTransferPainter finishedPainter;
     void processCancel(int tag);
     void processShowInFolder(int tag);
 };
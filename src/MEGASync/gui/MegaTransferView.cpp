@@ -69,6 +69,9 @@ void MegaTransferView::setup(int type)
     createContextMenu();
     createCompletedContextMenu();
     this->type = type;
+
+    // Finished rows show their clear button while hovered
+    viewport()->setAttribute(Qt::WA_Hover, type == QTransfersModel::TYPE_FINISHED);
 }
 
 void MegaTransferView::disableGetLink(bool disable)
@@ -478,15 +481,16 @@ void MegaTransferView::onCustomContextMenu(const QPoint &point)
                             failed = true;
                         }
 
-                        TransferItem *item = model->transferItems[transferTagSelected[i]];
+                        // Finished rows are painted without a TransferItem, so the model data is used
+                        TransferItemData *tData = model->data(indexes[i], Qt::UserRole).value<TransferItemData*>();
 
-                        if (!item || !item->getIsLinkAvailable())
+                        if (!tData || !tData->data.publicNode)
                         {
                             linkAvailable = false;
                         }
 
                         const bool transferIsDownloadType{transfer->getType() == MegaTransfer::TYPE_DOWNLOAD};
-                        const bool unkownAccess{!item || item->getNodeAccess() == MegaShare::ACCESS_UNKNOWN};
+                        const bool unkownAccess{!tData || tData->data.nodeAccess == MegaShare::ACCESS_UNKNOWN};
                         if (unkownAccess || transferIsDownloadType)
                         {
                             showInMega = false;
@@ -103,6 +103,7 @@ void NodeSelector::nodesReady()
 
     ui->tMegaFolders->setModel(model);
     connect(ui->tMegaFolders->selectionModel(), SIGNAL(selectionChanged(QItemSelection,QItemSelection)),this, SLOT(onSelectionChanged(QItemSelection,QItemSelection)));
+    connect(ui->tMegaFolders, SIGNAL(collapsed(QModelIndex)), this, SLOT(onItemCollapsed(QModelIndex)), Qt::UniqueConnection);
 
     ui->tMegaFolders->collapseAll();
     ui->tMegaFolders->header()->close();
@@ -189,6 +190,7 @@ void NodeSelector::setSelectedFolderHandle(MegaHandle selectedHandle)
     while (index >= 0)
     {
         node = list.at(index);
+        model->loadChildren(modelIndex);
         for (int j = 0; j < model->rowCount(modelIndex); j++)
         {
             QModelIndex tmp = model->index(j, 0, modelIndex);
@@ -388,6 +390,21 @@ void NodeSelector::onSelectionChanged(QItemSelection, QItemSelection)
     }
 }
 
+void NodeSelector::onItemCollapsed(const QModelIndex &index)
+{
+    // The released children can't stay selected, so the selection moves up to the collapsed folder
+    for (QModelIndex ancestor = selectedItem.parent(); ancestor.isValid(); ancestor = ancestor.parent())
+    {
+        if (ancestor == index)
+        {
+            ui->tMegaFolders->selectionModel()->select(index, QItemSelectionModel::ClearAndSelect);
+            ui->tMegaFolders->selectionModel()->setCurrentIndex(index, QItemSelectionModel::ClearAndSelect);
+            break;
+        }
+    }
+    model->releaseChildren(index);
+}
+
 void NodeSelector::on_bNewFolder_clicked()
 {
     newFolderUi->errorLabel->hide();
@@ -427,6 +444,7 @@ void NodeSelector::on_bNewFolder_clicked()
     }
     else
     {
+        model->loadChildren(selectedItem);
         for (int i = 0; i < model->rowCount(selectedItem); i++)
         {
             QModelIndex row = model->index(i, 0, selectedItem);
@@ -47,6 +47,7 @@ protected:
 
 private slots:
     void onSelectionChanged(QItemSelection,QItemSelection);
+    void onItemCollapsed(const QModelIndex &index);
     void on_bNewFolder_clicked();
     void on_bOk_clicked();
 
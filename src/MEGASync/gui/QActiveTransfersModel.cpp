@@ -4,6 +4,7 @@
 #include "control/AppStatsEvents.h"
 
 #include <assert.h>
+#include <algorithm>
 
 
 using namespace mega;
@@ -20,10 +21,16 @@ bool priority_comparator(TransferItemData* i, TransferItemData *j)
 }
 
 QActiveTransfersModel::QActiveTransfersModel(int type, std::shared_ptr<MegaTransferData> transferData, QObject *parent) :
-    QTransfersModel(type, parent)
+    QTransfersModel(type, parent),
+    updatesReceived(0),
+    updatesApplied(0)
 {
     QPointer<QActiveTransfersModel> model = this;
 
+    updateTimer.setSingleShot(true);
+    updateTimer.setInterval(DEFAULT_UPDATE_INTERVAL_MS);
+    connect(&updateTimer, SIGNAL(timeout()), this, SLOT(flushPendingUpdates()));
+
     if (!transferData)
     {
         return;
@@ -108,6 +115,12 @@ QActiveTransfersModel::QActiveTransfersModel(int type, std::shared_ptr<MegaTrans
     }
 }
 
+QActiveTransfersModel::~QActiveTransfersModel()
+{
+    MegaApi::log(MegaApi::LOG_LEVEL_DEBUG, QString::fromUtf8("Transfer updates received: %1 applied: %2")
+                 .arg(updatesReceived).arg(updatesApplied).toUtf8().constData());
+}
+
 void QActiveTransfersModel::removeTransferByTag(int transferTag)
 {
     TransferItemData *item =  transfers.value(transferTag);
@@ -124,6 +137,8 @@ void QActiveTransfersModel::removeTransferByTag(int transferTag)
         return;
     }
 
+    pendingUpdates.remove(transferTag);
+
     beginRemoveRows(QModelIndex(), row, row);
     transfers.remove(transferTag);
     transferOrder.erase(it);
@@ -280,23 +295,68 @@ void QActiveTransfersModel::onTransferTemporaryError(MegaApi *, MegaTransfer *tr
     }
 }
 
+void QActiveTransfersModel::setUpdateInterval(int msecs)
+{
+    updateTimer.setInterval(std::max(0, msecs));
+}
+
+long long QActiveTransfersModel::getUpdatesReceived() const
+{
+    return updatesReceived;
+}
+
+long long QActiveTransfersModel::getUpdatesApplied() const
+{
+    return updatesApplied;
+}
+
 void QActiveTransfersModel::updateTransferInfo(MegaTransfer *transfer)
 {
-    TransferItemData *itemData = transfers.value(transfer->getTag());
-    if (!itemData)
+    int tag = transfer->getTag();
+    if (!transfers.contains(tag))
     {
         return;
     }
 
-    unsigned long long newPriority = transfer->getPriority();
-    TransferItem *item = transferItems[transfer->getTag()];
+    updatesReceived++;
+
+    // Only the latest state of each transfer is kept until the next flush
+    PendingTransferUpdate &update = pendingUpdates[tag];
+    update.type = transfer->getType();
+    update.isSyncTransfer = transfer->isSyncTransfer();
+    update.fileName = QString::fromUtf8(transfer->getFileName());
+    update.totalBytes = transfer->getTotalBytes();
+    update.speed = transfer->getSpeed();
+    update.meanSpeed = transfer->getMeanSpeed();
+    update.transferredBytes = transfer->getTransferredBytes();
+    update.state = transfer->getState();
+    update.priority = transfer->getPriority();
+    update.errorCode = transfer->getLastError().getErrorCode();
+    update.errorValue = 0;
+    if (update.errorCode != MegaError::API_OK)
+    {
+        assert(transfer->getLastErrorExtended());
+        update.errorValue = transfer->getLastErrorExtended() ? transfer->getLastErrorExtended()->getValue() : 0;
+    }
+
+    if (!updateTimer.isActive())
+    {
+        updateTimer.start();
+    }
+}
+
+bool QActiveTransfersModel::applyTransferUpdate(const PendingTransferUpdate &update, TransferItemData *itemData)
+{
+    int tag = itemData->data.tag;
+    unsigned long long newPriority = update.priority;
+    TransferItem *item = transferItems[tag];
     if (item)
     {
         if (item->getType() < 0)
         {
-            item->setType(transfer->getType(), transfer->isSyncTransfer());
-            item->setFileName(QString::fromUtf8(transfer->getFileName()));
-            item->setTotalSize(transfer->getTotalBytes());
+            item->setType(update.type, update.isSyncTransfer);
+            item->setFileName(update.fileName);
+            item->setTotalSize(update.totalBytes);
         }
 
         // Get http speed, which reports speed changes faster than the transfer.
@@ -310,71 +370,122 @@ void QActiveTransfersModel::updateTransferInfo(MegaTransfer *transfer)
             httpSpeed = static_cast<MegaApplication*>(qApp)->getMegaApi()->getCurrentUploadSpeed();
         }
 
-        item->setSpeed(std::min(transfer->getSpeed(), httpSpeed), transfer->getMeanSpeed());
-        item->setTransferredBytes(transfer->getTransferredBytes(), !transfer->isSyncTransfer());
-        item->setTransferState(transfer->getState());
+        item->setSpeed(std::min(update.speed, httpSpeed), update.meanSpeed);
+        item->setTransferredBytes(update.transferredBytes, !update.isSyncTransfer);
+        item->setTransferState(update.state);
         item->setPriority(newPriority);
 
-        int tError = transfer->getLastError().getErrorCode();
-        if (tError != MegaError::API_OK)
+        if (update.errorCode != MegaError::API_OK)
         {
-            assert(transfer->getLastErrorExtended());
-            item->setTransferError(tError, transfer->getLastErrorExtended()->getValue());
+            item->setTransferError(update.errorCode, update.errorValue);
         }
     }
     else
     {
         //Update values in case itemdata is not created yet by delegate
-        itemData->data.speed = transfer->getSpeed();
-        itemData->data.meanSpeed = transfer->getMeanSpeed();
-        itemData->data.transferredBytes = transfer->getTransferredBytes();
+        itemData->data.speed = update.speed;
+        itemData->data.meanSpeed = update.meanSpeed;
+        itemData->data.transferredBytes = update.transferredBytes;
     }
 
     if (newPriority == itemData->data.priority)
     {
-        //Update modified item
-        std::deque<TransferItemData*>::iterator it = std::lower_bound(transferOrder.begin(), transferOrder.end(), itemData, priority_comparator);
-        int row = std::distance(transferOrder.begin(), it);
-        assert(it != transferOrder.end() && (*it)->data.tag == itemData->data.tag);
-        if (row >= transferOrder.size())
+        //Modified item, its row is refreshed by the caller
+        return true;
+    }
+
+    //Move item to its new position
+    std::deque<TransferItemData*>::iterator it = std::lower_bound(transferOrder.begin(), transferOrder.end(), itemData, priority_comparator);
+    int row = std::distance(transferOrder.begin(), it);
+    assert(it != transferOrder.end() && (*it)->data.tag == tag);
+    if (it == transferOrder.end() || (*it)->data.tag != tag)
+    {
+        return false;
+    }
+
+    TransferItemData testItem;
+    testItem.data.tag = tag;
+    testItem.data.priority = newPriority;
+    std::deque<TransferItemData*>::iterator newit = std::lower_bound(transferOrder.begin(), transferOrder.end(), &testItem, priority_comparator);
+    int newrow = std::distance(transferOrder.begin(), newit);
+
+    if (row == newrow || (row + 1) == newrow)
+    {
+        //Priorities are being adjusted, but there isn't an actual move operation
+        itemData->data.priority = newPriority;
+        return true;
+    }
+
+    beginMoveRows(QModelIndex(), row, row, QModelIndex(), newrow);
+    transferOrder.erase(it);
+    itemData->data.priority = newPriority;
+    std::deque<TransferItemData*>::iterator finalit = std::lower_bound(transferOrder.begin(), transferOrder.end(), itemData, priority_comparator);
+    transferOrder.insert(finalit, itemData);
+    endMoveRows();
+    return false;
+}
+
+void QActiveTransfersModel::flushPendingUpdates()
+{
+    if (pendingUpdates.isEmpty())
+    {
+        return;
+    }
+
+    QMap<int, PendingTransferUpdate> updates;
+    updates.swap(pendingUpdates);
+
+    // Apply every update first (moves included), so that rows are stable
+    // when the changed ranges are computed
+    QVector<TransferItemData*> changedItems;
+    changedItems.reserve(updates.size());
+    for (QMap<int, PendingTransferUpdate>::const_iterator it = updates.cbegin(); it != updates.cend(); ++it)
+    {
+        TransferItemData *itemData = transfers.value(it.key());
+        if (!itemData)
         {
-            return;
+            continue;
+        }
+
+        updatesApplied++;
+        if (applyTransferUpdate(it.value(), itemData))
+        {
+            changedItems.append(itemData);
         }
-        emit dataChanged(index(row, 0, QModelIndex()), index(row, 0, QModelIndex()));
     }
-    else
+
+    std::vector<int> rows;
+    rows.reserve(changedItems.size());
+    for (int i = 0; i < changedItems.size(); i++)
     {
-        //Move item to its new position
-        std::deque<TransferItemData*>::iterator it = std::lower_bound(transferOrder.begin(), transferOrder.end(), itemData, priority_comparator);
-        int row = std::distance(transferOrder.begin(), it);
+        TransferItemData *itemData = changedItems.at(i);
+        transfer_it it = std::lower_bound(transferOrder.begin(), transferOrder.end(), itemData, priority_comparator);
         assert(it != transferOrder.end() && (*it)->data.tag == itemData->data.tag);
-        if (it == transferOrder.end() || (*it)->data.tag != itemData->data.tag)
+        if (it != transferOrder.end() && (*it)->data.tag == itemData->data.tag)
         {
-            return;
+            rows.push_back(int(std::distance(transferOrder.begin(), it)));
         }
+    }
 
-        TransferItemData testItem;
-        testItem.data.tag = itemData->data.tag;
-        testItem.data.priority = newPriority;
-        std::deque<TransferItemData*>::iterator newit = std::lower_bound(transferOrder.begin(), transferOrder.end(), &testItem, priority_comparator);
-        int newrow = std::distance(transferOrder.begin(), newit);
+    if (rows.empty())
+    {
+        return;
+    }
 
-        if (row == newrow || (row + 1) == newrow)
-        {
-            //Priorities are being adjusted, but there isn't an actual move operation
-            itemData->data.priority = newPriority;
-            emit dataChanged(index(row, 0, QModelIndex()), index(row, 0, QModelIndex()));
-        }
-        else
+    //Emit one dataChanged per contiguous range of modified rows
+    std::sort(rows.begin(), rows.end());
+    int first = rows.front();
+    int last = first;
+    for (std::size_t i = 1; i < rows.size(); i++)
+    {
+        if (rows[i] > last + 1)
         {
-            beginMoveRows(QModelIndex(), row, row, QModelIndex(), newrow);
-            transferOrder.erase(it);
-            itemData->data.priority = newPriority;
-            std::deque<TransferItemData*>::iterator finalit = std::lower_bound(transferOrder.begin(), transferOrder.end(), itemData, priority_comparator);
-            transferOrder.insert(finalit, itemData);
-            endMoveRows();
+            emit dataChanged(index(first, 0, QModelIndex()), index(last, 0, QModelIndex()));
+            first = rows[i];
         }
+        last = rows[i];
     }
+    emit dataChanged(index(first, 0, QModelIndex()), index(last, 0, QModelIndex()));
 }
 
 void QActiveTransfersModel::refreshTransferItem(int tag)
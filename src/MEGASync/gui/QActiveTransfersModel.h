@@ -3,6 +3,7 @@
 
 #include <QAbstractItemModel>
 #include <QCache>
+#include <QTimer>
 #include "TransferItem.h"
 #include <megaapi.h>
 #include "QTMegaTransferListener.h"
@@ -18,6 +19,7 @@ class QActiveTransfersModel : public QTransfersModel
 
 public:
     explicit QActiveTransfersModel(int type, std::shared_ptr<mega::MegaTransferData> transferData, QObject *parent = 0);
+    virtual ~QActiveTransfersModel();
     void removeTransferByTag(int transferTag);
     void removeAllTransfers();
 
@@ -35,11 +37,43 @@ public:
     virtual void onTransferUpdate(mega::MegaApi *api, mega::MegaTransfer *transfer);
     virtual void onTransferTemporaryError(mega::MegaApi *api, mega::MegaTransfer *transfer, mega::MegaError* e);
 
+    // Update coalescing
+    void setUpdateInterval(int msecs);
+    long long getUpdatesReceived() const;
+    long long getUpdatesApplied() const;
+
 protected:
+    // Latest known state of a transfer, waiting for the next flush
+    struct PendingTransferUpdate
+    {
+        int type;
+        bool isSyncTransfer;
+        QString fileName;
+        long long totalBytes;
+        long long speed;
+        long long meanSpeed;
+        long long transferredBytes;
+        int state;
+        unsigned long long priority;
+        int errorCode;
+        long long errorValue;
+    };
+
     void updateTransferInfo(mega::MegaTransfer *transfer);
+    bool applyTransferUpdate(const PendingTransferUpdate &update, TransferItemData *itemData);
 
 private slots:
     void refreshTransferItem(int tag);
+    void flushPendingUpdates();
+
+private:
+    // One flush per display frame by default
+    static const int DEFAULT_UPDATE_INTERVAL_MS = 16;
+
+    QTimer updateTimer;
+    QMap<int, PendingTransferUpdate> pendingUpdates;
+    long long updatesReceived;
+    long long updatesApplied;
 };
 
 #endif // QACTIVETRANSFERSMODEL_H
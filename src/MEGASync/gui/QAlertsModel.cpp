@@ -6,6 +6,8 @@
 
 using namespace mega;
 
+const int QAlertsModel::MAX_RENDERED_ALERTS_KB = 16 * 1024;
+
 QAlertsModel::QAlertsModel(MegaUserAlertList *alerts, bool copy, QObject *parent)
     : QAbstractItemModel(parent)
 {
@@ -17,6 +19,7 @@ QAlertsModel::QAlertsModel(MegaUserAlertList *alerts, bool copy, QObject *parent
     }
 
     alertItems.setMaxCost(16);
+    alertPixmaps.setMaxCost(MAX_RENDERED_ALERTS_KB);
     insertAlerts(alerts, copy);
 }
 
@@ -101,6 +104,7 @@ void QAlertsModel::insertAlerts(MegaUserAlertList *alerts, bool copy)
                         }
                     }
 
+                    alertPixmaps.remove(alert->getId());
                     AlertItem *udpatedAlertItem = alertItems[alert->getId()];
                     if (udpatedAlertItem)
                     {
@@ -208,6 +212,7 @@ QVariant QAlertsModel::data(const QModelIndex &index, int role) const
 
 void QAlertsModel::refreshAlerts()
 {
+    alertPixmaps.clear();
     if (alertOrder.size())
     {
         emit dataChanged(index(0, 0, QModelIndex()), index(int(alertOrder.size()) - 1, 0, QModelIndex()));
@@ -268,6 +273,7 @@ int QAlertsModel::checkAlertType(int alertType) const
 
 void QAlertsModel::refreshAlertItem(unsigned id)
 {
+    alertPixmaps.remove(id);
     int row = 0;
     for (auto it = alertOrder.begin(); it != alertOrder.end() && *it != id; ++it)
     {
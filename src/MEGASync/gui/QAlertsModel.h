@@ -2,6 +2,7 @@
 #define QALERTSMODEL_H
 
 #include <QCache>
+#include <QPixmap>
 #include <megaapi.h>
 #include <deque>
 #include "AlertItem.h"
@@ -35,6 +36,9 @@ public:
     QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
 
     QCache<int, AlertItem> alertItems;
+    // Rendered alerts, so that painting doesn't need the widgets. The cost is in KB
+    QCache<int, QPixmap> alertPixmaps;
+    static const int MAX_RENDERED_ALERTS_KB;
 
     void refreshAlerts();
     void insertAlerts(mega::MegaUserAlertList *alerts, bool copy = false);
@@ -25,7 +25,7 @@ MegaTransfer *QCustomTransfersModel::getTransferByTag(int tag)
     MegaTransfer *transfer = ((MegaApplication *)qApp)->getFinishedTransferByTag(tag);
     if (transfer)
     {
-        return transfer->copy();
+        return transfer;
     }
 
     return megaApi->getTransferByTag(tag);
@@ -66,82 +66,13 @@ void QCustomTransfersModel::onTransferStart(MegaApi *api, MegaTransfer *transfer
     }
 }
 
-void QCustomTransfersModel::onTransferFinish(MegaApi *api, MegaTransfer *t, MegaError *e)
+void QCustomTransfersModel::onTransferFinish(MegaApi *api, MegaTransfer *transfer, MegaError *e)
 {
-    QPointer<QCustomTransfersModel> model = this;
-    MegaTransfer *transfer = t->copy();
-
     removeTransferByTag(transfer->getTag());
 
     if (transfer->getState() == MegaTransfer::STATE_COMPLETED || transfer->getState() == MegaTransfer::STATE_FAILED)
-    {       
-        mThreadPool->push([this, model, transfer]()
-        {//thread pool function
-            if (!model)
-            {
-                delete transfer;
-                return;
-            }
-
-            bool isPublicNode = false;
-            int access = MegaShare::ACCESS_UNKNOWN;
-            MegaNode *ownNode = ((MegaApplication*)qApp)->getMegaApi()->getNodeByHandle(transfer->getNodeHandle());
-            if (ownNode)
-            {
-               access = ((MegaApplication*)qApp)->getMegaApi()->getAccess(ownNode);
-               if (access == MegaShare::ACCESS_OWNER)
-               {
-                   isPublicNode = true;
-               }
-               delete ownNode;
-            }
-
-            Utilities::queueFunctionInAppThread([this, model, isPublicNode, access, transfer]()
-            {//queued function
-
-                if (model)
-                {
-                    TransferItemData *item = new TransferItemData(transfer);
-                    item->data.publicNode = isPublicNode;
-                    item->data.nodeAccess = access;
-
-                    if ((int)transfers.size() == (int)Preferences::MAX_COMPLETED_ITEMS)
-                    {
-                        TransferItemData *itemData = transferOrder.back();
-                        int row = int(transferOrder.size()) - 1;
-                        beginRemoveRows(QModelIndex(), row, row);
-                        transfers.remove(itemData->data.tag);
-                        transferOrder.pop_back();
-                        transferItems.remove(itemData->data.tag);
-                        endRemoveRows();
-                        delete itemData;
-                    }
-
-                    transfer_it it = getInsertPosition(transfer);
-                    int row = it - transferOrder.begin();
-                    beginInsertRows(QModelIndex(), row, row);
-                    transfers.insert(item->data.tag, item);
-                    transferOrder.insert(it, item);
-                    endInsertRows();
-
-                    if (transfers.isEmpty())
-                    {
-                        emit noTransfers();
-                    }
-                    else
-                    {
-                        if (transferOrder.size() == 1)
-                        {
-                            emit onTransferAdded();
-                        }
-                    }
-                }
-
-                delete transfer;
-
-            });//end of queued function
-
-        });// end of thread pool function;
+    {
+        addFinishedTransfer(transfer);
     }
 }
 
@@ -382,15 +313,7 @@ transfer_it QCustomTransfersModel::getInsertPosition(MegaTransfer *transfer)
     transfer_it it = transferOrder.begin();
     if (transfer->isFinished())
     {
-        if (modelState & DOWNLOAD)
-        {
-            std::advance(it, 1);
-        }
-
-        if (modelState & UPLOAD)
-        {
-            std::advance(it, 1);
-        }
+        std::advance(it, getFinishedTransfersRow());
     }
     else
     {
@@ -401,3 +324,19 @@ transfer_it QCustomTransfersModel::getInsertPosition(MegaTransfer *transfer)
     }
     return it;
 }
+
+int QCustomTransfersModel::getFinishedTransfersRow() const
+{
+    // Finished transfers go below the active download and upload
+    int row = 0;
+    if (modelState & DOWNLOAD)
+    {
+        row++;
+    }
+
+    if (modelState & UPLOAD)
+    {
+        row++;
+    }
+    return row;
+}
@@ -35,6 +35,7 @@ private slots:
     void removeAllCompletedTransfers();
 
 protected:
+    int getFinishedTransfersRow() const override;
     void updateTransferInfo(mega::MegaTransfer *transfer);
     void replaceWithTransfer(mega::MegaTransfer *transfer);
 
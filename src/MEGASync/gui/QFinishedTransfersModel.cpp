@@ -7,82 +7,11 @@ using namespace mega;
 QFinishedTransfersModel::QFinishedTransfersModel(QList<MegaTransfer *> finishedTransfers, int type, QObject *parent) :
     QTransfersModel(type, parent)
 {
-    int numTransfers = finishedTransfers.size();
-    if (numTransfers)
+    for (MegaTransfer *transfer : finishedTransfers)
     {
-        for (int i = 0; i < numTransfers; i++)
-        {
-            MegaTransfer *transfer = finishedTransfers.at(i);
-            insertTransfer(transfer);
-        }
+        addFinishedTransfer(transfer);
     }
-}
-
-void QFinishedTransfersModel::insertTransfer(MegaTransfer *t)
-{
-    QPointer<QFinishedTransfersModel> model = this;
-    MegaTransfer *transfer = t->copy(); //Copy transfer to avoid deletions by finishedtransfers if QMap reaches limit.
-
-    mThreadPool->push([this, model, transfer]()
-    {//thread pool function
-        if (!model)
-        {
-
-            delete transfer;
-            return;
-        }
-
-        bool isPublicNode = false;
-        int access = MegaShare::ACCESS_UNKNOWN;
-        MegaNode *ownNode = ((MegaApplication*)qApp)->getMegaApi()->getNodeByHandle(transfer->getNodeHandle());
-        if (ownNode)
-        {
-           access = ((MegaApplication*)qApp)->getMegaApi()->getAccess(ownNode);
-           if (access == MegaShare::ACCESS_OWNER)
-           {
-               isPublicNode = true;
-           }
-           delete ownNode;
-        }
-
-        Utilities::queueFunctionInAppThread([this, model, isPublicNode, access, transfer]()
-        {//queued function
-            if (model)
-            {
-                TransferItemData *item = new TransferItemData(transfer);
-                item->data.publicNode = isPublicNode;
-                item->data.nodeAccess = access;
-
-                if ((int)transfers.size() == (int)Preferences::MAX_COMPLETED_ITEMS)
-                {
-                    TransferItemData *t = transferOrder.back();
-                    int row = int(transferOrder.size()) - 1;
-                    beginRemoveRows(QModelIndex(), row, row);
-                    transfers.remove(t->data.tag);
-                    transferOrder.pop_back();
-                    transferItems.remove(t->data.tag);
-                    endRemoveRows();
-                    delete t;
-                }
-
-                transfer_it it = transferOrder.begin();
-                int row = 0;
-
-                beginInsertRows(QModelIndex(), row, row);
-                transfers.insert(item->data.tag, item);
-                transferOrder.insert(it, item);
-                endInsertRows();
-
-                if (transferOrder.size() == 1)
-                {
-                    emit onTransferAdded();
-                }                
-            }
-
-            delete transfer;
-        });//end of queued function
-
-    });// end of thread pool function;
+    flushFinishedTransfers();
 }
 
 void QFinishedTransfersModel::removeTransferByTag(int transferTag)
@@ -134,19 +63,14 @@ void QFinishedTransfersModel::removeAllTransfers()
 
 MegaTransfer *QFinishedTransfersModel::getTransferByTag(int tag)
 {
-    MegaTransfer *transfer = ((MegaApplication *)qApp)->getFinishedTransferByTag(tag);
-    if (transfer)
-    {
-        return transfer->copy();
-    }
-    return NULL;
+    return ((MegaApplication *)qApp)->getFinishedTransferByTag(tag);
 }
 
 void QFinishedTransfersModel::onTransferFinish(MegaApi *, MegaTransfer *transfer, MegaError *)
 {
     if (transfer->getState() == MegaTransfer::STATE_COMPLETED || transfer->getState() == MegaTransfer::STATE_FAILED)
     {
-        insertTransfer(transfer);
+        addFinishedTransfer(transfer);
     }
 }
 
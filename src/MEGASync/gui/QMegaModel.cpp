@@ -3,10 +3,13 @@
 
 #include <QBrush>
 #include <QApplication>
+#include <QPointer>
 #include "control/Utilities.h"
 
 using namespace mega;
 
+const int QMegaModel::FETCH_PAGE_SIZE = 500;
+
 QMegaModel::QMegaModel(mega::MegaApi *megaApi, QObject *parent) :
     QAbstractItemModel(parent)
 {
@@ -24,7 +27,9 @@ QMegaModel::QMegaModel(mega::MegaApi *megaApi, QObject *parent) :
         {
             MegaNode *folder = folders->get(j)->copy();
             ownNodes.append(folder);
-            inshareItems.append(new MegaItem(folder));
+            MegaItem *item = new MegaItem(folder);
+            item->setRow(1 + inshareItems.size());
+            inshareItems.append(item);
             inshareOwners.append(QString::fromUtf8(contact->getEmail()));
         }
         delete folders;
@@ -34,6 +39,7 @@ QMegaModel::QMegaModel(mega::MegaApi *megaApi, QObject *parent) :
     this->requiredRights = MegaShare::ACCESS_READ;
     this->displayFiles = false;
     this->disableFolders = false;
+    this->lastFetchId = 0;
 }
 
 int QMegaModel::columnCount(const QModelIndex &) const
@@ -51,6 +57,10 @@ QVariant QMegaModel::data(const QModelIndex &index, int role) const
     MegaItem *item = (MegaItem *)index.internalPointer();
     if (!item->getNode())
     {
+        if (item->isPlaceholder() && role == Qt::DisplayRole)
+        {
+            return QVariant(tr("Loading..."));
+        }
         return QVariant();
     }
 
@@ -122,12 +132,6 @@ QModelIndex QMegaModel::index(int row, int column, const QModelIndex &parent) co
     {
         MegaItem * item = NULL;
         item = (MegaItem *)parent.internalPointer();
-
-        if (!item->areChildrenSet())
-        {
-            item->setChildren(megaApi->getChildren(item->getNode()));
-        }
-
         return createIndex(row, column, item->getChild(row));
     }
 
@@ -153,34 +157,203 @@ QModelIndex QMegaModel::parent(const QModelIndex &index) const
         return QModelIndex();
     }
 
-    MegaItem *grandparent = parent->getParent();
-    if (!grandparent)
+    // Top level items have their position in the model as row
+    return createIndex(parent->getRow(), 0, parent);
+}
+
+int QMegaModel::rowCount(const QModelIndex &parent) const
+{
+    if (parent.isValid())
     {
-        if (parent == rootItem)
-        {
-            return createIndex(0, 0, parent);
-        }
+        MegaItem *item = (MegaItem *)parent.internalPointer();
+        return item->getNumChildren();
+    }
 
-        return createIndex(1 + inshareItems.indexOf(parent), 0, parent);
+    return inshareItems.size() + 1;
+}
+
+bool QMegaModel::hasChildren(const QModelIndex &parent) const
+{
+    if (!parent.isValid())
+    {
+        return true;
     }
 
-    return createIndex(grandparent->indexOf(parent), 0, parent);
+    MegaItem *item = (MegaItem *)parent.internalPointer();
+    if (item->getChildrenState() == MegaItem::CHILDREN_NOT_FETCHED)
+    {
+        // Children are only fetched on expansion, so any folder can be expanded
+        return item->getNode() && item->getNode()->getType() != MegaNode::TYPE_FILE;
+    }
+    return item->getNumChildren() > 0;
 }
 
-int QMegaModel::rowCount(const QModelIndex &parent) const
+bool QMegaModel::canFetchMore(const QModelIndex &parent) const
 {
-    if (parent.isValid())
+    if (!parent.isValid())
     {
-        MegaItem *item = (MegaItem *)parent.internalPointer();
-        if (!item->areChildrenSet())
+        return false;
+    }
+
+    MegaItem *item = (MegaItem *)parent.internalPointer();
+    switch (item->getChildrenState())
+    {
+        case MegaItem::CHILDREN_NOT_FETCHED:
+            return item->getNode() && item->getNode()->getType() != MegaNode::TYPE_FILE;
+        case MegaItem::CHILDREN_FETCHED:
+            return item->getPendingChildren() > 0;
+        default:
+            return false;
+    }
+}
+
+void QMegaModel::fetchMore(const QModelIndex &parent)
+{
+    if (!canFetchMore(parent))
+    {
+        return;
+    }
+
+    MegaItem *item = (MegaItem *)parent.internalPointer();
+    if (item->getChildrenState() == MegaItem::CHILDREN_FETCHED)
+    {
+        fetchNextPage(parent, item);
+        return;
+    }
+
+    beginInsertRows(parent, 0, 0);
+    item->setFetching();
+    endInsertRows();
+
+    // Getting the children of a big folder takes a while, so it's done by a worker
+    unsigned long long fetchId = ++lastFetchId;
+    pendingFetches.insert(fetchId, item);
+    std::shared_ptr<MegaNode> node(item->getNode()->copy());
+    QPointer<QMegaModel> model = this;
+    mega::MegaApi *api = megaApi;
+    ThreadPoolSingleton::getInstance()->submit([model, api, node, fetchId]()
+    {//thread pool function
+
+        MegaNodeList *children = api->getChildren(node.get());
+        Utilities::queueFunctionInAppThread([model, children, fetchId]()
+        {//queued function
+
+            if (!model)
+            {
+                delete children;
+                return;
+            }
+            model->onChildrenFetched(fetchId, children);
+
+        });//end of queued function
+
+    }, ThreadPool::Priority::INTERACTIVE, this);// end of thread pool function
+}
+
+void QMegaModel::loadChildren(const QModelIndex &parent)
+{
+    if (!parent.isValid())
+    {
+        return;
+    }
+
+    MegaItem *item = (MegaItem *)parent.internalPointer();
+    if (item->getChildrenState() == MegaItem::CHILDREN_FETCHING)
+    {
+        cancelFetches(item);
+        beginRemoveRows(parent, 0, 0);
+        item->setChildren(megaApi->getChildren(item->getNode()));
+        endRemoveRows();
+    }
+    else if (item->getChildrenState() == MegaItem::CHILDREN_NOT_FETCHED)
+    {
+        item->setChildren(megaApi->getChildren(item->getNode()));
+    }
+
+    int pending = item->getPendingChildren();
+    if (pending)
+    {
+        int first = item->getNumChildren();
+        beginInsertRows(parent, first, first + pending - 1);
+        item->fetchChildren(pending);
+        endInsertRows();
+    }
+}
+
+void QMegaModel::releaseChildren(const QModelIndex &parent)
+{
+    if (!parent.isValid())
+    {
+        return;
+    }
+
+    MegaItem *item = (MegaItem *)parent.internalPointer();
+    if (item->getChildrenState() == MegaItem::CHILDREN_NOT_FETCHED)
+    {
+        return;
+    }
+
+    cancelFetches(item);
+    int numChildren = item->getNumChildren();
+    if (numChildren)
+    {
+        beginRemoveRows(parent, 0, numChildren - 1);
+        item->releaseChildren();
+        endRemoveRows();
+    }
+    else
+    {
+        item->releaseChildren();
+    }
+}
+
+void QMegaModel::onChildrenFetched(unsigned long long fetchId, MegaNodeList *children)
+{
+    MegaItem *item = pendingFetches.take(fetchId);
+    if (!item)
+    {
+        // The item was released or loaded synchronously meanwhile
+        delete children;
+        return;
+    }
+
+    QModelIndex parent = createIndex(item->getRow(), 0, item);
+    beginRemoveRows(parent, 0, 0);
+    item->setChildren(children);
+    endRemoveRows();
+    fetchNextPage(parent, item);
+}
+
+// Drops the pending fetches of the item and its descendants
+void QMegaModel::cancelFetches(MegaItem *item)
+{
+    QMutableHashIterator<unsigned long long, MegaItem *> it(pendingFetches);
+    while (it.hasNext())
+    {
+        it.next();
+        for (MegaItem *ancestor = it.value(); ancestor; ancestor = ancestor->getParent())
         {
-            item->setChildren(megaApi->getChildren(item->getNode()));
+            if (ancestor == item)
+            {
+                it.remove();
+                break;
+            }
         }
+    }
+}
 
-        return item->getNumChildren();
+void QMegaModel::fetchNextPage(const QModelIndex &parent, MegaItem *item)
+{
+    int count = qMin(FETCH_PAGE_SIZE, item->getPendingChildren());
+    if (!count)
+    {
+        return;
     }
 
-    return inshareItems.size() + 1;
+    int first = item->getNumChildren();
+    beginInsertRows(parent, first, first + count - 1);
+    item->fetchChildren(count);
+    endInsertRows();
 }
 
 void QMegaModel::setRequiredRights(int requiredRights)
@@ -206,6 +379,18 @@ void QMegaModel::showFiles(bool show)
 QModelIndex QMegaModel::insertNode(MegaNode *node, const QModelIndex &parent)
 {
     MegaItem *item = (MegaItem *)parent.internalPointer();
+    if (item->getChildrenState() != MegaItem::CHILDREN_FETCHED || item->getPendingChildren())
+    {
+        // The children got from the SDK can already include the new node
+        loadChildren(parent);
+        MegaItem *child = item->getChildByHandle(node->getHandle());
+        if (child)
+        {
+            delete node;
+            return this->index(child->getRow(), 0, parent);
+        }
+    }
+
     int index = item->insertPosition(node);
 
     beginInsertRows(parent, index, index);
@@ -224,6 +409,7 @@ void QMegaModel::removeNode(QModelIndex &item)
         return;
     }
     int index = parent->indexOf((MegaItem *)item.internalPointer());
+    cancelFetches((MegaItem *)item.internalPointer());
 
     beginRemoveRows(item.parent(), index, index);
     parent->removeNode(node);
@@ -3,6 +3,7 @@
 
 #include <QAbstractItemModel>
 #include <QList>
+#include <QHash>
 #include <QIcon>
 #include "MegaItem.h"
 #include <megaapi.h>
@@ -19,6 +20,14 @@ public:
     virtual QModelIndex index(int row, int column, const QModelIndex & parent = QModelIndex()) const;
     virtual QModelIndex parent(const QModelIndex & index) const;
     virtual int rowCount(const QModelIndex & parent = QModelIndex()) const;
+    virtual bool hasChildren(const QModelIndex & parent = QModelIndex()) const;
+    virtual bool canFetchMore(const QModelIndex & parent) const;
+    virtual void fetchMore(const QModelIndex & parent);
+
+    // Loads all the children of the item synchronously
+    void loadChildren(const QModelIndex &parent);
+    // Frees the items below a collapsed item
+    void releaseChildren(const QModelIndex &parent);
 
     void setRequiredRights(int requiredRights);
     void setDisableFolders(bool option);
@@ -30,7 +39,13 @@ public:
 
     virtual ~QMegaModel();
 
+    static const int FETCH_PAGE_SIZE;
+
 protected:
+    void onChildrenFetched(unsigned long long fetchId, mega::MegaNodeList *children);
+    void cancelFetches(MegaItem *item);
+    void fetchNextPage(const QModelIndex &parent, MegaItem *item);
+
     mega::MegaApi *megaApi;
     std::shared_ptr<mega::MegaNode> root;
     MegaItem *rootItem;
@@ -41,6 +56,9 @@ protected:
     int requiredRights;
     bool displayFiles;
     bool disableFolders;
+    // Items waiting for their children, by fetch id
+    QHash<unsigned long long, MegaItem *> pendingFetches;
+    unsigned long long lastFetchId;
 };
 
 #endif // QMEGAMODEL_H
@@ -131,16 +131,18 @@ void QSyncItemWidget::enterEvent(QEvent* event)
         mNodesUpToDate = true; // to avoid further triggering updates, until some node changes
 
         //queue an update of the sync remote node
-        ThreadPoolSingleton::getInstance()->push([this]()
+        //the task may already be running when the widget is destroyed, so it must not use it
+        std::shared_ptr<SyncSetting> syncSetting = mSyncSetting;
+        ThreadPoolSingleton::getInstance()->submit([syncSetting]()
         {//thread pool function
 
             auto megaApi (MegaSyncApp->getMegaApi());
             std::unique_ptr<char[]> np (megaApi->getNodePathByNodeHandle(
-                                            mSyncSetting->getMegaHandle()));
+                                            syncSetting->getMegaHandle()));
             Model::instance()->updateMegaFolder(np ? QString::fromUtf8(np.get())
                                                    : QString(),
-                                                mSyncSetting);
-        });// end of thread pool function
+                                                syncSetting);
+        }, ThreadPool::Priority::HOUSEKEEPING, this);// end of thread pool function
         mLastRemotePathCheck = QDateTime::currentMSecsSinceEpoch();
     }
     return QWidget::enterEvent(event);
@@ -1,8 +1,14 @@
 #include "QTransfersModel.h"
 #include "MegaApplication.h"
+#include <QSet>
+#include <algorithm>
 
 using namespace mega;
 
+// A burst of small sync transfers finishes within a few milliseconds
+const int QTransfersModel::FINISHED_TRANSFERS_BATCH_DELAY_MS = 100;
+const int QTransfersModel::MAX_FINISHED_TRANSFERS_BATCH = 1000;
+
 QTransfersModel::QTransfersModel(int type, QObject *parent) :
     QAbstractItemModel(parent)
 {
@@ -11,6 +17,10 @@ QTransfersModel::QTransfersModel(int type, QObject *parent) :
     this->transferItems.setMaxCost(16);
 
     mThreadPool = ThreadPoolSingleton::getInstance();
+
+    finishedTransfersTimer.setSingleShot(true);
+    finishedTransfersTimer.setInterval(FINISHED_TRANSFERS_BATCH_DELAY_MS);
+    connect(&finishedTransfersTimer, &QTimer::timeout, this, &QTransfersModel::flushFinishedTransfers);
 }
 
 int QTransfersModel::columnCount(const QModelIndex &parent) const
@@ -74,7 +84,161 @@ int QTransfersModel::getModelType()
     return type;
 }
 
+void QTransfersModel::addFinishedTransfer(MegaTransfer *transfer)
+{
+    //Copy transfer to avoid deletions by finishedtransfers if QMap reaches limit.
+    pendingFinishedTransfers.append(transfer->copy());
+    if (pendingFinishedTransfers.size() >= MAX_FINISHED_TRANSFERS_BATCH)
+    {
+        flushFinishedTransfers();
+    }
+    else if (!finishedTransfersTimer.isActive())
+    {
+        finishedTransfersTimer.start();
+    }
+}
+
+void QTransfersModel::flushFinishedTransfers()
+{
+    finishedTransfersTimer.stop();
+    if (pendingFinishedTransfers.isEmpty())
+    {
+        return;
+    }
+
+    QPointer<QTransfersModel> model = this;
+    QList<MegaTransfer*> batch;
+    batch.swap(pendingFinishedTransfers);
+
+    mThreadPool->push([this, model, batch]()
+    {//thread pool function
+        if (!model)
+        {
+            qDeleteAll(batch);
+            return;
+        }
+
+        // Newest transfer first, as they are shown. Transfers of the same node share the lookup
+        MegaApi *api = ((MegaApplication*)qApp)->getMegaApi();
+        QHash<MegaHandle, int> accessByHandle;
+        QList<TransferItemData*> items;
+        for (MegaTransfer *transfer : batch)
+        {
+            MegaHandle handle = transfer->getNodeHandle();
+            auto it = accessByHandle.constFind(handle);
+            if (it == accessByHandle.constEnd())
+            {
+                int access = MegaShare::ACCESS_UNKNOWN;
+                std::unique_ptr<MegaNode> ownNode(api->getNodeByHandle(handle));
+                if (ownNode)
+                {
+                    access = api->getAccess(ownNode.get());
+                }
+                it = accessByHandle.insert(handle, access);
+            }
+
+            TransferItemData *item = new TransferItemData(transfer);
+            item->data.nodeAccess = it.value();
+            item->data.publicNode = (it.value() == MegaShare::ACCESS_OWNER);
+            items.prepend(item);
+            delete transfer;
+        }
+
+        Utilities::queueFunctionInAppThread([this, model, items]()
+        {//queued function
+            if (model)
+            {
+                insertFinishedTransfers(items);
+            }
+            else
+            {
+                qDeleteAll(items);
+            }
+        });//end of queued function
+
+    });// end of thread pool function;
+}
+
+int QTransfersModel::getFinishedTransfersRow() const
+{
+    return 0;
+}
+
+void QTransfersModel::insertFinishedTransfers(QList<TransferItemData*> items)
+{
+    // Already listed, or repeated in the batch: keep the newest one
+    QSet<int> tags;
+    for (auto it = items.begin(); it != items.end();)
+    {
+        int tag = (*it)->data.tag;
+        if (transfers.contains(tag) || tags.contains(tag))
+        {
+            delete *it;
+            it = items.erase(it);
+        }
+        else
+        {
+            tags.insert(tag);
+            ++it;
+        }
+    }
+
+    const int row = getFinishedTransfersRow();
+    const int maxItems = (int)Preferences::MAX_COMPLETED_ITEMS;
+
+    // Oldest transfers of the batch that don't fit even after evicting every finished row
+    while (items.size() && row + items.size() > maxItems)
+    {
+        delete items.takeLast();
+    }
+    if (items.isEmpty())
+    {
+        return;
+    }
+
+    const bool wasEmpty = transferOrder.empty();
+    int excess = int(transfers.size()) + items.size() - maxItems;
+    if (excess > 0)
+    {
+        removeLastTransfers(excess);
+    }
+
+    beginInsertRows(QModelIndex(), row, row + items.size() - 1);
+    for (TransferItemData *item : items)
+    {
+        transfers.insert(item->data.tag, item);
+    }
+    transferOrder.insert(transferOrder.begin() + row, items.begin(), items.end());
+    endInsertRows();
+
+    if (wasEmpty)
+    {
+        emit onTransferAdded();
+    }
+}
+
+void QTransfersModel::removeLastTransfers(int count)
+{
+    count = std::min(count, int(transferOrder.size()));
+    if (count <= 0)
+    {
+        return;
+    }
+
+    const int first = int(transferOrder.size()) - count;
+    beginRemoveRows(QModelIndex(), first, int(transferOrder.size()) - 1);
+    for (auto it = transferOrder.begin() + first; it != transferOrder.end(); ++it)
+    {
+        transfers.remove((*it)->data.tag);
+        transferItems.remove((*it)->data.tag);
+        delete *it;
+    }
+    transferOrder.erase(transferOrder.begin() + first, transferOrder.end());
+    endRemoveRows();
+}
+
 QTransfersModel::~QTransfersModel()
 {
+    qDeleteAll(pendingFinishedTransfers);
     qDeleteAll(transfers);
 }
@@ -3,6 +3,7 @@
 
 #include <QAbstractItemModel>
 #include <QCache>
+#include <QTimer>
 #include "TransferItem.h"
 #include <megaapi.h>
 #include "QTMegaTransferListener.h"
@@ -102,10 +103,25 @@ private slots:
     virtual void refreshTransferItem(int tag) = 0;
 
 protected:
+    // Finished transfers are collected for FINISHED_TRANSFERS_BATCH_DELAY_MS, their node access is
+    // resolved in a single thread pool task and they are inserted as one range of rows
+    void addFinishedTransfer(mega::MegaTransfer *transfer);
+    void flushFinishedTransfers();
+    // Row where finished transfers are inserted, the newest one first
+    virtual int getFinishedTransfersRow() const;
+    void insertFinishedTransfers(QList<TransferItemData*> items);
+    // Removes the last rows of the model as a single range
+    void removeLastTransfers(int count);
+
+    static const int FINISHED_TRANSFERS_BATCH_DELAY_MS;
+    static const int MAX_FINISHED_TRANSFERS_BATCH;
+
     QMap<int, TransferItemData*> transfers;
     std::deque<TransferItemData*> transferOrder;
     int type;
     ThreadPool* mThreadPool;
+    QList<mega::MegaTransfer*> pendingFinishedTransfers;
+    QTimer finishedTransfersTimer;
 };
 
 #endif // QTRANSFERSMODEL_H
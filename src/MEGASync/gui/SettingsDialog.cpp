@@ -20,6 +20,7 @@
 #include <QButtonGroup>
 #include <QtConcurrent/QtConcurrent>
 #include <QShortcut>
+#include <QFontDatabase>
 
 #include <assert.h>
 
@@ -50,6 +51,7 @@ constexpr auto SETTING_ANIMATION_SECURITY_TAB_HEIGHT{372};
 
 const QString SYNCS_TAB_MENU_LABEL_QSS = QString::fromUtf8("QLabel{ border-image: url(%1); }");
 static constexpr int NUMBER_OF_CLICKS_TO_DEBUG {5};
+static constexpr int DEBUG_INFO_REFRESH_INTERVAL_MS {5000};
 static constexpr int NETWORK_LIMITS_MAX {9999};
 
 long long calculateCacheSize()
@@ -91,6 +93,8 @@ SettingsDialog::SettingsDialog(MegaApplication* app, bool proxyOnly, QWidget* pa
     mCacheSize (-1),
     mRemoteCacheSize (-1),
     mDebugCounter (0),
+    mDebugInfoGroup (nullptr),
+    mDebugInfo (nullptr),
     mAreSyncsDisabled (false),
     mIsSavingSyncsOnGoing (false),
     mSelectedSyncRow(-1)
@@ -128,6 +132,26 @@ SettingsDialog::SettingsDialog(MegaApplication* app, bool proxyOnly, QWidget* pa
 
     mUi->gExcludedFilesInfo->hide();
 
+    // Debug information, only while debug mode is enabled. Not translated, it is meant for bug reports
+    mDebugInfoGroup = new QGroupBox(QString::fromUtf8("Debug information"), mUi->pGeneral);
+    mDebugInfo = new QLabel(mDebugInfoGroup);
+    mDebugInfo->setTextInteractionFlags(Qt::TextSelectableByMouse);
+    mDebugInfo->setFont(QFontDatabase::systemFont(QFontDatabase::FixedFont));
+    QVBoxLayout* debugInfoLayout = new QVBoxLayout(mDebugInfoGroup);
+    debugInfoLayout->addWidget(mDebugInfo);
+    if (QBoxLayout* generalLayout = qobject_cast<QBoxLayout*>(mUi->pGeneral->layout()))
+    {
+        int index = generalLayout->count();
+        while (index > 0 && generalLayout->itemAt(index - 1)->spacerItem())
+        {
+            index--;
+        }
+        generalLayout->insertWidget(index, mDebugInfoGroup);
+    }
+    mDebugInfoGroup->hide();
+    mDebugInfoTimer.setInterval(DEBUG_INFO_REFRESH_INTERVAL_MS);
+    connect(&mDebugInfoTimer, &QTimer::timeout, this, &SettingsDialog::updateDebugInfo);
+
 #ifdef Q_OS_WINDOWS
     mUi->cFinderIcons->hide();
 
@@ -196,8 +220,8 @@ SettingsDialog::SettingsDialog(MegaApplication* app, bool proxyOnly, QWidget* pa
 
     if (!proxyOnly)
     {
-        setMinimumHeight(SETTING_ANIMATION_GENERAL_TAB_HEIGHT);
-        setMaximumHeight(SETTING_ANIMATION_GENERAL_TAB_HEIGHT);
+        setMinimumHeight(generalTabHeight());
+        setMaximumHeight(generalTabHeight());
         mUi->pNetwork->hide();
     }
 
@@ -227,6 +251,8 @@ SettingsDialog::SettingsDialog(MegaApplication* app, bool proxyOnly, QWidget* pa
             this, &SettingsDialog::onSyncSelected);
     mUi->tSyncs->setMouseTracking(true);
     syncsStateInformation(SyncStateInformation::NO_SAVING_SYNCS);
+
+    setDebugInfoVisible(mApp->isDebugModeEnabled());
 }
 
 SettingsDialog::~SettingsDialog()
@@ -639,6 +665,37 @@ void SettingsDialog::storageChanged()
     onCacheSizeAvailable();
 }
 
+void SettingsDialog::setDebugInfoVisible(bool visible)
+{
+    if (mDebugInfoGroup->isHidden() != visible)
+    {
+        return;
+    }
+
+    mDebugInfoGroup->setVisible(visible);
+    if (visible)
+    {
+        updateDebugInfo();
+        mDebugInfoTimer.start();
+    }
+    else
+    {
+        mDebugInfoTimer.stop();
+    }
+
+#ifdef Q_OS_MACOS
+    if (mUi->wStack->currentWidget() == mUi->pGeneral && !mProxyOnly)
+    {
+        animateSettingPage(generalTabHeight(), SETTING_ANIMATION_PAGE_TIMEOUT);
+    }
+#endif
+}
+
+void SettingsDialog::updateDebugInfo()
+{
+    mDebugInfo->setText(mApp->getDebugInfo());
+}
+
 void SettingsDialog::onLocalCacheSizeAvailable()
 {
     mCacheSize = mCacheSizeWatcher.result();
@@ -705,6 +762,12 @@ void SettingsDialog::onAnimationFinished()
     }
 }
 
+int SettingsDialog::generalTabHeight()
+{
+    return SETTING_ANIMATION_GENERAL_TAB_HEIGHT
+            + (mDebugInfoGroup && !mDebugInfoGroup->isHidden() ? mDebugInfoGroup->sizeHint().height() : 0);
+}
+
 void SettingsDialog::animateSettingPage(int endValue, int duration)
 {
     mMinHeightAnimation->setTargetObject(this);
@@ -793,7 +856,7 @@ void SettingsDialog::on_bGeneral_clicked()
     onCacheSizeAvailable();
 
     mUi->pGeneral->hide();
-    animateSettingPage(SETTING_ANIMATION_GENERAL_TAB_HEIGHT, SETTING_ANIMATION_PAGE_TIMEOUT);
+    animateSettingPage(generalTabHeight(), SETTING_ANIMATION_PAGE_TIMEOUT);
 #endif
 }
 
@@ -974,7 +1037,7 @@ void SettingsDialog::on_cLanguage_currentIndexChanged(int index)
         mPreferences->setLanguage(selectedLanguage);
         mApp->changeLanguage(selectedLanguage);
         QString currentLanguage = mApp->getCurrentLanguageCode();
-        mThreadPool->push([=]()
+        mThreadPool->submit([=]()
         {
             mMegaApi->setLanguage(currentLanguage.toUtf8().constData());
             mMegaApi->setLanguagePreference(currentLanguage.toUtf8().constData());
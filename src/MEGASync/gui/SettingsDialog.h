@@ -13,6 +13,9 @@
 #include "control/Utilities.h"
 
 #include <QDialog>
+#include <QGroupBox>
+#include <QLabel>
+#include <QTimer>
 #include <QFuture>
 #include <QFutureWatcher>
 #include <QtCore>
@@ -52,6 +55,7 @@ public:
     void setOverQuotaMode(bool mode);
     void setUpdateAvailable(bool updateAvailable);
     void storageChanged();
+    void setDebugInfoVisible(bool visible);
 
     // Account
     void updateStorageElements() override;
@@ -83,6 +87,7 @@ public slots:
     // General
     void onLocalCacheSizeAvailable();
     void onRemoteCacheSizeAvailable();
+    void updateDebugInfo();
 
     // Account
     void storageStateChanged(int state);
@@ -207,6 +212,7 @@ private:
     void reloadToolBarItemNames();
     void macOSretainSizeWhenHidden();
     void animateSettingPage(int endValue, int duration = 150);
+    int generalTabHeight();
     QPropertyAnimation* mMinHeightAnimation;
     QPropertyAnimation* mMaxHeightAnimation;
     QParallelAnimationGroup* mAnimationGroup;
@@ -236,6 +242,9 @@ private:
     long long mCacheSize;
     long long mRemoteCacheSize;
     int mDebugCounter; // Easter Egg
+    QGroupBox* mDebugInfoGroup;
+    QLabel* mDebugInfo;
+    QTimer mDebugInfoTimer;
     QStringList mSyncNames;
     bool mAreSyncsDisabled; //Check if there are any sync disabled by any kind of error
     bool mIsSavingSyncsOnGoing;
@@ -80,7 +80,8 @@ TransferManager::TransferManager(MegaApi *megaApi, QWidget *parent) :
 
     });// end of thread pool function
 
-    if (((MegaApplication *)qApp)->getFinishedTransfers().size() > 0)
+    QList<MegaTransfer*> finishedTransfers = ((MegaApplication *)qApp)->getFinishedTransfers();
+    if (finishedTransfers.size() > 0)
     {
         ui->wCompletedTab->setVisible(true);
     }
@@ -89,7 +90,8 @@ TransferManager::TransferManager(MegaApi *megaApi, QWidget *parent) :
         ui->wCompletedTab->setVisible(false);
     }
 
-    ui->wCompleted->setupFinishedTransfers(((MegaApplication *)qApp)->getFinishedTransfers());
+    ui->wCompleted->setupFinishedTransfers(finishedTransfers);
+    qDeleteAll(finishedTransfers);
     updateNumberOfCompletedTransfers(((MegaApplication *)qApp)->getNumUnviewedTransfers());
 
     connect(ui->wCompleted->getModel(), SIGNAL(noTransfers()), this, SLOT(updateState()));
@@ -34,6 +34,7 @@ SOURCES += $$PWD/SettingsDialog.cpp \
     $$PWD/QActiveTransfersModel.cpp \
     $$PWD/QFinishedTransfersModel.cpp \
     $$PWD/MegaTransferDelegate.cpp \
+    $$PWD/FinishedTransferPainter.cpp \
     $$PWD/MegaTransferView.cpp \
     $$PWD/QMegaMessageBox.cpp \
     $$PWD/TransfersStateInfoWidget.cpp \
@@ -106,6 +107,7 @@ HEADERS  += $$PWD/SettingsDialog.h \
     $$PWD/QActiveTransfersModel.h \
     $$PWD/QFinishedTransfersModel.h \
     $$PWD/MegaTransferDelegate.h \
+    $$PWD/FinishedTransferPainter.h \
     $$PWD/MegaTransferView.h \
     $$PWD/QMegaMessageBox.h \
     $$PWD/TransfersStateInfoWidget.h \
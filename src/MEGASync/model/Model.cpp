@@ -239,13 +239,13 @@ std::shared_ptr<SyncSetting> Model::updateSyncSettings(MegaSync *sync, int addin
     }
 
     //queue an update of the sync remote node
-    ThreadPoolSingleton::getInstance()->push([this, cs]()
+    ThreadPoolSingleton::getInstance()->submit([this, cs]()
     {//thread pool function
 
         std::unique_ptr<char[]> np(MegaSyncApp->getMegaApi()->getNodePathByNodeHandle(cs->getMegaHandle()));
         updateMegaFolder(np ? QString::fromUtf8(np.get()) : QString(), cs);
 
-    });// end of thread pool function
+    }, ThreadPool::Priority::HOUSEKEEPING);// end of thread pool function
 
 
     if (addingState) //new or resumed
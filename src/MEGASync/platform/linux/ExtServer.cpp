@@ -67,11 +67,21 @@ void ExtServer::onClientDisconnected()
     if (!client)
         return;
     m_clients.removeAll(client);
+    m_batchBuffers.remove(client);
     client->deleteLater();
 
     //LOG_debug << "Client disconnected";
 }
 
+#define BUFSIZE 1024
+#define RESPONSE_DEFAULT    "9"
+#define RESPONSE_ERROR      "0"
+#define RESPONSE_SYNCED     "1"
+#define RESPONSE_PENDING    "2"
+#define RESPONSE_SYNCING    "3"
+#define OP_PATH_STATES      'B'
+#define MAX_BATCH_REQUEST_SIZE (16 * 1024 * 1024)
+
 // client sends some data
 void ExtServer::onClientData()
 {
@@ -85,21 +95,55 @@ void ExtServer::onClientData()
     }
 
     char buf[1024];
-    while (client->readLine(buf, sizeof(buf)) > 0) {
-        const char *out = GetAnswerToRequest(buf);
-        if (out) {
-            client->write(out);
-            client->write("\n");
+    for (;;) {
+        QByteArray &batch = m_batchBuffers[client];
+        if (batch.isEmpty()) {
+            char op;
+            if (client->peek(&op, 1) != 1)
+                break;
+
+            if (op != OP_PATH_STATES) {
+                if (client->readLine(buf, sizeof(buf)) <= 0)
+                    break;
+
+                const char *out = GetAnswerToRequest(buf);
+                if (out) {
+                    client->write(out);
+                    client->write("\n");
+                }
+                continue;
+            }
+        }
+
+        // batched requests are framed by a newline and can arrive in several chunks
+        batch.append(client->readAll());
+        int end = batch.indexOf('\n');
+        if (end < 0) {
+            if (batch.size() > MAX_BATCH_REQUEST_SIZE) {
+                //LOG_err << "Batch request too large";
+                batch.clear();
+                client->write(RESPONSE_ERROR "\n");
+            }
+            break;
+        }
+
+        QByteArray request = batch.left(end);
+        batch.remove(0, end + 1);
+        client->write(GetAnswerToBatchRequest(request));
+        client->write("\n");
+
+        if (!batch.isEmpty() && batch.at(0) != OP_PATH_STATES) {
+            // not expected from request/response clients, answer it anyway
+            const char *out = GetAnswerToRequest(batch.constData());
+            batch.clear();
+            if (out) {
+                client->write(out);
+                client->write("\n");
+            }
         }
     }
 }
 
-#define BUFSIZE 1024
-#define RESPONSE_DEFAULT    "9"
-#define RESPONSE_ERROR      "0"
-#define RESPONSE_SYNCED     "1"
-#define RESPONSE_PENDING    "2"
-#define RESPONSE_SYNCING    "3"
 // parse incoming request and send response back to client
 const char *ExtServer::GetAnswerToRequest(const char *buf)
 {
@@ -236,16 +280,10 @@ const char *ExtServer::GetAnswerToRequest(const char *buf)
         // get the state of an object
         case 'P':
         {
-            int state = MegaApi::STATE_NONE;
             string scontent(content);
             size_t possep = scontent.find((char)0x1C);
             bool forceGetState = (possep != string::npos) && ((possep + 1) < scontent.size()) && scontent.at(possep+1) == '1';
-
-            if (forceGetState || !Preferences::instance()->overlayIconsDisabled() )
-            {
-                string tmpPath = scontent.substr(0,possep);
-                state = ((MegaApplication *)qApp)->getMegaApi()->syncPathState(&tmpPath);
-            }
+            int state = getPathState(scontent.substr(0,possep), forceGetState);
 
             switch(state)
             {
@@ -313,3 +351,52 @@ const char *ExtServer::GetAnswerToRequest(const char *buf)
 
     return out;
 }
+
+int ExtServer::getPathState(const string &path, bool forceGetState)
+{
+    if (!forceGetState && Preferences::instance()->overlayIconsDisabled())
+    {
+        return MegaApi::STATE_NONE;
+    }
+
+    string tmpPath = path;
+    return ((MegaApplication *)qApp)->getMegaApi()->syncPathState(&tmpPath);
+}
+
+// request: B:<force>0x1C<path>0x1D<path>...
+// answer: one state digit per requested path, in the same order
+QByteArray ExtServer::GetAnswerToBatchRequest(const QByteArray &request)
+{
+    // skip "B:"
+    int possep = request.indexOf((char)0x1C);
+    if (request.size() < 2 || possep < 0)
+    {
+        return QByteArray(RESPONSE_ERROR);
+    }
+
+    bool forceGetState = possep > 2 && request.at(2) == '1';
+    QList<QByteArray> paths = request.mid(possep + 1).split((char)0x1D);
+
+    QByteArray answer;
+    answer.reserve(paths.size());
+    foreach (const QByteArray &path, paths)
+    {
+        switch (getPathState(string(path.constData(), path.size()), forceGetState))
+        {
+            case MegaApi::STATE_SYNCED:
+                answer.append(RESPONSE_SYNCED);
+                break;
+            case MegaApi::STATE_SYNCING:
+                answer.append(RESPONSE_SYNCING);
+                break;
+            case MegaApi::STATE_PENDING:
+                answer.append(RESPONSE_PENDING);
+                break;
+            case MegaApi::STATE_NONE:
+            case MegaApi::STATE_IGNORED:
+            default:
+                answer.append(RESPONSE_DEFAULT);
+        }
+    }
+    return answer;
+}
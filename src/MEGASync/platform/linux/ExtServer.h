@@ -34,7 +34,10 @@ class ExtServer: public QObject
  private:
     QString sockPath;
     QList<QLocalSocket *> m_clients;
+    QMap<QLocalSocket *, QByteArray> m_batchBuffers;
     const char *GetAnswerToRequest(const char *buf);
+    QByteArray GetAnswerToBatchRequest(const QByteArray &request);
+    int getPathState(const std::string &path, bool forceGetState);
 
  signals:
     void newUploadQueue(QQueue<QString> uploadQueue);
@@ -7,8 +7,15 @@
 using namespace mega;
 using namespace std;
 
+// window in which repeated changes of the same path are merged
+#define FLUSH_INTERVAL_MS 50
+// above this amount of unsent data a client is considered too slow for per-path updates
+#define MAX_CLIENT_PENDING_BYTES (256 * 1024)
+
 NotifyServer::NotifyServer(): QObject(),
-    m_localServer(0)
+    m_localServer(0),
+    m_coalesced(0),
+    m_dropped(0)
 {
     // construct local socket path
     sockPath = MegaApplication::applicationDataPath() + QDir::separator() + QString::fromAscii("notify.socket");
@@ -27,12 +34,20 @@ NotifyServer::NotifyServer(): QObject(),
         return;
     }
 
+    m_flushTimer.setSingleShot(true);
+    m_flushTimer.setInterval(FLUSH_INTERVAL_MS);
+    connect(&m_flushTimer, SIGNAL(timeout()), this, SLOT(flushItemChanges()));
+
     connect(this, SIGNAL(sendToAll(const char *, QByteArray)), this, SLOT(doSendToAll(const char *, QByteArray)));
+    connect(this, SIGNAL(itemChanged(QByteArray)), this, SLOT(queueItemChange(QByteArray)));
     connect(m_localServer, SIGNAL(newConnection()), this, SLOT(acceptConnection()));
 }
 
 NotifyServer::~NotifyServer()
 {
+    MegaApi::log(MegaApi::LOG_LEVEL_DEBUG, QString::fromUtf8("Shell notifications coalesced: %1 dropped: %2")
+                 .arg(m_coalesced).arg(m_dropped).toUtf8().constData());
+
     qDeleteAll(m_clients);
     QLocalServer::removeServer(sockPath);
     m_localServer->close();
@@ -52,6 +67,7 @@ void NotifyServer::acceptConnection()
         }
 
         connect(client, SIGNAL(disconnected()), this, SLOT(onClientDisconnected()));
+        connect(client, SIGNAL(bytesWritten(qint64)), this, SLOT(onClientBytesWritten()));
 
         // send the list of current synced folders to the new client
         int localFolders = 0;
@@ -81,6 +97,7 @@ void NotifyServer::acceptConnection()
         }
 
         m_clients.append(client);
+        m_clientQueues.insert(client, ClientQueue());
     }
 }
 
@@ -91,26 +108,168 @@ void NotifyServer::onClientDisconnected()
     if (!client)
         return;
     m_clients.removeAll(client);
+    m_clientQueues.remove(client);
     client->deleteLater();
 
     //LOG_debug << "Client disconnected";
 }
 
+// a slow client has made progress, send the pending refreshes once it is drained
+void NotifyServer::onClientBytesWritten()
+{
+    QLocalSocket *client = qobject_cast<QLocalSocket *>(sender());
+    if (!client || !m_clientQueues.contains(client))
+        return;
+
+    ClientQueue &queue = m_clientQueues[client];
+    if (!queue.rootsToRefresh.isEmpty() && client->bytesToWrite() < MAX_CLIENT_PENDING_BYTES / 2)
+    {
+        sendRootRefresh(client, queue);
+    }
+}
+
 // send string to all connected clients
 void NotifyServer::doSendToAll(const char *type, QByteArray str)
 {
+    // keep the order with respect to the item changes already queued
+    flushItemChanges();
+
     foreach(QLocalSocket *socket, m_clients)
         if (socket && socket->state() == QLocalSocket::ConnectedState) {
             socket->write(type);
             socket->write(str.constData(), str.size());
             socket->write("\n");
-            socket->flush();
         }
 }
 
+void NotifyServer::queueItemChange(QByteArray path)
+{
+    if (m_pendingSet.contains(path))
+    {
+        m_coalesced++;
+        return;
+    }
+
+    m_pendingSet.insert(path);
+    m_pendingPaths.append(path);
+    if (!m_flushTimer.isActive())
+    {
+        m_flushTimer.start();
+    }
+}
+
+// send all the paths changed during the last window in a single write per client
+void NotifyServer::flushItemChanges()
+{
+    m_flushTimer.stop();
+    if (m_pendingPaths.isEmpty())
+    {
+        return;
+    }
+
+    QByteArray frame;
+    foreach (const QByteArray &path, m_pendingPaths)
+    {
+        frame.append('P');
+        frame.append(path);
+        frame.append('\n');
+    }
+
+    QList<QByteArray> roots;
+    bool rootsLoaded = false;
+    foreach(QLocalSocket *socket, m_clients)
+    {
+        if (!socket || socket->state() != QLocalSocket::ConnectedState)
+        {
+            continue;
+        }
+
+        ClientQueue &queue = m_clientQueues[socket];
+        if (queue.rootsToRefresh.isEmpty()
+                && socket->bytesToWrite() + frame.size() <= MAX_CLIENT_PENDING_BYTES)
+        {
+            socket->write(frame);
+            continue;
+        }
+
+        // the client can't keep up: remember which sync roots must be refreshed
+        if (!rootsLoaded)
+        {
+            roots = getSyncRoots();
+            rootsLoaded = true;
+        }
+        foreach (const QByteArray &path, m_pendingPaths)
+        {
+            queue.rootsToRefresh.insert(getSyncRoot(path, roots));
+        }
+        m_dropped += m_pendingPaths.size();
+
+        if (socket->bytesToWrite() < MAX_CLIENT_PENDING_BYTES / 2)
+        {
+            sendRootRefresh(socket, queue);
+        }
+    }
+
+    m_pendingPaths.clear();
+    m_pendingSet.clear();
+}
+
+long long NotifyServer::getCoalescedCount() const
+{
+    return m_coalesced;
+}
+
+long long NotifyServer::getDroppedCount() const
+{
+    return m_dropped;
+}
+
+// 'R' makes clients refresh the state of everything under a sync root
+void NotifyServer::sendRootRefresh(QLocalSocket *client, ClientQueue &queue)
+{
+    QByteArray frame;
+    foreach (const QByteArray &root, queue.rootsToRefresh)
+    {
+        frame.append('R');
+        frame.append(root);
+        frame.append('\n');
+    }
+    queue.rootsToRefresh.clear();
+    client->write(frame);
+}
+
+QList<QByteArray> NotifyServer::getSyncRoots()
+{
+    QList<QByteArray> roots;
+    Model *model = Model::instance();
+    for (int i = 0; i < model->getNumSyncedFolders(); i++)
+    {
+        auto syncSetting = model->getSyncSetting(i);
+        QString root = QDir::toNativeSeparators(QDir(syncSetting->getLocalFolder()).canonicalPath());
+        if (root.size())
+        {
+            roots.append(root.toUtf8());
+        }
+    }
+    return roots;
+}
+
+QByteArray NotifyServer::getSyncRoot(const QByteArray &path, const QList<QByteArray> &roots)
+{
+    foreach (const QByteArray &root, roots)
+    {
+        if (path.startsWith(root)
+                && (path.size() == root.size() || path.at(root.size()) == QDir::separator().toLatin1()))
+        {
+            return root;
+        }
+    }
+    return path;
+}
+
 void NotifyServer::notifyItemChange(string *localPath)
 {
-    emit sendToAll("P", QByteArray(localPath->data(), localPath->size()));
+    emit itemChanged(QByteArray(localPath->data(), localPath->size()));
 }
 
 void NotifyServer::notifySyncAdd(QString path)
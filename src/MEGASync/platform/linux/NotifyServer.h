@@ -5,6 +5,11 @@
 #include "megaapi.h"
 #include "control/Preferences.h"
 
+#include <QHash>
+#include <QSet>
+#include <QTimer>
+#include <QVector>
+
 class NotifyServer: public QObject
 {
     Q_OBJECT
@@ -16,23 +21,47 @@ class NotifyServer: public QObject
     void notifySyncAdd(QString path);
     void notifySyncDel(QString path);
 
+    long long getCoalescedCount() const;
+    long long getDroppedCount() const;
+
  protected:
     QLocalServer *m_localServer;
 
  public Q_SLOTS:
     void acceptConnection();
     void onClientDisconnected();
+    void onClientBytesWritten();
     void doSendToAll(const char *type, QByteArray str);
+    void queueItemChange(QByteArray path);
+    void flushItemChanges();
 
  private:
+    // Paths that could not be sent to a slow client are replaced by
+    // a refresh of their sync root
+    struct ClientQueue
+    {
+        QSet<QByteArray> rootsToRefresh;
+    };
+
+    QList<QByteArray> getSyncRoots();
+    QByteArray getSyncRoot(const QByteArray &path, const QList<QByteArray> &roots);
+    void sendRootRefresh(QLocalSocket *client, ClientQueue &queue);
+
     MegaApplication *app;
     QString sockPath;
     QList<QLocalSocket *> m_clients;
+    QHash<QLocalSocket *, ClientQueue> m_clientQueues;
+
+    QTimer m_flushTimer;
+    QVector<QByteArray> m_pendingPaths;
+    QSet<QByteArray> m_pendingSet;
+    long long m_coalesced;
+    long long m_dropped;
 
 signals:
     void sendToAll(const char *type, QByteArray str);
+    void itemChanged(QByteArray path);
 
 };
 
 #endif
-
@@ -2,6 +2,10 @@
 #include <fstream>
 #include <vector>
 #include <string>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <unordered_map>
 
 namespace mega {
 // within ::mega namespace, byte is unsigned char (avoids ambiguity when std::byte from c++17 and perhaps other defined ::byte are available)
@@ -24,6 +28,8 @@ typedef int64_t m_off_t;
 
 #define KEY_LENGTH 4096
 #define SIGNATURE_LENGTH 512
+#define DELTA_BLOCK_SIZE 4096
+#define DELTA_MAX_LITERAL (1024 * 1024)
 
 using namespace mega;
 using std::string;
@@ -33,6 +39,7 @@ using std::cout;
 using std::cerr;
 using std::endl;
 using std::ifstream;
+using std::ofstream;
 
 class HashSignature
 {
@@ -111,6 +118,8 @@ void printUsage(const char* appname)
     cerr << "    " << appname << " <update folder> <keyfile> --file <contentsfile>" << endl;
     cerr << "    e.g:" << endl;
     cerr << "        " << appname << " /tmp/updatefiles /tmp/key.pem --file /megasync/contrib/updater/fileswin.txt" << endl;
+    cerr << "Sign an update and generate delta patches against previous releases:" << endl;
+    cerr << "    " << appname << " <update folder> <keyfile> --file <contentsfile> --delta <previous update folder> [--delta <folder>...]" << endl;
 }
 
 unsigned signFile(const char * filePath, AsymmCipher* key, ::mega::byte* signature, unsigned signbuflen)
@@ -216,6 +225,182 @@ bool generateHashFromContents(string contents, string *hash)
     return true;
 }
 
+bool readWholeFile(const string& filePath, string *contents)
+{
+    ifstream input(filePath.c_str(), std::ios::in | std::ios::binary);
+    if (input.fail())
+    {
+        return false;
+    }
+
+    input.seekg(0, std::ios::end);
+    contents->resize(size_t(input.tellg()));
+    input.seekg(0, std::ios::beg);
+    input.read(&(*contents)[0], std::streamsize(contents->size()));
+    return !input.fail() || contents->empty();
+}
+
+// rsync style weak checksum of a block, can be rolled one byte at a time
+struct RollingChecksum
+{
+    uint32_t a = 0;
+    uint32_t b = 0;
+    uint32_t length = 0;
+
+    void init(const unsigned char* data, uint32_t len)
+    {
+        a = b = 0;
+        length = len;
+        for (uint32_t i = 0; i < len; i++)
+        {
+            a += data[i];
+            b += (len - i) * data[i];
+        }
+    }
+
+    void roll(unsigned char out, unsigned char in)
+    {
+        a = a - out + in;
+        b = b - length * out + a;
+    }
+
+    uint32_t value() const
+    {
+        return (a & 0xFFFF) | (b << 16);
+    }
+};
+
+void appendLE(string& out, uint64_t value, int bytes)
+{
+    for (int i = 0; i < bytes; i++)
+    {
+        out.push_back(char((value >> (8 * i)) & 0xFF));
+    }
+}
+
+void appendLiteral(string& delta, const string& target, size_t start, size_t end)
+{
+    while (start < end)
+    {
+        size_t len = std::min<size_t>(end - start, DELTA_MAX_LITERAL);
+        delta.push_back('D');
+        appendLE(delta, len, 4);
+        delta.append(target, start, len);
+        start += len;
+    }
+}
+
+// Delta format, read by UpdateTask::applyDelta. Integers are little endian:
+//   "MEGADLT1", uint64 base size, uint64 target size, then operations until 'E':
+//   'C' uint64 offset, uint32 length: copy a range of the base file
+//   'D' uint32 length, <length bytes>: literal data
+// Blocks of the base file are indexed by their rolling checksum and looked up at every
+// offset of the target, so insertions and removals don't break the matching.
+void generateDelta(const string& base, const string& target, string *delta)
+{
+    delta->assign("MEGADLT1");
+    appendLE(*delta, base.size(), 8);
+    appendLE(*delta, target.size(), 8);
+
+    const unsigned char* baseData = (const unsigned char*)base.data();
+    const unsigned char* targetData = (const unsigned char*)target.data();
+
+    std::unordered_multimap<uint32_t, size_t> blocks;
+    for (size_t offset = 0; offset + DELTA_BLOCK_SIZE <= base.size(); offset += DELTA_BLOCK_SIZE)
+    {
+        RollingChecksum checksum;
+        checksum.init(baseData + offset, DELTA_BLOCK_SIZE);
+        blocks.emplace(checksum.value(), offset);
+    }
+
+    size_t pos = 0;
+    size_t literalStart = 0;
+    RollingChecksum checksum;
+    if (target.size() >= DELTA_BLOCK_SIZE)
+    {
+        checksum.init(targetData, DELTA_BLOCK_SIZE);
+    }
+
+    while (!blocks.empty() && pos + DELTA_BLOCK_SIZE <= target.size())
+    {
+        size_t matchOffset = string::npos;
+        auto range = blocks.equal_range(checksum.value());
+        for (auto it = range.first; it != range.second; ++it)
+        {
+            if (!memcmp(baseData + it->second, targetData + pos, DELTA_BLOCK_SIZE))
+            {
+                matchOffset = it->second;
+                break;
+            }
+        }
+
+        if (matchOffset == string::npos)
+        {
+            if (pos + DELTA_BLOCK_SIZE < target.size())
+            {
+                checksum.roll(targetData[pos], targetData[pos + DELTA_BLOCK_SIZE]);
+            }
+            pos++;
+            continue;
+        }
+
+        appendLiteral(*delta, target, literalStart, pos);
+
+        size_t length = DELTA_BLOCK_SIZE;
+        while (matchOffset + length < base.size() && pos + length < target.size()
+               && length < 0xFFFFFFFF && baseData[matchOffset + length] == targetData[pos + length])
+        {
+            length++;
+        }
+        delta->push_back('C');
+        appendLE(*delta, matchOffset, 8);
+        appendLE(*delta, length, 4);
+
+        pos += length;
+        literalStart = pos;
+        if (pos + DELTA_BLOCK_SIZE <= target.size())
+        {
+            checksum.init(targetData + pos, DELTA_BLOCK_SIZE);
+        }
+    }
+
+    appendLiteral(*delta, target, literalStart, target.size());
+    delta->push_back('E');
+}
+
+// Writes <file>.<sha256 of the previous file>.delta next to the new file, if it is smaller than the file itself
+bool generateDeltaFile(const string& previousPath, const string& filePath, size_t *deltaSize)
+{
+    string base, target, delta, baseHash;
+    if (!readWholeFile(previousPath, &base) || !readWholeFile(filePath, &target))
+    {
+        return false;
+    }
+
+    *deltaSize = 0;
+    if (base == target || !generateHash(previousPath.c_str(), &baseHash))
+    {
+        return true;
+    }
+
+    generateDelta(base, target, &delta);
+    if (delta.size() >= target.size())
+    {
+        return true;
+    }
+
+    ofstream output((filePath + "." + baseHash + ".delta").c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+    output.write(delta.data(), std::streamsize(delta.size()));
+    output.close();
+    if (output.fail())
+    {
+        return false;
+    }
+
+    *deltaSize = delta.size();
+    return true;
+}
+
 bool extractarg(vector<const char*>& args, const char *what)
 {
     for (int i = int(args.size()); i--; )
@@ -253,6 +438,16 @@ int main(int argc, char *argv[])
 
     string fileInput;
     bool externalfile = extractargparam(args, "--file", fileInput);
+    vector<string> previousFolders;
+    string previousFolder;
+    while (extractargparam(args, "--delta", previousFolder))
+    {
+        if (previousFolder.size() && previousFolder[previousFolder.size()-1] != '/')
+        {
+            previousFolder.append("/");
+        }
+        previousFolders.push_back(previousFolder);
+    }
     bool generate = extractarg(args, "-g");
 
     HashSignature signatureGenerator(new Hash());
@@ -453,6 +648,26 @@ int main(int argc, char *argv[])
             string fileurl = baseUrl + filesVector.at(i);
             downloadURLs.push_back(fileurl);
 
+            for (unsigned int j = 0; j < previousFolders.size(); j++)
+            {
+                string previousPath = previousFolders[j] + filesVector.at(i);
+                if (!ifstream(previousPath.c_str()).good())
+                {
+                    continue;
+                }
+
+                size_t deltaSize = 0;
+                if (!generateDeltaFile(previousPath, filePath, &deltaSize))
+                {
+                    cerr << "Error generating delta for file: " << filePath << " from " << previousPath << endl;
+                    return 9;
+                }
+                if (deltaSize)
+                {
+                    cerr << "Delta for " << filesVector.at(i) << " from " << previousFolders[j] << ": " << deltaSize << " bytes" << endl;
+                }
+            }
+
             signatureGenerator.add((const ::mega::byte*)fileurl.data(), fileurl.size());
             signatureGenerator.add((const ::mega::byte*)targetPathsVector.at(i).data(),
                                    targetPathsVector.at(i).size());
@@ -0,0 +1,17 @@
+QT       -= core gui
+
+TARGET = MEGAShellExtBenchmark
+TEMPLATE = app
+CONFIG += console
+CONFIG -= app_bundle
+
+SHELLEXT_DIR = $$PWD/../../src/MEGAShellExtNautilus
+INCLUDEPATH += $$SHELLEXT_DIR
+
+SOURCES += sync_trie_benchmark.c \
+    $$SHELLEXT_DIR/mega_ext_sync_trie.c
+
+HEADERS += $$SHELLEXT_DIR/mega_ext_sync_trie.h
+
+CONFIG += link_pkgconfig
+PKGCONFIG += glib-2.0
@@ -0,0 +1,125 @@
+// Compares mega_sync_trie_match with the linear scan over the sync roots it replaced
+// usage: MEGAShellExtBenchmark [num_syncs] [num_lookups]
+
+#include "mega_ext_sync_trie.h"
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define DEFAULT_NUM_SYNCS 2000
+#define DEFAULT_NUM_LOOKUPS 1000
+
+// same as expanselocalpath in the extensions
+static void canonicalize(const gchar *path, char *canonical)
+{
+    if (!realpath(path, canonical))
+        g_strlcpy(canonical, path, PATH_MAX);
+}
+
+// match done by mega_ext_path_in_sync before the trie:
+// the raw and the canonical path are compared with every sync root
+static gboolean linear_match(GHashTable *syncs, const gchar *path)
+{
+    GList *l, *p;
+    gboolean found = FALSE;
+
+    l = g_hash_table_get_keys(syncs);
+    for (p = g_list_first(l); p; p = g_list_next(p)) {
+        const gchar *sync = p->data;
+        char canonical[PATH_MAX];
+
+        if (strlen(sync) <= strlen(path) && !strncmp(sync, path, strlen(sync))) {
+            found = TRUE;
+            break;
+        }
+
+        canonicalize(path, canonical);
+        if (strlen(sync) <= strlen(canonical) && !strncmp(sync, canonical, strlen(sync))) {
+            found = TRUE;
+            break;
+        }
+    }
+    g_list_free(l);
+
+    return found;
+}
+
+// match done by mega_ext_path_in_sync now
+static gboolean trie_match(MEGASyncTrie *trie, const gchar *path)
+{
+    char canonical[PATH_MAX];
+
+    if (mega_sync_trie_match(trie, path))
+        return TRUE;
+
+    canonicalize(path, canonical);
+    return strcmp(canonical, path) && mega_sync_trie_match(trie, canonical);
+}
+
+int main(int argc, char *argv[])
+{
+    guint num_syncs = argc > 1 ? (guint)atoi(argv[1]) : DEFAULT_NUM_SYNCS;
+    guint num_lookups = argc > 2 ? (guint)atoi(argv[2]) : DEFAULT_NUM_LOOKUPS;
+    GHashTable *syncs;
+    MEGASyncTrie *trie;
+    gchar **paths;
+    guint i, linear_found, trie_found;
+    gint64 start, linear_us, trie_us;
+
+    if (!num_syncs || !num_lookups) {
+        fprintf(stderr, "usage: %s [num_syncs] [num_lookups]\n", argv[0]);
+        return 1;
+    }
+
+    syncs = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+    trie = mega_sync_trie_new();
+    for (i = 0; i < num_syncs; i++) {
+        gchar *sync = g_strdup_printf("/home/user/MEGA/sync%05u/folder", i);
+        mega_sync_trie_insert(trie, sync);
+        g_hash_table_insert(syncs, sync, GINT_TO_POINTER(1));
+    }
+
+    // half of the paths are inside a sync root, the other half are not
+    paths = g_new0(gchar *, num_lookups);
+    for (i = 0; i < num_lookups; i++) {
+        if (i % 2)
+            paths[i] = g_strdup_printf("/home/user/MEGA/sync%05u/folder/docs/file%u.txt", i % num_syncs, i);
+        else
+            paths[i] = g_strdup_printf("/home/user/Documents/docs/file%u.txt", i);
+    }
+
+    linear_found = 0;
+    start = g_get_monotonic_time();
+    for (i = 0; i < num_lookups; i++) {
+        if (linear_match(syncs, paths[i]))
+            linear_found++;
+    }
+    linear_us = g_get_monotonic_time() - start;
+
+    trie_found = 0;
+    start = g_get_monotonic_time();
+    for (i = 0; i < num_lookups; i++) {
+        if (trie_match(trie, paths[i]))
+            trie_found++;
+    }
+    trie_us = g_get_monotonic_time() - start;
+
+    printf("%u sync roots, %u lookups (%u in a sync)\n", num_syncs, num_lookups, num_lookups / 2);
+    printf("linear scan: %" G_GINT64_FORMAT " us, %.3f us per lookup, %u found\n",
+           linear_us, (double)linear_us / num_lookups, linear_found);
+    printf("trie:        %" G_GINT64_FORMAT " us, %.3f us per lookup, %u found\n",
+           trie_us, (double)trie_us / num_lookups, trie_found);
+
+    for (i = 0; i < num_lookups; i++)
+        g_free(paths[i]);
+    g_free(paths);
+    mega_sync_trie_free(trie);
+    g_hash_table_destroy(syncs);
+
+    if (linear_found != trie_found) {
+        fprintf(stderr, "The trie and the linear scan disagree\n");
+        return 1;
+    }
+    return 0;
+}
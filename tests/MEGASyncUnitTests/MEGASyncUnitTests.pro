@@ -11,5 +11,20 @@ include(../3rdparty/trompeloeil/trompeloeil.pri)
 SOURCES += GuestWidgetTest.cpp \
            Utilities.test.cpp \
            control/TransferRemainingTime.Test.cpp \
+           control/MegaSyncLogger.Test.cpp \
+           control/MegaDownloader.Test.cpp \
+           control/MegaUploader.Test.cpp \
+           control/JsonTokenizer.Test.cpp \
+           control/MemorySampler.Test.cpp \
+           control/FinishedTransferHistory.Test.cpp \
+           control/LinkProcessor.Test.cpp \
+           control/ExportProcessor.Test.cpp \
+           control/EncryptedSettings.Test.cpp \
+           control/Preferences.Test.cpp \
+           control/HTTPServer.Test.cpp \
+           control/UpdateTask.Test.cpp \
+           gui/MegaItem.Test.cpp \
+           gui/QMegaModel.Test.cpp \
+           gui/FinishedTransferPainter.Test.cpp \
            ScaleFactorManager.Test.cpp \
            main.cpp
@@ -1,6 +1,12 @@
 #include <catch.hpp>
 #include "Utilities.h"
 
+#include <QElapsedTimer>
+#include <QFile>
+#include <QTemporaryDir>
+
+#include <algorithm>
+
 TEST_CASE("Create string with sufix from quantities")
 {
     CHECK(Utilities::getQuantityString(1).toStdString() == "1");
@@ -52,3 +58,79 @@ TEST_CASE("Create time string")
     constexpr auto secondsPrecision{false};
     REQUIRE(Utilities::getTimeString((5*minuteSeconds) + 7, secondsPrecision).toStdString() == expected);
 }
+
+namespace
+{
+void writeFile(const QString& path, qint64 size, qint64 differentByte = -1)
+{
+    QFile file(path);
+    REQUIRE(file.open(QIODevice::WriteOnly | QIODevice::Truncate));
+    QByteArray chunk(1024 * 1024, '\0');
+    for (int i = 0; i < chunk.size(); ++i)
+    {
+        chunk[i] = static_cast<char>(i * 31);
+    }
+    for (qint64 written = 0; written < size; )
+    {
+        QByteArray data = chunk.left(static_cast<int>(std::min<qint64>(chunk.size(), size - written)));
+        if (differentByte >= written && differentByte < written + data.size())
+        {
+            data[static_cast<int>(differentByte - written)] = static_cast<char>(~data[static_cast<int>(differentByte - written)]);
+        }
+        REQUIRE(file.write(data) == data.size());
+        written += data.size();
+    }
+}
+}
+
+TEST_CASE("Compare file contents")
+{
+    QTemporaryDir dir;
+    REQUIRE(dir.isValid());
+    const auto source{dir.filePath(QString::fromUtf8("source"))};
+    const auto destination{dir.filePath(QString::fromUtf8("destination"))};
+    constexpr qint64 size{3 * 1024 * 1024 + 17};
+
+    writeFile(source, size);
+    writeFile(destination, size);
+    CHECK_FALSE(Utilities::fileContentsDiffer(source, destination));
+
+    writeFile(destination, size, size - 1);
+    CHECK(Utilities::fileContentsDiffer(source, destination));
+
+    writeFile(destination, size, 0);
+    CHECK(Utilities::fileContentsDiffer(source, destination));
+
+    writeFile(destination, size - 1);
+    CHECK(Utilities::fileContentsDiffer(source, destination));
+
+    writeFile(source, 0);
+    writeFile(destination, 0);
+    CHECK_FALSE(Utilities::fileContentsDiffer(source, destination));
+
+    CHECK(Utilities::fileContentsDiffer(source, dir.filePath(QString::fromUtf8("missing"))));
+}
+
+// Not run by default: tagged hidden, run with "[benchmark]". Needs about 5GB of temporary space
+TEST_CASE("Compare large file contents", "[.][benchmark]")
+{
+    QTemporaryDir dir;
+    REQUIRE(dir.isValid());
+    const auto source{dir.filePath(QString::fromUtf8("source"))};
+    const auto destination{dir.filePath(QString::fromUtf8("destination"))};
+
+    for (const qint64 size : {256LL * 1024 * 1024, 2304LL * 1024 * 1024})
+    {
+        writeFile(source, size);
+        for (const qint64 differentByte : {-1LL, 0LL, size - 1})
+        {
+            writeFile(destination, size, differentByte);
+            QElapsedTimer timer;
+            timer.start();
+            const bool differs{Utilities::fileContentsDiffer(source, destination)};
+            WARN(QString::fromUtf8("%1 MB, difference at %2: %3 ms")
+                 .arg(size / (1024 * 1024)).arg(differentByte).arg(timer.elapsed()).toStdString());
+            CHECK(differs == (differentByte >= 0));
+        }
+    }
+}
@@ -0,0 +1,105 @@
+#include <catch.hpp>
+#include "EncryptedSettings.h"
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QTemporaryDir>
+
+namespace
+{
+QString str(const char *text)
+{
+    return QString::fromUtf8(text);
+}
+
+QByteArray fileContents(const QString &path)
+{
+    QFile file(path);
+    return file.open(QIODevice::ReadOnly) ? file.readAll() : QByteArray();
+}
+
+// Scheduled flushes are started from the event loop of this thread
+void processEventsFor(int ms)
+{
+    QElapsedTimer timer;
+    timer.start();
+    while (timer.elapsed() < ms)
+    {
+        QCoreApplication::processEvents(QEventLoop::AllEvents, 10);
+    }
+}
+}
+
+TEST_CASE("EncryptedSettings changes are read back from the file")
+{
+    QTemporaryDir dir;
+    REQUIRE(dir.isValid());
+    const QString file = dir.path() + str("/settings.cfg");
+
+    {
+        EncryptedSettings settings(file);
+        settings.setValue(str("top"), str("top value"));
+        settings.beginGroup(str("account"));
+        settings.setValue(str("email"), str("user@example.com"));
+        settings.setValue(str("stale"), str("first"));
+        settings.setValue(str("removedLater"), str("x"));
+        settings.beginGroup(str("sync"));
+        settings.setValue(str("path"), str("/home/user/MEGA"));
+        settings.endGroup();
+        settings.beginGroup(str("removedGroup"));
+        settings.setValue(str("key"), str("value"));
+        settings.endGroup();
+        settings.setValue(str("neverWritten"), str("y"));
+        settings.remove(str("neverWritten"));
+        settings.endGroup();
+        settings.flush();
+
+        // The first flush wrote these, they are removed from the file
+        settings.beginGroup(str("account"));
+        settings.setValue(str("stale"), str("second"));
+        settings.remove(str("removedLater"));
+        settings.remove(str("removedGroup"));
+        settings.endGroup();
+        settings.flush();
+    }
+
+    const QByteArray contents = fileContents(file);
+    REQUIRE_FALSE(contents.isEmpty());
+    REQUIRE_FALSE(contents.contains("user@example.com"));
+    REQUIRE_FALSE(contents.contains("/home/user/MEGA"));
+
+    EncryptedSettings settings(file);
+    REQUIRE(settings.value(str("top")).toString() == str("top value"));
+    REQUIRE(settings.containsGroup(str("account")));
+    settings.beginGroup(str("account"));
+    REQUIRE(settings.value(str("email")).toString() == str("user@example.com"));
+    REQUIRE(settings.value(str("stale")).toString() == str("second"));
+    REQUIRE_FALSE(settings.value(str("removedLater")).isValid());
+    REQUIRE_FALSE(settings.value(str("neverWritten")).isValid());
+    REQUIRE(settings.value(str("neverWritten"), str("default")).toString() == str("default"));
+    REQUIRE(settings.containsGroup(str("sync")));
+    REQUIRE_FALSE(settings.containsGroup(str("removedGroup")));
+    settings.beginGroup(str("sync"));
+    REQUIRE(settings.value(str("path")).toString() == str("/home/user/MEGA"));
+    settings.endGroup();
+    settings.endGroup();
+}
+
+TEST_CASE("A scheduled EncryptedSettings flush that runs after its instance is destroyed")
+{
+    QTemporaryDir dir;
+    REQUIRE(dir.isValid());
+    const QString file = dir.path() + str("/settings.cfg");
+
+    // The change schedules a flush, but the destructor writes it first
+    EncryptedSettings *settings = new EncryptedSettings(file);
+    settings->setValue(str("key"), str("value"));
+    delete settings;
+
+    // The scheduled flush finds the instance gone and does nothing
+    processEventsFor(EncryptedSettings::FLUSH_DELAY_MS + 500);
+
+    EncryptedSettings reader(file);
+    REQUIRE(reader.value(str("key")).toString() == str("value"));
+}
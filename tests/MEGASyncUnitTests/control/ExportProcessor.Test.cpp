@@ -0,0 +1,141 @@
+#include <catch.hpp>
+#include <trompeloeil.hpp>
+#include "ExportProcessor.h"
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QSignalSpy>
+
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace
+{
+class MegaApiMock : public mega::MegaApi
+{
+public:
+    MegaApiMock():mega::MegaApi("appKey"){};
+    MAKE_MOCK1(getSyncedNode, mega::MegaNode*(std::string* path), override);
+    MAKE_MOCK1(getFingerprint, char*(const char* filePath), override);
+    MAKE_MOCK1(getNodeByFingerprint, mega::MegaNode*(const char* fingerprint), override);
+    MAKE_MOCK2(exportNode, void(mega::MegaNode* node, mega::MegaRequestListener* listener), override);
+};
+
+class FakeNode : public mega::MegaNode
+{
+public:
+    explicit FakeNode(mega::MegaHandle handle) : mHandle(handle) {}
+    mega::MegaNode *copy() override { return new FakeNode(mHandle); }
+    mega::MegaHandle getHandle() override { return mHandle; }
+
+private:
+    mega::MegaHandle mHandle;
+};
+
+class ExportRequest : public mega::MegaRequest
+{
+public:
+    ExportRequest(mega::MegaHandle handle, const std::string& link) : mHandle(handle), mLink(link) {}
+    int getType() const override { return TYPE_EXPORT; }
+    mega::MegaHandle getNodeHandle() const override { return mHandle; }
+    const char* getLink() const override { return mLink.c_str(); }
+
+private:
+    mega::MegaHandle mHandle;
+    std::string mLink;
+};
+
+class RequestError : public mega::MegaError
+{
+public:
+    explicit RequestError(int errorCode) : mega::MegaError(errorCode) {}
+};
+
+// The fake fingerprint of a file is its path, and its node handle is the number the path ends with
+char *fingerprint(const char *path)
+{
+    char *copy = new char[strlen(path) + 1];
+    strcpy(copy, path);
+    return copy;
+}
+
+mega::MegaNode *nodeFor(const char *path)
+{
+    return new FakeNode(100 + std::atoi(strrchr(path, '/') + 1));
+}
+
+std::string linkFor(mega::MegaHandle handle)
+{
+    return "https://mega.nz/file/" + std::to_string(handle);
+}
+
+// Fingerprints are computed by a worker and exported from this thread
+bool waitFor(const std::function<bool()>& condition, int timeoutMs = 5000)
+{
+    QElapsedTimer timer;
+    timer.start();
+    while (!condition())
+    {
+        if (timer.elapsed() > timeoutMs)
+        {
+            return false;
+        }
+        QCoreApplication::processEvents(QEventLoop::AllEvents, 10);
+    }
+    return true;
+}
+}
+
+TEST_CASE("Exported links keep the order of the selection")
+{
+    MegaApiMock api;
+    ALLOW_CALL(api, getSyncedNode(trompeloeil::_))
+        .RETURN(_1->find("/synced/") != std::string::npos ? nodeFor(_1->c_str()) : nullptr);
+    ALLOW_CALL(api, getFingerprint(trompeloeil::_))
+        .RETURN(fingerprint(_1));
+    ALLOW_CALL(api, getNodeByFingerprint(trompeloeil::_))
+        .RETURN(strstr(_1, "missing") ? nullptr : nodeFor(_1));
+    std::vector<mega::MegaHandle> exported;
+    ALLOW_CALL(api, exportNode(trompeloeil::_, trompeloeil::_))
+        .LR_SIDE_EFFECT(exported.push_back(_1->getHandle()));
+
+    // Synced files are exported first; the last file has the same contents as the one before it,
+    // the export of the fourth one fails and the fifth one was never uploaded
+    QStringList files;
+    files << QString::fromUtf8("/synced/0")
+          << QString::fromUtf8("/local/1")
+          << QString::fromUtf8("/synced/2")
+          << QString::fromUtf8("/local/3")
+          << QString::fromUtf8("/local/missing")
+          << QString::fromUtf8("/local/5")
+          << QString::fromUtf8("/local/copy/5");
+    REQUIRE(files.size() > ExportProcessor::MAX_PARALLEL_FINGERPRINTS);
+
+    ExportProcessor processor(&api, files);
+    QSignalSpy finished(&processor, SIGNAL(onRequestLinksFinished()));
+    processor.requestLinks();
+    REQUIRE(exported.size() == 2);
+    REQUIRE(waitFor([&]() { return exported.size() == 6; }));
+
+    // Answers in reverse order
+    while (!exported.empty())
+    {
+        REQUIRE(finished.count() == 0);
+        mega::MegaHandle handle = exported.back();
+        exported.pop_back();
+        ExportRequest request(handle, linkFor(handle));
+        RequestError error(handle == 103 ? mega::MegaError::API_EACCESS : mega::MegaError::API_OK);
+        processor.onRequestFinish(&api, &request, &error);
+    }
+
+    REQUIRE(finished.count() == 1);
+    QStringList expected;
+    for (mega::MegaHandle handle : {100, 101, 102, 105, 105})
+    {
+        expected.append(QString::fromStdString(linkFor(handle)));
+    }
+    REQUIRE(processor.getValidLinks() == expected);
+}
@@ -0,0 +1,94 @@
+#include <catch.hpp>
+#include "FinishedTransferHistory.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace
+{
+class FakeTransfer : public mega::MegaTransfer
+{
+public:
+    FakeTransfer(int tag, int state) : mTag(tag), mState(state), mPath("/tmp/file" + std::to_string(tag)) {}
+    mega::MegaTransfer* copy() override { return new FakeTransfer(mTag, mState); }
+    int getTag() const override { return mTag; }
+    int getState() const override { return mState; }
+    const char* getPath() const override { return mPath.c_str(); }
+
+private:
+    int mTag;
+    int mState;
+    std::string mPath;
+};
+
+void add(FinishedTransferHistory& history, int tag, int state = mega::MegaTransfer::STATE_COMPLETED)
+{
+    FakeTransfer transfer(tag, state);
+    history.add(&transfer);
+}
+
+std::vector<int> tags(const FinishedTransferHistory& history)
+{
+    std::vector<int> result;
+    for (mega::MegaTransfer* transfer : history.getTransfers())
+    {
+        result.push_back(transfer->getTag());
+        delete transfer;
+    }
+    return result;
+}
+}
+
+TEST_CASE("Keep the latest finished transfers in a ring")
+{
+    FinishedTransferHistory history;
+    history.setCapacity(4);
+    for (int tag = 1; tag <= 4; tag++)
+    {
+        add(history, tag);
+    }
+
+    SECTION("The oldest transfer is evicted when full")
+    {
+        FakeTransfer transfer(5, mega::MegaTransfer::STATE_COMPLETED);
+        REQUIRE(history.add(&transfer) == 1);
+        REQUIRE(tags(history) == std::vector<int>({2, 3, 4, 5}));
+        REQUIRE_FALSE(history.contains(1));
+    }
+
+    SECTION("Removed transfers free their slot without evicting others")
+    {
+        REQUIRE(history.remove(2));
+        REQUIRE_FALSE(history.remove(2));
+        FakeTransfer transfer(5, mega::MegaTransfer::STATE_COMPLETED);
+        REQUIRE(history.add(&transfer) == -1);
+        REQUIRE(tags(history) == std::vector<int>({1, 3, 4, 5}));
+
+        add(history, 6);
+        REQUIRE(tags(history) == std::vector<int>({3, 4, 5, 6}));
+        REQUIRE(history.size() == 4);
+    }
+
+    SECTION("Completed transfers are records, failed ones keep the copy")
+    {
+        add(history, 5, mega::MegaTransfer::STATE_FAILED);
+        std::unique_ptr<mega::MegaTransfer> completed(history.getTransfer(4));
+        REQUIRE(completed->getState() == mega::MegaTransfer::STATE_COMPLETED);
+        REQUIRE(std::string(completed->getPath()) == "/tmp/file4");
+        std::unique_ptr<mega::MegaTransfer> failed(history.getTransfer(5));
+        REQUIRE(failed->getState() == mega::MegaTransfer::STATE_FAILED);
+        REQUIRE(history.getStats().transferCopies == 1);
+        REQUIRE(history.getStats().records == 4);
+        REQUIRE(history.getTransfer(1) == nullptr);
+    }
+
+    SECTION("Clear")
+    {
+        history.clear();
+        REQUIRE(history.size() == 0);
+        REQUIRE(tags(history).empty());
+        add(history, 7);
+        REQUIRE(tags(history) == std::vector<int>({7}));
+    }
+}
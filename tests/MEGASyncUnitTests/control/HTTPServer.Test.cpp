@@ -0,0 +1,193 @@
+#include <catch.hpp>
+#include "HTTPServer.h"
+#include "Preferences.h"
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QTcpSocket>
+
+#include <functional>
+
+namespace
+{
+// Restores a setting when the test ends, even if a REQUIRE fails
+class ScopedSetting
+{
+public:
+    ScopedSetting(int& setting, int value) : mSetting(setting), mPrevious(setting) { mSetting = value; }
+    ~ScopedSetting() { mSetting = mPrevious; }
+
+private:
+    int& mSetting;
+    const int mPrevious;
+};
+
+// The server and the client run in this thread, so events are processed while waiting
+bool waitFor(const std::function<bool()>& condition, int timeoutMs = 5000)
+{
+    QElapsedTimer timer;
+    timer.start();
+    while (!condition())
+    {
+        if (timer.elapsed() > timeoutMs)
+        {
+            return false;
+        }
+        QCoreApplication::processEvents(QEventLoop::AllEvents, 10);
+    }
+    return true;
+}
+
+QByteArray postRequest(const QByteArray& body, const char* version = "HTTP/1.1", const char* extraHeaders = "")
+{
+    return QByteArray("POST / ") + version + "\r\n"
+            + "Origin: " + Preferences::BASE_URL.toUtf8() + "\r\n"
+            + extraHeaders
+            + "Content-Length: " + QByteArray::number(body.size()) + "\r\n"
+            + "\r\n"
+            + body;
+}
+
+QByteArray stateCommand(mega::MegaHandle handle)
+{
+    char* base64Handle = mega::MegaApi::handleToBase64(handle);
+    QByteArray command = QByteArray("{\"a\":\"t\",\"h\":\"") + base64Handle + "\"}";
+    delete [] base64Handle;
+    return command;
+}
+
+QByteArray transferEvent(mega::MegaHandle handle)
+{
+    char* base64Handle = mega::MegaApi::handleToBase64(handle);
+    QByteArray event = QByteArray("event: t\ndata: {\"h\":\"") + base64Handle + "\"";
+    delete [] base64Handle;
+    return event;
+}
+
+struct Client
+{
+    QTcpSocket socket;
+    QByteArray received;
+
+    bool connect(const HTTPServer& server)
+    {
+        socket.connectToHost(QHostAddress::LocalHost, server.serverPort());
+        return waitFor([this]() { return socket.state() == QAbstractSocket::ConnectedState; });
+    }
+
+    bool waitForResponses(int count)
+    {
+        return waitFor([this, count]()
+        {
+            received += socket.readAll();
+            return received.count("HTTP/1.") >= count;
+        });
+    }
+
+    bool waitForText(const QByteArray& text, int timeoutMs = 5000)
+    {
+        return waitFor([this, &text]()
+        {
+            received += socket.readAll();
+            return received.contains(text);
+        }, timeoutMs);
+    }
+
+    bool waitForDisconnection()
+    {
+        return waitFor([this]() { return socket.state() == QAbstractSocket::UnconnectedState; });
+    }
+};
+}
+
+TEST_CASE("Webclient requests on persistent connections")
+{
+    mega::MegaApi api("appKey");
+    HTTPServer server(&api, 0, false);
+    REQUIRE(server.isListening());
+
+    const mega::MegaHandle handle = 0x1001;
+    HTTPServer::trackTransfer(handle);
+
+    Client client;
+    REQUIRE(client.connect(server));
+
+    SECTION("Pipelined requests are answered in order on the same connection")
+    {
+        client.socket.write(postRequest(stateCommand(handle)) + postRequest("{\"a\":\"x\"}"));
+        REQUIRE(client.waitForResponses(2));
+
+        const int state = client.received.indexOf("{\"s\":0}");
+        const int error = client.received.indexOf(QByteArray::number(mega::MegaError::API_EARGS));
+        REQUIRE(state > 0);
+        REQUIRE(error > state);
+        REQUIRE(client.received.count("Connection: keep-alive") == 2);
+        REQUIRE(client.socket.state() == QAbstractSocket::ConnectedState);
+    }
+
+    SECTION("A request split across reads is completed by the carried over data")
+    {
+        // The second request starts in the same write as the first one and ends in a later one
+        QByteArray second = postRequest(stateCommand(handle));
+        const int split = second.indexOf("\r\n\r\n") - 2;
+        client.socket.write(postRequest("{\"a\":\"x\"}") + second.left(split));
+        REQUIRE(client.waitForResponses(1));
+        REQUIRE_FALSE(client.received.contains("{\"s\":0}"));
+
+        client.socket.write(second.mid(split));
+        REQUIRE(client.waitForResponses(2));
+        REQUIRE(client.received.contains("{\"s\":0}"));
+        REQUIRE(client.socket.state() == QAbstractSocket::ConnectedState);
+    }
+
+    SECTION("Connection: close ends an HTTP/1.1 connection")
+    {
+        client.socket.write(postRequest(stateCommand(handle), "HTTP/1.1", "Connection: close\r\n"));
+        REQUIRE(client.waitForResponses(1));
+        REQUIRE(client.received.startsWith("HTTP/1.0 200 Ok"));
+        REQUIRE(client.waitForDisconnection());
+    }
+
+    SECTION("HTTP/1.0 connections are kept only if asked")
+    {
+        client.socket.write(postRequest(stateCommand(handle), "HTTP/1.0", "Connection: keep-alive\r\n"));
+        REQUIRE(client.waitForResponses(1));
+        REQUIRE(client.received.contains("Connection: keep-alive"));
+
+        client.socket.write(postRequest(stateCommand(handle), "HTTP/1.0"));
+        REQUIRE(client.waitForResponses(2));
+        REQUIRE(client.waitForDisconnection());
+    }
+}
+
+TEST_CASE("Transfer updates are pushed only for changed transfers")
+{
+    ScopedSetting pushInterval(Preferences::WEBCLIENT_PUSH_INTERVAL_MS, 10);
+
+    mega::MegaApi api("appKey");
+    HTTPServer server(&api, 0, false);
+    REQUIRE(server.isListening());
+
+    const mega::MegaHandle changed = 0x2001;
+    const mega::MegaHandle unchanged = 0x2002;
+    HTTPServer::trackTransfer(changed);
+    HTTPServer::trackTransfer(unchanged);
+
+    Client client;
+    REQUIRE(client.connect(server));
+    client.socket.write(QByteArray("GET /events HTTP/1.1\r\nOrigin: ") + Preferences::BASE_URL.toUtf8() + "\r\n\r\n");
+
+    // The first update has every tracked transfer
+    REQUIRE(client.waitForText(transferEvent(unchanged)));
+    REQUIRE(client.received.contains(transferEvent(changed)));
+    client.received.clear();
+
+    // Ticks without changes send nothing until the heartbeat is due
+    REQUIRE_FALSE(client.waitForText("event:", 10 * Preferences::WEBCLIENT_PUSH_INTERVAL_MS));
+    REQUIRE(client.received.isEmpty());
+
+    HTTPServer::onTransferDataUpdate(changed, mega::MegaTransfer::STATE_ACTIVE, 10, 100, 5, QString());
+    REQUIRE(client.waitForText(transferEvent(changed)));
+    REQUIRE(client.received.contains("\"s\":2,\"p\":10,\"t\":100,\"v\":5"));
+    REQUIRE_FALSE(client.received.contains(transferEvent(unchanged)));
+}
@@ -0,0 +1,130 @@
+#include <catch.hpp>
+#include "HTTPServer.h"
+#include "JsonTokenizer.h"
+
+#include <QElapsedTimer>
+
+#include <random>
+#include <sstream>
+
+namespace
+{
+QByteArray downloadCommand(int nodes)
+{
+    QByteArray json("{\"a\":\"d\",\"esid\":\"session\",\"f\":[");
+    for (int i = 0; i < nodes; ++i)
+    {
+        json += i ? "," : "";
+        json += "{\"t\":0,\"h\":\"AAAAAAAA\",\"p\":\"BBBBBBBB\",\"n\":\"bmFtZQ\","
+                "\"k\":\"AAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAA\",\"s\":" + QByteArray::number(i) + ",\"ts\":1600000000}";
+    }
+    json += "]}";
+    return json;
+}
+}
+
+TEST_CASE("Parse webclient commands")
+{
+    SECTION("Download command")
+    {
+        WebCommand command;
+        REQUIRE(command.parse(downloadCommand(3)));
+        REQUIRE(command.string("a") == QString::fromUtf8("d"));
+        REQUIRE(command.string("esid") == QString::fromUtf8("session"));
+        REQUIRE(command.string("en").isEmpty());
+        REQUIRE(command.hasFiles);
+        REQUIRE(command.files.size() == 3);
+        REQUIRE(command.files[2].size == 2);
+        REQUIRE(command.files[2].mtime == 1600000000);
+        REQUIRE(command.files[2].key.size == 43);
+        REQUIRE(command.files[2].name.toString() == QString::fromUtf8("bmFtZQ"));
+    }
+
+    SECTION("Escaped strings and nested values")
+    {
+        WebCommand command;
+        REQUIRE(command.parse(QByteArray("{\"a\":\"sf\",\"x\":{\"h\":\"inner\"},\"h\":\"a\\\"b\\u0063\",\"t\":-3}")));
+        REQUIRE(command.string("h") == QString::fromUtf8("a\"bc"));
+        REQUIRE(command.number("t") == -3);
+        REQUIRE(command.number("missing") == 0);
+    }
+
+    SECTION("Malformed commands")
+    {
+        WebCommand command;
+        REQUIRE_FALSE(command.parse(QByteArray("{\"a\":\"d\",\"f\":[{\"t\":0")));
+        REQUIRE_FALSE(WebCommand().parse(QByteArray("{\"a\":\"v")));
+        REQUIRE_FALSE(WebCommand().parse(QByteArray("[]")));
+        REQUIRE_FALSE(WebCommand().parse(QByteArray("{\"a\":nope}")));
+    }
+}
+
+TEST_CASE("Fuzz webclient commands", "[fuzz]")
+{
+    const QByteArray valid = downloadCommand(4);
+    const char alphabet[] = "{}[]\",:\\u0-9ae";
+    std::mt19937 random(12345);
+
+    for (int i = 0; i < 20000; ++i)
+    {
+        QByteArray json = valid;
+        const int mutations = 1 + int(random() % 4);
+        for (int m = 0; m < mutations; ++m)
+        {
+            const int position = int(random() % unsigned(json.size() + 1));
+            switch (random() % 3)
+            {
+                case 0: if (position < json.size()) json[position] = char(random()); break;
+                case 1: json.insert(position, alphabet[random() % (sizeof(alphabet) - 1)]); break;
+                default: json.truncate(position); break;
+            }
+        }
+
+        // Must terminate without reading outside the buffer, and tokens must point into it
+        WebCommand command;
+        command.parse(json);
+        for (const WebDownloadNode& node : command.files)
+        {
+            REQUIRE((!node.name.size || (node.name.data >= json.constData()
+                                         && node.name.data + node.name.size <= json.constData() + json.size())));
+        }
+    }
+}
+
+// Not run by default: tagged hidden, run with "[benchmark]"
+TEST_CASE("Parse a webclient download of 10k nodes", "[.][benchmark]")
+{
+    const QByteArray json = downloadCommand(10000);
+
+    QElapsedTimer timer;
+    timer.start();
+    WebCommand command;
+    REQUIRE(command.parse(json));
+    const qint64 tokenizerMs = timer.elapsed();
+    REQUIRE(command.files.size() == 10000);
+
+    // Previous approach: text search of each field on a copy of each node object
+    timer.restart();
+    QString data = QString::fromUtf8(json);
+    int start = data.indexOf(QString::fromUtf8("\"f\":[")) + 5;
+    long long total = 0;
+    while (data[start] == QChar::fromAscii('{'))
+    {
+        int end = data.indexOf(QChar::fromAscii('}'), start) + 1;
+        QString file = data.mid(start, end - start);
+        start = end + 1;
+        total += Utilities::extractJSONNumber(file, QString::fromUtf8("t"));
+        total += Utilities::extractJSONString(file, QString::fromUtf8("h")).size();
+        total += Utilities::extractJSONString(file, QString::fromUtf8("n")).size();
+        total += Utilities::extractJSONString(file, QString::fromUtf8("p")).size();
+        total += Utilities::extractJSONString(file, QString::fromUtf8("k")).size();
+        total += Utilities::extractJSONNumber(file, QString::fromUtf8("s"));
+        total += Utilities::extractJSONNumber(file, QString::fromUtf8("ts"));
+    }
+    const qint64 extractMs = timer.elapsed();
+    REQUIRE(total > 0);
+
+    std::ostringstream result;
+    result << "10k nodes: tokenizer " << tokenizerMs << " ms, field search " << extractMs << " ms";
+    WARN(result.str());
+}
@@ -0,0 +1,223 @@
+#include <catch.hpp>
+#include <trompeloeil.hpp>
+#include "LinkProcessor.h"
+#include "Preferences.h"
+
+#include <QSignalSpy>
+#include <QTemporaryDir>
+
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace
+{
+class MegaApiMock : public mega::MegaApi
+{
+public:
+    MegaApiMock():mega::MegaApi("appKey"){};
+    MAKE_MOCK2(getPublicNode, void(const char* megaFileLink, mega::MegaRequestListener *listener), override);
+    MAKE_MOCK0(getAccountAuth, char*(), override);
+    MAKE_MOCK2(loginToFolder, void(const char* megaFolderLink, mega::MegaRequestListener *listener), override);
+    MAKE_MOCK1(fetchNodes, void(mega::MegaRequestListener *listener), override);
+    MAKE_MOCK0(getRootNode, mega::MegaNode*(), override);
+    MAKE_MOCK1(authorizeNode, mega::MegaNode*(mega::MegaNode* node), override);
+};
+
+class PublicNode : public mega::MegaNode
+{
+public:
+    mega::MegaNode* copy() override { return new PublicNode(); }
+};
+
+class PublicNodeRequest : public mega::MegaRequest
+{
+public:
+    PublicNodeRequest(const std::string& link, mega::MegaNode* node) : mLink(link), mNode(node) {}
+    int getType() const override { return TYPE_GET_PUBLIC_NODE; }
+    const char* getLink() const override { return mLink.c_str(); }
+    mega::MegaNode* getPublicMegaNode() const override { return mNode ? mNode->copy() : nullptr; }
+
+private:
+    std::string mLink;
+    mega::MegaNode* mNode;
+};
+
+class FolderRequest : public mega::MegaRequest
+{
+public:
+    FolderRequest(int type, const std::string& link) : mType(type), mLink(link) {}
+    int getType() const override { return mType; }
+    const char* getLink() const override { return mLink.c_str(); }
+
+private:
+    int mType;
+    std::string mLink;
+};
+
+class RequestError : public mega::MegaError
+{
+public:
+    explicit RequestError(int errorCode) : mega::MegaError(errorCode) {}
+};
+}
+
+TEST_CASE("Resolve file links with several requests in flight")
+{
+    MegaApiMock api;
+    PublicNode node;
+
+    // The last two links are the same link pasted twice
+    QStringList links;
+    const int count = LinkProcessor::MAX_FILE_LINK_REQUESTS + 4;
+    for (int i = 0; i < count - 1; i++)
+    {
+        links.append(Preferences::BASE_URL + QString::fromUtf8("/file/link%1#key").arg(i));
+    }
+    links.append(links.last());
+
+    std::vector<std::string> requested;
+    ALLOW_CALL(api, getPublicNode(trompeloeil::_, trompeloeil::_))
+        .LR_SIDE_EFFECT(requested.push_back(_1));
+
+    LinkProcessor processor(links, &api, []()
+    {
+        return QList<mega::MegaApi *>();
+    });
+    QSignalSpy available(&processor, SIGNAL(onLinkInfoAvailable(int)));
+    QSignalSpy finished(&processor, SIGNAL(onLinkInfoRequestFinish()));
+
+    processor.requestLinkInfo();
+    REQUIRE(requested.size() == static_cast<size_t>(LinkProcessor::MAX_FILE_LINK_REQUESTS));
+
+    // Answers in reverse order: each one frees a slot for the next pending link
+    int answered = 0;
+    while (answered < count)
+    {
+        std::string link = requested.back();
+        requested.pop_back();
+        bool fails = link.find("link3#") != std::string::npos;
+        PublicNodeRequest request(link, fails ? nullptr : &node);
+        RequestError error(fails ? mega::MegaError::API_ENOENT : mega::MegaError::API_OK);
+        processor.onRequestFinish(&api, &request, &error);
+        answered++;
+
+        // Stable indices: the reported link is the one that was answered
+        int id = available.takeFirst().at(0).toInt();
+        REQUIRE(processor.getLink(id).toStdString() == link);
+        REQUIRE(processor.isLinkInfoAvailable(id));
+        REQUIRE((processor.getNode(id) != nullptr) == !fails);
+        REQUIRE(processor.getError(id) == (fails ? mega::MegaError::API_ENOENT : mega::MegaError::API_OK));
+        REQUIRE(requested.size() <= static_cast<size_t>(LinkProcessor::MAX_FILE_LINK_REQUESTS));
+    }
+
+    REQUIRE(requested.empty());
+    REQUIRE(processor.getCurrentIndex() == count);
+    REQUIRE(finished.size() == 1);
+    for (int i = 0; i < count; i++)
+    {
+        REQUIRE(processor.isLinkInfoAvailable(i));
+    }
+}
+
+TEST_CASE("Resolve folder links with the folder API instances")
+{
+    // Resolved folder links are stored as the last public handle of the account
+    QTemporaryDir dataPath;
+    REQUIRE(dataPath.isValid());
+    Preferences* preferences = Preferences::instance();
+    preferences->initialize(dataPath.path());
+    preferences->setEmail(QString::fromUtf8("links@mega.nz"));
+
+    MegaApiMock api;
+    ALLOW_CALL(api, getAccountAuth())
+        .RETURN(nullptr);
+
+    // Logins in flight, in the order they were started. The expectations outlive the loop that sets
+    // them, so they copy the instance and reach the recorded calls through a pointer
+    std::vector<std::pair<mega::MegaApi*, std::string>> logins;
+    std::vector<mega::MegaApi*> fetches;
+    auto *loginsStarted = &logins;
+    auto *fetchesStarted = &fetches;
+    std::vector<std::unique_ptr<MegaApiMock>> folderApis;
+    std::vector<std::unique_ptr<trompeloeil::expectation>> expectations;
+    QList<mega::MegaApi *> folderApiList;
+    for (int i = 0; i < LinkProcessor::FOLDER_API_POOL_SIZE; i++)
+    {
+        folderApis.emplace_back(new MegaApiMock());
+        MegaApiMock *folderApi = folderApis.back().get();
+        folderApiList.append(folderApi);
+        expectations.emplace_back(NAMED_ALLOW_CALL(*folderApi, loginToFolder(trompeloeil::_, trompeloeil::_))
+            .SIDE_EFFECT(loginsStarted->emplace_back(folderApi, _1)));
+        expectations.emplace_back(NAMED_ALLOW_CALL(*folderApi, fetchNodes(trompeloeil::_))
+            .SIDE_EFFECT(fetchesStarted->push_back(folderApi)));
+        expectations.emplace_back(NAMED_ALLOW_CALL(*folderApi, getRootNode())
+            .RETURN(new PublicNode()));
+        expectations.emplace_back(NAMED_ALLOW_CALL(*folderApi, authorizeNode(trompeloeil::_))
+            .RETURN(_1 ? _1->copy() : nullptr));
+    }
+
+    // More distinct links than instances; the first link is pasted again at the end
+    QStringList links;
+    const int distinct = LinkProcessor::FOLDER_API_POOL_SIZE + 3;
+    for (int i = 0; i < distinct; i++)
+    {
+        links.append(Preferences::BASE_URL + QString::fromUtf8("/folder/link%1#key").arg(i));
+    }
+    links.append(links.first());
+
+    int providerCalls = 0;
+    LinkProcessor processor(links, &api, [&]()
+    {
+        providerCalls++;
+        return folderApiList;
+    });
+    QSignalSpy available(&processor, SIGNAL(onLinkInfoAvailable(int)));
+    QSignalSpy finished(&processor, SIGNAL(onLinkInfoRequestFinish()));
+
+    processor.requestLinkInfo();
+    REQUIRE(providerCalls == 1);
+    REQUIRE(logins.size() == static_cast<size_t>(LinkProcessor::FOLDER_API_POOL_SIZE));
+
+    // Each finished link frees its instance for the next pending one
+    std::set<std::string> loggedIn;
+    while (!logins.empty())
+    {
+        REQUIRE(logins.size() <= static_cast<size_t>(LinkProcessor::FOLDER_API_POOL_SIZE));
+        mega::MegaApi *folderApi = logins.front().first;
+        std::string link = logins.front().second;
+        logins.erase(logins.begin());
+        REQUIRE(loggedIn.insert(link).second);
+
+        bool fails = link.find("link2#") != std::string::npos;
+        FolderRequest login(mega::MegaRequest::TYPE_LOGIN, link);
+        RequestError loginError(fails ? mega::MegaError::API_ENOENT : mega::MegaError::API_OK);
+        processor.onRequestFinish(folderApi, &login, &loginError);
+        if (!fails)
+        {
+            REQUIRE(fetches.size() == 1);
+            REQUIRE(fetches.back() == folderApi);
+            fetches.clear();
+            FolderRequest fetch(mega::MegaRequest::TYPE_FETCH_NODES, link);
+            RequestError fetchError(mega::MegaError::API_OK);
+            processor.onRequestFinish(folderApi, &fetch, &fetchError);
+        }
+    }
+
+    // One login per distinct link, its result is given to every index with that link
+    REQUIRE(loggedIn.size() == static_cast<size_t>(distinct));
+    REQUIRE(available.size() == links.size());
+    REQUIRE(finished.size() == 1);
+    REQUIRE(processor.getCurrentIndex() == links.size());
+    for (int i = 0; i < links.size(); i++)
+    {
+        bool fails = (i == 2);
+        REQUIRE(processor.isLinkInfoAvailable(i));
+        REQUIRE((processor.getNode(i) != nullptr) == !fails);
+        REQUIRE(processor.getError(i) == (fails ? mega::MegaError::API_ENOENT : mega::MegaError::API_OK));
+    }
+    REQUIRE(processor.getNode(0) != processor.getNode(distinct));
+
+    preferences->logout();
+}
@@ -0,0 +1,206 @@
+#include <catch.hpp>
+#include <trompeloeil.hpp>
+#include "MegaApplication.h"
+#include "MegaDownloader.h"
+
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QTemporaryDir>
+#include <QThread>
+#include <QTimer>
+
+#include <algorithm>
+#include <future>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+namespace
+{
+class MegaApiMock : public mega::MegaApi
+{
+public:
+    MegaApiMock():mega::MegaApi("appKey"){};
+    MAKE_MOCK4(startDownloadWithData, void(mega::MegaNode* node, const char* localPath, const char* appData, mega::MegaTransferListener* listener), override);
+};
+
+// A foreign "root" folder followed by its subfolders, each one followed by its files
+QQueue<WrappedNode *> foreignTree(mega::MegaApi *megaApi, int folders, int filesPerFolder, WrappedNode::TransferOrigin origin)
+{
+    QQueue<WrappedNode *> queue;
+    mega::MegaHandle root = 1;
+    queue.append(new WrappedNode(origin, megaApi->createForeignFolderNode(root, "root", mega::INVALID_HANDLE, "auth", nullptr)));
+    mega::MegaHandle nextHandle = root + 1;
+    for (int folder = 0; folder < folders - 1; ++folder)
+    {
+        mega::MegaHandle folderHandle = nextHandle++;
+        queue.append(new WrappedNode(origin, megaApi->createForeignFolderNode(folderHandle, QByteArray::number(folder).constData(), root, "auth", nullptr)));
+        for (int file = 0; file < filesPerFolder; ++file)
+        {
+            queue.append(new WrappedNode(origin, megaApi->createForeignFileNode(nextHandle++, "AAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAA",
+                                                                                 QByteArray::number(file).constData(), 1, 0,
+                                                                                 folderHandle, "auth", nullptr, nullptr)));
+        }
+    }
+    return queue;
+}
+}
+
+TEST_CASE("A queued batch downloads every node exactly once")
+{
+    MegaApiMock api;
+    QTemporaryDir destination;
+    REQUIRE(destination.isValid());
+
+    // Several chunks, with the files of some folders split between two of them
+    constexpr int folders{11};
+    constexpr int filesPerFolder{99};
+    QQueue<WrappedNode *> queue = foreignTree(&api, folders, filesPerFolder, WrappedNode::TransferOrigin::FROM_APP);
+    const int total = queue.size();
+
+    std::mutex downloadsMutex;
+    std::vector<mega::MegaHandle> downloads;
+    ALLOW_CALL(api, startDownloadWithData(trompeloeil::_, trompeloeil::_, trompeloeil::_, trompeloeil::_))
+        .LR_SIDE_EFFECT(std::lock_guard<std::mutex> lock(downloadsMutex); downloads.push_back(_1->getHandle()));
+
+    MegaApplication *app = static_cast<MegaApplication*>(qApp);
+    const unsigned long long appDataID = 0xD0C0B1ULL;
+    TransferMetaData *data = new TransferMetaData(mega::MegaTransfer::TYPE_DOWNLOAD, 1, total);
+    app->addTransferAppData(appDataID, data);
+
+    MegaDownloader downloader(&api);
+    // Connected as MegaApplication::initialize does
+    QObject::connect(&downloader, SIGNAL(downloadQueueProgress(unsigned long long, int, int)),
+                     app, SLOT(onDownloadQueueProgress(unsigned long long, int, int)), Qt::QueuedConnection);
+    QEventLoop loop;
+    QObject::connect(&downloader, &MegaDownloader::downloadQueueProgress, &loop,
+                     [&loop](unsigned long long, int processed, int queued)
+    {
+        if (processed == queued)
+        {
+            loop.quit();
+        }
+    }, Qt::QueuedConnection);
+    QTimer::singleShot(10000, &loop, &QEventLoop::quit);
+
+    REQUIRE(downloader.processDownloadQueue(&queue, destination.path(), appDataID));
+    REQUIRE(queue.isEmpty());
+    loop.exec();
+
+    std::vector<mega::MegaHandle> expected;
+    for (int folder = 0; folder < folders - 1; ++folder)
+    {
+        mega::MegaHandle firstFile = 3 + folder * (filesPerFolder + 1);
+        for (int file = 0; file < filesPerFolder; ++file)
+        {
+            expected.push_back(firstFile + file);
+        }
+    }
+    {
+        std::lock_guard<std::mutex> lock(downloadsMutex);
+        std::sort(downloads.begin(), downloads.end());
+        CHECK(downloads == expected);
+    }
+    CHECK(data->queuedDownloads == total);
+    CHECK(data->totalFolders == 1);
+    CHECK(QDir(destination.path() + QString::fromUtf8("/root/") + QString::number(folders - 2)).exists());
+
+    app->removeTransferAppData(appDataID);
+}
+
+TEST_CASE("Destroying the downloader in the middle of a batch")
+{
+    MegaApiMock api;
+    QTemporaryDir destination;
+    REQUIRE(destination.isValid());
+
+    QQueue<WrappedNode *> queue = foreignTree(&api, 11, 99, WrappedNode::TransferOrigin::FROM_APP);
+    const int total = queue.size();
+
+    // The first download blocks its chunk until the downloader is being destroyed
+    std::promise<void> started;
+    std::promise<void> release;
+    std::shared_future<void> released = release.get_future().share();
+    std::mutex downloadsMutex;
+    std::vector<mega::MegaHandle> downloads;
+    ALLOW_CALL(api, startDownloadWithData(trompeloeil::_, trompeloeil::_, trompeloeil::_, trompeloeil::_))
+        .LR_SIDE_EFFECT(
+            bool first;
+            {
+                std::lock_guard<std::mutex> lock(downloadsMutex);
+                first = downloads.empty();
+                downloads.push_back(_1->getHandle());
+            }
+            if (first)
+            {
+                started.set_value();
+                released.wait();
+            });
+
+    MegaDownloader *downloader = new MegaDownloader(&api);
+    REQUIRE(downloader->processDownloadQueue(&queue, destination.path(), 0));
+    started.get_future().wait();
+
+    // The destructor waits for the running chunk, and the chunks queued after it find it gone
+    std::thread destroyer([downloader]() { delete downloader; });
+    QThread::msleep(50);
+    release.set_value();
+    destroyer.join();
+
+    size_t afterDestruction;
+    {
+        std::lock_guard<std::mutex> lock(downloadsMutex);
+        afterDestruction = downloads.size();
+    }
+    QThread::msleep(200);
+    QCoreApplication::processEvents();
+
+    std::lock_guard<std::mutex> lock(downloadsMutex);
+    CHECK(downloads.size() == afterDestruction);
+    CHECK(downloads.size() < static_cast<size_t>(total));
+    std::sort(downloads.begin(), downloads.end());
+    CHECK(std::adjacent_find(downloads.begin(), downloads.end()) == downloads.end());
+}
+
+
+// Not run by default: tagged hidden, run with "[benchmark]"
+TEST_CASE("Queue 100k foreign nodes for download", "[.][benchmark]")
+{
+    // The application MegaApi isn't initialized in the test runner
+    mega::MegaApi api("appKey");
+    mega::MegaApi *megaApi = &api;
+    constexpr int folders{1000};
+    constexpr int filesPerFolder{99};
+
+    QTemporaryDir destination;
+    REQUIRE(destination.isValid());
+
+    QQueue<WrappedNode *> queue = foreignTree(megaApi, folders, filesPerFolder, WrappedNode::TransferOrigin::FROM_WEBSERVER);
+    const int total = queue.size();
+
+    MegaDownloader downloader(megaApi);
+    QEventLoop loop;
+    QObject::connect(&downloader, &MegaDownloader::downloadQueueProgress, &loop,
+                     [&loop](unsigned long long, int processed, int queued)
+    {
+        if (processed == queued)
+        {
+            loop.quit();
+        }
+    }, Qt::QueuedConnection);
+
+    QElapsedTimer timer;
+    timer.start();
+    REQUIRE(downloader.processDownloadQueue(&queue, destination.path(), 0));
+    const qint64 submitMs = timer.elapsed();
+    loop.exec();
+    const qint64 totalMs = timer.elapsed();
+    megaApi->cancelTransfers(mega::MegaTransfer::TYPE_DOWNLOAD);
+
+    std::ostringstream result;
+    result << total << " nodes: caller blocked " << submitMs << " ms, queued in " << totalMs << " ms";
+    WARN(result.str());
+    REQUIRE(queue.isEmpty());
+    REQUIRE(QDir(destination.path() + QString::fromUtf8("/root/998")).exists());
+}
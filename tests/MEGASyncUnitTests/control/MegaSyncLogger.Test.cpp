@@ -0,0 +1,181 @@
+#include <catch.hpp>
+#include "MegaApplication.h"
+#include "MegaSyncLogger.h"
+
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+void logLine(MegaSyncLogger& logger, int logLevel, const char* message)
+{
+    logger.log(nullptr, logLevel, nullptr, message
+#ifdef ENABLE_LOG_PERFORMANCE
+               , nullptr, nullptr, 0
+#endif
+               );
+}
+
+// Reads the lines of the application log containing text, once the line with endMarker is written
+bool readLoggedLines(const std::string& text, const std::string& endMarker, std::vector<std::string>& lines,
+                     std::chrono::milliseconds timeout = std::chrono::milliseconds(5000))
+{
+    const QString logPath = QDir(MegaApplication::applicationDataPath())
+            .filePath(LOGS_FOLDER_LEAFNAME_QSTRING + QString::fromUtf8("/MEGAsync.log"));
+    const auto deadline = std::chrono::steady_clock::now() + timeout;
+    do
+    {
+        lines.clear();
+        QFile file(logPath);
+        if (file.open(QIODevice::ReadOnly))
+        {
+            while (!file.atEnd())
+            {
+                const std::string line = file.readLine().toStdString();
+                if (line.find(endMarker) != std::string::npos)
+                {
+                    return true;
+                }
+                if (line.find(text) != std::string::npos)
+                {
+                    lines.push_back(line);
+                }
+            }
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    while (std::chrono::steady_clock::now() < deadline);
+    return false;
+}
+
+std::string uniqueTag(const char* name)
+{
+    return name + std::to_string(QDateTime::currentMSecsSinceEpoch());
+}
+}
+
+TEST_CASE("Lines logged from several threads are written in order")
+{
+    MegaSyncLogger& logger = static_cast<MegaApplication*>(qApp)->getLogger();
+    constexpr int threadCount{4};
+    constexpr int linesPerThread{2000};
+    const std::string tag = uniqueTag("logger order test ");
+
+    std::mutex orderMutex;
+    int nextLine{0};
+    std::vector<std::thread> threads;
+    for (int t = 0; t < threadCount; ++t)
+    {
+        threads.emplace_back([&logger, &tag, &orderMutex, &nextLine, t]()
+        {
+            char message[128];
+            for (int i = 0; i < linesPerThread; ++i)
+            {
+                // The lock fixes the order in which the lines are logged, each thread still uses its own ring
+                std::lock_guard<std::mutex> lock(orderMutex);
+                snprintf(message, sizeof(message), "%s: %d %d %d", tag.c_str(), nextLine++, t, i);
+                logLine(logger, mega::MegaApi::LOG_LEVEL_DEBUG, message);
+            }
+        });
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+
+    const std::string endMarker = tag + " end";
+    logLine(logger, mega::MegaApi::LOG_LEVEL_ERROR, endMarker.c_str());
+
+    std::vector<std::string> lines;
+    REQUIRE(readLoggedLines(tag + ":", endMarker, lines));
+    REQUIRE(lines.size() == static_cast<size_t>(threadCount * linesPerThread));
+
+    std::vector<int> nextPerThread(threadCount, 0);
+    for (size_t position = 0; position < lines.size(); ++position)
+    {
+        int line = -1;
+        int thread = -1;
+        int index = -1;
+        const std::string& text = lines[position];
+        REQUIRE(sscanf(text.c_str() + text.find(tag) + tag.size(), ": %d %d %d", &line, &thread, &index) == 3);
+        REQUIRE(line == static_cast<int>(position));
+        REQUIRE(index == nextPerThread[thread]++);
+    }
+}
+
+TEST_CASE("Error lines are written without waiting for the periodic flush")
+{
+    MegaSyncLogger& logger = static_cast<MegaApplication*>(qApp)->getLogger();
+    const std::string marker = uniqueTag("logger flush test ");
+
+    // Give the logging thread time to go back to sleep
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+    const auto start = std::chrono::steady_clock::now();
+    logLine(logger, mega::MegaApi::LOG_LEVEL_ERROR, marker.c_str());
+    std::vector<std::string> lines;
+    REQUIRE(readLoggedLines(marker, marker, lines));
+
+    // The logging thread wakes up by itself every 500 ms
+    REQUIRE(std::chrono::steady_clock::now() - start < std::chrono::milliseconds(400));
+}
+
+// Not run by default: tagged hidden, run with "[benchmark]"
+TEST_CASE("Per-line log latency with concurrent producer threads", "[.][benchmark]")
+{
+    MegaSyncLogger& logger = static_cast<MegaApplication*>(qApp)->getLogger();
+    constexpr int linesPerThread{20000};
+
+    for (const int producers : {1, 2, 4, 8})
+    {
+        std::atomic<long long> totalNs{0};
+        std::atomic<long long> maxNs{0};
+        std::vector<std::thread> threads;
+
+        for (int p = 0; p < producers; ++p)
+        {
+            threads.emplace_back([&logger, &totalNs, &maxNs, p]()
+            {
+                char message[64];
+                long long threadTotalNs{0};
+                long long threadMaxNs{0};
+                for (int i = 0; i < linesPerThread; ++i)
+                {
+                    snprintf(message, sizeof(message), "logger benchmark %d %d", p, i);
+                    const auto start = std::chrono::steady_clock::now();
+                    logLine(logger, mega::MegaApi::LOG_LEVEL_DEBUG, message);
+                    const auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+                    threadTotalNs += elapsed;
+                    threadMaxNs = std::max(threadMaxNs, static_cast<long long>(elapsed));
+                }
+                totalNs += threadTotalNs;
+                long long currentMax = maxNs;
+                while (threadMaxNs > currentMax && !maxNs.compare_exchange_weak(currentMax, threadMaxNs))
+                {
+                }
+            });
+        }
+
+        for (auto& thread : threads)
+        {
+            thread.join();
+        }
+
+        const double meanNs = static_cast<double>(totalNs) / (linesPerThread * producers);
+        std::ostringstream result;
+        result << producers << " producer threads: mean " << meanNs << " ns/line, max " << maxNs / 1000 << " us";
+        WARN(result.str());
+        REQUIRE(meanNs > 0);
+    }
+}
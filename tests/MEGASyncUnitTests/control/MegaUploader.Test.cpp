@@ -0,0 +1,98 @@
+#include <catch.hpp>
+#include <trompeloeil.hpp>
+#include "MegaApplication.h"
+#include "MegaUploader.h"
+
+#include <QSignalSpy>
+#include <QTemporaryDir>
+
+#include <utility>
+#include <vector>
+
+namespace
+{
+class MegaApiMock : public mega::MegaApi
+{
+public:
+    MegaApiMock():mega::MegaApi("appKey"){};
+    MAKE_MOCK2(isSyncable, bool(const char* path, long long size), override);
+    MAKE_MOCK2(getNodeByPath, mega::MegaNode*(const char* path, mega::MegaNode* n), override);
+};
+
+class FolderNode : public mega::MegaNode
+{
+public:
+    bool isFolder() override { return true; }
+    mega::MegaNode* copy() override { return new FolderNode(); }
+};
+}
+
+TEST_CASE("Local copy progress is written into the transfer metadata")
+{
+    MegaApiMock api;
+    ALLOW_CALL(api, isSyncable(trompeloeil::_, trompeloeil::_))
+        .RETURN(true);
+    // Every remote folder already exists, so no folder is created
+    ALLOW_CALL(api, getNodeByPath(trompeloeil::_, trompeloeil::_))
+        .RETURN(new FolderNode());
+
+    QTemporaryDir source;
+    QTemporaryDir destination;
+    REQUIRE(source.isValid());
+    REQUIRE(destination.isValid());
+
+    const int files = 300;
+    const QString srcPath = source.path() + QString::fromUtf8("/folder");
+    REQUIRE(QDir(srcPath).mkpath(QString::fromUtf8("sub")));
+    for (int i = 0; i < files; i++)
+    {
+        QFile file(srcPath + (i % 2 ? QString::fromUtf8("/sub") : QString()) + QString::fromUtf8("/file%1").arg(i));
+        REQUIRE(file.open(QIODevice::WriteOnly));
+        file.write(QByteArray::number(i));
+    }
+
+    MegaApplication *app = static_cast<MegaApplication*>(qApp);
+    const unsigned long long appDataID = 0x10C0B1ULL;
+    TransferMetaData *data = new TransferMetaData(mega::MegaTransfer::TYPE_UPLOAD, 1, 1);
+    app->addTransferAppData(appDataID, data);
+
+    // Connected as MegaApplication::initialize does; the second connection records the metadata after each update
+    MegaUploader uploader(&api);
+    QObject::connect(&uploader, SIGNAL(localCopyProgress(unsigned long long, int, int)),
+                     app, SLOT(onLocalCopyProgress(unsigned long long, int, int)), Qt::QueuedConnection);
+    std::vector<std::pair<int, int>> seen;
+    QObject::connect(&uploader, &MegaUploader::localCopyProgress, app, [&seen, data](unsigned long long, int, int)
+    {
+        seen.emplace_back(data->localFilesCopied, data->localFilesQueued);
+    }, Qt::QueuedConnection);
+    QSignalSpy finished(&uploader, SIGNAL(localCopyFinished(unsigned long long, bool, bool)));
+
+    const QString dstPath = destination.path() + QString::fromUtf8("/folder");
+    FolderNode parent;
+    REQUIRE(uploader.uploadRecursivelyIntoASyncedLocation(QFileInfo(srcPath), dstPath, &parent, appDataID));
+
+    // Updates are delivered in the application thread
+    CHECK(data->localFilesCopied == 0);
+    QCoreApplication::processEvents();
+
+    REQUIRE(!seen.empty());
+    for (size_t i = 0; i < seen.size(); i++)
+    {
+        CHECK(seen[i].first <= seen[i].second);
+        if (i)
+        {
+            CHECK(seen[i].first >= seen[i - 1].first);
+        }
+    }
+    CHECK(seen.back() == std::make_pair(files, files));
+    CHECK(data->localFilesCopied == files);
+    CHECK(data->localFilesQueued == files);
+
+    REQUIRE(finished.count() == 1);
+    CHECK(finished.at(0).at(0).toULongLong() == appDataID);
+    CHECK(finished.at(0).at(1).toBool());
+    CHECK(finished.at(0).at(2).toBool());
+    CHECK(QDir(dstPath + QString::fromUtf8("/sub")).entryList(QDir::Files).size() == files / 2);
+
+    app->removeTransferAppData(appDataID);
+}
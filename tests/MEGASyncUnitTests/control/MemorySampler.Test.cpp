@@ -0,0 +1,84 @@
+#include <catch.hpp>
+#include "MemorySampler.h"
+
+namespace
+{
+constexpr long long MINUTE_MS{60 * 1000};
+constexpr long long NODES{100000};
+
+MemorySampler::Usage anonymous(long long bytes)
+{
+    MemorySampler::Usage usage;
+    usage.residentBytes = bytes * 2;
+    usage.anonymousBytes = bytes;
+    return usage;
+}
+}
+
+TEST_CASE("Detect sustained memory growth per node")
+{
+    MemorySampler sampler;
+    const long long base = 200 * 1024 * 1024;
+
+    SECTION("Memory that follows the number of nodes is not a leak")
+    {
+        for (long long i = 0; i < MemorySampler::MAX_SAMPLES; i++)
+        {
+            long long nodes = NODES + i * 1000;
+            sampler.addSample(i * MINUTE_MS, anonymous(base / NODES * nodes), nodes);
+        }
+        REQUIRE(sampler.getGrowth() < 0.01);
+        REQUIRE_FALSE(sampler.isGrowing());
+    }
+
+    SECTION("Steady growth with the same nodes is flagged")
+    {
+        for (long long i = 0; i < MemorySampler::MAX_SAMPLES; i++)
+        {
+            // +1% per minute with some noise
+            long long noise = (i % 3) * 1024 * 1024;
+            sampler.addSample(i * MINUTE_MS, anonymous(base + i * base / 100 + noise), NODES);
+        }
+        REQUIRE(sampler.getGrowth() > MemorySampler::GROWTH_THRESHOLD);
+        REQUIRE(sampler.isGrowing());
+    }
+
+    SECTION("A single spike is not sustained growth")
+    {
+        for (long long i = 0; i < MemorySampler::MAX_SAMPLES; i++)
+        {
+            long long spike = i >= 50 && i < 55 ? base : 0;
+            sampler.addSample(i * MINUTE_MS, anonymous(base + spike), NODES);
+        }
+        REQUIRE_FALSE(sampler.isGrowing());
+    }
+
+    SECTION("Not enough samples")
+    {
+        for (long long i = 0; i < MemorySampler::MIN_TREND_SAMPLES - 1; i++)
+        {
+            sampler.addSample(i * MINUTE_MS, anonymous(base * (i + 1)), NODES);
+        }
+        REQUIRE_FALSE(sampler.isGrowing());
+    }
+
+    SECTION("The window keeps the latest samples")
+    {
+        for (long long i = 0; i < 2 * MemorySampler::MAX_SAMPLES; i++)
+        {
+            sampler.addSample(i * MINUTE_MS, anonymous(base), NODES);
+        }
+        REQUIRE(sampler.getSamples().size() == MemorySampler::MAX_SAMPLES);
+        REQUIRE(sampler.getSamples().front().timeMs == MemorySampler::MAX_SAMPLES * MINUTE_MS);
+    }
+}
+
+#ifdef __linux__
+TEST_CASE("Read the memory of this process")
+{
+    MemorySampler::Usage usage;
+    REQUIRE(MemorySampler::readProcessUsage(usage));
+    REQUIRE(usage.residentBytes > 0);
+    REQUIRE(usage.trackedBytes() > 0);
+}
+#endif
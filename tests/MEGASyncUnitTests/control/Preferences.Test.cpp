@@ -0,0 +1,152 @@
+#include <catch.hpp>
+#include "Preferences.h"
+#include "model/SyncSettings.h"
+
+#include <QElapsedTimer>
+#include <QTemporaryDir>
+
+#include <memory>
+#include <sstream>
+#include <vector>
+
+namespace
+{
+const int SYNCS = 500;
+const int ROUNDS = 10;
+
+std::shared_ptr<SyncSetting> syncSetting(mega::MegaHandle backupId, const char *syncID)
+{
+    auto cs = std::make_shared<SyncSetting>();
+    cs->setBackupId(backupId);
+    cs->setSyncID(QString::fromUtf8(syncID));
+    return cs;
+}
+
+// Entering the account again reads the stored syncs into the loaded ones
+QMap<mega::MegaHandle, QString> reloadSyncs(Preferences *preferences, const QString &email)
+{
+    if (preferences->logged())
+    {
+        preferences->leaveUser();
+    }
+    REQUIRE(preferences->enterUser(email));
+
+    QMap<mega::MegaHandle, QString> syncIDs;
+    auto loaded = preferences->getLoadedSyncsMap();
+    for (auto it = loaded.constBegin(); it != loaded.constEnd(); ++it)
+    {
+        REQUIRE(it.key() == it.value()->backupId());
+        syncIDs.insert(it.key(), it.value()->getSyncID());
+    }
+    return syncIDs;
+}
+}
+
+TEST_CASE("Journaled sync settings are stored and read back")
+{
+    QTemporaryDir dataPath;
+    REQUIRE(dataPath.isValid());
+    const QString email = QString::fromUtf8("journal@mega.nz");
+    Preferences* preferences = Preferences::instance();
+    preferences->initialize(dataPath.path());
+    preferences->setEmail(email);
+    REQUIRE(preferences->getLoadedSyncsMap().isEmpty());
+
+    // The last write of each backup id wins
+    preferences->writeSyncSetting(syncSetting(1, "first"));
+    preferences->writeSyncSetting(syncSetting(2, "other"));
+    preferences->writeSyncSetting(syncSetting(1, "second"));
+    preferences->flush();
+    QMap<mega::MegaHandle, QString> syncs = reloadSyncs(preferences, email);
+    REQUIRE(syncs.size() == 2);
+    REQUIRE(syncs.value(1) == QString::fromUtf8("second"));
+    REQUIRE(syncs.value(2) == QString::fromUtf8("other"));
+
+    // A removal after a write, of a stored sync and of one never stored
+    preferences->writeSyncSetting(syncSetting(2, "changed"));
+    preferences->removeSyncSetting(syncSetting(2, "changed"));
+    preferences->writeSyncSetting(syncSetting(3, "new"));
+    preferences->removeSyncSetting(syncSetting(3, "new"));
+    preferences->flush();
+    syncs = reloadSyncs(preferences, email);
+    REQUIRE(syncs.keys() == QList<mega::MegaHandle>() << 1);
+
+    // Only the writes made after removing all of them remain
+    preferences->writeSyncSetting(syncSetting(4, "dropped"));
+    preferences->removeAllSyncSettings();
+    preferences->writeSyncSetting(syncSetting(5, "kept"));
+    preferences->writeSyncSetting(syncSetting(6, "kept too"));
+    preferences->flush();
+    syncs = reloadSyncs(preferences, email);
+    REQUIRE(syncs.keys() == QList<mega::MegaHandle>() << 5 << 6);
+    REQUIRE(syncs.value(6) == QString::fromUtf8("kept too"));
+
+    // Leaving the account writes the changes not flushed yet
+    preferences->writeSyncSetting(syncSetting(7, "unflushed"));
+    syncs = reloadSyncs(preferences, email);
+    REQUIRE(syncs.keys() == QList<mega::MegaHandle>() << 5 << 6 << 7);
+
+    // Changes made out of an account are discarded
+    preferences->logout();
+    REQUIRE_FALSE(preferences->logged());
+    preferences->writeSyncSetting(syncSetting(8, "logged out"));
+    preferences->flush();
+    syncs = reloadSyncs(preferences, email);
+    REQUIRE(syncs.keys() == QList<mega::MegaHandle>() << 5 << 6 << 7);
+
+    preferences->logout();
+}
+
+// Not run by default: tagged hidden, run with "[benchmark]"
+TEST_CASE("Persist the settings of 500 flapping syncs", "[.][benchmark]")
+{
+    QTemporaryDir dataPath;
+    REQUIRE(dataPath.isValid());
+    Preferences* preferences = Preferences::instance();
+    preferences->initialize(dataPath.path());
+    preferences->setEmail(QString::fromUtf8("benchmark@mega.nz"));
+
+    std::vector<std::shared_ptr<SyncSetting>> syncs;
+    for (int i = 0; i < SYNCS; i++)
+    {
+        auto cs = std::make_shared<SyncSetting>();
+        cs->setBackupId(i + 1);
+        cs->setSyncID(QString::fromUtf8("sync %1").arg(i));
+        syncs.push_back(cs);
+    }
+
+    // Every sync changes state ROUNDS times, as when the network goes down and up
+    QElapsedTimer timer;
+    timer.start();
+    for (int round = 0; round < ROUNDS; round++)
+    {
+        for (auto& cs : syncs)
+        {
+            cs->setEnabled(round % 2);
+            preferences->writeSyncSetting(cs);
+        }
+    }
+    preferences->flush();
+    const qint64 journalMs = timer.elapsed();
+
+    // Previous approach: the same changes, with the whole file written after every one
+    timer.restart();
+    for (int round = 0; round < ROUNDS; round++)
+    {
+        for (auto& cs : syncs)
+        {
+            cs->setEnabled(round % 2);
+            preferences->writeSyncSetting(cs);
+            preferences->flush();
+        }
+    }
+    const qint64 writeEachMs = timer.elapsed();
+
+    std::ostringstream result;
+    result << SYNCS << " syncs, " << ROUNDS << " rounds: journaled in " << journalMs
+           << " ms, writing every change in " << writeEachMs << " ms";
+    WARN(result.str());
+
+    preferences->removeAllSyncSettings();
+    preferences->flush();
+}
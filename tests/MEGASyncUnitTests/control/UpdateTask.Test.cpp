@@ -0,0 +1,164 @@
+#include <catch.hpp>
+#include "UpdateTask.h"
+
+#include <QDataStream>
+#include <QTemporaryDir>
+
+#include <cstring>
+#include <memory>
+
+namespace
+{
+class UpdateTaskTester : public UpdateTask
+{
+public:
+    explicit UpdateTaskTester(const QString& appFolder) : UpdateTask(nullptr, appFolder) {}
+
+    using UpdateTask::FileDownload;
+    using UpdateTask::applyDelta;
+    using UpdateTask::processFileData;
+    using UpdateTask::localPaths;
+};
+
+// Reply of an update file request, with the status and range the server would send
+class FakeReply : public QNetworkReply
+{
+public:
+    FakeReply(int statusCode, const QByteArray& contentRange, const QByteArray& data) : mData(data)
+    {
+        setAttribute(QNetworkRequest::HttpStatusCodeAttribute, statusCode);
+        if (!contentRange.isEmpty())
+        {
+            setRawHeader("Content-Range", contentRange);
+        }
+        open(QIODevice::ReadOnly);
+    }
+
+    void abort() override {}
+    qint64 bytesAvailable() const override { return mData.size() - mOffset + QIODevice::bytesAvailable(); }
+
+protected:
+    qint64 readData(char* data, qint64 maxSize) override
+    {
+        qint64 size = qMin(maxSize, static_cast<qint64>(mData.size() - mOffset));
+        memcpy(data, mData.constData() + mOffset, static_cast<size_t>(size));
+        mOffset += size;
+        return size;
+    }
+
+private:
+    QByteArray mData;
+    qint64 mOffset = 0;
+};
+
+std::unique_ptr<UpdateTaskTester::FileDownload> openDownload(const QString& partPath)
+{
+    std::unique_ptr<UpdateTaskTester::FileDownload> download(new UpdateTaskTester::FileDownload());
+    download->index = 0;
+    download->hash.reset(new mega::MegaHashSignature(Preferences::UPDATE_PUBLIC_KEY));
+    download->hash->init();
+    download->partFile.setFileName(partPath);
+    download->partFile.open(QIODevice::ReadWrite);
+    return download;
+}
+
+QByteArray readFile(QFile& file)
+{
+    file.flush();
+    file.seek(0);
+    return file.readAll();
+}
+
+void writeFile(const QString& path, const QByteArray& contents)
+{
+    QFile file(path);
+    REQUIRE(file.open(QIODevice::WriteOnly));
+    REQUIRE(file.write(contents) == contents.size());
+}
+}
+
+TEST_CASE("Resume partial update files")
+{
+    QTemporaryDir folder;
+    REQUIRE(folder.isValid());
+    UpdateTaskTester task(folder.path());
+
+    const QString partPath = folder.filePath(QString::fromUtf8("file.bin.part"));
+    writeFile(partPath, "hello ");
+    std::unique_ptr<UpdateTaskTester::FileDownload> download = openDownload(partPath);
+    download->resumeOffset = download->partFile.size();
+
+    SECTION("The rest of the file is appended when the server sends the requested range")
+    {
+        FakeReply reply(206, "bytes 6-10/11", "world");
+        REQUIRE(task.processFileData(&reply, download.get()));
+        REQUIRE(readFile(download->partFile) == "hello world");
+    }
+
+    SECTION("The partial file is discarded when the server sends the whole file")
+    {
+        FakeReply reply(200, QByteArray(), "hello world");
+        REQUIRE(task.processFileData(&reply, download.get()));
+        REQUIRE(download->resumeOffset == 0);
+        REQUIRE(readFile(download->partFile) == "hello world");
+    }
+
+    SECTION("Another range fails the download")
+    {
+        FakeReply reply(206, "bytes 0-10/11", "hello world");
+        REQUIRE_FALSE(task.processFileData(&reply, download.get()));
+    }
+}
+
+TEST_CASE("Apply delta patches to installed files")
+{
+    QTemporaryDir folder;
+    REQUIRE(folder.isValid());
+    UpdateTaskTester task(folder.path());
+    task.localPaths.append(QString::fromUtf8("file.bin"));
+
+    const QByteArray installed("0123456789abcdef");
+    writeFile(folder.filePath(QString::fromUtf8("file.bin")), installed);
+    std::unique_ptr<UpdateTaskTester::FileDownload> download = openDownload(folder.filePath(QString::fromUtf8("file.bin.part")));
+
+    // "89ab" + "NEW" + "0123": copy, data, copy
+    const QByteArray expected("89abNEW0123");
+    QDataStream delta(&download->deltaData, QIODevice::WriteOnly);
+    delta.setByteOrder(QDataStream::LittleEndian);
+    delta.writeRawData("MEGADLT1", 8);
+
+    SECTION("The new file is rebuilt from the installed one")
+    {
+        delta << quint64(installed.size()) << quint64(expected.size());
+        delta << quint8('C') << quint64(8) << quint32(4);
+        delta << quint8('D') << quint32(3);
+        delta.writeRawData("NEW", 3);
+        delta << quint8('C') << quint64(0) << quint32(4);
+        delta << quint8('E');
+
+        REQUIRE(task.applyDelta(download.get()));
+        REQUIRE(readFile(download->partFile) == expected);
+    }
+
+    SECTION("A delta made for another installed file is rejected")
+    {
+        delta << quint64(installed.size() + 1) << quint64(expected.size());
+        delta << quint8('E');
+        REQUIRE_FALSE(task.applyDelta(download.get()));
+    }
+
+    SECTION("Copies out of the installed file are rejected")
+    {
+        delta << quint64(installed.size()) << quint64(4);
+        delta << quint8('C') << quint64(14) << quint32(4);
+        delta << quint8('E');
+        REQUIRE_FALSE(task.applyDelta(download.get()));
+    }
+
+    SECTION("A truncated delta is rejected")
+    {
+        delta << quint64(installed.size()) << quint64(expected.size());
+        delta << quint8('C') << quint64(8) << quint32(4);
+        REQUIRE_FALSE(task.applyDelta(download.get()));
+    }
+}
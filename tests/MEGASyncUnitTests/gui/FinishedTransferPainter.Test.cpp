@@ -0,0 +1,129 @@
+#include <catch.hpp>
+#include "FinishedTransferPainter.h"
+#include "QTransfersModel.h"
+#include "TransferManagerItem.h"
+
+#include <QCache>
+#include <QElapsedTimer>
+#include <QImage>
+#include <QPainter>
+
+#include <memory>
+#include <sstream>
+#include <vector>
+
+namespace
+{
+const int ROWS = 10000;
+const int VISIBLE_ROWS = 12;
+const QSize ROW_SIZE(784, 48);
+
+std::vector<std::unique_ptr<TransferItemData>> finishedTransfers()
+{
+    std::vector<std::unique_ptr<TransferItemData>> transfers;
+    for (int i = 0; i < ROWS; i++)
+    {
+        std::unique_ptr<TransferItemData> tData(new TransferItemData());
+        tData->data.tag = i + 1;
+        tData->data.type = i % 2 ? mega::MegaTransfer::TYPE_DOWNLOAD : mega::MegaTransfer::TYPE_UPLOAD;
+        tData->data.filename = QString::fromUtf8("a fairly long file name for transfer number %1.jpg").arg(i);
+        tData->data.errorCode = i % 50 ? mega::MegaError::API_OK : mega::MegaError::API_EFAILED;
+        tData->data.errorValue = 0;
+        tData->data.state = mega::MegaTransfer::STATE_COMPLETED;
+        tData->data.totalSize = 1024LL * i;
+        tData->data.updateTime = 1;
+        transfers.push_back(std::move(tData));
+    }
+    return transfers;
+}
+
+// Scrolls through the whole list one row at a time and returns the frames per second
+template <typename PaintRow>
+double scroll(PaintRow paintRow)
+{
+    QImage frame(ROW_SIZE.width(), ROW_SIZE.height() * VISIBLE_ROWS, QImage::Format_ARGB32_Premultiplied);
+    QElapsedTimer timer;
+    timer.start();
+    int frames = 0;
+    for (int first = 0; first + VISIBLE_ROWS <= ROWS; first += 4, frames++)
+    {
+        frame.fill(Qt::white);
+        QPainter painter(&frame);
+        for (int i = 0; i < VISIBLE_ROWS; i++)
+        {
+            paintRow(&painter, QRect(QPoint(0, i * ROW_SIZE.height()), ROW_SIZE), first + i);
+        }
+    }
+    return frames * 1000.0 / qMax<qint64>(1, timer.elapsed());
+}
+}
+
+// Not run by default: tagged hidden, run with "[benchmark]"
+TEST_CASE("Scroll 10k finished transfers", "[.][benchmark]")
+{
+    std::vector<std::unique_ptr<TransferItemData>> transfers = finishedTransfers();
+
+    FinishedTransferPainter finishedPainter;
+    double painterFps = scroll([&](QPainter *painter, const QRect &rect, int row)
+    {
+        finishedPainter.paint(painter, rect, transfers[row].get(), false);
+    });
+
+    // Previous approach: a widget per row kept in a cache of 16, rendered into the view
+    QCache<int, TransferItem> transferItems;
+    transferItems.setMaxCost(16);
+    double widgetFps = scroll([&](QPainter *painter, const QRect &rect, int row)
+    {
+        TransferItemData *tData = transfers[row].get();
+        TransferItem *ti = transferItems[tData->data.tag];
+        if (!ti)
+        {
+            ti = new TransferManagerItem();
+            ti->setTransferTag(tData->data.tag);
+            ti->setType(tData->data.type, false);
+            ti->setFileName(tData->data.filename);
+            ti->setTotalSize(tData->data.totalSize);
+            if (tData->data.errorCode != mega::MegaError::API_OK)
+            {
+                ti->setTransferError(tData->data.errorCode, tData->data.errorValue);
+            }
+            ti->setTransferState(tData->data.state);
+            ti->setFinishedTime(tData->data.updateTime);
+            ti->updateFinishedTime();
+            transferItems.insert(tData->data.tag, ti);
+        }
+        painter->save();
+        painter->translate(rect.topLeft());
+        ti->render(painter, QPoint(0, 0), QRegion(0, 0, rect.width(), rect.height()));
+        painter->restore();
+    });
+
+    REQUIRE(painterFps > 0);
+    std::ostringstream result;
+    result << "Scrolling 10k finished transfers: painter " << painterFps << " fps, widgets " << widgetFps << " fps";
+    WARN(result.str());
+}
+
+TEST_CASE("Finished transfer names are elided to the width of the row")
+{
+    FinishedTransferPainter finishedPainter;
+    TransferItemData tData;
+    tData.data.tag = 1;
+    tData.data.type = mega::MegaTransfer::TYPE_DOWNLOAD;
+    tData.data.filename = QString::fromUtf8("photo.jpg");
+    tData.data.errorCode = mega::MegaError::API_OK;
+    tData.data.totalSize = 1024;
+    tData.data.updateTime = 1;
+
+    QImage frame(ROW_SIZE.width(), ROW_SIZE.height(), QImage::Format_ARGB32_Premultiplied);
+    QPainter painter(&frame);
+    finishedPainter.paint(&painter, QRect(QPoint(0, 0), ROW_SIZE), &tData, false);
+    REQUIRE_FALSE(finishedPainter.isFileNameElided(tData.data.tag));
+
+    // The right-aligned columns leave almost no room for the name in a narrow row
+    finishedPainter.paint(&painter, QRect(0, 0, 420, ROW_SIZE.height()), &tData, false);
+    REQUIRE(finishedPainter.isFileNameElided(tData.data.tag));
+
+    finishedPainter.paint(&painter, QRect(QPoint(0, 0), ROW_SIZE), &tData, false);
+    REQUIRE_FALSE(finishedPainter.isFileNameElided(tData.data.tag));
+}
@@ -0,0 +1,72 @@
+#include <catch.hpp>
+#include "MegaItem.h"
+
+#include <memory>
+#include <string>
+
+namespace
+{
+// Only what MegaItem reads to sort and index its children
+class FakeNode : public mega::MegaNode
+{
+public:
+    FakeNode(mega::MegaHandle handle, const char *name, int type) : mHandle(handle), mName(name), mType(type) {}
+    mega::MegaNode *copy() override { return new FakeNode(mHandle, mName.c_str(), mType); }
+    mega::MegaHandle getHandle() override { return mHandle; }
+    const char *getName() override { return mName.c_str(); }
+    int getType() override { return mType; }
+
+private:
+    mega::MegaHandle mHandle;
+    std::string mName;
+    int mType;
+};
+
+mega::MegaNode *folderNode(mega::MegaHandle handle, const char *name)
+{
+    return new FakeNode(handle, name, mega::MegaNode::TYPE_FOLDER);
+}
+
+mega::MegaNode *fileNode(mega::MegaHandle handle, const char *name)
+{
+    return new FakeNode(handle, name, mega::MegaNode::TYPE_FILE);
+}
+
+void insert(MegaItem &parent, mega::MegaNode *node)
+{
+    parent.insertNode(node, parent.insertPosition(node));
+}
+}
+
+TEST_CASE("MegaItem keeps inserted children sorted")
+{
+    std::unique_ptr<mega::MegaNode> root(folderNode(1, "root"));
+    MegaItem item(root.get(), nullptr, true);
+
+    insert(item, fileNode(2, "b.txt"));
+    insert(item, folderNode(3, "Zeta"));
+    insert(item, fileNode(4, "A.txt"));
+    insert(item, folderNode(5, "alpha"));
+    insert(item, fileNode(6, "c.txt"));
+
+    const char *expected[] = {"alpha", "Zeta", "A.txt", "b.txt", "c.txt"};
+    REQUIRE(item.getNumChildren() == 5);
+    for (int i = 0; i < item.getNumChildren(); i++)
+    {
+        REQUIRE(QString::fromUtf8(item.getChild(i)->getNode()->getName()) == QString::fromUtf8(expected[i]));
+        REQUIRE(item.getChild(i)->getRow() == i);
+        REQUIRE(item.indexOf(item.getChild(i)) == i);
+    }
+
+    SECTION("Rows are updated after a removal")
+    {
+        item.removeNode(item.getChildByHandle(5)->getNode());
+        REQUIRE(item.getNumChildren() == 4);
+        REQUIRE(item.getChildByHandle(5) == nullptr);
+        for (int i = 0; i < item.getNumChildren(); i++)
+        {
+            REQUIRE(item.getChild(i)->getRow() == i);
+        }
+        REQUIRE(item.getChildByHandle(6)->getRow() == 3);
+    }
+}
@@ -0,0 +1,165 @@
+#include <catch.hpp>
+#include <trompeloeil.hpp>
+#include "QMegaModel.h"
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+
+#include <atomic>
+#include <functional>
+#include <string>
+
+namespace
+{
+class MegaApiMock : public mega::MegaApi
+{
+public:
+    MegaApiMock():mega::MegaApi("appKey"){};
+    MAKE_MOCK0(getContacts, mega::MegaUserList*(), override);
+    MAKE_MOCK2(getChildren, mega::MegaNodeList*(mega::MegaNode* parent, int order), override);
+};
+
+class EmptyUserList : public mega::MegaUserList
+{
+public:
+    mega::MegaUserList *copy() override { return new EmptyUserList(); }
+    int size() override { return 0; }
+};
+
+// Only what the model and MegaItem read
+class FakeNode : public mega::MegaNode
+{
+public:
+    FakeNode(mega::MegaHandle handle, const char *name, int type) : mHandle(handle), mName(name), mType(type) {}
+    mega::MegaNode *copy() override { return new FakeNode(mHandle, mName.c_str(), mType); }
+    mega::MegaHandle getHandle() override { return mHandle; }
+    const char *getName() override { return mName.c_str(); }
+    int getType() override { return mType; }
+    bool isFolder() override { return mType != TYPE_FILE; }
+
+private:
+    mega::MegaHandle mHandle;
+    std::string mName;
+    int mType;
+};
+
+// The model shows the given folder as its first top level item
+class FolderModel : public QMegaModel
+{
+public:
+    FolderModel(mega::MegaApi *megaApi, mega::MegaNode *folder) : QMegaModel(megaApi)
+    {
+        delete rootItem;
+        rootItem = new MegaItem(folder);
+    }
+};
+
+mega::MegaNodeList *subfolders(int count)
+{
+    mega::MegaNodeList *list = mega::MegaNodeList::createInstance();
+    for (int i = 0; i < count; i++)
+    {
+        FakeNode node(100 + i, std::to_string(i).c_str(), mega::MegaNode::TYPE_FOLDER);
+        list->addNode(&node);
+    }
+    return list;
+}
+
+// Children are fetched by a worker and set in this thread
+bool waitFor(const std::function<bool()>& condition, int timeoutMs = 5000)
+{
+    QElapsedTimer timer;
+    timer.start();
+    while (!condition())
+    {
+        if (timer.elapsed() > timeoutMs)
+        {
+            return false;
+        }
+        QCoreApplication::processEvents(QEventLoop::AllEvents, 10);
+    }
+    return true;
+}
+}
+
+TEST_CASE("QMegaModel fetches the children of a folder in pages")
+{
+    const int children = 2 * QMegaModel::FETCH_PAGE_SIZE + 200;
+    MegaApiMock api;
+    ALLOW_CALL(api, getContacts())
+        .RETURN(new EmptyUserList());
+    ALLOW_CALL(api, getChildren(trompeloeil::_, trompeloeil::_))
+        .RETURN(subfolders(children));
+
+    FakeNode folder(1, "folder", mega::MegaNode::TYPE_FOLDER);
+    FolderModel model(&api, &folder);
+    QModelIndex parent = model.index(0, 0);
+    REQUIRE(model.hasChildren(parent));
+    REQUIRE(model.canFetchMore(parent));
+    REQUIRE(model.rowCount(parent) == 0);
+
+    // A placeholder is shown until the worker answers, then the first page is added
+    model.fetchMore(parent);
+    REQUIRE(model.rowCount(parent) == 1);
+    REQUIRE(model.data(model.index(0, 0, parent)).toString() == QMegaModel::tr("Loading..."));
+    REQUIRE_FALSE(model.canFetchMore(parent));
+    REQUIRE(waitFor([&]() { return model.rowCount(parent) == QMegaModel::FETCH_PAGE_SIZE; }));
+    REQUIRE(model.data(model.index(0, 0, parent)).toString() == QString::fromUtf8("0"));
+
+    REQUIRE(model.canFetchMore(parent));
+    model.fetchMore(parent);
+    REQUIRE(model.rowCount(parent) == 2 * QMegaModel::FETCH_PAGE_SIZE);
+    REQUIRE(model.canFetchMore(parent));
+    model.fetchMore(parent);
+    REQUIRE(model.rowCount(parent) == children);
+    REQUIRE_FALSE(model.canFetchMore(parent));
+
+    for (int row = 0; row < children; row += 97)
+    {
+        QModelIndex child = model.index(row, 0, parent);
+        REQUIRE(model.parent(child) == parent);
+        REQUIRE(model.getNode(child)->getHandle() == static_cast<mega::MegaHandle>(100 + row));
+    }
+
+    SECTION("Released children are fetched again on the next expansion")
+    {
+        model.releaseChildren(parent);
+        REQUIRE(model.rowCount(parent) == 0);
+        REQUIRE(model.hasChildren(parent));
+        REQUIRE(model.canFetchMore(parent));
+
+        model.fetchMore(parent);
+        REQUIRE(waitFor([&]() { return model.rowCount(parent) == QMegaModel::FETCH_PAGE_SIZE; }));
+    }
+}
+
+TEST_CASE("QMegaModel drops the children fetched for a released folder")
+{
+    MegaApiMock api;
+    ALLOW_CALL(api, getContacts())
+        .RETURN(new EmptyUserList());
+    std::atomic<int> fetches(0);
+    ALLOW_CALL(api, getChildren(trompeloeil::_, trompeloeil::_))
+        .LR_SIDE_EFFECT(fetches++)
+        .RETURN(subfolders(10));
+
+    FakeNode folder(1, "folder", mega::MegaNode::TYPE_FOLDER);
+    FolderModel model(&api, &folder);
+    QModelIndex parent = model.index(0, 0);
+
+    // Collapsed before the worker answers
+    model.fetchMore(parent);
+    model.releaseChildren(parent);
+    REQUIRE(model.rowCount(parent) == 0);
+    REQUIRE(waitFor([&]() { return fetches == 1; }));
+    REQUIRE_FALSE(waitFor([&]() { return model.rowCount(parent) != 0; }, 200));
+    REQUIRE(model.canFetchMore(parent));
+
+    // A synchronous load replaces the pending fetch
+    model.fetchMore(parent);
+    model.loadChildren(parent);
+    REQUIRE(model.rowCount(parent) == 10);
+    REQUIRE(waitFor([&]() { return fetches == 3; }));
+    REQUIRE_FALSE(waitFor([&]() { return model.rowCount(parent) != 10; }, 200));
+    REQUIRE_FALSE(model.canFetchMore(parent));
+}